@@ -93,6 +93,8 @@ public:
 		//create a vector to a target position on the wander circle
 		mWanderTarget = Vector2(WanderRad * cos(theta),
 									WanderRad * sin(theta));
+		//No contacts processed
+		_subscribeContacts(0);
 	}
 	virtual ~AIAgent()
 	{
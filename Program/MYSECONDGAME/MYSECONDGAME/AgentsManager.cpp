@@ -12,6 +12,7 @@
 #include "AgentsManager.h"
 #include "AgentsManagerListener.h"
 #include "PhysicsEvents.h"
+#include "GameEvents.h"
 #include <sstream>
 
 //Static variables definition
@@ -66,6 +67,12 @@ IAgent* AgentsManager::CreateNewAgent(const std::string &name,const GameAgentPar
 		break;
 	}
 
+	//IF - Created: give it a handle (collisions dispatching)
+	if(newagent)
+	{
+		_addAgentSlot(newagent);
+	}//IF
+
 	//Update number of created agents
 	mAgentsMap[name] = newagent;
 	++mAgentCount;
@@ -90,12 +97,40 @@ void AgentsManager::UpdateAgents(float dt)
 		}
 		else //ELSE - AGENT WAS DESTROYED
 		{
+			_releaseAgentSlot((*itr).second);
 			delete (*itr).second;
 			itr = mAgentsMap.erase(itr);
 		}
 	}//LOOP END
 }
 
+//Place agents graphics between last two physics steps (every frame)
+void AgentsManager::InterpolateAgents()
+{
+	GameAgentsMapIterator itr;
+	//LOOP - All alive agents (dead ones are deleted in update)
+	for(itr = mAgentsMap.begin(); itr != mAgentsMap.end(); ++itr)
+	{
+		if((*itr).second->IsAlive())
+			(*itr).second->InterpolateGFX();
+	}//LOOP END
+}
+
+//Back to state after level load
+bool AgentsManager::RestartAgents()
+{
+	GameAgentsMapIterator itr;
+	//LOOP - Restart all agents
+	for(itr = mAgentsMap.begin(); itr != mAgentsMap.end(); ++itr)
+	{
+		//IF - Agent cant restart (it changed the level)
+		if(!(*itr).second->Restart())
+			return false;
+	}//LOOP END
+
+	return true;
+}
+
 //Search for a concrete agent
 IAgent* AgentsManager::_searchAgent(const std::string &name)
 {
@@ -112,77 +147,67 @@ IAgent* AgentsManager::_searchAgent(const std::string &name)
 	}
 }
 
-//Handle collisions
+//Handle events
 bool AgentsManager::_handleEvents(const EventData& eventdata)
 {
 	bool eventprocessed(false);
-	//Check received events are of correct type
-	//IF - Collision events!
-	if(eventdata.GetEventType() == Event_NewCollision
-		||
-		eventdata.GetEventType() == Event_PersistantCollision
-		||
-		eventdata.GetEventType() == Event_DeletedCollision
-		||
-		eventdata.GetEventType() == Event_CollisionResult
-		)
+	//IF - Physics thread stepping: agents cant use the world now
+	if(mPhysicsManager->IsStepping())
 	{
-		const CollisionEventData& collevent = static_cast<const CollisionEventData&>(eventdata);
-		
-		const ContactInfo& theinfo = collevent.GetCollisionData();
-		b2Body* body1 = theinfo.collidedbody1;
-		if(body1)
+		//Events are handled in next physics update (copied), so the game never waits for the steps.
+		//Rendering reads the step snapshot published by the thread: newest step is taken once per frame
+		if(eventdata.GetEventType() == Event_RenderInLayer)
 		{
-			//Forward event to this agent (collisions)
-			if(theinfo.agent1)
-			{
-				//Check agent exists
-				if(_agentExists(theinfo.agent1))
-				{
-					collevent.SetActiveBody(body1); //Memorize this is the body
-					theinfo.agent1->HandleCollision(collevent);
-				}
-				else //DEBUG
-				{
-					#ifdef _DEBUGGING
-					std::stringstream ss;
-					ss<<"NOT FORWARDED EVENT COLLISION!";
-					DebugStringInfo themessage(ss.str());
-					SingletonGameEventMgr::Instance()->QueueEvent(
-													EventDataPointer(new DebugMessageEvent(Event_DebugString,themessage))
-													);
-					#endif
-				}
-			}
+			if(static_cast<const RenderInLayerXEvent&>(eventdata).GetLayer() == 0)
+				mPhysicsManager->ReadStepSnapshot();
 		}
-		b2Body* body2 = theinfo.collidedbody2;
-		if(body2)
+		else if(eventdata.GetEventType() == Event_BlobMove)
 		{
-			//Forward event to this agent (collisions)
-			if(theinfo.agent2)
+			const BlobMovementEvent& command = static_cast<const BlobMovementEvent&>(eventdata);
+			mPhysicsManager->QueueCommand(EventDataPointer(new BlobMovementEvent(command)),mEventListener);
+			return true;
+		}
+		else if(eventdata.GetEventType() == Event_ShootBlobCommand)
+		{
+			const ShootBlobEvent& command = static_cast<const ShootBlobEvent&>(eventdata);
+			mPhysicsManager->QueueCommand(EventDataPointer(new ShootBlobEvent(command)),mEventListener);
+			return true;
+		}
+		else if(eventdata.GetEventType() == Event_BlobDeath)
+		{
+			//Affected bodies can be destroyed before it is handled: handles of their agents are checked then
+			const BlobDeathEvent& death = static_cast<const BlobDeathEvent&>(eventdata);
+			BlobDeathInfo info(death.GetInfo());
+			info.affectedhandles.clear();
+			//LOOP - Handle of agent of each affected body (not valid if none)
+			for(std::vector<b2Body*>::const_iterator itr = info.affectedbodies.begin(); itr != info.affectedbodies.end(); ++itr)
 			{
-				//Check agent exists
-				if(_agentExists(theinfo.agent2))
-				{
-					collevent.SetActiveBody(body2); //Memorize this is the body
-					theinfo.agent2->HandleCollision(collevent);
-				}	
-				else //DEBUG
-				{
-					#ifdef _DEBUGGING
-					std::stringstream ss;
-					ss<<"NOT FORWARDED EVENT COLLISION!";
-					DebugStringInfo themessage(ss.str());
-					SingletonGameEventMgr::Instance()->QueueEvent(
-													EventDataPointer(new DebugMessageEvent(Event_DebugString,themessage))
-													);
-					#endif
-				}
-			}
+				IAgent* bodyagent = static_cast<IAgent*>((*itr)->GetUserData());
+				info.affectedhandles.push_back(bodyagent ? bodyagent->GetHandle() : AgentHandle());
+			}//LOOP END
+			mPhysicsManager->QueueCommand(EventDataPointer(new BlobDeathEvent(Event_BlobDeath,info,death.GetEventTimeStamp())),mEventListener);
+			return true;
 		}
-		eventprocessed = true;
-	}//ELSE - Out of limits event
-	else if(eventdata.GetEventType() == Event_OutOfLimits)
+		else if(eventdata.GetEventType() == Event_DropCollision)
+		{
+			const DropCollidedEvent& collision = static_cast<const DropCollidedEvent&>(eventdata);
+			mPhysicsManager->QueueCommand(EventDataPointer(new DropCollidedEvent(collision)),mEventListener);
+			return true;
+		}
+		else if(eventdata.GetEventType() == Event_ChangeBlobCommand || eventdata.GetEventType() == Event_SacrificeBlobCommand)
+		{
+			mPhysicsManager->QueueCommand(EventDataPointer(new EventData(eventdata.GetEventType())),mEventListener);
+			return true;
+		}
+		else //ELSE - Other events wait for steps (out of limits is sent by physics update, when world is not in use)
+		{
+			mPhysicsManager->WaitForSteps();
+		}
+	}//IF
+
+	//Check received events are of correct type
+	//IF - Out of limits event
+	if(eventdata.GetEventType() == Event_OutOfLimits)
 	{
 		const OutOfLimitsEventData& oolevent = static_cast<const OutOfLimitsEventData&>(eventdata);
 		const OutOfLimitsData& data = oolevent.GetEventData();
@@ -238,19 +263,34 @@ bool AgentsManager::_handleEvents(const EventData& eventdata)
 		const BlobDeathEvent& deatheventdata = static_cast<const BlobDeathEvent&>(eventdata);
 		std::vector<b2Body*>::const_iterator itr = deatheventdata.GetFirstAffectedBody();
 		std::vector<b2Body*>::const_iterator lastbody = deatheventdata.GetLastAffectedBody();
+		const std::vector<AgentHandle>& handles = deatheventdata.GetInfo().affectedhandles;
+		std::vector<b2Body*> wetbodies;		//Solid bodies wetted: friction changed in one call
+		std::vector<float> wetfrictions;
 
 		//LOOP - Check if Body was affected
-		while(itr != lastbody)
+		for(size_t i = 0; itr != lastbody; ++itr, ++i)
 		{
+			//IF - Queued while stepping and agent of body deleted since then (body can be destroyed)
+			if(!handles.empty() && !_isHandleValid(handles[i]))
+				continue;
+
 			IAgent* bodyagent = static_cast<IAgent*> ((*itr)->GetUserData());
 			//IF - Some user data assigned
 			if(bodyagent)
 			{
 				eventprocessed = bodyagent->HandleEvent(eventdata);
+				//IF - Solid body wetted
+				if(eventprocessed && bodyagent->GetType() == PHYSICBODY)
+				{
+					wetbodies.push_back(*itr);
+					wetfrictions.push_back(static_cast<SolidBodyAgent*>(bodyagent)->GetFriction());
+				}//IF
 			}//IF
-
-			++itr;
 		}//LOOP END
+
+		//IF - Bodies wetted: change frictions (contacts are kept)
+		if(!wetbodies.empty())
+			mPhysicsManager->ChangeFrictionofBodies(wetbodies,wetfrictions);
 	}//ELSE - Incoherent type
 	else
 	{
@@ -261,32 +301,162 @@ bool AgentsManager::_handleEvents(const EventData& eventdata)
 	return eventprocessed;
 }
 
-//Query if an agent exists
-bool AgentsManager::_agentExists(IAgent* agenttosearch)
+//Deliver collisions of an update grouped by agent: every agent receives all its contacts in one call
+void AgentsManager::DispatchCollisions(const ContactInfoBuffer& points, const ContactInfoBuffer& results)
 {
-	bool agentfound(false);
-	GameAgentsMapIterator itr;	
-	//LOOP - Search for agent with this pointer
-	for(itr = mAgentsMap.begin();itr != mAgentsMap.end(); ++itr)
+	memset(&mDispatchStatistics,0,sizeof(CollisionDispatchStatistics));
+	mContacts.clear();
+	mContactSlots.clear();
+
+	int pointscount(points.GetSortedCount());
+	//LOOP - Contact points, for both agents
+	for(int i = 0; i < pointscount; ++i)
+	{
+		const ContactInfo& info = points.GetSortedInfo(i);
+		GameEventType type(Event_NewCollision);
+		//Check in which state is the point
+		if(info.state == PERSISTED)
+			type = Event_PersistantCollision;
+		else if(info.state == REMOVED)
+			type = Event_DeletedCollision;
+		else if(info.state == TRIGGERENTER)
+			type = Event_TriggerEnter;
+		else if(info.state == TRIGGEREXIT)
+			type = Event_TriggerExit;
+
+		_addAgentContact(type,info,info.collidedbody1,info.agent1,info.agenthandle1);
+		_addAgentContact(type,info,info.collidedbody2,info.agent2,info.agenthandle2);
+	}//LOOP END
+
+	int resultscount(results.GetSortedCount());
+	//LOOP - Contact results, for both agents
+	for(int i = 0; i < resultscount; ++i)
+	{
+		const ContactInfo& info = results.GetSortedInfo(i);
+		//Assert good state
+		assert(info.state == RESULT);
+
+		_addAgentContact(Event_CollisionResult,info,info.collidedbody1,info.agent1,info.agenthandle1);
+		_addAgentContact(Event_CollisionResult,info,info.collidedbody2,info.agent2,info.agenthandle2);
+	}//LOOP END
+
+	//Group by agent slot keeping buffers order (counting sort)
+	int contactscount(static_cast<int>(mContacts.size()));
+	int slotscount(static_cast<int>(mAgentSlots.size()));
+	mSlotOffsets.assign(slotscount + 1,0);
+	mAgentContacts.resize(contactscount);
+	//LOOP - Count contacts of each agent
+	for(int i = 0; i < contactscount; ++i)
+	{
+		++mSlotOffsets[mContactSlots[i] + 1];
+	}//LOOP END
+	//LOOP - Groups start
+	for(int slot = 0; slot < slotscount; ++slot)
+	{
+		mSlotOffsets[slot + 1] += mSlotOffsets[slot];
+	}//LOOP END
+	//LOOP - Place contacts (offsets end as groups end)
+	for(int i = 0; i < contactscount; ++i)
 	{
-		//IF - Is the player agent
-		if((*itr).second == agenttosearch)
+		mAgentContacts[mSlotOffsets[mContactSlots[i]]++] = mContacts[i];
+	}//LOOP END
+
+	//LOOP - Deliver every group to its agent
+	int groupstart(0);
+	for(int slot = 0; slot < slotscount; ++slot)
+	{
+		int groupend(mSlotOffsets[slot]);
+		//IF - Agent had contacts
+		if(groupend > groupstart)
 		{
-			agentfound = true;
-			break;
-		}
-	}//LOOP END	
+			mAgentSlots[slot].agent->HandleCollisions(&mAgentContacts[groupstart],groupend - groupstart);
+			++mDispatchStatistics.agents;
+		}//IF
+		groupstart = groupend;
+	}//LOOP END
+	mDispatchStatistics.contacts = contactscount;
+}
+
+//Give a handle to a new agent
+void AgentsManager::_addAgentSlot(IAgent* agent)
+{
+	AgentHandle handle;
+	//IF - Free slot to reuse
+	if(!mFreeSlots.empty())
+	{
+		handle.slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else //ELSE - New slot
+	{
+		AgentSlot newslot;
+		newslot.agent = NULL;
+		newslot.generation = 0;
+		handle.slot = static_cast<int>(mAgentSlots.size());
+		mAgentSlots.push_back(newslot);
+	}//IF
 
-	return agentfound;
+	mAgentSlots[handle.slot].agent = agent;
+	handle.generation = mAgentSlots[handle.slot].generation;
+	agent->SetHandle(handle);
+}
+
+//Invalidate handle of a deleted agent
+void AgentsManager::_releaseAgentSlot(IAgent* agent)
+{
+	const AgentHandle& handle = agent->GetHandle();
+	assert(_isHandleValid(handle) && mAgentSlots[handle.slot].agent == agent);
+
+	//Handles taken before are not valid anymore
+	++mAgentSlots[handle.slot].generation;
+	mAgentSlots[handle.slot].agent = NULL;
+	mFreeSlots.push_back(handle.slot);
+}
+
+//Add contact to deliver to one of the agents
+void AgentsManager::_addAgentContact(GameEventType type, const ContactInfo& info, b2Body* body, IAgent* agent, const AgentHandle& handle)
+{
+	//IF - No body or agent
+	if(!body || !agent)
+		return;
+
+	//IF - Agent still exists
+	if(_isHandleValid(handle))
+	{
+		AgentContact contact;
+		contact.type = type;
+		contact.info = &info;
+		contact.activebody = body; //Memorize this is the body
+		mContacts.push_back(contact);
+		mContactSlots.push_back(handle.slot);
+	}
+	else //ELSE - Agent deleted after contact was buffered
+	{
+		++mDispatchStatistics.dropped;
+		#ifdef _DEBUGGING
+		std::stringstream ss;
+		ss<<"NOT FORWARDED EVENT COLLISION!";
+		DebugStringInfo themessage(ss.str());
+		SingletonGameEventMgr::Instance()->QueueEvent(
+										EventDataPointer(new DebugMessageEvent(Event_DebugString,themessage))
+										);
+		#endif
+	}//IF
 }
 
 void AgentsManager::_init()
 {
+	memset(&mDispatchStatistics,0,sizeof(CollisionDispatchStatistics));
 	mEventListener = new AgentsManagerListener(this);
+	//Receive collisions from physics
+	mPhysicsManager->SetCollisionDispatcher(this);
 }
 
 void AgentsManager::_release()
 {
+	//Stop receiving collisions (agents are deleted now)
+	mPhysicsManager->SetCollisionDispatcher(NULL);
+
 	//Delete al dynamically created agents
 	GameAgentsMapIterator itr;	
 	
@@ -297,6 +467,8 @@ void AgentsManager::_release()
 			delete (*itr).second;
 	}//LOOP END
 	mAgentsMap.clear();
+	mAgentSlots.clear();
+	mFreeSlots.clear();
 
 	if(mEventListener)
 	{
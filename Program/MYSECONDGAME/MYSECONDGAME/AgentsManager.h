@@ -17,6 +17,7 @@
 //Library dependencies
 #include <map>
 #include <string>
+#include <vector>
 //Classes dependencies
 #include "LogManager.h"
 #include "GenericException.h"
@@ -27,7 +28,15 @@
 class PhysicsManager;
 class AgentsManagerListener;
 
-class AgentsManager
+//Collisions dispatching counters (last update)
+typedef struct CollisionDispatchStatistics
+{
+	int contacts;	//Contacts delivered to agents
+	int agents;		//Agents which received contacts (one call each)
+	int dropped;	//Contacts of agents deleted after buffering
+}CollisionDispatchStatistics;
+
+class AgentsManager : public ICollisionDispatcher
 {
 //Friends
 	friend class AgentsManagerListener;
@@ -36,6 +45,13 @@ public:
 	//A map to contain agents
 	typedef std::map<std::string, IAgent*> GameAgentsMap;
 	typedef GameAgentsMap::iterator GameAgentsMapIterator; //the iterator for the map
+	//Table of agents indexed by handles: generation changes when the agent in slot is deleted
+	typedef struct AgentSlot
+	{
+		IAgent* agent;
+		unsigned int generation;
+	}AgentSlot;
+	typedef std::vector<AgentSlot> AgentSlotsVec;
 public:
 	//----CONSTRUCTORS/DESTRUCTORS----
 	AgentsManager(PhysicsManagerPointer physicsptr):
@@ -50,21 +66,35 @@ public:
 	//----- VALUES GET/SET ---------------
 	PhysicsManagerPointer GetPhysicsManager() { return mPhysicsManager; }
 	IAgent* GetAgent(const std::string &name){ return(_searchAgent(name)); }
+	const CollisionDispatchStatistics& GetCollisionDispatchStatistics() const { return mDispatchStatistics; }
 	//----- OTHER FUNCTIONS --------------
 	IAgent* CreateNewAgent(const std::string &name,const GameAgentPar *newagentparams );	//Create a new agent instance
 	void UpdateAgents(float dt); //Update all available agents state
+	void InterpolateAgents();	 //Place agents graphics between last two physics steps (every frame)
+	bool RestartAgents();		//Back to state after level load (false if some agent cant: level must be loaded again)
+	virtual void DispatchCollisions(const ContactInfoBuffer& points, const ContactInfoBuffer& results); //Deliver collisions grouped by agent
 private:
 	//---- INTERNAL VARIABLES ---- 
 	GameAgentsMap mAgentsMap;				//The map to contain agents
 	static int mAgentCount;					//An internal count of added agents
 	AgentsManagerListener* mEventListener;	//Internal friend object to manage event receiving
 	PhysicsManagerPointer mPhysicsManager;
+	AgentSlotsVec mAgentSlots;				//Agents by handle slot
+	std::vector<int> mFreeSlots;			//Slots of deleted agents to reuse
+	std::vector<AgentContact> mContacts;	//Collisions dispatching (storage reused every update)
+	std::vector<int> mContactSlots;			//Agent slot of each contact
+	std::vector<AgentContact> mAgentContacts; //Contacts grouped by agent slot
+	std::vector<int> mSlotOffsets;			//Start of each agent group
+	CollisionDispatchStatistics mDispatchStatistics;
 	//---- INTERNAL FUNCTIONS ----	
 	void _init();
 	void _release();
 	IAgent* _searchAgent(const std::string &name);   //Search agent
-	bool _agentExists(IAgent* agenttosearch); //Query if an agent exists
-	bool _handleEvents(const EventData& eventdata);	//Handle collisions
+	bool _isHandleValid(const AgentHandle& handle) const { return (handle.slot >= 0 && handle.slot < static_cast<int>(mAgentSlots.size()) && mAgentSlots[handle.slot].generation == handle.generation); }
+	void _addAgentSlot(IAgent* agent);		//Give a handle to a new agent
+	void _releaseAgentSlot(IAgent* agent);	//Invalidate handle of a deleted agent
+	void _addAgentContact(GameEventType type, const ContactInfo& info, b2Body* body, IAgent* agent, const AgentHandle& handle); //Add contact to deliver
+	bool _handleEvents(const EventData& eventdata);	//Handle events
 };
 
 #endif
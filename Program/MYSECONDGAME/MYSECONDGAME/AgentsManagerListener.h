@@ -30,11 +30,7 @@ public:
 	{
 		assert(mAgentsManager);
 		//Register events to process
-		//Collisions
-		SingletonGameEventMgr::Instance()->AddListener(this,Event_NewCollision);
-		SingletonGameEventMgr::Instance()->AddListener(this,Event_PersistantCollision);
-		SingletonGameEventMgr::Instance()->AddListener(this,Event_DeletedCollision);
-		SingletonGameEventMgr::Instance()->AddListener(this,Event_CollisionResult);
+		//Collisions are not events: physics manager delivers them to agents manager (collisions dispatcher)
 		//Out of limits
 		SingletonGameEventMgr::Instance()->AddListener(this,Event_OutOfLimits);
 		//New Target event
@@ -54,11 +50,6 @@ public:
 	~AgentsManagerListener()
 	{
 		//Deregister events to process
-		//Collisions
-		SingletonGameEventMgr::Instance()->RemoveListener(this,Event_NewCollision);
-		SingletonGameEventMgr::Instance()->RemoveListener(this,Event_PersistantCollision);
-		SingletonGameEventMgr::Instance()->RemoveListener(this,Event_DeletedCollision);
-		SingletonGameEventMgr::Instance()->RemoveListener(this,Event_CollisionResult);
 		//Out of limits
 		SingletonGameEventMgr::Instance()->RemoveListener(this,Event_OutOfLimits);
 		//New Target event
@@ -29,6 +29,8 @@ void BlobBuilder::LoadBlob(const ticpp::Element* xmlelement)
 				MassesRadius(number) MassesFriction(number) MassesRestitution(number)
 				MassesDensity(number)
 				InnerMassRadius(number) InnerMassDensity(number)
+				RingSolver(number)(optional) RingSolverIterations(number)(optional)
+				SoftBody(number)(optional) SoftBodyParticles(number)(optional) SoftBodyStiffness(number)(optional)
 	*/
 	
 	//Assert correct parameters
@@ -62,6 +64,19 @@ void BlobBuilder::LoadBlob(const ticpp::Element* xmlelement)
 	//Get optional parameter if double skin is active
 	if(creationparams.doubleskinned)
 		xmlelement->GetAttribute("InnerSkinRadius",&creationparams.innerskinradius);
+	//Optional ring solver for the springs
+	xmlelement->GetAttribute("RingSolver",&creationparams.ringsolver,false);  //Optional parameter
+	xmlelement->GetAttribute("RingSolverIterations",&creationparams.ringsolveriterations,false);  //Optional parameter
+	if(creationparams.ringsolveriterations <= 0 || creationparams.ringsolveriterations > 20)
+		throw GenericException("Failure while reading blob attributes - Bad value of RingSolverIterations",GenericException::FILE_CONFIG_INCORRECT);
+	//Optional soft body model (shape matching and pressure instead of joints)
+	xmlelement->GetAttribute("SoftBody",&creationparams.softbody,false);  //Optional parameter
+	xmlelement->GetAttribute("SoftBodyParticles",&creationparams.softbodyparticles,false);  //Optional parameter
+	xmlelement->GetAttribute("SoftBodyStiffness",&creationparams.softbodystiffness,false);  //Optional parameter
+	if(creationparams.softbodyparticles < 0 || (creationparams.softbodyparticles > 0 && creationparams.softbodyparticles < 3))
+		throw GenericException("Failure while reading blob attributes - Bad value of SoftBodyParticles",GenericException::FILE_CONFIG_INCORRECT);
+	if(creationparams.softbodystiffness <= 0.0f || creationparams.softbodystiffness > 1.0f)
+		throw GenericException("Failure while reading blob attributes - Bad value of SoftBodyStiffness",GenericException::FILE_CONFIG_INCORRECT);
 
 	//TODO: CHECK ALL ATTRIBUTES!
 	//if(x<0 || y<0 || h<=0 || w<=0 || layer<0 || layer > 63 || lindamping < 0 || lindamping > 1 || angdamping < 0 || angdamping > 1 || (isstatic != 0 && isstatic != 1))
@@ -78,12 +93,38 @@ void  BlobBuilder::LoadBlob(const BlobParameters& params)
 	_load(params);
 }
 
-void BlobBuilder::_load(const BlobParameters& creationparams)
+void BlobBuilder::_load(const BlobParameters& blobparams)
 {
 	//--------Building of a blob soft body!!----------
 	//Creation of an object controller which will hold all created data together:
 	mBlobControllerptr = BlobControllerPointer(new BlobController(mRelatedAgent,mPhysicsMgr));  //Stored in a shared pointer
-	mBlobControllerptr->SetInitialParameters(creationparams);
+	mBlobControllerptr->SetInitialParameters(blobparams);
+
+	//Parameters used to build the bodies
+	BlobParameters creationparams(blobparams);
+	//IF - Soft body model selected: single skin of fewer and heavier masses, with the same total mass
+	if(creationparams.softbody)
+	{
+		if(creationparams.doubleskinned)
+		{
+			SingletonLogMgr::Instance()->AddNewLine("BlobBuilder::LoadBlob","Soft body blobs have a single skin, inner skin ignored",LOGDEBUG);
+			creationparams.doubleskinned = false;
+		}
+		//IF - Less masses wanted
+		if(creationparams.softbodyparticles > 0 && creationparams.softbodyparticles < creationparams.bodies)
+			creationparams.bodies = creationparams.softbodyparticles;
+		//Masses big enough to close the skin
+		float halfspacing = creationparams.radius * static_cast<float>(sin(SingletonMath::Instance()->Pi / creationparams.bodies));
+		float radiusratio(1.0f);
+		if(halfspacing > creationparams.massesradius)
+		{
+			radiusratio = creationparams.massesradius / halfspacing;
+			creationparams.massesradius = halfspacing;
+		}
+		float skinmassscale = static_cast<float>(blobparams.bodies) / static_cast<float>(creationparams.bodies);
+		creationparams.massesdensity *= skinmassscale * radiusratio * radiusratio;
+		mBlobControllerptr->SetSkinMassScale(skinmassscale);
+	}//IF
 	
 	//Total mass of blob
 	float totalblobmass(0.0f);   //Store of total computed mass of all bodies together in blob
@@ -119,6 +160,7 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 	innerbodydefinition.angularDamping = 0;
 	innerbodydefinition.fixedRotation = true;
 	innerbodydefinition.applyPosCorrection = false;		//Hack to Box2D to work correctly with friction and soft bodies
+	innerbodydefinition.isSoftBody = true;				//Island solved with soft body iterations
 	std::stringstream innerbodyname;
 	innerbodyname<<"Blob"<<mBlobsCreated<<"InnerMass";
 	//Create the body
@@ -134,6 +176,8 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 	innercircledefinition.filter.groupIndex = 1; //Never collide * But collide with outer masses
 	innercircledefinition.filter.categoryBits = 0x02;
 	innercircledefinition.filter.maskBits = 0x03; 
+	if(creationparams.softbody)
+		innercircledefinition.filter.maskBits = 0x01; //Soft body keeps the center inside, it only collides with the world
 	mPhysicsMgr->CreateCircleShape(&innercircledefinition,innerbodyname.str());
 	centerbody->SetMassFromShapes();
 	totalblobmass += centerbody->GetMass();
@@ -177,6 +221,49 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 		inskinspringdef.length = innerskindist;
 	}
 
+	//*****Soft body controller (optional)***********
+	//Keeps the shape by shape matching and pressure, instead of creating joints
+	b2SoftBodyController* softbodycontroller = NULL;
+	//IF - Soft body model selected
+	if(creationparams.softbody)
+	{
+		b2SoftBodyControllerDef softbodydef;
+		softbodydef.shapeStiffness = creationparams.softbodystiffness;
+		softbodycontroller = static_cast<b2SoftBodyController*>(mPhysicsMgr->CreateController(&softbodydef));
+		softbodycontroller->SetCenterBody(centerbody);
+		mBlobControllerptr->SetSoftBodyController(softbodycontroller);
+	}//IF
+
+	//*****Ring controller (optional)***********
+	//Solves all skin and radial springs at once, instead of creating joints
+	b2RingSpringController* ringcontroller = NULL;
+	//IF - Ring solver selected (and not a soft body)
+	if(creationparams.ringsolver && !softbodycontroller)
+	{
+		//IF - Single skin (the only supported by ring controller)
+		if(!creationparams.doubleskinned)
+		{
+			b2RingSpringControllerDef ringdef;
+			ringdef.skinLength = skinspringdef.length;
+			ringdef.skinFrequencyHz = skinspringdef.frequencyHz;
+			ringdef.skinDampingRatio = skinspringdef.dampingRatio;
+			ringdef.radialLength = springdef.length;
+			ringdef.radialFrequencyHz = springdef.frequencyHz;
+			ringdef.radialDampingRatio = springdef.dampingRatio;
+			ringdef.iterations = creationparams.ringsolveriterations;
+			ringcontroller = static_cast<b2RingSpringController*>(mPhysicsMgr->CreateController(&ringdef));
+			ringcontroller->SetCenterBody(centerbody);
+			mBlobControllerptr->SetRingController(ringcontroller);
+		}
+		else
+		{
+			SingletonLogMgr::Instance()->AddNewLine("BlobBuilder::LoadBlob","Ring solver not supported for double skinned blobs, using joints",LOGDEBUG);
+		}
+	}//IF
+
+	//Joints only created if no controller keeps the blob together
+	bool usejoints(!ringcontroller && !softbodycontroller);
+
 
 	//****Creation of blob************
 
@@ -206,11 +293,13 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 		b2Vec2 newposition = creationrotation + creationoffset;
 		bodydefinition.position = newposition;
 		bodydefinition.allowSleep = true;
-		bodydefinition.isBullet = true;
+		bodydefinition.isBullet = false;
+		bodydefinition.isSpeculative = true;	//Contacts one step ahead instead of TOI: thrown masses don't go through thin tiles
 		bodydefinition.linearDamping = 0;
 		bodydefinition.angularDamping = 0;
 		bodydefinition.fixedRotation = true;
 		bodydefinition.applyPosCorrection = false;		//Hack to Box2D to work correctly with friction and soft bodies
+		bodydefinition.isSoftBody = true;				//Island solved with soft body iterations
 		bodyname<<"Blob"<<mBlobsCreated<<"SubMass"<<i;
 		newbody = mPhysicsMgr->CreateBody(&bodydefinition,bodyname.str());
 		assert(newbody);
@@ -219,6 +308,12 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 		totalblobmass += newbody->GetMass();
 		//Assign user data pointer
 		newbody->SetUserData(mRelatedAgent);
+		//Springs solved by ring controller (added in ring order)
+		if(ringcontroller)
+			ringcontroller->AddBody(newbody);
+		//Shape kept by soft body controller (added in ring order)
+		if(softbodycontroller)
+			softbodycontroller->AddBody(newbody);
 
 		//*****Creation of inner skin body*******
 		if(creationparams.doubleskinned)
@@ -239,31 +334,35 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 		//IF - There was a previous body created
 		if(prevbody || ( creationparams.doubleskinned && prevbody && in_prevbody ))
 		{
-			std::stringstream jointname;
-			jointname<<"Blob"<<mBlobsCreated<<"Joint"<<bodyname.str()<<prevbodyname;
-			mPhysicsMgr->CreateDistanceJoint(&skinspringdef,  //Definition for skin spring joint
-											 jointname.str(),  //joint name
-											 prevbodyname,     //body name 1 (previous outer mass)
-											 bodyname.str(),   //body name 2 (outer mass)
-											 prevbody->GetPosition(), //body 1 position (previous outer mass)
-											 newbody->GetPosition()); //body 2 position (outer mass)
-			//Add joint to controller
-			mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(jointname.str())));
-			//Inner skin joints creation
-			if(creationparams.doubleskinned)
+			//IF - Springs not solved by a controller
+			if(usejoints)
 			{
-				std::stringstream in_jointname;
-				in_jointname<<"Blob"<<mBlobsCreated<<"Joint"<<in_bodyname.str()<<in_prevbodyname;
+				std::stringstream jointname;
+				jointname<<"Blob"<<mBlobsCreated<<"Joint"<<bodyname.str()<<prevbodyname;
 				mPhysicsMgr->CreateDistanceJoint(&skinspringdef,  //Definition for skin spring joint
-												 in_jointname.str(),  //joint name
-												 in_prevbodyname,     //body name 1 (previous inner mass)
-												 in_bodyname.str(),   //body name 2 (inner mass)
-												 in_prevbody->GetPosition(), //body 1 position (previous inner mass)
-												 in_newbody->GetPosition()); //body 2 position (inner mass)				
-
+												 jointname.str(),  //joint name
+												 prevbodyname,     //body name 1 (previous outer mass)
+												 bodyname.str(),   //body name 2 (outer mass)
+												 prevbody->GetPosition(), //body 1 position (previous outer mass)
+												 newbody->GetPosition()); //body 2 position (outer mass)
 				//Add joint to controller
-				mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(in_jointname.str())));
-			}
+				mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(jointname.str())));
+				//Inner skin joints creation
+				if(creationparams.doubleskinned)
+				{
+					std::stringstream in_jointname;
+					in_jointname<<"Blob"<<mBlobsCreated<<"Joint"<<in_bodyname.str()<<in_prevbodyname;
+					mPhysicsMgr->CreateDistanceJoint(&skinspringdef,  //Definition for skin spring joint
+													 in_jointname.str(),  //joint name
+													 in_prevbodyname,     //body name 1 (previous inner mass)
+													 in_bodyname.str(),   //body name 2 (inner mass)
+													 in_prevbody->GetPosition(), //body 1 position (previous inner mass)
+													 in_newbody->GetPosition()); //body 2 position (inner mass)				
+
+					//Add joint to controller
+					mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(in_jointname.str())));
+				}
+			}//IF
 		}//ELSE - There was no previous body created
 		else
 		{
@@ -281,8 +380,8 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 		}
 		
 		//Spring joints to center mass
-		//IF - Simple skin
-		if(!creationparams.doubleskinned)
+		//IF - Simple skin (and springs not solved by a controller)
+		if(!creationparams.doubleskinned && usejoints)
 		{
 			//Simple joint from outer skin to center
 			std::stringstream jointname;
@@ -297,7 +396,7 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 			mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(jointname.str())));
 
 		}//ELSE - Double skin
-		else
+		else if(creationparams.doubleskinned)
 		{
 			//Three joints : From outer skin to inner skin, from inner skin to center, and crossed interskin
 			//Interskinjoint
@@ -361,16 +460,20 @@ void BlobBuilder::_load(const BlobParameters& creationparams)
 
 	//*****Make final connection between last and first body*****
 	assert(firstbody);
-	std::stringstream jointname;
-	jointname<<"Blob"<<mBlobsCreated<<"FinalJoint";
-	mPhysicsMgr->CreateDistanceJoint(&skinspringdef,
-									 jointname.str(),
-									 firstbodyname,
-									 bodyname.str(),
-									 firstbody->GetPosition(),
-									 newbody->GetPosition());	
-	//Add joint to controller
-				mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(jointname.str())));
+	//IF - Springs not solved by a controller (it closes the ring itself)
+	if(usejoints)
+	{
+		std::stringstream jointname;
+		jointname<<"Blob"<<mBlobsCreated<<"FinalJoint";
+		mPhysicsMgr->CreateDistanceJoint(&skinspringdef,
+										 jointname.str(),
+										 firstbodyname,
+										 bodyname.str(),
+										 firstbody->GetPosition(),
+										 newbody->GetPosition());	
+		//Add joint to controller
+		mBlobControllerptr->AddJointToList(static_cast<b2DistanceJoint*>(mPhysicsMgr->GetJoint(jointname.str())));
+	}//IF
 	//IF - Double skin
 	if(creationparams.doubleskinned)
 	{
@@ -17,6 +17,8 @@
 
 //Constant variables definitions
 const float BlobController::BLOBBROKENTOLERANCE = 0.4f;
+const float BlobController::BLOBSLEEPSPEED = 0.1f;
+const float BlobController::BLOBSLEEPTIME = 500.0f;
 
 //Update bodies control
 void BlobController::Update(float dt)
@@ -51,6 +53,9 @@ void BlobController::Update(float dt)
 		mCurrentSpeed = Vector2(static_cast<double>(speed.x),
 								  static_cast<double>(speed.y));
 
+		//Sleep the blob as a whole when resting
+		_updateSleep(dt);
+
 
 		//Check "blob broken"
 		if(_blobBroken())
@@ -115,6 +120,21 @@ void BlobController::Sleep()
 	}//LOOP END
 
 	mCenterBody->PutToSleep();
+	mSleepCounter = 0.0f;
+}
+
+//Call to wake bodies
+void BlobController::WakeUp()
+{
+	BodiesVectorIterator it;
+	//LOOP - Wake every body
+	for(it = mBodiesVector.begin(); it != mBodiesVector.end(); ++it)
+	{	
+		(*it)->WakeUp();
+	}//LOOP END
+
+	mCenterBody->WakeUp();
+	mSleepCounter = 0.0f;
 }
 // Set the important center body and its related bounding sensor
 void BlobController::SetCenterBody(b2Body* body) 
@@ -140,6 +160,33 @@ void BlobController::AddJointToList(b2DistanceJoint* joint)
 	mJointsVector.push_back(joint);
 }
 
+//Change solve turns of ring controller (if used)
+void BlobController::SetRingSolverIterations(int iterations)
+{
+	assert(iterations > 0);
+	if(mRingController)
+		mRingController->iterations = iterations;
+}
+
+//Change springs stiffness of ring controller (if used)
+void BlobController::SetRingSolverStiffness(float skinfrequency, float radialfrequency)
+{
+	assert(skinfrequency >= 0.0f && radialfrequency >= 0.0f);
+	if(mRingController)
+	{
+		mRingController->skinFrequencyHz = skinfrequency;
+		mRingController->radialFrequencyHz = radialfrequency;
+	}
+}
+
+//Change shape matching stiffness of soft body controller (if used)
+void BlobController::SetSoftBodyStiffness(float stiffness)
+{
+	assert(stiffness > 0.0f && stiffness <= 1.0f);
+	if(mSoftBodyController)
+		mSoftBodyController->shapeStiffness = stiffness;
+}
+
 //Called to finish control and destroy related bodies and joints
 void BlobController::Destroy()
 {
@@ -149,6 +196,19 @@ void BlobController::Destroy()
 		//Store position of blob before destroying
 		b2Vec2 position = mCenterBody->GetPosition();
 
+		//Destroy ring controller first (it references the bodies)
+		if(mRingController)
+		{
+			mPhysicsMgr->DestroyController(mRingController);
+			mRingController = NULL;
+		}
+		//Destroy soft body controller first (it references the bodies)
+		if(mSoftBodyController)
+		{
+			mPhysicsMgr->DestroyController(mSoftBodyController);
+			mSoftBodyController = NULL;
+		}
+
 		//---Call destroy for every body---
 		BodiesVectorIterator it;
 		//LOOP - Destroy bodies
@@ -185,7 +245,7 @@ void BlobController::Destroy()
 			assert(bb.IsValid());
 
 			//Query for bodies affected by destroying (make them wet)
-			eventinfo.affectedbodies = mPhysicsMgr->QueryforBodies(bb,false);  //Dont include static bodies
+			mPhysicsMgr->QueryforBodies(bb,eventinfo.affectedbodies,false);  //Dont include static bodies
 		}
 		
 		SingletonGameEventMgr::Instance()->QueueEvent(
@@ -194,6 +254,29 @@ void BlobController::Destroy()
 	}//IF
 }
 
+//Back to state after creation (bodies, joints and controllers restored by physics manager)
+bool BlobController::Restart()
+{
+	//IF - Destroyed: bodies are gone
+	if(mDestroyed)
+		return false;
+
+	//Logic tracking
+	mIntegrity = mInitialParams.initialintegrity;
+	mCurrentRadius = mInitialParams.radius;
+	mDamaged = false;
+	mDamageFilterCounter = mInitialParams.damagefiltertime;
+	mApplyCollisionDamage = true;
+	mMoveCommand = false;
+	mMoveDirection = Vector2(0.0f,0.0f);
+	mCurrentSpeed = Vector2(0.0f,0.0f);
+	mSleepCounter = 0.0f;
+	mActive = true;
+	//Sensor collisions count is kept: restored contacts are removed as usual
+
+	return true;
+}
+
 //Call to know if the blob is about to "die"
 bool BlobController::IsIntegrityVeryLow()
 {
@@ -205,6 +288,13 @@ void BlobController::MoveBlob(const Vector2& direction)
 {
 	mMoveDirection = direction;
 	mMoveCommand = true;
+	//IF - Real movement (wake the blob to move)
+	if(direction.x != 0 || direction.y != 0)
+	{
+		if(mActive && mCenterBody->IsSleeping())
+			WakeUp();
+		mSleepCounter = 0.0f;
+	}//IF
 }
 
 //Command to move by force the blob
@@ -218,10 +308,13 @@ void BlobController::ApplyImpulseToBlob(const Vector2& force)
 		//Get force
 		b2Vec2 movforce(static_cast<float32>(force.x),
 						static_cast<float32>(force.y));
+		//Impulses wake the bodies one by one, wake the whole blob
+		WakeUp();
 		//Apply to center body
 		mCenterBody->ApplyImpulse(movforce,mCenterBody->GetPosition());
 		
-		//Apply to outer bodies
+		//Apply to outer bodies (heavier bodies get more, so all blobs get the same speed)
+		movforce *= mSkinMassScale;
 		BodiesVectorIterator it;
 		//LOOP - Apply force to outer bodies (scaled)
 		for(it = mBodiesVector.begin(); it != mBodiesVector.end(); ++it)
@@ -370,6 +463,26 @@ void BlobController::_handleDamage(float amount)
 	JointsVectorIterator it;
 	float totallength = mInitialParams.radius;
 	float toreduce = (amount>1.5*mDamageForce) ? mInitialParams.radius/10.0f : mInitialParams.radius/30.0f;
+	//IF - Springs solved by ring controller (all radial springs have the same length)
+	if(mRingController)
+	{
+		mRingController->radialLength -= toreduce;
+		//IF - Length is smaller than a minimum
+		if(mRingController->radialLength < 0.10f * totallength)
+			mRingController->radialLength = 0.10f * totallength;
+		//Store radius tracking
+		mCurrentRadius = mRingController->radialLength;
+	}//IF
+	//IF - Shape kept by soft body controller (scale the rest shape)
+	if(mSoftBodyController)
+	{
+		mSoftBodyController->scale -= toreduce / totallength;
+		//IF - Scale is smaller than a minimum
+		if(mSoftBodyController->scale < 0.10f)
+			mSoftBodyController->scale = 0.10f;
+		//Store radius tracking
+		mCurrentRadius = mSoftBodyController->scale * totallength;
+	}//IF
 	//LOOP - Set tocenter joints length
 	for(it = mJointsVector.begin(); it != mJointsVector.end(); ++it)
 	{	
@@ -422,6 +535,26 @@ void BlobController::_handleHealth()
 	JointsVectorIterator it;
 	float totallength = mInitialParams.radius;
 	float toincrement = mInitialParams.radius/30.0f;
+	//IF - Springs solved by ring controller (all radial springs have the same length)
+	if(mRingController)
+	{
+		mRingController->radialLength += toincrement;
+		//IF - Length is bigger than start
+		if(mRingController->radialLength > totallength)
+			mRingController->radialLength = totallength;
+		//Store radius tracking
+		mCurrentRadius = mRingController->radialLength;
+	}//IF
+	//IF - Shape kept by soft body controller (scale the rest shape)
+	if(mSoftBodyController)
+	{
+		mSoftBodyController->scale += toincrement / totallength;
+		//IF - Scale is bigger than start
+		if(mSoftBodyController->scale > 1.0f)
+			mSoftBodyController->scale = 1.0f;
+		//Store radius tracking
+		mCurrentRadius = mSoftBodyController->scale * totallength;
+	}//IF
 
 	//LOOP - Set tocenter joints length
 	for(it = mJointsVector.begin(); it != mJointsVector.end(); ++it)
@@ -489,7 +622,7 @@ bool BlobController::IsBodyInBlob(b2Body* thebody)
 bool BlobController::_blobBroken()
 {
 	//Local variables
-	int bodiescount(mInitialParams.bodies);
+	int bodiescount(mSoftBodyController ? static_cast<int>(mBodiesVector.size()) : mInitialParams.bodies);	//Soft body blobs have their own masses count
 	int bodxbigger(0);
 	int bodybigger(0);
 	int bodxsmaller(0);
@@ -521,4 +654,58 @@ bool BlobController::_blobBroken()
 			 ||
 			  bodysmaller == bodiescount);
 	return(broken);
-}
\ No newline at end of file
+}
+
+//Aggregate sleeping: the skin masses jiggle on the springs, so the bodies never rest at the
+//same time as Box2D needs to sleep them. The kinetic energy of the center body and the mean of
+//the skin masses are measured instead, and the whole blob (bodies and joints) sleeps as a unit.
+//A move command or an impulse wakes it, and so does a contact from an awake body (same island)
+void BlobController::_updateSleep(float dt)
+{
+	//IF - Already sleeping
+	if(mCenterBody->IsSleeping())
+	{
+		mSleepCounter = 0.0f;
+		return;
+	}
+
+	//Energy per unit of mass of a resting blob
+	float restenergy(0.5f * BLOBSLEEPSPEED * BLOBSLEEPSPEED);
+
+	//Center body energy
+	float centermass(mCenterBody->GetMass());
+	b2Vec2 centerspeed(mCenterBody->GetLinearVelocity());
+	float centerangspeed(mCenterBody->GetAngularVelocity());
+	float centerenergy(0.5f * (centermass * b2Dot(centerspeed,centerspeed) + mCenterBody->GetInertia() * centerangspeed * centerangspeed));
+
+	//Skin energy
+	float skinmass(0.0f);
+	float skinenergy(0.0f);
+	BodiesVectorIterator it;
+	//LOOP - Add energy of skin masses
+	for(it = mBodiesVector.begin(); it != mBodiesVector.end(); ++it)
+	{
+		b2Body* body = (*it);
+		b2Vec2 bodyspeed(body->GetLinearVelocity());
+		float bodyangspeed(body->GetAngularVelocity());
+		skinmass += body->GetMass();
+		skinenergy += 0.5f * (body->GetMass() * b2Dot(bodyspeed,bodyspeed) + body->GetInertia() * bodyangspeed * bodyangspeed);
+	}//LOOP END
+
+	//IF - Center and skin resting
+	if(mMoveCommand == false
+	   &&
+	   centerenergy <= restenergy * centermass
+	   &&
+	   skinenergy <= restenergy * skinmass)
+	{
+		mSleepCounter += dt;
+		//IF - Resting long enough
+		if(mSleepCounter >= BLOBSLEEPTIME)
+			Sleep();
+	}
+	else
+	{
+		mSleepCounter = 0.0f;
+	}//IF
+}
@@ -25,6 +25,8 @@
 class b2Body;
 class b2Shape;
 class b2DistanceJoint;
+class b2RingSpringController;
+class b2SoftBodyController;
 class CollisionEventData;
 struct ContactInfo;
 class IAgent;
@@ -57,7 +59,12 @@ public:
 	innermassdensity(0.8f),
 	doubleskinned(false),
 	innerskinradius(2.0f),
-	initialintegrity(100.0f)
+	initialintegrity(100.0f),
+	ringsolver(false),
+	ringsolveriterations(2),
+	softbody(false),
+	softbodyparticles(0),
+	softbodystiffness(0.05f)
 	{}
 	//Creation parameters for a blob
 	float initialx,initialy;
@@ -70,6 +77,11 @@ public:
 	bool doubleskinned;
 	float innerskinradius;
 	float initialintegrity;
+	bool ringsolver;			//Solve skin and radial springs with a ring controller instead of joints (single skin only)
+	int ringsolveriterations;	//Skin / radial solve turns per step of the ring controller
+	bool softbody;				//Keep the shape by shape matching and pressure instead of joints (soft body controller)
+	int softbodyparticles;		//Masses of a soft body blob (0 to use "bodies")
+	float softbodystiffness;	//Shape matching stiffness of a soft body blob (0..1]
 };
 
 class BlobController
@@ -98,6 +110,9 @@ public:
 	  mDestroyed(false),
 	  mApplyCollisionDamage(true),
 	  mCenterBody(NULL),
+	  mRingController(NULL),
+	  mSoftBodyController(NULL),
+	  mSkinMassScale(1.0f),
 	  mBoundingCollisions(0), 
 	  mIntegrity(100.0f),
 	  mCurrentRadius(2.0f),
@@ -107,7 +122,8 @@ public:
 	  mIsMainBlob(true),
 	  mTotalMass(10.0f),
 	  mAffectWhenDying(true),
-	  mMainBlob(false)
+	  mMainBlob(false),
+	  mSleepCounter(0.0f)
 	{
 	}
 	~BlobController()
@@ -130,14 +146,24 @@ public:
 	float GetIntegrity() const { return mIntegrity; }
 	float GetIntegrityPercent() const { return mIntegrity / mInitialParams.initialintegrity; }
 	void DisableAffectBodiesWhenDeath() { mAffectWhenDying = false; }
+	void SetRingController(b2RingSpringController* controller) { assert(controller); mRingController = controller; }  //Springs solved by a ring controller (used in creation step)
+	b2RingSpringController* GetRingController() const { return mRingController; }
+	void SetRingSolverIterations(int iterations);	//Change solve turns of ring controller (if used)
+	void SetRingSolverStiffness(float skinfrequency, float radialfrequency);	//Change springs stiffness of ring controller (if used)
+	void SetSoftBodyController(b2SoftBodyController* controller) { assert(controller); mSoftBodyController = controller; }  //Shape kept by a soft body controller (used in creation step)
+	b2SoftBodyController* GetSoftBodyController() const { return mSoftBodyController; }
+	void SetSoftBodyStiffness(float stiffness);	//Change shape matching stiffness of soft body controller (if used)
+	void SetSkinMassScale(float scale) { assert(scale > 0.0f); mSkinMassScale = scale; }	//Mass of skin bodies relative to "bodies" masses (used in creation step)
 	//----- OTHER FUNCTIONS -----
 	void StartControlling(bool ismainblob);				 //Call to start logic of controller (finished creation)
 	void StopControlling();					//Call to stop control
 	void Sleep();							//Call to sleep bodies
+	void WakeUp();							//Call to wake bodies
 	void Update(float dt);					  //Update callback
 	void AddBodyToControl(b2Body* body);	  //Add a body (used in creation step)
 	void AddJointToList(b2DistanceJoint* joint);	//Add a joint created (used in creation step)
 	void Destroy();		//Called to finish control and destroy related bodies and joints
+	bool Restart();		//Back to state after creation (bodies, joints and controllers restored by physics manager)
 	bool HandleCollision(const CollisionEventData& data);	//Process possible collisions
 
 	//Logic 
@@ -158,11 +184,16 @@ private:
 	//----- INTERNAL VARIABLES -----
 	BlobParameters mInitialParams;	//Initial creation parameters
 	static const float BLOBBROKENTOLERANCE;	//Broken tolerance ratio
+	static const float BLOBSLEEPSPEED;		//Mean speed of center and skin under which the blob is resting
+	static const float BLOBSLEEPTIME;		//Resting time to put the whole blob to sleep
 	IAgent* mRelatedAgent;			//Related agent
 	PhysicsManagerPointer mPhysicsMgr; //Physics manager
 	BodiesVector mBodiesVector;	//Bodies composing the blob
 	JointsVector mJointsVector; //Joints composing the blob
 	b2Body* mCenterBody;		//The center body
+	b2RingSpringController* mRingController;	//Ring controller solving the springs (NULL if joints are used)
+	b2SoftBodyController* mSoftBodyController;	//Soft body controller keeping the shape (NULL if not used)
+	float mSkinMassScale;		//Soft body blobs have fewer and heavier skin bodies
 	bool mActive;				//Active tracking
 	bool mMoveCommand;			//Move command tracking
 	bool mDestroyed;			//Destroyed tracking
@@ -184,6 +215,7 @@ private:
 	float mDamageFilterCounter;	//Filtering collision damage counter
 	float mTotalMass;			//Total mass of blob: Used to scale impact forces
 	bool mMainBlob;				//Is the currently controlled blob?
+	float mSleepCounter;		//Time the blob has been resting (aggregate sleeping)
 
 	bool mApplyCollisionDamage;	//To disable damage temporary
 
@@ -191,6 +223,7 @@ private:
 	void _handleDamage(float amount);  //Internal handle damage function
 	void _handleHealth();				//Internal health function
 	bool _blobBroken();					//"Blob broken" tracking
+	void _updateSleep(float dt);		//Aggregate sleeping: put the whole blob to sleep when it rests
 	
 };
 
@@ -38,6 +38,53 @@ For discussion please visit http://www.box2d.org/forum
 	  File: b2Island.h b2Island.cpp b2World.h b2World.cpp
 	- MODIFY BODIES TO ADD A FLAG TO RESET POSITION CORRECTION (USED FOR SOFT BODIES ONLY) Files: b2Body.h b2Body.cpp 
 	  THIS FLAG WILL DISABLE POSITION CORRECTION IN BODIES OF SOME ISLAND Files: b2Island.h b2Island.cpp b2World.cpp
+	- DYNAMIC AABB TREE BROAD-PHASE, SELECTABLE AT WORLD CREATION (SWEEP AND PRUNE STAYS THE DEFAULT)
+	  Files: b2DynamicTree.h b2DynamicTree.cpp b2BroadPhase.h b2BroadPhase.cpp b2PairManager.cpp b2Settings.h b2World.h b2World.cpp
+	- GROWABLE OPEN ADDRESSING PAIR TABLE WITH 32 BIT PROXY IDS (NO b2_maxPairs LIMIT), PAIR TABLE STATISTICS
+	  Files: b2PairManager.h b2PairManager.cpp b2BroadPhase.h b2BroadPhase.cpp b2Shape.h b2Settings.h b2World.h b2World.cpp
+	- PARALLEL ISLAND SOLVING: ISLANDS FOUND FIRST, THEN SOLVED ON A THREAD POOL. CONTACT RESULTS REPORTED IN SERIAL ORDER
+	  Files: b2ThreadPool.h b2ThreadPool.cpp b2World.h b2World.cpp
+	- SIMD CONTACT SOLVER MODE: SINGLE POINT CONTACTS COLORED AND SOLVED 4 AT A TIME (SSE), SOLVER STATISTICS
+	  Files: b2ContactSolver.h b2ContactSolver.cpp b2ContactSolverSIMD.cpp b2Island.h b2Island.cpp b2World.h b2World.cpp
+	- RING SPRING CONTROLLER: BLOB SKIN AND RADIAL SPRINGS SOLVED AS CYCLIC SYSTEMS. CONTROLLERS CAN BIND THEIR BODIES IN ONE ISLAND,
+	  BODY LIST FUNCTIONS ARE VIRTUAL, THE WORLD DESTROYS THE CONTROLLERS LEFT
+	  Files: b2RingSpringController.h b2RingSpringController.cpp b2Controller.h b2World.cpp
+	- SOFT BODY CONTROLLER: BLOBS KEPT BY SHAPE MATCHING AND A GAS PRESSURE (AREA) CONSTRAINT, WITHOUT JOINTS
+	  Files: b2SoftBodyController.h b2SoftBodyController.cpp
+	- SPECULATIVE CONTACTS: CIRCLE CONTACTS OF SPECULATIVE BODIES CREATED ONE STEP AHEAD AND SOLVED BY THE CONTACT SOLVER, WITHOUT TOI.
+	  POINTS AHEAD OF THE SHAPES ARE NOT REPORTED TO THE LISTENER
+	  Files: b2Body.h b2Body.cpp b2World.cpp b2Collision.h b2CollideCircle.cpp b2Contact.h b2Contact.cpp b2CircleContact.cpp
+	  b2PolyAndCircleContact.cpp b2EdgeAndCircleContact.h b2EdgeAndCircleContact.cpp b2ContactManager.cpp b2Island.cpp
+	- TOI EVENT QUEUE: TIMES OF IMPACT KEPT IN A HEAP, ONLY CONTACTS OF THE BODIES MOVED BY A SUB-STEP COMPUTED AGAIN. TOI STATISTICS
+	  Files: b2TOIQueue.h b2TOIQueue.cpp b2Timer.h b2Timer.cpp b2Contact.h b2Contact.cpp b2ContactManager.cpp b2World.h b2World.cpp
+	- PERSISTENT ISLANDS: ISLANDS KEPT BETWEEN STEPS (UNION-FIND), SPLIT AT THE NEXT STEP. ONLY AWAKE ISLANDS ARE VISITED BY THE STEP.
+	  AN ISLAND SLEEPS AND WAKES AS A WHOLE (CHECKED IN _DEBUG)
+	  Files: b2Body.h b2Body.cpp b2World.h b2World.cpp b2Contact.cpp b2ContactManager.cpp b2Controller.h b2Controller.cpp
+	- CALLBACK QUERIES: AABB QUERIES AND RAY CASTS REPORTING SHAPES TO A CALLBACK (NO COUNT LIMIT, EARLY EXIT, NO ALLOCATIONS).
+	  FIXED ONE PAST THE END WRITE IN SORTED SEGMENT QUERIES
+	  Files: b2WorldCallbacks.h b2World.h b2World.cpp b2BroadPhase.h b2BroadPhase.cpp
+	- WORLD SNAPSHOTS: JOINTS AND CONTROLLERS STATE CAN BE COPIED AND RESTORED (WARM STARTING IMPULSES AND RUN TIME VALUES).
+	  WORLD CONTACT LIST ACCESS. ISLANDS WOKEN OR PUT TO SLEEP AS A WHOLE, BODY FORCES CLEARED
+	  Files: b2Body.h b2World.cpp b2Joint.h b2DistanceJoint.h/.cpp b2GearJoint.h/.cpp b2LineJoint.h/.cpp b2MouseJoint.h/.cpp b2PrismaticJoint.h/.cpp
+	         b2PulleyJoint.h/.cpp b2RevoluteJoint.h/.cpp b2Controller.h b2RingSpringController.h/.cpp b2SoftBodyController.h/.cpp b2World.h
+	- STEP PROFILING: TIME OF THE PHASES OF THE STEP (LAST STEP AND ROLLING AVERAGE) AND WORLD COUNTS. CONTACT CALLBACKS ARE TIMED
+	  Files: b2World.h b2World.cpp
+	- SEPARATION BOUND: CONTACTS WITHOUT POINTS KEEP A LOWER BOUND OF THE DISTANCE OF THEIR SHAPES, NOT UPDATED WHILE THE BODIES MOVED LESS.
+	  POLYGON AND CIRCLE CONTACTS CAN KEEP THEIR MANIFOLD IF THE SHAPES ALMOST DIDNT MOVE (APPROXIMATE, OFF BY DEFAULT). NARROW-PHASE STATISTICS
+	  Files: b2Contact.h b2Contact.cpp b2PolyAndCircleContact.h b2PolyAndCircleContact.cpp b2ContactManager.cpp b2World.h b2World.cpp
+	- ALLOCATOR STATISTICS: STACK ALLOCATOR ARENA ALLOCATED AT RUN TIME, GROWING TO THE HIGH-WATER MARK WHEN ALL IS FREED.
+	  BLOCK ALLOCATOR COUNTERS BY SIZE CLASS. SOLVER WORKERS OWN A STACK AND A BLOCK ALLOCATOR
+	  Files: b2StackAllocator.h b2StackAllocator.cpp b2BlockAllocator.h b2BlockAllocator.cpp b2World.h b2World.cpp
+	- ADAPTIVE ITERATIONS: ISLANDS CLASSIFIED AS DEFAULT, STACK OR SOFT BODY (BODY FLAG), EACH CLASS WITH ITS OWN ITERATIONS.
+	  VELOCITY ITERATIONS STOP WHEN BODY VELOCITIES SETTLE (OPTIONAL). ITERATION COUNTERS AND HISTOGRAMS OF THE LAST STEP
+	  Files: b2Settings.h b2Body.h b2Body.cpp b2Island.h b2Island.cpp b2World.h b2World.cpp
+	- MATERIAL TABLE: WORLD MATERIALS (FRICTION AND RESTITUTION) REFERENCED BY SHAPES. CONTACTS MIX THEM WHEN SOLVED AND
+	  REPORTED, SO CHANGING A MATERIAL OR A SHAPE FRICTION NEEDS NO REFILTER
+	  Files: b2Settings.h b2Shape.h b2Shape.cpp b2Contact.h b2Contact.cpp b2ContactSolver.cpp b2ContactManager.cpp b2World.h
+	  b2World.cpp b2CircleContact.cpp b2PolyContact.cpp b2PolyAndCircleContact.cpp b2EdgeAndCircleContact.cpp b2PolyAndEdgeContact.cpp
+	- TRIGGER VOLUMES: TRIGGER SHAPES (SENSORS) CREATE NO CONTACTS. THEIR BROAD-PHASE PAIRS ARE TESTED FOR OVERLAP AT THE
+	  END OF THE STEP AND REPORTED AS ENTER/EXIT TO A TRIGGER LISTENER. TRIGGER PAIR COUNTERS OF THE LAST STEP
+	  Files: b2Shape.h b2Shape.cpp b2WorldCallbacks.h b2ContactManager.h b2ContactManager.cpp b2World.h b2World.cpp
 */
 
 #include "Common/b2Settings.h"
@@ -65,5 +112,9 @@ For discussion please visit http://www.box2d.org/forum
 #include "Dynamics/Controllers/b2ConstantAccelController.h"
 #include "Dynamics/Controllers/b2GravityController.h"
 #include "Dynamics/Controllers/b2TensorDampingController.h"
+//MIGUEL MODIFICATION: Direct solver for rings of springs
+#include "Dynamics/Controllers/b2RingSpringController.h"
+//MIGUEL MODIFICATION: Shape matching / pressure soft bodies
+#include "Dynamics/Controllers/b2SoftBodyController.h"
 
 #endif
@@ -81,6 +81,7 @@ b2Shape::b2Shape(const b2ShapeDef* def)
 	m_userData = def->userData;
 	m_friction = def->friction;
 	m_restitution = def->restitution;
+	m_material = def->material;	//MIGUEL MODIFICATION: Material table
 	m_density = def->density;
 	m_body = NULL;
 	m_sweepRadius = 0.0f;
@@ -92,6 +93,10 @@ b2Shape::b2Shape(const b2ShapeDef* def)
 	m_filter = def->filter;
 
 	m_isSensor = def->isSensor;
+
+	//MIGUEL MODIFICATION: Trigger volumes. Triggers are sensors for the rest of the engine (ray casts...)
+	m_isTrigger = def->isTrigger;
+	m_isSensor = m_isSensor || m_isTrigger;
 }
 
 b2Shape::~b2Shape()
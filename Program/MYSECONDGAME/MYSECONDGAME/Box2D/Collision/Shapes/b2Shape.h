@@ -73,6 +73,18 @@ enum b2SegmentCollide
 	e_hitCollide = 1
 };
 
+//MIGUEL MODIFICATION: Material table
+/// Friction and restitution shared by the shapes which reference it (b2World::CreateMaterial).
+/// Changing a material changes the contacts of its shapes from the next step on.
+struct b2Material
+{
+	float32 friction;
+	float32 restitution;
+};
+
+/// Shapes with this material use their own friction and restitution.
+const int32 b2_nullMaterial = -1;
+
 /// A shape definition is used to construct a shape. This class defines an
 /// abstract shape definition. You can reuse shape definitions safely.
 struct b2ShapeDef
@@ -89,6 +101,8 @@ struct b2ShapeDef
 		filter.maskBits = 0xFFFF;
 		filter.groupIndex = 0;
 		isSensor = false;
+		material = b2_nullMaterial;
+		isTrigger = false;
 	}
 
 	virtual ~b2ShapeDef() {}
@@ -114,6 +128,15 @@ struct b2ShapeDef
 
 	/// Contact filtering data.
 	b2FilterData filter;
+
+	/// MIGUEL MODIFICATION: Material table
+	/// The world material of the shape. Its friction and restitution replace the ones above.
+	int32 material;
+
+	/// MIGUEL MODIFICATION: Trigger volumes
+	/// A trigger shape is a sensor which creates no contacts: overlapping shapes are tested each
+	/// step and reported to the b2TriggerListener when they enter or exit it.
+	bool isTrigger;
 };
 
 /// A shape is used for collision detection. Shapes are created in b2World.
@@ -130,6 +153,9 @@ public:
 	/// @return the true if the shape is a sensor.
 	bool IsSensor() const;
 
+	/// MIGUEL MODIFICATION: Trigger volumes. Is this shape a trigger (sensor without contacts)?
+	bool IsTrigger() const;
+
 	/// Set the contact filtering data. You must call b2World::Refilter to correct
 	/// existing contacts/non-contacts.
 	void SetFilterData(const b2FilterData& filter);
@@ -221,6 +247,13 @@ public:
 	/// Set the density of the shape.
 	void SetDensity(float32 density);
 
+	/// MIGUEL MODIFICATION: Material table. Get the world material of the shape (b2_nullMaterial if none).
+	int32 GetMaterial() const;
+
+	/// MIGUEL MODIFICATION: Material table. Set the world material of the shape. Existing contacts
+	/// use it from the next step on: no need to call b2World::Refilter.
+	void SetMaterial(int32 material);
+
 protected:
 
 	friend class b2Body;
@@ -249,11 +282,13 @@ protected:
 	float32 m_density;
 	float32 m_friction;
 	float32 m_restitution;
+	int32 m_material;	//MIGUEL MODIFICATION: Material table
 
-	uint16 m_proxyId;
+	int32 m_proxyId;
 	b2FilterData m_filter;
 
 	bool m_isSensor;
+	bool m_isTrigger;	//MIGUEL MODIFICATION: Trigger volumes
 
 	void* m_userData;
 };
@@ -268,6 +303,12 @@ inline bool b2Shape::IsSensor() const
 	return m_isSensor;
 }
 
+//MIGUEL MODIFICATION: Trigger volumes
+inline bool b2Shape::IsTrigger() const
+{
+	return m_isTrigger;
+}
+
 inline void b2Shape::SetFilterData(const b2FilterData& filter)
 {
 	m_filter = filter;
@@ -323,6 +364,18 @@ inline void b2Shape::SetRestitution(float32 restitution)
 	m_restitution = restitution;
 }
 
+//MIGUEL MODIFICATION: Material table
+inline int32 b2Shape::GetMaterial() const
+{
+	return m_material;
+}
+
+inline void b2Shape::SetMaterial(int32 material)
+{
+	b2Assert(material == b2_nullMaterial || (0 <= material && material < b2_maxMaterials));
+	m_material = material;
+}
+
 
 inline float32 b2Shape::GetDensity() const
 {
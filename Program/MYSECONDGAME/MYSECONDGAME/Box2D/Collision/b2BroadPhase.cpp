@@ -65,9 +65,10 @@ static int32 BinarySearch(b2Bound* bounds, int32 count, uint16 value)
 	return low;
 }
 
-b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
+b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback, b2BroadPhaseType type)
 {
 	m_pairManager.Initialize(this, callback);
+	m_type = type;
 
 	b2Assert(worldAABB.IsValid());
 	m_worldAABB = worldAABB;
@@ -77,6 +78,27 @@ b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
 	m_quantizationFactor.x = float32(B2BROADPHASE_MAX) / d.x;
 	m_quantizationFactor.y = float32(B2BROADPHASE_MAX) / d.y;
 
+	m_timeStamp = 1;
+	m_queryResultCount = 0;
+
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase. The tree grows on demand, it needs none of the arrays below
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		m_proxyPool = NULL;
+		m_freeProxy = b2_nullSAPProxy;
+		m_bounds[0] = NULL;
+		m_bounds[1] = NULL;
+		m_queryResults = NULL;
+		m_querySortKeys = NULL;
+		return;
+	}
+
+	m_proxyPool = (b2Proxy*)b2Alloc(b2_maxProxies * sizeof(b2Proxy));
+	m_bounds[0] = (b2Bound*)b2Alloc(2 * b2_maxProxies * sizeof(b2Bound));
+	m_bounds[1] = (b2Bound*)b2Alloc(2 * b2_maxProxies * sizeof(b2Bound));
+	m_queryResults = (int32*)b2Alloc(b2_maxProxies * sizeof(int32));
+	m_querySortKeys = (float32*)b2Alloc(b2_maxProxies * sizeof(float32));
+
 	for (uint16 i = 0; i < b2_maxProxies - 1; ++i)
 	{
 		m_proxyPool[i].SetNext(i + 1);
@@ -84,18 +106,24 @@ b2BroadPhase::b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback)
 		m_proxyPool[i].overlapCount = b2_invalid;
 		m_proxyPool[i].userData = NULL;
 	}
-	m_proxyPool[b2_maxProxies-1].SetNext(b2_nullProxy);
+	m_proxyPool[b2_maxProxies-1].SetNext(b2_nullSAPProxy);
 	m_proxyPool[b2_maxProxies-1].timeStamp = 0;
 	m_proxyPool[b2_maxProxies-1].overlapCount = b2_invalid;
 	m_proxyPool[b2_maxProxies-1].userData = NULL;
 	m_freeProxy = 0;
-
-	m_timeStamp = 1;
-	m_queryResultCount = 0;
 }
 
 b2BroadPhase::~b2BroadPhase()
 {
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_sweepAndPruneBroadPhase)
+	{
+		b2Free(m_proxyPool);
+		b2Free(m_bounds[0]);
+		b2Free(m_bounds[1]);
+		b2Free(m_queryResults);
+		b2Free(m_querySortKeys);
+	}
 }
 
 // This one is only used for validation.
@@ -185,7 +213,7 @@ void b2BroadPhase::IncrementOverlapCount(int32 proxyId)
 	{
 		proxy->overlapCount = 2;
 		b2Assert(m_queryResultCount < b2_maxProxies);
-		m_queryResults[m_queryResultCount] = (uint16)proxyId;
+		m_queryResults[m_queryResultCount] = proxyId;
 		++m_queryResultCount;
 	}
 }
@@ -236,10 +264,16 @@ void b2BroadPhase::Query(int32* lowerQueryOut, int32* upperQueryOut,
 	*upperQueryOut = upperQuery;
 }
 
-uint16 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
+int32 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 {
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		return CreateTreeProxy(aabb, userData);
+	}
+
 	b2Assert(m_proxyCount < b2_maxProxies);
-	b2Assert(m_freeProxy != b2_nullProxy);
+	b2Assert(m_freeProxy != b2_nullSAPProxy);
 
 	uint16 proxyId = m_freeProxy;
 	b2Proxy* proxy = m_proxyPool + proxyId;
@@ -324,6 +358,13 @@ uint16 b2BroadPhase::CreateProxy(const b2AABB& aabb, void* userData)
 
 void b2BroadPhase::DestroyProxy(int32 proxyId)
 {
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		DestroyTreeProxy(proxyId);
+		return;
+	}
+
 	b2Assert(0 < m_proxyCount && m_proxyCount <= b2_maxProxies);
 	b2Proxy* proxy = m_proxyPool + proxyId;
 	b2Assert(proxy->IsValid());
@@ -400,7 +441,14 @@ void b2BroadPhase::DestroyProxy(int32 proxyId)
 
 void b2BroadPhase::MoveProxy(int32 proxyId, const b2AABB& aabb)
 {
-	if (proxyId == b2_nullProxy || b2_maxProxies <= proxyId)
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		MoveTreeProxy(proxyId, aabb);
+		return;
+	}
+
+	if (proxyId < 0 || b2_maxProxies <= proxyId)
 	{
 		b2Assert(false);
 		return;
@@ -609,6 +657,31 @@ void b2BroadPhase::Commit()
 
 int32 b2BroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
 {
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		return QueryTree(aabb, userData, maxCount);
+	}
+
+	//MIGUEL MODIFICATION: Callback queries
+	int32 resultCount = GatherQuery(aabb);
+
+	int32 count = 0;
+	for (int32 i = 0; i < resultCount && count < maxCount; ++i, ++count)
+	{
+		userData[i] = m_proxyPool[m_queryResults[i]].userData;
+	}
+
+	ClearQuery();
+
+	return count;
+}
+
+//MIGUEL MODIFICATION: Callback queries
+int32 b2BroadPhase::GatherQuery(const b2AABB& aabb)
+{
+	b2Assert(m_type == e_sweepAndPruneBroadPhase);
+
 	uint16 lowerValues[2];
 	uint16 upperValues[2];
 	ComputeBounds(lowerValues, upperValues, aabb);
@@ -620,24 +693,37 @@ int32 b2BroadPhase::Query(const b2AABB& aabb, void** userData, int32 maxCount)
 
 	b2Assert(m_queryResultCount < b2_maxProxies);
 
-	int32 count = 0;
-	for (int32 i = 0; i < m_queryResultCount && count < maxCount; ++i, ++count)
+#ifdef _DEBUG
+	for (int32 i = 0; i < m_queryResultCount; ++i)
 	{
 		b2Assert(m_queryResults[i] < b2_maxProxies);
-		b2Proxy* proxy = m_proxyPool + m_queryResults[i];
-		b2Assert(proxy->IsValid());
-		userData[i] = proxy->userData;
+		b2Assert(m_proxyPool[m_queryResults[i]].IsValid());
 	}
+#endif
 
+	return m_queryResultCount;
+}
+
+void b2BroadPhase::ClearQuery()
+{
 	// Prepare for next query.
 	m_queryResultCount = 0;
-	IncrementTimeStamp();
-
-	return count;
+	if (m_type == e_sweepAndPruneBroadPhase)
+	{
+		IncrementTimeStamp();
+	}
 }
 
 void b2BroadPhase::Validate()
 {
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		m_tree.Validate();
+		b2Assert(m_tree.GetProxyCount() == m_proxyCount);
+		return;
+	}
+
 	for (int32 axis = 0; axis < 2; ++axis)
 	{
 		b2Bound* bounds = m_bounds[axis];
@@ -649,7 +735,7 @@ void b2BroadPhase::Validate()
 		{
 			b2Bound* bound = bounds + i;
 			b2Assert(i == 0 || bounds[i-1].value <= bound->value);
-			b2Assert(bound->proxyId != b2_nullProxy);
+			b2Assert(bound->proxyId != b2_nullSAPProxy);
 			b2Assert(m_proxyPool[bound->proxyId].IsValid());
 
 			if (bound->IsLower() == true)
@@ -669,8 +755,59 @@ void b2BroadPhase::Validate()
 }
 
 
+//MIGUEL MODIFICATION: Dynamic tree broad-phase
+// Segment query callback that copies user data up to a maximum count (sorted by the segment query).
+class b2SegmentCollectQuery
+{
+public:
+	bool QueryCallback(void* proxyUserData)
+	{
+		userData[count] = proxyUserData;
+		++count;
+		return count < maxCount;
+	}
+
+	void** userData;
+	int32 maxCount;
+	int32 count;
+};
+
 int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey)
 {
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		if (maxCount <= 0)
+		{
+			return 0;
+		}
+
+		b2SegmentCollectQuery query;
+		query.userData = userData;
+		query.maxCount = maxCount;
+		query.count = 0;
+		QuerySegment(&query, segment, sortKey);
+		return query.count;
+	}
+
+	//MIGUEL MODIFICATION: Callback queries
+	int32 count = GatherSegment(segment, maxCount, sortKey);
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		userData[i] = GetUserData(m_queryResults[i]);
+	}
+
+	ClearQuery();
+
+	return count;
+}
+
+//MIGUEL MODIFICATION: Callback queries
+int32 b2BroadPhase::GatherSegment(const b2Segment& segment, int32 maxCount, SortKeyFunc sortKey)
+{
+	b2Assert(m_type == e_sweepAndPruneBroadPhase);
+
 	float32 maxLambda = 1;
 
 	float32 dx = (segment.p2.x-segment.p1.x)*m_quantizationFactor.x;
@@ -729,7 +866,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 			{
 				m_querySortKeys[i+1] = a;
 				m_querySortKeys[i]   = b;
-				uint16 tempValue = m_queryResults[i+1];
+				int32 tempValue = m_queryResults[i+1];
 				m_queryResults[i+1] = m_queryResults[i];
 				m_queryResults[i] = tempValue;
 				i--;
@@ -781,7 +918,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 							//Add the proxy
 							if(sortKey)
 							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
+								AddProxyResult(proxyId,proxy->userData,maxCount,sortKey);
 							}
 							else
 							{
@@ -797,7 +934,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 							//Add the proxy
 							if(sortKey)
 							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
+								AddProxyResult(proxyId,proxy->userData,maxCount,sortKey);
 							}
 							else
 							{
@@ -844,7 +981,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 							//Add the proxy
 							if(sortKey)
 							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
+								AddProxyResult(proxyId,proxy->userData,maxCount,sortKey);
 							}
 							else
 							{
@@ -860,7 +997,7 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 							//Add the proxy
 							if(sortKey)
 							{
-								AddProxyResult(proxyId,proxy,maxCount,sortKey);
+								AddProxyResult(proxyId,proxy->userData,maxCount,sortKey);
 							}
 							else
 							{
@@ -895,25 +1032,12 @@ int32 b2BroadPhase::QuerySegment(const b2Segment& segment, void** userData, int3
 		break;
 	}
 
-	int32 count = 0;
-	for(int32 i=0;i < m_queryResultCount && count<maxCount; ++i, ++count)
-	{
-		b2Assert(m_queryResults[i] < b2_maxProxies);
-		b2Proxy* proxy = m_proxyPool + m_queryResults[i];
-		b2Assert(proxy->IsValid());
-		userData[i] = proxy->userData;
-	}
-
-	// Prepare for next query.
-	m_queryResultCount = 0;
-	IncrementTimeStamp();
-	
-	return count;
-
+	//MIGUEL MODIFICATION: Callback queries. Results are kept for the caller
+	return b2Min(m_queryResultCount, maxCount);
 }
-void b2BroadPhase::AddProxyResult(uint16 proxyId, b2Proxy* proxy, int32 maxCount, SortKeyFunc sortKey)
+void b2BroadPhase::AddProxyResult(int32 proxyId, void* proxyUserData, int32 maxCount, SortKeyFunc sortKey)
 {
-	float32 key = sortKey(proxy->userData);
+	float32 key = sortKey(proxyUserData);
 	//Filter proxies on positive keys
 	if(key<0)
 		return;
@@ -928,11 +1052,228 @@ void b2BroadPhase::AddProxyResult(uint16 proxyId, b2Proxy* proxy, int32 maxCount
 	if(maxCount==m_queryResultCount)
 		m_queryResultCount--;
 	//std::copy_backward
-	for(int32 j=m_queryResultCount+1;j>i;--j){
+	//MIGUEL MODIFICATION: Callback queries. Shift from the last result, not one past it (full arrays overflowed)
+	for(int32 j=m_queryResultCount;j>i;--j){
 		m_querySortKeys[j] = m_querySortKeys[j-1];
 		m_queryResults[j]  = m_queryResults[j-1];
 	}
 	m_querySortKeys[i] = key;
 	m_queryResults[i] = proxyId;
 	m_queryResultCount++;
-}
\ No newline at end of file
+}
+
+//MIGUEL MODIFICATION: Algorithm independent proxy access
+void b2BroadPhase::GetFatAABB(int32 proxyId, b2AABB* aabb) const
+{
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		*aabb = m_tree.GetFatAABB(proxyId);
+		return;
+	}
+
+	// Recover the world box from the quantized bounds.
+	const b2Proxy* proxy = m_proxyPool + proxyId;
+	b2Vec2 invQ;
+	invQ.Set(1.0f / m_quantizationFactor.x, 1.0f / m_quantizationFactor.y);
+	aabb->lowerBound.x = m_worldAABB.lowerBound.x + invQ.x * m_bounds[0][proxy->lowerBounds[0]].value;
+	aabb->lowerBound.y = m_worldAABB.lowerBound.y + invQ.y * m_bounds[1][proxy->lowerBounds[1]].value;
+	aabb->upperBound.x = m_worldAABB.lowerBound.x + invQ.x * m_bounds[0][proxy->upperBounds[0]].value;
+	aabb->upperBound.y = m_worldAABB.lowerBound.y + invQ.y * m_bounds[1][proxy->upperBounds[1]].value;
+}
+
+bool b2BroadPhase::TestProxyOverlap(int32 proxyId1, int32 proxyId2)
+{
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		return b2TestOverlap(m_tree.GetFatAABB(proxyId1), m_tree.GetFatAABB(proxyId2));
+	}
+
+	return TestOverlap(m_proxyPool + proxyId1, m_proxyPool + proxyId2);
+}
+
+//MIGUEL MODIFICATION: Dynamic tree broad-phase
+// Pairs in the tree broad-phase are defined exactly like in sweep and prune: two proxies
+// are paired while their (fat) boxes overlap. Every proxy creation, destruction and tree
+// re-insertion queries the tree and feeds the transitions to the pair manager, which
+// buffers them and reports them to the contact manager on Commit.
+
+// Tree query callback that buffers pair transitions for one proxy.
+class b2TreePairQuery
+{
+public:
+	enum Mode
+	{
+		e_addOverlaps,		// proxy created: every overlap is a new pair
+		e_removeOverlaps,	// proxy destroyed: every overlap is a lost pair
+		e_updateOverlaps	// proxy re-inserted: diff old and new fat boxes
+	};
+
+	bool QueryCallback(int32 otherId)
+	{
+		if (otherId == proxyId)
+		{
+			return true;
+		}
+
+		const b2AABB& otherAABB = broadPhase->m_tree.GetFatAABB(otherId);
+
+		switch (mode)
+		{
+		case e_addOverlaps:
+			broadPhase->m_pairManager.AddBufferedPair(proxyId, otherId);
+			break;
+
+		case e_removeOverlaps:
+			broadPhase->m_pairManager.RemoveBufferedPair(proxyId, otherId);
+			break;
+
+		case e_updateOverlaps:
+			{
+				bool oldOverlap = b2TestOverlap(oldAABB, otherAABB);
+				bool newOverlap = b2TestOverlap(newAABB, otherAABB);
+				if (newOverlap && oldOverlap == false)
+				{
+					broadPhase->m_pairManager.AddBufferedPair(proxyId, otherId);
+				}
+				else if (oldOverlap && newOverlap == false)
+				{
+					broadPhase->m_pairManager.RemoveBufferedPair(proxyId, otherId);
+				}
+			}
+			break;
+		}
+
+		return true;
+	}
+
+	b2BroadPhase* broadPhase;
+	int32 proxyId;
+	Mode mode;
+	b2AABB oldAABB;
+	b2AABB newAABB;
+};
+
+// Tree query callback that copies user data up to a maximum count.
+class b2TreeCollectQuery
+{
+public:
+	bool QueryCallback(int32 proxyId)
+	{
+		if (count == maxCount)
+		{
+			return false;
+		}
+
+		userData[count] = tree->GetUserData(proxyId);
+		++count;
+		return count < maxCount;
+	}
+
+	const b2DynamicTree* tree;
+	void** userData;
+	int32 maxCount;
+	int32 count;
+};
+
+int32 b2BroadPhase::CreateTreeProxy(const b2AABB& aabb, void* userData)
+{
+	int32 proxyId = m_tree.CreateProxy(aabb, userData);
+
+	++m_proxyCount;
+
+	b2TreePairQuery query;
+	query.broadPhase = this;
+	query.proxyId = proxyId;
+	query.mode = b2TreePairQuery::e_addOverlaps;
+	m_tree.Query(&query, m_tree.GetFatAABB(proxyId));
+
+	m_pairManager.Commit();
+
+	if (s_validate)
+	{
+		Validate();
+	}
+
+	return proxyId;
+}
+
+void b2BroadPhase::DestroyTreeProxy(int32 proxyId)
+{
+	b2Assert(0 < m_proxyCount);
+	b2Assert(m_tree.IsValidProxy(proxyId));
+
+	b2TreePairQuery query;
+	query.broadPhase = this;
+	query.proxyId = proxyId;
+	query.mode = b2TreePairQuery::e_removeOverlaps;
+	m_tree.Query(&query, m_tree.GetFatAABB(proxyId));
+
+	// The proxy must still be alive while the removed pairs are reported.
+	m_pairManager.Commit();
+
+	m_tree.DestroyProxy(proxyId);
+	--m_proxyCount;
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+void b2BroadPhase::MoveTreeProxy(int32 proxyId, const b2AABB& aabb)
+{
+	if (m_tree.IsValidProxy(proxyId) == false)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	if (aabb.IsValid() == false)
+	{
+		b2Assert(false);
+		return;
+	}
+
+	b2AABB oldAABB = m_tree.GetFatAABB(proxyId);
+
+	// Most moves stay inside the fat box and cost nothing.
+	if (m_tree.MoveProxy(proxyId, aabb) == false)
+	{
+		return;
+	}
+
+	b2TreePairQuery query;
+	query.broadPhase = this;
+	query.proxyId = proxyId;
+	query.mode = b2TreePairQuery::e_updateOverlaps;
+	query.oldAABB = oldAABB;
+	query.newAABB = m_tree.GetFatAABB(proxyId);
+
+	b2AABB sweptAABB;
+	sweptAABB.lowerBound = b2Min(query.oldAABB.lowerBound, query.newAABB.lowerBound);
+	sweptAABB.upperBound = b2Max(query.oldAABB.upperBound, query.newAABB.upperBound);
+	m_tree.Query(&query, sweptAABB);
+
+	if (s_validate)
+	{
+		Validate();
+	}
+}
+
+int32 b2BroadPhase::QueryTree(const b2AABB& aabb, void** userData, int32 maxCount)
+{
+	if (maxCount <= 0)
+	{
+		return 0;
+	}
+
+	b2TreeCollectQuery query;
+	query.tree = &m_tree;
+	query.userData = userData;
+	query.maxCount = maxCount;
+	query.count = 0;
+	m_tree.Query(&query, aabb);
+
+	return query.count;
+}
+
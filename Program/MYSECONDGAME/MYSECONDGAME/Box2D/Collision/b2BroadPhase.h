@@ -29,6 +29,7 @@ Bullet (http:/www.bulletphysics.com).
 #include "../Common/b2Settings.h"
 #include "b2Collision.h"
 #include "b2PairManager.h"
+#include "b2DynamicTree.h"
 #include <climits>
 
 #ifdef TARGET_FLOAT32_IS_FIXED
@@ -40,6 +41,8 @@ Bullet (http:/www.bulletphysics.com).
 
 const uint16 b2_invalid = B2BROADPHASE_MAX;
 const uint16 b2_nullEdge = B2BROADPHASE_MAX;
+//MIGUEL MODIFICATION: Pair manager proxy ids are 32 bit, the sweep and prune pool keeps its own 16 bit null id
+const uint16 b2_nullSAPProxy = USHRT_MAX;
 struct b2BoundValues;
 
 struct b2Bound
@@ -66,19 +69,33 @@ struct b2Proxy
 
 typedef float32 (*SortKeyFunc)(void* shape);
 
+//MIGUEL MODIFICATION: Broad-phase algorithm selection
+/// The algorithm used to find overlapping proxies. Sweep and prune is the original
+/// Box2D one, limited to b2_maxProxies. The dynamic tree keeps fattened AABBs in a
+/// balanced hierarchy that grows on demand. Both report pairs through the same
+/// b2PairManager, so contacts and callbacks do not change.
+enum b2BroadPhaseType
+{
+	e_sweepAndPruneBroadPhase,
+	e_dynamicTreeBroadPhase
+};
+
 class b2BroadPhase
 {
 public:
-	b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback);
+	b2BroadPhase(const b2AABB& worldAABB, b2PairCallback* callback, b2BroadPhaseType type = e_sweepAndPruneBroadPhase);
 	~b2BroadPhase();
 
+	//MIGUEL MODIFICATION: Broad-phase algorithm selection
+	b2BroadPhaseType GetType() const { return m_type; }
+
 	// Use this to see if your proxy is in range. If it is not in range,
 	// it should be destroyed. Otherwise you may get O(m^2) pairs, where m
 	// is the number of proxies that are out of range.
 	bool InRange(const b2AABB& aabb) const;
 
 	// Create and destroy proxies. These call Flush first.
-	uint16 CreateProxy(const b2AABB& aabb, void* userData);
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
 	void DestroyProxy(int32 proxyId);
 
 	// Call MoveProxy as many times as you like, then when you are done
@@ -87,8 +104,15 @@ public:
 	void Commit();
 
 	// Get a single proxy. Returns NULL if the id is invalid.
+	// Only the sweep and prune broad-phase has b2Proxy objects; the dynamic tree returns NULL.
 	b2Proxy* GetProxy(int32 proxyId);
 
+	//MIGUEL MODIFICATION: Algorithm independent proxy access (used by the pair manager and debug draw)
+	bool IsValidProxy(int32 proxyId) const;
+	void* GetUserData(int32 proxyId) const;
+	void GetFatAABB(int32 proxyId, b2AABB* aabb) const;
+	bool TestProxyOverlap(int32 proxyId1, int32 proxyId2);
+
 	// Query an AABB for overlapping proxies, returns the user data and
 	// the count, up to the supplied maximum count.
 	int32 Query(const b2AABB& aabb, void** userData, int32 maxCount);
@@ -101,6 +125,20 @@ public:
 	// Proxies with a negative sortKey are discarded
 	int32 QuerySegment(const b2Segment& segment, void** userData, int32 maxCount, SortKeyFunc sortKey);
 
+	//MIGUEL MODIFICATION: Callback queries
+	/// Query an AABB for overlapping proxies, without a count limit. The callback class implements
+	/// bool QueryCallback(void* userData), returning false to stop the query.
+	/// Do not query the broad-phase or change proxies from the callback.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb);
+
+	/// Query a segment for overlapping proxies, with the same callback as Query. If sortKey is
+	/// provided they are reported in sortKey order, as QuerySegment does. Without a count limit.
+	/// With the dynamic tree and a sortKey the nearest nodes are visited first, so the proxies
+	/// past the one that stops the query are never keyed (a ray cast for the first hit is cheap).
+	template <typename T>
+	void QuerySegment(T* callback, const b2Segment& segment, SortKeyFunc sortKey);
+
 	void Validate();
 	void ValidatePairs();
 
@@ -114,20 +152,36 @@ private:
 				b2Bound* bounds, int32 boundCount, int32 axis);
 	void IncrementOverlapCount(int32 proxyId);
 	void IncrementTimeStamp();
-	void AddProxyResult(uint16 proxyId, b2Proxy* proxy, int32 maxCount, SortKeyFunc sortKey);
+	void AddProxyResult(int32 proxyId, void* proxyUserData, int32 maxCount, SortKeyFunc sortKey);
+
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase
+	int32 CreateTreeProxy(const b2AABB& aabb, void* userData);
+	void DestroyTreeProxy(int32 proxyId);
+	void MoveTreeProxy(int32 proxyId, const b2AABB& aabb);
+	int32 QueryTree(const b2AABB& aabb, void** userData, int32 maxCount);
+
+	//MIGUEL MODIFICATION: Callback queries. Results are gathered in m_queryResults, then ClearQuery is called
+	int32 GatherQuery(const b2AABB& aabb);
+	int32 GatherSegment(const b2Segment& segment, int32 maxCount, SortKeyFunc sortKey);
+	void ClearQuery();
 
 public:
 	friend class b2PairManager;
 
 	b2PairManager m_pairManager;
 
-	b2Proxy m_proxyPool[b2_maxProxies];
+	//MIGUEL MODIFICATION: Dynamic tree broad-phase. The sweep and prune arrays (b2_maxProxies
+	//entries) are only allocated for sweep and prune, they are NULL with the tree.
+	b2BroadPhaseType m_type;
+	b2DynamicTree m_tree;
+
+	b2Proxy* m_proxyPool;
 	uint16 m_freeProxy;
 
-	b2Bound m_bounds[2][2*b2_maxProxies];
+	b2Bound* m_bounds[2];
 
-	uint16 m_queryResults[b2_maxProxies];
-	float32 m_querySortKeys[b2_maxProxies];
+	int32* m_queryResults;
+	float32* m_querySortKeys;
 	int32 m_queryResultCount;
 
 	b2AABB m_worldAABB;
@@ -147,7 +201,7 @@ inline bool b2BroadPhase::InRange(const b2AABB& aabb) const
 
 inline b2Proxy* b2BroadPhase::GetProxy(int32 proxyId)
 {
-	if (proxyId == b2_nullProxy || m_proxyPool[proxyId].IsValid() == false)
+	if (m_type != e_sweepAndPruneBroadPhase || proxyId < 0 || b2_maxProxies <= proxyId || m_proxyPool[proxyId].IsValid() == false)
 	{
 		return NULL;
 	}
@@ -155,4 +209,113 @@ inline b2Proxy* b2BroadPhase::GetProxy(int32 proxyId)
 	return m_proxyPool + proxyId;
 }
 
+inline bool b2BroadPhase::IsValidProxy(int32 proxyId) const
+{
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		return m_tree.IsValidProxy(proxyId);
+	}
+
+	return 0 <= proxyId && proxyId < b2_maxProxies && m_proxyPool[proxyId].IsValid();
+}
+
+inline void* b2BroadPhase::GetUserData(int32 proxyId) const
+{
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		return m_tree.GetUserData(proxyId);
+	}
+
+	return m_proxyPool[proxyId].userData;
+}
+
+//MIGUEL MODIFICATION: Callback queries
+// Tree query, segment and ray cast callback that forwards the user data of the proxies.
+template <typename T>
+class b2TreeUserDataQuery
+{
+public:
+	bool QueryCallback(int32 proxyId)
+	{
+		return callback->QueryCallback(tree->GetUserData(proxyId));
+	}
+
+	bool QuerySegmentCallback(int32 proxyId)
+	{
+		return callback->QueryCallback(tree->GetUserData(proxyId));
+	}
+
+	float32 RayCastKey(int32 proxyId)
+	{
+		return sortKey(tree->GetUserData(proxyId));
+	}
+
+	bool RayCastCallback(int32 proxyId)
+	{
+		return callback->QueryCallback(tree->GetUserData(proxyId));
+	}
+
+	const b2DynamicTree* tree;
+	T* callback;
+	SortKeyFunc sortKey;
+};
+
+template <typename T>
+inline void b2BroadPhase::Query(T* callback, const b2AABB& aabb)
+{
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		b2TreeUserDataQuery<T> query;
+		query.tree = &m_tree;
+		query.callback = callback;
+		query.sortKey = NULL;
+		m_tree.Query(&query, aabb);
+		return;
+	}
+
+	int32 count = GatherQuery(aabb);
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (callback->QueryCallback(m_proxyPool[m_queryResults[i]].userData) == false)
+		{
+			break;
+		}
+	}
+
+	ClearQuery();
+}
+
+template <typename T>
+inline void b2BroadPhase::QuerySegment(T* callback, const b2Segment& segment, SortKeyFunc sortKey)
+{
+	if (m_type == e_dynamicTreeBroadPhase)
+	{
+		b2TreeUserDataQuery<T> query;
+		query.tree = &m_tree;
+		query.callback = callback;
+		query.sortKey = sortKey;
+		if (sortKey)
+		{
+			m_tree.RayCast(&query, segment);
+		}
+		else
+		{
+			m_tree.QuerySegment(&query, segment);
+		}
+		return;
+	}
+
+	// Sweep and prune never holds more than b2_maxProxies, so the gather finds them all.
+	int32 count = GatherSegment(segment, b2_maxProxies, sortKey);
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (callback->QueryCallback(GetUserData(m_queryResults[i])) == false)
+		{
+			break;
+		}
+	}
+
+	ClearQuery();
+}
+
 #endif
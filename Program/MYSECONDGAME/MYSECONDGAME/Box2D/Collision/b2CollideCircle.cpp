@@ -23,7 +23,8 @@
 void b2CollideCircles(
 	b2Manifold* manifold,
 	const b2CircleShape* circle1, const b2XForm& xf1,
-	const b2CircleShape* circle2, const b2XForm& xf2)
+	const b2CircleShape* circle2, const b2XForm& xf2,
+	float32 margin)
 {
 	manifold->pointCount = 0;
 
@@ -35,7 +36,8 @@ void b2CollideCircles(
 	float32 r1 = circle1->GetRadius();
 	float32 r2 = circle2->GetRadius();
 	float32 radiusSum = r1 + r2;
-	if (distSqr > radiusSum * radiusSum)
+	float32 reach = radiusSum + margin;
+	if (distSqr > reach * reach)
 	{
 		return;
 	}
@@ -71,7 +73,8 @@ void b2CollideCircles(
 void b2CollidePolygonAndCircle(
 	b2Manifold* manifold,
 	const b2PolygonShape* polygon, const b2XForm& xf1,
-	const b2CircleShape* circle, const b2XForm& xf2)
+	const b2CircleShape* circle, const b2XForm& xf2,
+	float32 margin)
 {
 	manifold->pointCount = 0;
 
@@ -83,6 +86,7 @@ void b2CollidePolygonAndCircle(
 	int32 normalIndex = 0;
 	float32 separation = -B2_FLT_MAX;
 	float32 radius = circle->GetRadius();
+	float32 reach = radius + margin;
 	int32 vertexCount = polygon->GetVertexCount();
 	const b2Vec2* vertices = polygon->GetVertices();
 	const b2Vec2* normals = polygon->GetNormals();
@@ -91,7 +95,7 @@ void b2CollidePolygonAndCircle(
 	{
 		float32 s = b2Dot(normals[i], cLocal - vertices[i]);
 
-		if (s > radius)
+		if (s > reach)
 		{
 			// Early out.
 			return;
@@ -152,7 +156,7 @@ void b2CollidePolygonAndCircle(
 
 	b2Vec2 d = cLocal - p;
 	float32 dist = d.Normalize();
-	if (dist > radius)
+	if (dist > reach)
 	{
 		return;
 	}
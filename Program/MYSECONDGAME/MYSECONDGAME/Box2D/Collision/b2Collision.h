@@ -99,14 +99,18 @@ struct b2OBB
 };
 
 /// Compute the collision manifold between two circles.
+/// MIGUEL MODIFICATION: Speculative contacts. Shapes up to margin apart get a point with positive separation.
 void b2CollideCircles(b2Manifold* manifold,
 					  const b2CircleShape* circle1, const b2XForm& xf1,
-					  const b2CircleShape* circle2, const b2XForm& xf2);
+					  const b2CircleShape* circle2, const b2XForm& xf2,
+					  float32 margin = 0.0f);
 
 /// Compute the collision manifold between a polygon and a circle.
+/// MIGUEL MODIFICATION: Speculative contacts. Shapes up to margin apart get a point with positive separation.
 void b2CollidePolygonAndCircle(b2Manifold* manifold,
 							   const b2PolygonShape* polygon, const b2XForm& xf1,
-							   const b2CircleShape* circle, const b2XForm& xf2);
+							   const b2CircleShape* circle, const b2XForm& xf2,
+							   float32 margin = 0.0f);
 
 /// Compute the collision manifold between two circles.
 void b2CollidePolygons(b2Manifold* manifold,
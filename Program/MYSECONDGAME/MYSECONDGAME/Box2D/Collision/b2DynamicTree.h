@@ -0,0 +1,537 @@
+/*
+* Copyright (c) 2009 Erin Catto http://www.gphysics.com
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_DYNAMIC_TREE_H
+#define B2_DYNAMIC_TREE_H
+
+#include "b2Collision.h"
+#include <cstring>
+
+//MIGUEL MODIFICATION: Dynamic AABB tree, used as an alternative broad-phase (see b2BroadPhase.h)
+
+const int32 b2_nullNode = -1;
+
+/// A node in the dynamic tree. The client does not interact with this directly.
+struct b2DynamicTreeNode
+{
+	bool IsLeaf() const
+	{
+		return child1 == b2_nullNode;
+	}
+
+	/// This is the fattened AABB.
+	b2AABB aabb;
+
+	void* userData;
+
+	union
+	{
+		int32 parent;
+		int32 next;
+	};
+
+	int32 child1;
+	int32 child2;
+
+	// leaf = 0, free node = -1
+	int32 height;
+};
+
+/// A dynamic AABB tree broad-phase, inspired by Nathanael Presson's btDbvt.
+/// A dynamic tree arranges data in a binary tree to accelerate
+/// queries such as volume queries and ray casts. Leafs are proxies
+/// with an AABB. In the tree we expand the proxy AABB by b2_aabbExtension
+/// so that the proxy AABB is bigger than the client object. This allows the client
+/// object to move by small amounts without triggering a tree update.
+///
+/// Nodes are pooled and relocatable, so we use node indices rather than pointers.
+/// The pool grows on demand, so there is no fixed proxy limit.
+class b2DynamicTree
+{
+public:
+	/// Constructing the tree initializes the node pool.
+	b2DynamicTree();
+
+	/// Destroy the tree, freeing the node pool.
+	~b2DynamicTree();
+
+	/// Create a proxy. Provide a tight fitting AABB and a userData pointer.
+	int32 CreateProxy(const b2AABB& aabb, void* userData);
+
+	/// Destroy a proxy. This asserts if the id is invalid.
+	void DestroyProxy(int32 proxyId);
+
+	/// Move a proxy. If the proxy has moved outside of its fattened AABB,
+	/// then the proxy is removed from the tree and re-inserted. Otherwise
+	/// the function returns immediately.
+	/// @return true if the proxy was re-inserted.
+	bool MoveProxy(int32 proxyId, const b2AABB& aabb);
+
+	/// Get proxy user data.
+	/// @return the proxy user data or NULL if the id is invalid.
+	void* GetUserData(int32 proxyId) const;
+
+	/// Get the fat AABB for a proxy.
+	const b2AABB& GetFatAABB(int32 proxyId) const;
+
+	/// Is this id a live leaf of the tree?
+	bool IsValidProxy(int32 proxyId) const;
+
+	/// Query an AABB for overlapping proxies. The callback class
+	/// is called for each proxy that overlaps the supplied AABB.
+	/// The callback returns false to terminate the query.
+	template <typename T>
+	void Query(T* callback, const b2AABB& aabb) const;
+
+	/// Query a segment for proxies whose fat AABB it crosses. The callback
+	/// class is called for each candidate proxy; it returns false to terminate the query.
+	template <typename T>
+	void QuerySegment(T* callback, const b2Segment& segment) const;
+
+	/// Ray cast a segment through the proxies, nearest first. The callback class implements
+	/// float32 RayCastKey(int32 proxyId), the hit fraction of the proxy along the segment
+	/// (negative if it is not hit), and bool RayCastCallback(int32 proxyId), called in hit
+	/// fraction order and returning false to terminate the ray cast. Nodes are visited nearest
+	/// first, so the proxies past the terminating one are never keyed.
+	template <typename T>
+	void RayCast(T* callback, const b2Segment& segment) const;
+
+	/// Validate this tree. For testing.
+	void Validate() const;
+
+	/// Compute the height of the tree in O(1), using the cached heights.
+	int32 GetHeight() const;
+
+	/// Number of live proxies (leaves) in the tree.
+	int32 GetProxyCount() const;
+
+	/// Number of nodes the pool can hold before growing.
+	int32 GetNodeCapacity() const;
+
+private:
+
+	int32 AllocateNode();
+	void FreeNode(int32 node);
+
+	void InsertLeaf(int32 node);
+	void RemoveLeaf(int32 node);
+
+	int32 Balance(int32 index);
+
+	int32 ComputeHeight(int32 nodeId) const;
+	void ValidateStructure(int32 index) const;
+
+	int32 m_root;
+
+	b2DynamicTreeNode* m_nodes;
+	int32 m_nodeCount;
+	int32 m_nodeCapacity;
+
+	int32 m_freeList;
+
+	int32 m_proxyCount;
+};
+
+/// Traversal stack for tree queries. It lives on the call stack and only
+/// touches the heap for very deep trees.
+class b2TreeStack
+{
+public:
+	b2TreeStack()
+	{
+		m_stack = m_array;
+		m_count = 0;
+		m_capacity = e_initialCapacity;
+	}
+
+	~b2TreeStack()
+	{
+		if (m_stack != m_array)
+		{
+			b2Free(m_stack);
+		}
+	}
+
+	void Push(int32 element)
+	{
+		if (m_count == m_capacity)
+		{
+			int32* old = m_stack;
+			m_capacity *= 2;
+			m_stack = (int32*)b2Alloc(m_capacity * sizeof(int32));
+			memcpy(m_stack, old, m_count * sizeof(int32));
+			if (old != m_array)
+			{
+				b2Free(old);
+			}
+		}
+
+		m_stack[m_count] = element;
+		++m_count;
+	}
+
+	int32 Pop()
+	{
+		b2Assert(m_count > 0);
+		--m_count;
+		return m_stack[m_count];
+	}
+
+	int32 GetCount() const
+	{
+		return m_count;
+	}
+
+private:
+	enum
+	{
+		e_initialCapacity = 256
+	};
+
+	int32* m_stack;
+	int32 m_array[e_initialCapacity];
+	int32 m_count;
+	int32 m_capacity;
+};
+
+/// Nodes and proxies waiting in a tree ray cast, nearest first (a binary min heap). It lives
+/// on the call stack and only touches the heap for very long segments.
+class b2TreeRayQueue
+{
+public:
+	b2TreeRayQueue()
+	{
+		m_entries = m_array;
+		m_count = 0;
+		m_capacity = e_initialCapacity;
+	}
+
+	~b2TreeRayQueue()
+	{
+		if (m_entries != m_array)
+		{
+			b2Free(m_entries);
+		}
+	}
+
+	/// Queue a node by the fraction where the segment enters its box, or a proxy by its hit fraction.
+	void Push(int32 id, float32 fraction, bool keyed)
+	{
+		if (m_count == m_capacity)
+		{
+			b2RayEntry* old = m_entries;
+			m_capacity *= 2;
+			m_entries = (b2RayEntry*)b2Alloc(m_capacity * sizeof(b2RayEntry));
+			memcpy(m_entries, old, m_count * sizeof(b2RayEntry));
+			if (old != m_array)
+			{
+				b2Free(old);
+			}
+		}
+
+		// Sift up.
+		int32 index = m_count;
+		++m_count;
+		while (index > 0)
+		{
+			int32 parent = (index - 1) >> 1;
+			if (m_entries[parent].fraction <= fraction)
+			{
+				break;
+			}
+			m_entries[index] = m_entries[parent];
+			index = parent;
+		}
+		m_entries[index].id = id;
+		m_entries[index].fraction = fraction;
+		m_entries[index].keyed = keyed;
+	}
+
+	/// Take the nearest entry out. The queue must not be empty.
+	void Pop(int32* id, bool* keyed)
+	{
+		b2Assert(m_count > 0);
+		*id = m_entries[0].id;
+		*keyed = m_entries[0].keyed;
+
+		// Sift the last entry down from the top.
+		--m_count;
+		b2RayEntry last = m_entries[m_count];
+		int32 index = 0;
+		for (;;)
+		{
+			int32 child = 2 * index + 1;
+			if (child >= m_count)
+			{
+				break;
+			}
+			if (child + 1 < m_count && m_entries[child + 1].fraction < m_entries[child].fraction)
+			{
+				++child;
+			}
+			if (last.fraction <= m_entries[child].fraction)
+			{
+				break;
+			}
+			m_entries[index] = m_entries[child];
+			index = child;
+		}
+		if (m_count > 0)
+		{
+			m_entries[index] = last;
+		}
+	}
+
+	int32 GetCount() const
+	{
+		return m_count;
+	}
+
+private:
+	enum
+	{
+		e_initialCapacity = 128
+	};
+
+	struct b2RayEntry
+	{
+		float32 fraction;
+		int32 id;
+		bool keyed;		// proxy with its hit fraction, reported when it comes out
+	};
+
+	b2RayEntry* m_entries;
+	b2RayEntry m_array[e_initialCapacity];
+	int32 m_count;
+	int32 m_capacity;
+};
+
+/// Slab test of a segment (p1 + t * d, t in [0,1]) against a box. Gives the fraction where it enters the box.
+inline bool b2TestSegmentOverlap(const b2Vec2& p1, const b2Vec2& d, const b2AABB& aabb, float32* fraction)
+{
+	float32 tmin = 0.0f;
+	float32 tmax = 1.0f;
+	for (int32 axis = 0; axis < 2; ++axis)
+	{
+		float32 p = axis == 0 ? p1.x : p1.y;
+		float32 dir = axis == 0 ? d.x : d.y;
+		float32 lower = axis == 0 ? aabb.lowerBound.x : aabb.lowerBound.y;
+		float32 upper = axis == 0 ? aabb.upperBound.x : aabb.upperBound.y;
+
+		if (b2Abs(dir) < B2_FLT_EPSILON)
+		{
+			if (p < lower || upper < p)
+			{
+				return false;
+			}
+		}
+		else
+		{
+			float32 inv = 1.0f / dir;
+			float32 t1 = (lower - p) * inv;
+			float32 t2 = (upper - p) * inv;
+			if (t1 > t2)
+			{
+				b2Swap(t1, t2);
+			}
+			tmin = b2Max(tmin, t1);
+			tmax = b2Min(tmax, t2);
+			if (tmin > tmax)
+			{
+				return false;
+			}
+		}
+	}
+
+	*fraction = tmin;
+	return true;
+}
+
+inline void* b2DynamicTree::GetUserData(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	return m_nodes[proxyId].userData;
+}
+
+inline const b2AABB& b2DynamicTree::GetFatAABB(int32 proxyId) const
+{
+	b2Assert(0 <= proxyId && proxyId < m_nodeCapacity);
+	return m_nodes[proxyId].aabb;
+}
+
+inline bool b2DynamicTree::IsValidProxy(int32 proxyId) const
+{
+	if (proxyId < 0 || m_nodeCapacity <= proxyId)
+	{
+		return false;
+	}
+
+	return m_nodes[proxyId].height == 0 && m_nodes[proxyId].IsLeaf();
+}
+
+inline int32 b2DynamicTree::GetProxyCount() const
+{
+	return m_proxyCount;
+}
+
+inline int32 b2DynamicTree::GetNodeCapacity() const
+{
+	return m_nodeCapacity;
+}
+
+template <typename T>
+inline void b2DynamicTree::Query(T* callback, const b2AABB& aabb) const
+{
+	b2TreeStack stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		if (nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		const b2DynamicTreeNode* node = m_nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, aabb))
+		{
+			if (node->IsLeaf())
+			{
+				bool proceed = callback->QueryCallback(nodeId);
+				if (proceed == false)
+				{
+					return;
+				}
+			}
+			else
+			{
+				stack.Push(node->child1);
+				stack.Push(node->child2);
+			}
+		}
+	}
+}
+
+template <typename T>
+inline void b2DynamicTree::QuerySegment(T* callback, const b2Segment& segment) const
+{
+	b2Vec2 p1 = segment.p1;
+	b2Vec2 d = segment.p2 - segment.p1;
+
+	// Bounding box of the segment, for a cheap first rejection.
+	b2AABB segmentAABB;
+	segmentAABB.lowerBound = b2Min(segment.p1, segment.p2);
+	segmentAABB.upperBound = b2Max(segment.p1, segment.p2);
+
+	b2TreeStack stack;
+	stack.Push(m_root);
+
+	while (stack.GetCount() > 0)
+	{
+		int32 nodeId = stack.Pop();
+		if (nodeId == b2_nullNode)
+		{
+			continue;
+		}
+
+		const b2DynamicTreeNode* node = m_nodes + nodeId;
+
+		if (b2TestOverlap(node->aabb, segmentAABB) == false)
+		{
+			continue;
+		}
+
+		float32 fraction;
+		if (b2TestSegmentOverlap(p1, d, node->aabb, &fraction) == false)
+		{
+			continue;
+		}
+
+		if (node->IsLeaf())
+		{
+			bool proceed = callback->QuerySegmentCallback(nodeId);
+			if (proceed == false)
+			{
+				return;
+			}
+		}
+		else
+		{
+			stack.Push(node->child1);
+			stack.Push(node->child2);
+		}
+	}
+}
+
+template <typename T>
+inline void b2DynamicTree::RayCast(T* callback, const b2Segment& segment) const
+{
+	b2Vec2 p1 = segment.p1;
+	b2Vec2 d = segment.p2 - segment.p1;
+
+	b2TreeRayQueue queue;
+	float32 fraction;
+	if (m_root != b2_nullNode && b2TestSegmentOverlap(p1, d, m_nodes[m_root].aabb, &fraction))
+	{
+		queue.Push(m_root, fraction, false);
+	}
+
+	// A proxy comes out keyed when everything left enters further along the segment,
+	// and the hit fraction of a proxy is never before the entry of its boxes.
+	while (queue.GetCount() > 0)
+	{
+		int32 nodeId;
+		bool keyed;
+		queue.Pop(&nodeId, &keyed);
+
+		if (keyed)
+		{
+			bool proceed = callback->RayCastCallback(nodeId);
+			if (proceed == false)
+			{
+				return;
+			}
+			continue;
+		}
+
+		const b2DynamicTreeNode* node = m_nodes + nodeId;
+
+		if (node->IsLeaf())
+		{
+			float32 key = callback->RayCastKey(nodeId);
+			if (key >= 0.0f)
+			{
+				queue.Push(nodeId, key, true);
+			}
+			continue;
+		}
+
+		if (b2TestSegmentOverlap(p1, d, m_nodes[node->child1].aabb, &fraction))
+		{
+			queue.Push(node->child1, fraction, false);
+		}
+		if (b2TestSegmentOverlap(p1, d, m_nodes[node->child2].aabb, &fraction))
+		{
+			queue.Push(node->child2, fraction, false);
+		}
+	}
+}
+
+#endif
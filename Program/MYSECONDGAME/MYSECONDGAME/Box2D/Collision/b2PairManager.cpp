@@ -20,12 +20,12 @@
 #include "b2BroadPhase.h"
 
 #include <algorithm>
+#include <cstring>
 
-// Thomas Wang's hash, see: http://www.concentric.net/~Ttwang/tech/inthash.htm
-// This assumes proxyId1 and proxyId2 are 16-bit.
-inline uint32 Hash(uint32 proxyId1, uint32 proxyId2)
+//MIGUEL MODIFICATION: 32 bit proxy ids. Thomas Wang's hash of each id, mixed together.
+// See: http://www.concentric.net/~Ttwang/tech/inthash.htm
+inline uint32 WangHash(uint32 key)
 {
-	uint32 key = (proxyId2 << 16) | proxyId1;
 	key = ~key + (key << 15);
 	key = key ^ (key >> 12);
 	key = key + (key << 2);
@@ -35,6 +35,13 @@ inline uint32 Hash(uint32 proxyId1, uint32 proxyId2)
 	return key;
 }
 
+inline uint32 Hash(uint32 proxyId1, uint32 proxyId2)
+{
+	uint32 key = WangHash(proxyId1);
+	key ^= proxyId2 + 0x9e3779b9 + (key << 6) + (key >> 2);
+	return WangHash(key);
+}
+
 inline bool Equals(const b2Pair& pair, int32 proxyId1, int32 proxyId2)
 {
 	return pair.proxyId1 == proxyId1 && pair.proxyId2 == proxyId2;
@@ -64,24 +71,44 @@ inline bool operator < (const b2BufferedPair& pair1, const b2BufferedPair& pair2
 
 b2PairManager::b2PairManager()
 {
-	b2Assert(b2IsPowerOfTwo(b2_tableCapacity) == true);
-	b2Assert(b2_tableCapacity >= b2_maxPairs);
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
-	{
-		m_hashTable[i] = b2_nullPair;
-	}
-	m_freePair = 0;
-	for (int32 i = 0; i < b2_maxPairs; ++i)
+	b2Assert(b2IsPowerOfTwo(b2_initialPairCapacity) == true);
+
+	m_pairCapacity = b2_initialPairCapacity;
+	m_pairs = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	for (int32 i = 0; i < m_pairCapacity; ++i)
 	{
 		m_pairs[i].proxyId1 = b2_nullProxy;
 		m_pairs[i].proxyId2 = b2_nullProxy;
 		m_pairs[i].userData = NULL;
 		m_pairs[i].status = 0;
-		m_pairs[i].next = uint16(i + 1);
+		m_pairs[i].next = i + 1;
 	}
-	m_pairs[b2_maxPairs-1].next = b2_nullPair;
+	m_pairs[m_pairCapacity-1].next = b2_nullPair;
+	m_freePair = 0;
 	m_pairCount = 0;
+
+	// Keep the table at most half full, so probe sequences stay short.
+	m_tableCapacity = 2 * b2_initialPairCapacity;
+	m_tableMask = m_tableCapacity - 1;
+	m_hashTable = (b2PairSlot*)b2Alloc(m_tableCapacity * sizeof(b2PairSlot));
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		m_hashTable[i].pairIndex = b2_nullPair;
+	}
+
+	m_pairBufferCapacity = b2_initialPairCapacity;
+	m_pairBuffer = (b2BufferedPair*)b2Alloc(m_pairBufferCapacity * sizeof(b2BufferedPair));
 	m_pairBufferCount = 0;
+
+	m_growCount = 0;
+	ResetStatistics();
+}
+
+b2PairManager::~b2PairManager()
+{
+	b2Free(m_pairs);
+	b2Free(m_hashTable);
+	b2Free(m_pairBuffer);
 }
 
 void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback)
@@ -90,63 +117,91 @@ void b2PairManager::Initialize(b2BroadPhase* broadPhase, b2PairCallback* callbac
 	m_callback = callback;
 }
 
-b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2, uint32 hash)
+// Returns the slot holding the pair, or the empty slot where it would be inserted.
+int32 b2PairManager::FindSlot(int32 proxyId1, int32 proxyId2, uint32 hash)
 {
-	int32 index = m_hashTable[hash];
+	int32 slot = hash & m_tableMask;
+	int32 probeLength = 1;
 
-	while (index != b2_nullPair && Equals(m_pairs[index], proxyId1, proxyId2) == false)
+	// The table is never full, so the probe always ends.
+	while (m_hashTable[slot].pairIndex != b2_nullPair)
 	{
-		index = m_pairs[index].next;
-	}
+		if (m_hashTable[slot].proxyId1 == proxyId1 && m_hashTable[slot].proxyId2 == proxyId2)
+		{
+			break;
+		}
 
-	if (index == b2_nullPair)
-	{
-		return NULL;
+		slot = (slot + 1) & m_tableMask;
+		++probeLength;
 	}
 
-	b2Assert(index < b2_maxPairs);
+	++m_lookupCount;
+	m_probeCount += probeLength;
+	m_maxProbeLength = b2Max(m_maxProbeLength, probeLength);
 
-	return m_pairs + index;
+	return slot;
 }
 
 b2Pair* b2PairManager::Find(int32 proxyId1, int32 proxyId2)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	int32 slot = FindSlot(proxyId1, proxyId2, Hash(proxyId1, proxyId2));
+	int32 index = m_hashTable[slot].pairIndex;
+
+	if (index == b2_nullPair)
+	{
+		return NULL;
+	}
+
+	b2Assert(index < m_pairCapacity);
 
-	return Find(proxyId1, proxyId2, hash);
+	return m_pairs + index;
 }
 
 // Returns existing pair or creates a new one.
-b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2)
+b2Pair* b2PairManager::AddPair(int32 proxyId1, int32 proxyId2, int32* pairIndex)
 {
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	uint32 hash = Hash(proxyId1, proxyId2);
+
+	int32 slot = FindSlot(proxyId1, proxyId2, hash);
+	if (m_hashTable[slot].pairIndex != b2_nullPair)
+	{
+		*pairIndex = m_hashTable[slot].pairIndex;
+		return m_pairs + *pairIndex;
+	}
 
-	b2Pair* pair = Find(proxyId1, proxyId2, hash);
-	if (pair != NULL)
+	// Grow before inserting. Growing the table rehashes, so look the slot up again.
+	if (m_freePair == b2_nullPair)
 	{
-		return pair;
+		GrowPairs();
 	}
 
-	b2Assert(m_pairCount < b2_maxPairs && m_freePair != b2_nullPair);
+	if (2 * (m_pairCount + 1) > m_tableCapacity)
+	{
+		GrowTable();
+		slot = FindSlot(proxyId1, proxyId2, hash);
+	}
 
-	uint16 pairIndex = m_freePair;
-	pair = m_pairs + pairIndex;
+	int32 index = m_freePair;
+	b2Pair* pair = m_pairs + index;
 	m_freePair = pair->next;
 
-	pair->proxyId1 = (uint16)proxyId1;
-	pair->proxyId2 = (uint16)proxyId2;
+	pair->proxyId1 = proxyId1;
+	pair->proxyId2 = proxyId2;
 	pair->status = 0;
 	pair->userData = NULL;
-	pair->next = m_hashTable[hash];
+	pair->next = b2_nullPair;
 
-	m_hashTable[hash] = pairIndex;
+	m_hashTable[slot].proxyId1 = proxyId1;
+	m_hashTable[slot].proxyId2 = proxyId2;
+	m_hashTable[slot].pairIndex = index;
 
 	++m_pairCount;
 
+	*pairIndex = index;
 	return pair;
 }
 
@@ -157,38 +212,137 @@ void* b2PairManager::RemovePair(int32 proxyId1, int32 proxyId2)
 
 	if (proxyId1 > proxyId2) b2Swap(proxyId1, proxyId2);
 
-	int32 hash = Hash(proxyId1, proxyId2) & b2_tableMask;
+	int32 slot = FindSlot(proxyId1, proxyId2, Hash(proxyId1, proxyId2));
+	int32 index = m_hashTable[slot].pairIndex;
 
-	uint16* node = &m_hashTable[hash];
-	while (*node != b2_nullPair)
+	if (index == b2_nullPair)
 	{
-		if (Equals(m_pairs[*node], proxyId1, proxyId2))
+		b2Assert(false);
+		return NULL;
+	}
+
+	b2Pair* pair = m_pairs + index;
+	void* userData = pair->userData;
+
+	// Scrub
+	pair->next = m_freePair;
+	pair->proxyId1 = b2_nullProxy;
+	pair->proxyId2 = b2_nullProxy;
+	pair->userData = NULL;
+	pair->status = 0;
+
+	m_freePair = index;
+	--m_pairCount;
+
+	// Backward shift deletion: pull following entries of the probe sequence into the
+	// hole, so the table needs no tombstones and lookups stay short.
+	int32 hole = slot;
+	int32 next = (hole + 1) & m_tableMask;
+	while (m_hashTable[next].pairIndex != b2_nullPair)
+	{
+		int32 home = Hash(m_hashTable[next].proxyId1, m_hashTable[next].proxyId2) & m_tableMask;
+
+		// Can the entry at 'next' move back to the hole? Only if its home slot is not
+		// cyclically inside (hole, next].
+		bool homeInRange = hole <= next ? (hole < home && home <= next) : (hole < home || home <= next);
+		if (homeInRange == false)
 		{
-			uint16 index = *node;
-			*node = m_pairs[*node].next;
-			
-			b2Pair* pair = m_pairs + index;
-			void* userData = pair->userData;
-
-			// Scrub
-			pair->next = m_freePair;
-			pair->proxyId1 = b2_nullProxy;
-			pair->proxyId2 = b2_nullProxy;
-			pair->userData = NULL;
-			pair->status = 0;
-
-			m_freePair = index;
-			--m_pairCount;
-			return userData;
+			m_hashTable[hole] = m_hashTable[next];
+			hole = next;
 		}
-		else
+
+		next = (next + 1) & m_tableMask;
+	}
+
+	m_hashTable[hole].pairIndex = b2_nullPair;
+
+	return userData;
+}
+
+void b2PairManager::GrowPairs()
+{
+	b2Pair* oldPairs = m_pairs;
+	int32 oldCapacity = m_pairCapacity;
+
+	m_pairCapacity *= 2;
+	m_pairs = (b2Pair*)b2Alloc(m_pairCapacity * sizeof(b2Pair));
+	memcpy(m_pairs, oldPairs, oldCapacity * sizeof(b2Pair));
+	b2Free(oldPairs);
+
+	for (int32 i = oldCapacity; i < m_pairCapacity; ++i)
+	{
+		m_pairs[i].proxyId1 = b2_nullProxy;
+		m_pairs[i].proxyId2 = b2_nullProxy;
+		m_pairs[i].userData = NULL;
+		m_pairs[i].status = 0;
+		m_pairs[i].next = i + 1;
+	}
+	m_pairs[m_pairCapacity-1].next = m_freePair;
+	m_freePair = oldCapacity;
+
+	++m_growCount;
+}
+
+void b2PairManager::GrowTable()
+{
+	b2PairSlot* oldTable = m_hashTable;
+	int32 oldCapacity = m_tableCapacity;
+
+	m_tableCapacity *= 2;
+	m_tableMask = m_tableCapacity - 1;
+	m_hashTable = (b2PairSlot*)b2Alloc(m_tableCapacity * sizeof(b2PairSlot));
+	for (int32 i = 0; i < m_tableCapacity; ++i)
+	{
+		m_hashTable[i].pairIndex = b2_nullPair;
+	}
+
+	// Rehash the live entries.
+	for (int32 i = 0; i < oldCapacity; ++i)
+	{
+		if (oldTable[i].pairIndex == b2_nullPair)
 		{
-			node = &m_pairs[*node].next;
+			continue;
 		}
+
+		int32 slot = Hash(oldTable[i].proxyId1, oldTable[i].proxyId2) & m_tableMask;
+		while (m_hashTable[slot].pairIndex != b2_nullPair)
+		{
+			slot = (slot + 1) & m_tableMask;
+		}
+		m_hashTable[slot] = oldTable[i];
+	}
+
+	b2Free(oldTable);
+
+	++m_growCount;
+}
+
+void b2PairManager::GrowBuffer()
+{
+	b2BufferedPair* oldBuffer = m_pairBuffer;
+
+	m_pairBufferCapacity *= 2;
+	m_pairBuffer = (b2BufferedPair*)b2Alloc(m_pairBufferCapacity * sizeof(b2BufferedPair));
+	memcpy(m_pairBuffer, oldBuffer, m_pairBufferCount * sizeof(b2BufferedPair));
+	b2Free(oldBuffer);
+
+	++m_growCount;
+}
+
+void b2PairManager::BufferPair(b2Pair* pair, int32 pairIndex)
+{
+	if (m_pairBufferCount == m_pairBufferCapacity)
+	{
+		GrowBuffer();
 	}
 
-	b2Assert(false);
-	return NULL;
+	pair->SetBuffered();
+	m_pairBuffer[m_pairBufferCount].proxyId1 = pair->proxyId1;
+	m_pairBuffer[m_pairBufferCount].proxyId2 = pair->proxyId2;
+	m_pairBuffer[m_pairBufferCount].pairIndex = pairIndex;
+	++m_pairBufferCount;
+
+	b2Assert(m_pairBufferCount <= m_pairCount);
 }
 
 /*
@@ -210,9 +364,9 @@ If the added pair is not a new pair, then it must be in the pair buffer (because
 void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 {
 	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
 
-	b2Pair* pair = AddPair(id1, id2);
+	int32 pairIndex;
+	b2Pair* pair = AddPair(id1, id2, &pairIndex);
 
 	// If this pair is not in the pair buffer ...
 	if (pair->IsBuffered() == false)
@@ -221,12 +375,7 @@ void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 		b2Assert(pair->IsFinal() == false);
 
 		// Add it to the pair buffer.
-		pair->SetBuffered();
-		m_pairBuffer[m_pairBufferCount].proxyId1 = pair->proxyId1;
-		m_pairBuffer[m_pairBufferCount].proxyId2 = pair->proxyId2;
-		++m_pairBufferCount;
-
-		b2Assert(m_pairBufferCount <= m_pairCount);
+		BufferPair(pair, pairIndex);
 	}
 
 	// Confirm this pair for the subsequent call to Commit.
@@ -242,7 +391,6 @@ void b2PairManager::AddBufferedPair(int32 id1, int32 id2)
 void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 {
 	b2Assert(id1 != b2_nullProxy && id2 != b2_nullProxy);
-	b2Assert(m_pairBufferCount < b2_maxPairs);
 
 	b2Pair* pair = Find(id1, id2);
 
@@ -258,12 +406,7 @@ void b2PairManager::RemoveBufferedPair(int32 id1, int32 id2)
 		// This must be an old pair.
 		b2Assert(pair->IsFinal() == true);
 
-		pair->SetBuffered();
-		m_pairBuffer[m_pairBufferCount].proxyId1 = pair->proxyId1;
-		m_pairBuffer[m_pairBufferCount].proxyId2 = pair->proxyId2;
-		++m_pairBufferCount;
-
-		b2Assert(m_pairBufferCount <= m_pairCount);
+		BufferPair(pair, (int32)(pair - m_pairs));
 	}
 
 	pair->SetRemoved();
@@ -278,21 +421,20 @@ void b2PairManager::Commit()
 {
 	int32 removeCount = 0;
 
-	b2Proxy* proxies = m_broadPhase->m_proxyPool;
-
+	//MIGUEL MODIFICATION: Proxies are accessed through the broad-phase, as the dynamic tree has no proxy pool
 	for (int32 i = 0; i < m_pairBufferCount; ++i)
 	{
-		b2Pair* pair = Find(m_pairBuffer[i].proxyId1, m_pairBuffer[i].proxyId2);
+		// Buffered pairs keep their pool index, no need to hash them again.
+		b2Pair* pair = m_pairs + m_pairBuffer[i].pairIndex;
+		b2Assert(Equals(*pair, m_pairBuffer[i].proxyId1, m_pairBuffer[i].proxyId2));
 		b2Assert(pair->IsBuffered());
 		pair->ClearBuffered();
 
-		b2Assert(pair->proxyId1 < b2_maxProxies && pair->proxyId2 < b2_maxProxies);
-
-		b2Proxy* proxy1 = proxies + pair->proxyId1;
-		b2Proxy* proxy2 = proxies + pair->proxyId2;
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId1));
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId2));
 
-		b2Assert(proxy1->IsValid());
-		b2Assert(proxy2->IsValid());
+		void* proxyUserData1 = m_broadPhase->GetUserData(pair->proxyId1);
+		void* proxyUserData2 = m_broadPhase->GetUserData(pair->proxyId2);
 
 		if (pair->IsRemoved())
 		{
@@ -301,7 +443,7 @@ void b2PairManager::Commit()
 			// the user didn't receive a matching add.
 			if (pair->IsFinal() == true)
 			{
-				m_callback->PairRemoved(proxy1->userData, proxy2->userData, pair->userData);
+				m_callback->PairRemoved(proxyUserData1, proxyUserData2, pair->userData);
 			}
 
 			// Store the ids so we can actually remove the pair below.
@@ -311,11 +453,11 @@ void b2PairManager::Commit()
 		}
 		else
 		{
-			b2Assert(m_broadPhase->TestOverlap(proxy1, proxy2) == true);
+			b2Assert(m_broadPhase->TestProxyOverlap(pair->proxyId1, pair->proxyId2) == true);
 
 			if (pair->IsFinal() == false)
 			{
-				pair->userData = m_callback->PairAdded(proxy1->userData, proxy2->userData);
+				pair->userData = m_callback->PairAdded(proxyUserData1, proxyUserData2);
 				pair->SetFinal();
 			}
 		}
@@ -334,6 +476,27 @@ void b2PairManager::Commit()
 	}
 }
 
+void b2PairManager::GetStatistics(b2PairStatistics* stats) const
+{
+	stats->pairCount = m_pairCount;
+	stats->pairCapacity = m_pairCapacity;
+	stats->tableCapacity = m_tableCapacity;
+	stats->occupancy = float32(m_pairCount) / float32(m_tableCapacity);
+	stats->bufferCount = m_pairBufferCount;
+	stats->bufferCapacity = m_pairBufferCapacity;
+	stats->lookupCount = m_lookupCount;
+	stats->probeCount = m_probeCount;
+	stats->maxProbeLength = m_maxProbeLength;
+	stats->growCount = m_growCount;
+}
+
+void b2PairManager::ResetStatistics()
+{
+	m_lookupCount = 0;
+	m_probeCount = 0;
+	m_maxProbeLength = 0;
+}
+
 void b2PairManager::ValidateBuffer()
 {
 #ifdef _DEBUG
@@ -350,16 +513,11 @@ void b2PairManager::ValidateBuffer()
 
 		b2Pair* pair = Find(m_pairBuffer[i].proxyId1, m_pairBuffer[i].proxyId2);
 		b2Assert(pair->IsBuffered());
+		b2Assert(pair == m_pairs + m_pairBuffer[i].pairIndex);
 
 		b2Assert(pair->proxyId1 != pair->proxyId2);
-		b2Assert(pair->proxyId1 < b2_maxProxies);
-		b2Assert(pair->proxyId2 < b2_maxProxies);
-
-		b2Proxy* proxy1 = m_broadPhase->m_proxyPool + pair->proxyId1;
-		b2Proxy* proxy2 = m_broadPhase->m_proxyPool + pair->proxyId2;
-
-		b2Assert(proxy1->IsValid() == true);
-		b2Assert(proxy2->IsValid() == true);
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId1) == true);
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId2) == true);
 	}
 #endif
 }
@@ -367,30 +525,29 @@ void b2PairManager::ValidateBuffer()
 void b2PairManager::ValidateTable()
 {
 #ifdef _DEBUG
-	for (int32 i = 0; i < b2_tableCapacity; ++i)
+	int32 count = 0;
+	for (int32 i = 0; i < m_tableCapacity; ++i)
 	{
-		uint16 index = m_hashTable[i];
-		while (index != b2_nullPair)
+		int32 index = m_hashTable[i].pairIndex;
+		if (index == b2_nullPair)
 		{
-			b2Pair* pair = m_pairs + index;
-			b2Assert(pair->IsBuffered() == false);
-			b2Assert(pair->IsFinal() == true);
-			b2Assert(pair->IsRemoved() == false);
-
-			b2Assert(pair->proxyId1 != pair->proxyId2);
-			b2Assert(pair->proxyId1 < b2_maxProxies);
-			b2Assert(pair->proxyId2 < b2_maxProxies);
+			continue;
+		}
 
-			b2Proxy* proxy1 = m_broadPhase->m_proxyPool + pair->proxyId1;
-			b2Proxy* proxy2 = m_broadPhase->m_proxyPool + pair->proxyId2;
+		++count;
 
-			b2Assert(proxy1->IsValid() == true);
-			b2Assert(proxy2->IsValid() == true);
+		b2Pair* pair = m_pairs + index;
+		b2Assert(Equals(*pair, m_hashTable[i].proxyId1, m_hashTable[i].proxyId2));
+		b2Assert(pair->IsBuffered() == false);
+		b2Assert(pair->IsFinal() == true);
+		b2Assert(pair->IsRemoved() == false);
 
-			b2Assert(m_broadPhase->TestOverlap(proxy1, proxy2) == true);
+		b2Assert(pair->proxyId1 != pair->proxyId2);
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId1) == true);
+		b2Assert(m_broadPhase->IsValidProxy(pair->proxyId2) == true);
 
-			index = pair->next;
-		}
+		b2Assert(m_broadPhase->TestProxyOverlap(pair->proxyId1, pair->proxyId2) == true);
 	}
+	b2Assert(count == m_pairCount);
 #endif
 }
@@ -20,6 +20,10 @@
 // of overlapping proxies. It is based closely on code provided by Pierre Terdiman.
 // http://www.codercorner.com/IncrementalSAP.txt
 
+//MIGUEL MODIFICATION: The fixed chained hash table (uint16 ids, b2_maxPairs pairs) was replaced
+// by a growable open addressing table with 32 bit proxy ids. Pairs live in a growable pool
+// and keep their index while they exist, so buffered pairs are found without hashing.
+
 #ifndef B2_PAIR_MANAGER_H
 #define B2_PAIR_MANAGER_H
 
@@ -31,10 +35,9 @@
 class b2BroadPhase;
 struct b2Proxy;
 
-const uint16 b2_nullPair = USHRT_MAX;
-const uint16 b2_nullProxy = USHRT_MAX;
-const int32 b2_tableCapacity = b2_maxPairs;	// must be a power of two
-const int32 b2_tableMask = b2_tableCapacity - 1;
+const int32 b2_nullPair = -1;
+const int32 b2_nullProxy = -1;
+const int32 b2_initialPairCapacity = 256;		// must be a power of two, grows on demand
 
 struct b2Pair
 {
@@ -57,16 +60,41 @@ struct b2Pair
 	bool IsFinal()		{ return (status & e_pairFinal) == e_pairFinal; }
 
 	void* userData;
-	uint16 proxyId1;
-	uint16 proxyId2;
-	uint16 next;
-	uint16 status;
+	int32 proxyId1;
+	int32 proxyId2;
+	int32 next;			// free list link, only meaningful for free pairs
+	uint32 status;
 };
 
 struct b2BufferedPair
 {
-	uint16 proxyId1;
-	uint16 proxyId2;
+	int32 proxyId1;
+	int32 proxyId2;
+	int32 pairIndex;	// index in the pair pool, valid until the pair is removed on Commit
+};
+
+// A hash table slot. The proxy ids are copied in the slot so a probe compares keys
+// without touching the pair pool; consecutive slots are scanned linearly.
+struct b2PairSlot
+{
+	int32 proxyId1;
+	int32 proxyId2;
+	int32 pairIndex;	// b2_nullPair if the slot is empty
+};
+
+/// Pair manager counters, to tune the table for big levels.
+struct b2PairStatistics
+{
+	int32 pairCount;		///< live pairs
+	int32 pairCapacity;		///< pairs the pool holds before growing
+	int32 tableCapacity;	///< hash table slots
+	float32 occupancy;		///< pairCount / tableCapacity
+	int32 bufferCount;		///< pairs waiting for Commit
+	int32 bufferCapacity;	///< buffered pairs before the buffer grows
+	int32 lookupCount;		///< hash lookups since the last reset
+	int32 probeCount;		///< slots visited by those lookups
+	int32 maxProbeLength;	///< longest probe sequence since the last reset
+	int32 growCount;		///< times the table or pool was grown since creation
 };
 
 class b2PairCallback
@@ -87,6 +115,7 @@ class b2PairManager
 {
 public:
 	b2PairManager();
+	~b2PairManager();
 
 	void Initialize(b2BroadPhase* broadPhase, b2PairCallback* callback);
 
@@ -95,27 +124,47 @@ public:
 
 	void Commit();
 
+	//MIGUEL MODIFICATION: Table counters
+	void GetStatistics(b2PairStatistics* stats) const;
+	void ResetStatistics();
+
 private:
 	b2Pair* Find(int32 proxyId1, int32 proxyId2);
-	b2Pair* Find(int32 proxyId1, int32 proxyId2, uint32 hashValue);
+	int32 FindSlot(int32 proxyId1, int32 proxyId2, uint32 hashValue);
 
-	b2Pair* AddPair(int32 proxyId1, int32 proxyId2);
+	b2Pair* AddPair(int32 proxyId1, int32 proxyId2, int32* pairIndex);
 	void* RemovePair(int32 proxyId1, int32 proxyId2);
 
+	void BufferPair(b2Pair* pair, int32 pairIndex);
+
+	void GrowPairs();
+	void GrowTable();
+	void GrowBuffer();
+
 	void ValidateBuffer();
 	void ValidateTable();
 
 public:
 	b2BroadPhase *m_broadPhase;
 	b2PairCallback *m_callback;
-	b2Pair m_pairs[b2_maxPairs];
-	uint16 m_freePair;
+
+	b2Pair* m_pairs;
+	int32 m_pairCapacity;
+	int32 m_freePair;
 	int32 m_pairCount;
 
-	b2BufferedPair m_pairBuffer[b2_maxPairs];
+	b2BufferedPair* m_pairBuffer;
+	int32 m_pairBufferCapacity;
 	int32 m_pairBufferCount;
 
-	uint16 m_hashTable[b2_tableCapacity];
+	b2PairSlot* m_hashTable;
+	int32 m_tableCapacity;	// always a power of two
+	int32 m_tableMask;
+
+	int32 m_lookupCount;
+	int32 m_probeCount;
+	int32 m_maxProbeLength;
+	int32 m_growCount;
 };
 
 #endif
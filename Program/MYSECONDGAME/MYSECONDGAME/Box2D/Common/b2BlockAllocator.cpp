@@ -17,6 +17,7 @@
 */
 
 #include "b2BlockAllocator.h"
+#include "b2Math.h"
 #include <cstdlib>
 #include <memory>
 #include <climits>
@@ -64,6 +65,7 @@ b2BlockAllocator::b2BlockAllocator()
 	
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+	memset(&m_statistics, 0, sizeof(m_statistics));	//MIGUEL MODIFICATION: Allocator statistics
 
 	if (s_blockSizeLookupInitialized == false)
 	{
@@ -106,6 +108,11 @@ void* b2BlockAllocator::Allocate(int32 size)
 	int32 index = s_blockSizeLookup[size];
 	b2Assert(0 <= index && index < b2_blockSizes);
 
+	//MIGUEL MODIFICATION: Allocator statistics
+	++m_statistics.allocationCount[index];
+	++m_statistics.blockCount[index];
+	m_statistics.maxBlockCount[index] = b2Max(m_statistics.maxBlockCount[index], m_statistics.blockCount[index]);
+
 	if (m_freeLists[index])
 	{
 		b2Block* block = m_freeLists[index];
@@ -144,6 +151,7 @@ void* b2BlockAllocator::Allocate(int32 size)
 
 		m_freeLists[index] = chunk->blocks->next;
 		++m_chunkCount;
+		++m_statistics.chunkCount[index];	//MIGUEL MODIFICATION: Allocator statistics
 
 		return chunk->blocks;
 	}
@@ -188,6 +196,9 @@ void b2BlockAllocator::Free(void* p, int32 size)
 	memset(p, 0xfd, blockSize);
 #endif
 
+	b2Assert(m_statistics.blockCount[index] > 0);
+	--m_statistics.blockCount[index];	//MIGUEL MODIFICATION: Allocator statistics
+
 	b2Block* block = (b2Block*)p;
 	block->next = m_freeLists[index];
 	m_freeLists[index] = block;
@@ -204,4 +215,8 @@ void b2BlockAllocator::Clear()
 	memset(m_chunks, 0, m_chunkSpace * sizeof(b2Chunk));
 
 	memset(m_freeLists, 0, sizeof(m_freeLists));
+
+	//MIGUEL MODIFICATION: Allocator statistics. Nothing in use (counts since created are kept).
+	memset(m_statistics.blockCount, 0, sizeof(m_statistics.blockCount));
+	memset(m_statistics.chunkCount, 0, sizeof(m_statistics.chunkCount));
 }
@@ -29,9 +29,20 @@ const int32 b2_chunkArrayIncrement = 128;
 struct b2Block;
 struct b2Chunk;
 
+/// MIGUEL MODIFICATION: Allocator statistics. Blocks of each size class (see GetBlockSize).
+struct b2BlockAllocatorStatistics
+{
+	int32 blockCount[b2_blockSizes];		///< blocks in use
+	int32 maxBlockCount[b2_blockSizes];		///< most blocks in use at once
+	int32 allocationCount[b2_blockSizes];	///< allocations since created
+	int32 chunkCount[b2_blockSizes];		///< chunks (b2_chunkSize bytes) of the size class
+};
+
 // This is a small object allocator used for allocating small
 // objects that persist for more than one time step.
 // See: http://www.codeproject.com/useritems/Small_Block_Allocator.asp
+//MIGUEL MODIFICATION: Not thread safe: one allocator per thread (the world has its own,
+//and each solver worker has another one, see b2WorkerAllocator).
 class b2BlockAllocator
 {
 public:
@@ -43,6 +54,12 @@ public:
 
 	void Clear();
 
+	/// MIGUEL MODIFICATION: Get the blocks and chunks of each size class.
+	void GetStatistics(b2BlockAllocatorStatistics* stats) const { *stats = m_statistics; }
+
+	/// MIGUEL MODIFICATION: Get the block size of a size class.
+	static int32 GetBlockSize(int32 index) { b2Assert(0 <= index && index < b2_blockSizes); return s_blockSizes[index]; }
+
 private:
 
 	b2Chunk* m_chunks;
@@ -51,6 +68,8 @@ private:
 
 	b2Block* m_freeLists[b2_blockSizes];
 
+	b2BlockAllocatorStatistics m_statistics;	//MIGUEL MODIFICATION: Allocator statistics
+
 	static int32 s_blockSizes[b2_blockSizes];
 	static uint8 s_blockSizeLookup[b2_maxBlockSize + 1];
 	static bool s_blockSizeLookupInitialized;
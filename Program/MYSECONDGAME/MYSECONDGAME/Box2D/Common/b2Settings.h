@@ -73,7 +73,15 @@ const float32 b2_pi = 3.14159265359f;
 const int32 b2_maxManifoldPoints = 2;
 const int32 b2_maxPolygonVertices = 8;
 const int32 b2_maxProxies = 512;				// this must be a power of two
-const int32 b2_maxPairs = 8 * b2_maxProxies;	// this must be a power of two
+
+//MIGUEL MODIFICATION: Dynamic tree broad-phase
+/// This is used to fatten AABBs in the dynamic tree broad-phase. This allows proxies
+/// to move by a small amount without triggering a tree adjustment.
+const float32 b2_aabbExtension = 0.1f;	// 10 cm
+
+//MIGUEL MODIFICATION: Material table
+/// The number of materials a world can hold (b2World::CreateMaterial).
+const int32 b2_maxMaterials = 64;
 
 // Dynamics
 
@@ -140,6 +148,21 @@ const float32 b2_linearSleepTolerance = 0.01f;		// 1 cm/s
 /// A body cannot sleep if its angular velocity is above this tolerance.
 const float32 b2_angularSleepTolerance = 2.0f / 180.0f;		// 2 degrees/s
 
+//MIGUEL MODIFICATION: Adaptive iterations
+/// The velocity iterations of an island stop when no body velocity changed more than
+/// this in the last iteration (only with adaptive iterations enabled in the world).
+const float32 b2_linearIterationTolerance = 0.25f * b2_linearSleepTolerance;
+const float32 b2_angularIterationTolerance = 0.25f * b2_angularSleepTolerance;
+
+/// Velocity iterations always done before checking the tolerances above.
+const int32 b2_minVelocityIterations = 2;
+
+/// Islands with at least this many dynamic bodies, and as many contacts, are solved as stacks.
+const int32 b2_stackIslandBodyCount = 4;
+
+/// Bins of the iteration histograms. The last bin counts this many iterations or more.
+const int32 b2_iterationHistogramSize = 16;
+
 // Memory Allocation
 
 /// The current number of bytes allocated through b2Alloc.
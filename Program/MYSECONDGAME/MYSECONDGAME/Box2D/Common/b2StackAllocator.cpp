@@ -19,18 +19,24 @@
 #include "b2StackAllocator.h"
 #include "b2Math.h"
 
-b2StackAllocator::b2StackAllocator()
+b2StackAllocator::b2StackAllocator(int32 capacity)
 {
+	b2Assert(capacity > 0);
+	m_data = (char*)b2Alloc(capacity);
+	m_capacity = capacity;
 	m_index = 0;
 	m_allocation = 0;
 	m_maxAllocation = 0;
 	m_entryCount = 0;
+	m_heapCount = 0;
+	m_growCount = 0;
 }
 
 b2StackAllocator::~b2StackAllocator()
 {
 	b2Assert(m_index == 0);
 	b2Assert(m_entryCount == 0);
+	b2Free(m_data);
 }
 
 void* b2StackAllocator::Allocate(int32 size)
@@ -39,10 +45,11 @@ void* b2StackAllocator::Allocate(int32 size)
 
 	b2StackEntry* entry = m_entries + m_entryCount;
 	entry->size = size;
-	if (m_index + size > b2_stackSize)
+	if (m_index + size > m_capacity)
 	{
 		entry->data = (char*)b2Alloc(size);
 		entry->usedMalloc = true;
+		++m_heapCount;	//MIGUEL MODIFICATION: Allocator statistics
 	}
 	else
 	{
@@ -74,6 +81,14 @@ void b2StackAllocator::Free(void* p)
 	m_allocation -= entry->size;
 	--m_entryCount;
 
+	//MIGUEL MODIFICATION: Growable arena. All freed: grow to the high-water mark
+	//(half the size more at least, so a mark growing slowly does not reallocate every step).
+	if (m_entryCount == 0 && m_maxAllocation > m_capacity)
+	{
+		Reserve(b2Max(m_maxAllocation, m_capacity + m_capacity / 2));
+		++m_growCount;
+	}
+
 	p = NULL;
 }
 
@@ -81,3 +96,27 @@ int32 b2StackAllocator::GetMaxAllocation() const
 {
 	return m_maxAllocation;
 }
+
+//MIGUEL MODIFICATION: Growable arena
+void b2StackAllocator::Reserve(int32 capacity)
+{
+	b2Assert(m_entryCount == 0 && m_index == 0);
+	b2Assert(capacity > 0);
+	if (capacity == m_capacity)
+	{
+		return;
+	}
+
+	b2Free(m_data);
+	m_data = (char*)b2Alloc(capacity);
+	m_capacity = capacity;
+}
+
+//MIGUEL MODIFICATION: Allocator statistics
+void b2StackAllocator::GetStatistics(b2StackAllocatorStatistics* stats) const
+{
+	stats->capacity = m_capacity;
+	stats->maxAllocation = m_maxAllocation;
+	stats->heapCount = m_heapCount;
+	stats->growCount = m_growCount;
+}
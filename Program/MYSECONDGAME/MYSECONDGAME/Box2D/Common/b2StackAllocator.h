@@ -21,9 +21,18 @@
 
 #include "b2Settings.h"
 
-const int32 b2_stackSize = 100 * 1024;	// 100k
+const int32 b2_stackSize = 100 * 1024;	// 100k (MIGUEL MODIFICATION: initial size)
 const int32 b2_maxStackEntries = 32;
 
+/// MIGUEL MODIFICATION: Allocator statistics.
+struct b2StackAllocatorStatistics
+{
+	int32 capacity;			///< arena size
+	int32 maxAllocation;	///< most memory in use at once (high-water mark)
+	int32 heapCount;		///< allocations that did not fit in the arena (heap)
+	int32 growCount;		///< times the arena grew
+};
+
 struct b2StackEntry
 {
 	char* data;
@@ -34,10 +43,12 @@ struct b2StackEntry
 // This is a stack allocator used for fast per step allocations.
 // You must nest allocate/free pairs. The code will assert
 // if you try to interleave multiple allocate/free pairs.
+//MIGUEL MODIFICATION: Growable arena. Allocations that do not fit go to the heap, and
+//when all are freed the arena grows to the high-water mark, so next steps fit.
 class b2StackAllocator
 {
 public:
-	b2StackAllocator();
+	b2StackAllocator(int32 capacity = b2_stackSize);
 	~b2StackAllocator();
 
 	void* Allocate(int32 size);
@@ -45,9 +56,16 @@ public:
 
 	int32 GetMaxAllocation() const;
 
+	/// MIGUEL MODIFICATION: Set the arena size. Nothing must be allocated.
+	void Reserve(int32 capacity);
+
+	/// MIGUEL MODIFICATION: Get the arena size, high-water mark and heap usage.
+	void GetStatistics(b2StackAllocatorStatistics* stats) const;
+
 private:
 
-	char m_data[b2_stackSize];
+	char* m_data;	//MIGUEL MODIFICATION: Growable arena
+	int32 m_capacity;
 	int32 m_index;
 
 	int32 m_allocation;
@@ -55,6 +73,9 @@ private:
 
 	b2StackEntry m_entries[b2_maxStackEntries];
 	int32 m_entryCount;
+
+	int32 m_heapCount;	//MIGUEL MODIFICATION: Allocator statistics
+	int32 m_growCount;
 };
 
 #endif
@@ -0,0 +1,368 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2ThreadPool.h"
+#include "b2Math.h"
+#include <new>
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+struct b2ThreadPoolImpl;
+
+// Parameter block of a worker thread. Owned by the pool, so threads never touch the heap.
+struct b2WorkerStart
+{
+	b2ThreadPoolImpl* impl;
+	int32 workerIndex;
+};
+
+struct b2ThreadPoolImpl
+{
+	static DWORD WINAPI ThreadMain(LPVOID parameter);
+
+	int32 NextTask()
+	{
+		return InterlockedIncrement(&nextTask) - 1;
+	}
+
+	b2ThreadPool* pool;
+	b2WorkerStart* starts;
+	HANDLE* threads;
+	HANDLE* startEvents;	// One auto reset event per thread
+	HANDLE doneEvent;
+	volatile LONG nextTask;
+	volatile LONG pending;
+	volatile bool quit;
+};
+
+DWORD WINAPI b2ThreadPoolImpl::ThreadMain(LPVOID parameter)
+{
+	b2WorkerStart* start = (b2WorkerStart*)parameter;
+	b2ThreadPoolImpl* impl = start->impl;
+	int32 workerIndex = start->workerIndex;
+
+	for (;;)
+	{
+		WaitForSingleObject(impl->startEvents[workerIndex - 1], INFINITE);
+		if (impl->quit)
+		{
+			return 0;
+		}
+
+		impl->pool->DoTasks(workerIndex);
+
+		if (InterlockedDecrement(&impl->pending) == 0)
+		{
+			SetEvent(impl->doneEvent);
+		}
+	}
+}
+
+b2ThreadPool::b2ThreadPool(int32 workerCount)
+{
+	b2Assert(workerCount > 0);
+
+	m_workerCount = workerCount;
+	m_callback = NULL;
+	m_context = NULL;
+	m_taskCount = 0;
+
+	void* mem = b2Alloc(sizeof(b2ThreadPoolImpl));
+	m_impl = new (mem) b2ThreadPoolImpl;
+	m_impl->pool = this;
+	m_impl->nextTask = 0;
+	m_impl->pending = 0;
+	m_impl->quit = false;
+	m_impl->threads = NULL;
+	m_impl->starts = NULL;
+	m_impl->startEvents = NULL;
+	m_impl->doneEvent = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+	int32 threadCount = m_workerCount - 1;
+	if (threadCount > 0)
+	{
+		m_impl->threads = (HANDLE*)b2Alloc(threadCount * sizeof(HANDLE));
+		m_impl->starts = (b2WorkerStart*)b2Alloc(threadCount * sizeof(b2WorkerStart));
+		m_impl->startEvents = (HANDLE*)b2Alloc(threadCount * sizeof(HANDLE));
+	}
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		m_impl->startEvents[i] = CreateEvent(NULL, FALSE, FALSE, NULL);
+
+		b2WorkerStart* start = m_impl->starts + i;
+		start->impl = m_impl;
+		start->workerIndex = i + 1;
+		m_impl->threads[i] = CreateThread(NULL, 0, b2ThreadPoolImpl::ThreadMain, start, 0, NULL);
+		b2Assert(m_impl->threads[i] != NULL);
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	int32 threadCount = m_workerCount - 1;
+
+	m_impl->quit = true;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		SetEvent(m_impl->startEvents[i]);
+	}
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		WaitForSingleObject(m_impl->threads[i], INFINITE);
+		CloseHandle(m_impl->threads[i]);
+		CloseHandle(m_impl->startEvents[i]);
+	}
+
+	CloseHandle(m_impl->doneEvent);
+
+	if (threadCount > 0)
+	{
+		b2Free(m_impl->threads);
+		b2Free(m_impl->starts);
+		b2Free(m_impl->startEvents);
+	}
+
+	m_impl->~b2ThreadPoolImpl();
+	b2Free(m_impl);
+}
+
+void b2ThreadPool::Run(b2TaskCallback callback, void* context, int32 taskCount)
+{
+	m_callback = callback;
+	m_context = context;
+	m_taskCount = taskCount;
+	m_impl->nextTask = 0;
+
+	// Not worth waking the threads.
+	int32 threadCount = b2Min(m_workerCount, taskCount) - 1;
+	if (threadCount <= 0)
+	{
+		DoTasks(0);
+		return;
+	}
+
+	m_impl->pending = threadCount;
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		SetEvent(m_impl->startEvents[i]);
+	}
+
+	DoTasks(0);
+
+	WaitForSingleObject(m_impl->doneEvent, INFINITE);
+}
+
+#else
+
+#include <pthread.h>
+
+struct b2ThreadPoolImpl;
+
+// Parameter block of a worker thread. Owned by the pool, so threads never touch the heap.
+struct b2WorkerStart
+{
+	b2ThreadPoolImpl* impl;
+	int32 workerIndex;
+};
+
+struct b2ThreadPoolImpl
+{
+	static void* ThreadMain(void* parameter);
+
+	int32 NextTask()
+	{
+		return __sync_fetch_and_add(&nextTask, 1);
+	}
+
+	b2ThreadPool* pool;
+	b2WorkerStart* starts;
+	pthread_t* threads;
+	pthread_mutex_t mutex;
+	pthread_cond_t startCondition;
+	pthread_cond_t doneCondition;
+	int32 generation;		// Bumped on each Run, wakes the threads
+	int32 activeCount;		// Threads woken for the current Run
+	int32 nextTask;
+	int32 pending;
+	bool quit;
+};
+
+void* b2ThreadPoolImpl::ThreadMain(void* parameter)
+{
+	b2WorkerStart* start = (b2WorkerStart*)parameter;
+	b2ThreadPoolImpl* impl = start->impl;
+	int32 workerIndex = start->workerIndex;
+
+	int32 generation = 0;
+	for (;;)
+	{
+		pthread_mutex_lock(&impl->mutex);
+		while (impl->quit == false && impl->generation == generation)
+		{
+			pthread_cond_wait(&impl->startCondition, &impl->mutex);
+		}
+		generation = impl->generation;
+		bool quit = impl->quit;
+		bool active = workerIndex <= impl->activeCount;
+		pthread_mutex_unlock(&impl->mutex);
+
+		if (quit)
+		{
+			return NULL;
+		}
+
+		// Not needed for this run.
+		if (active == false)
+		{
+			continue;
+		}
+
+		impl->pool->DoTasks(workerIndex);
+
+		pthread_mutex_lock(&impl->mutex);
+		if (--impl->pending == 0)
+		{
+			pthread_cond_signal(&impl->doneCondition);
+		}
+		pthread_mutex_unlock(&impl->mutex);
+	}
+}
+
+b2ThreadPool::b2ThreadPool(int32 workerCount)
+{
+	b2Assert(workerCount > 0);
+
+	m_workerCount = workerCount;
+	m_callback = NULL;
+	m_context = NULL;
+	m_taskCount = 0;
+
+	void* mem = b2Alloc(sizeof(b2ThreadPoolImpl));
+	m_impl = new (mem) b2ThreadPoolImpl;
+	m_impl->pool = this;
+	m_impl->generation = 0;
+	m_impl->activeCount = 0;
+	m_impl->nextTask = 0;
+	m_impl->pending = 0;
+	m_impl->quit = false;
+	m_impl->threads = NULL;
+	m_impl->starts = NULL;
+	pthread_mutex_init(&m_impl->mutex, NULL);
+	pthread_cond_init(&m_impl->startCondition, NULL);
+	pthread_cond_init(&m_impl->doneCondition, NULL);
+
+	int32 threadCount = m_workerCount - 1;
+	if (threadCount > 0)
+	{
+		m_impl->threads = (pthread_t*)b2Alloc(threadCount * sizeof(pthread_t));
+		m_impl->starts = (b2WorkerStart*)b2Alloc(threadCount * sizeof(b2WorkerStart));
+	}
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		b2WorkerStart* start = m_impl->starts + i;
+		start->impl = m_impl;
+		start->workerIndex = i + 1;
+		int result = pthread_create(m_impl->threads + i, NULL, b2ThreadPoolImpl::ThreadMain, start);
+		b2Assert(result == 0);
+		(void)result;
+	}
+}
+
+b2ThreadPool::~b2ThreadPool()
+{
+	int32 threadCount = m_workerCount - 1;
+
+	pthread_mutex_lock(&m_impl->mutex);
+	m_impl->quit = true;
+	pthread_cond_broadcast(&m_impl->startCondition);
+	pthread_mutex_unlock(&m_impl->mutex);
+
+	for (int32 i = 0; i < threadCount; ++i)
+	{
+		pthread_join(m_impl->threads[i], NULL);
+	}
+
+	pthread_cond_destroy(&m_impl->doneCondition);
+	pthread_cond_destroy(&m_impl->startCondition);
+	pthread_mutex_destroy(&m_impl->mutex);
+
+	if (threadCount > 0)
+	{
+		b2Free(m_impl->threads);
+		b2Free(m_impl->starts);
+	}
+
+	m_impl->~b2ThreadPoolImpl();
+	b2Free(m_impl);
+}
+
+void b2ThreadPool::Run(b2TaskCallback callback, void* context, int32 taskCount)
+{
+	m_callback = callback;
+	m_context = context;
+	m_taskCount = taskCount;
+	m_impl->nextTask = 0;
+
+	// Not worth waking the threads.
+	int32 threadCount = b2Min(m_workerCount, taskCount) - 1;
+	if (threadCount <= 0)
+	{
+		DoTasks(0);
+		return;
+	}
+
+	pthread_mutex_lock(&m_impl->mutex);
+	m_impl->pending = threadCount;
+	m_impl->activeCount = threadCount;
+	++m_impl->generation;
+	pthread_cond_broadcast(&m_impl->startCondition);
+	pthread_mutex_unlock(&m_impl->mutex);
+
+	DoTasks(0);
+
+	pthread_mutex_lock(&m_impl->mutex);
+	while (m_impl->pending > 0)
+	{
+		pthread_cond_wait(&m_impl->doneCondition, &m_impl->mutex);
+	}
+	pthread_mutex_unlock(&m_impl->mutex);
+}
+
+#endif
+
+void b2ThreadPool::DoTasks(int32 workerIndex)
+{
+	for (;;)
+	{
+		int32 taskIndex = m_impl->NextTask();
+		if (taskIndex >= m_taskCount)
+		{
+			break;
+		}
+
+		m_callback(m_context, taskIndex, workerIndex);
+	}
+}
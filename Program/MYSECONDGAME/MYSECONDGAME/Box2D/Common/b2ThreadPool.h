@@ -0,0 +1,60 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_THREAD_POOL_H
+#define B2_THREAD_POOL_H
+
+#include "b2Settings.h"
+
+//MIGUEL MODIFICATION: Worker threads used to solve islands in parallel (see b2World::SetSolverThreadCount)
+
+struct b2ThreadPoolImpl;
+
+/// A fixed set of worker threads that run a batch of tasks and wait for it to end.
+/// The calling thread works too, as worker 0, so a pool of n workers owns n - 1 threads.
+/// Tasks are handed out one at a time, so big tasks should go first.
+class b2ThreadPool
+{
+public:
+	/// Called once per task. The worker index is in [0, GetWorkerCount()).
+	typedef void (*b2TaskCallback)(void* context, int32 taskIndex, int32 workerIndex);
+
+	b2ThreadPool(int32 workerCount);
+	~b2ThreadPool();
+
+	/// Run taskCount tasks and return when all of them are done.
+	void Run(b2TaskCallback callback, void* context, int32 taskCount);
+
+	int32 GetWorkerCount() const { return m_workerCount; }
+
+private:
+
+	friend struct b2ThreadPoolImpl;
+
+	void DoTasks(int32 workerIndex);
+
+	int32 m_workerCount;
+
+	b2TaskCallback m_callback;
+	void* m_context;
+	int32 m_taskCount;
+
+	b2ThreadPoolImpl* m_impl;
+};
+
+#endif
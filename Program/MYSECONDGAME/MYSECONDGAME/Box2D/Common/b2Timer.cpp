@@ -0,0 +1,70 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2Timer.h"
+
+#ifdef _WIN32
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+static double b2TimerNow()
+{
+	static double s_invFrequency = 0.0;
+	LARGE_INTEGER counter;
+
+	if (s_invFrequency == 0.0)
+	{
+		LARGE_INTEGER frequency;
+		QueryPerformanceFrequency(&frequency);
+		s_invFrequency = 1000.0 / double(frequency.QuadPart);
+	}
+
+	QueryPerformanceCounter(&counter);
+	return double(counter.QuadPart) * s_invFrequency;
+}
+
+#else
+
+#include <sys/time.h>
+
+static double b2TimerNow()
+{
+	timeval t;
+	gettimeofday(&t, 0);
+	return 1000.0 * double(t.tv_sec) + 0.001 * double(t.tv_usec);
+}
+
+#endif
+
+b2Timer::b2Timer()
+{
+	Reset();
+}
+
+void b2Timer::Reset()
+{
+	m_start = b2TimerNow();
+}
+
+float32 b2Timer::GetMilliseconds() const
+{
+	return float32(b2TimerNow() - m_start);
+}
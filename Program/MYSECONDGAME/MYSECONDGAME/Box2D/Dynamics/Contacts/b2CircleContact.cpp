@@ -54,13 +54,15 @@ void b2CircleContact::Evaluate(b2ContactListener* listener)
 	b2Manifold m0;
 	memcpy(&m0, &m_manifold, sizeof(b2Manifold));
 
-	b2CollideCircles(&m_manifold, (b2CircleShape*)m_shape1, b1->GetXForm(), (b2CircleShape*)m_shape2, b2->GetXForm());
+	//MIGUEL MODIFICATION: Speculative contacts. Look ahead by the motion of the next step.
+	float32 margin = b1->GetSpeculativeDistance() + b2->GetSpeculativeDistance();
+
+	b2CollideCircles(&m_manifold, (b2CircleShape*)m_shape1, b1->GetXForm(), (b2CircleShape*)m_shape2, b2->GetXForm(), margin);
 
 	b2ContactPoint cp;
 	cp.shape1 = m_shape1;
 	cp.shape2 = m_shape2;
-	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
-	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+	MixMaterials(&cp.friction, &cp.restitution);	//MIGUEL MODIFICATION: Material table
 
 	if (m_manifold.pointCount > 0)
 	{
@@ -71,42 +73,57 @@ void b2CircleContact::Evaluate(b2ContactListener* listener)
 		{
 			mp->normalImpulse = 0.0f;
 			mp->tangentImpulse = 0.0f;
-
-			if (listener)
-			{
-				cp.position = b1->GetWorldPoint(mp->localPoint1);
-				b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
-				b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
-				cp.velocity = v2 - v1;
-				cp.normal = m_manifold.normal;
-				cp.separation = mp->separation;
-				cp.id = mp->id;
-				listener->Add(&cp);
-			}
 		}
 		else
 		{
 			b2ManifoldPoint* mp0 = m0.points + 0;
 			mp->normalImpulse = mp0->normalImpulse;
 			mp->tangentImpulse = mp0->tangentImpulse;
+		}
+
+		//MIGUEL MODIFICATION: Speculative contacts. A point ahead of the shapes is solved,
+		//but the listener only hears about it once the shapes touch.
+		bool touching = margin == 0.0f || mp->separation <= 0.0f;
+		bool reported = (m_flags & e_reportedFlag) == e_reportedFlag;
 
-			if (listener)
+		if (listener && (touching || reported))
+		{
+			cp.position = b1->GetWorldPoint(mp->localPoint1);
+			b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
+			b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
+			cp.velocity = v2 - v1;
+			cp.normal = m_manifold.normal;
+			cp.separation = mp->separation;
+			cp.id = mp->id;
+			if (touching == false)
+			{
+				listener->Remove(&cp);
+			}
+			else if (reported)
 			{
-				cp.position = b1->GetWorldPoint(mp->localPoint1);
-				b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
-				b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
-				cp.velocity = v2 - v1;
-				cp.normal = m_manifold.normal;
-				cp.separation = mp->separation;
-				cp.id = mp->id;
 				listener->Persist(&cp);
 			}
+			else
+			{
+				listener->Add(&cp);
+			}
+		}
+
+		if (touching)
+		{
+			m_flags |= e_reportedFlag;
+		}
+		else
+		{
+			m_flags &= ~e_reportedFlag;
 		}
 	}
 	else
 	{
 		m_manifoldCount = 0;
-		if (m0.pointCount > 0 && listener)
+		bool reported = (m_flags & e_reportedFlag) == e_reportedFlag;
+		m_flags &= ~e_reportedFlag;
+		if (reported && listener)
 		{
 			b2ManifoldPoint* mp0 = m0.points + 0;
 			cp.position = b1->GetWorldPoint(mp0->localPoint1);
@@ -25,6 +25,9 @@
 #include "b2ContactSolver.h"
 #include "../../Collision/b2Collision.h"
 #include "../../Collision/Shapes/b2Shape.h"
+#include "../../Collision/Shapes/b2CircleShape.h"
+#include "../../Collision/Shapes/b2PolygonShape.h"
+#include "../../Collision/Shapes/b2EdgeShape.h"
 #include "../../Common/b2BlockAllocator.h"
 #include "../../Dynamics/b2World.h"
 #include "../../Dynamics/b2Body.h"
@@ -121,6 +124,8 @@ void b2Contact::Destroy(b2Contact* contact, b2BlockAllocator* allocator)
 b2Contact::b2Contact(b2Shape* s1, b2Shape* s2)
 {
 	m_flags = 0;
+	m_toiIndex = -1;
+	m_separationBound = 0.0f;	//MIGUEL MODIFICATION: Separation bound
 
 	if (s1->IsSensor() || s2->IsSensor())
 	{
@@ -146,6 +151,152 @@ b2Contact::b2Contact(b2Shape* s1, b2Shape* s2)
 	m_node2.other = NULL;
 }
 
+//MIGUEL MODIFICATION: Separation bound
+// Largest separation of the vertices of polygon 2 along the face normals of polygon 1.
+// A positive separation is a lower bound of the distance of the polygons.
+static float32 b2FaceSeparation(const b2Vec2* vertices1, const b2Vec2* normals1, int32 count1, const b2XForm& xf1,
+								const b2Vec2* vertices2, int32 count2, const b2XForm& xf2)
+{
+	// Vertices of polygon 2 in the frame of polygon 1.
+	b2Vec2 local2[b2_maxPolygonVertices];
+	for (int32 j = 0; j < count2; ++j)
+	{
+		local2[j] = b2MulT(xf1, b2Mul(xf2, vertices2[j]));
+	}
+
+	float32 maxSeparation = -B2_FLT_MAX;
+	for (int32 i = 0; i < count1; ++i)
+	{
+		float32 separation = B2_FLT_MAX;
+		for (int32 j = 0; j < count2; ++j)
+		{
+			separation = b2Min(separation, b2Dot(normals1[i], local2[j] - vertices1[i]));
+		}
+		maxSeparation = b2Max(maxSeparation, separation);
+	}
+
+	return maxSeparation;
+}
+
+// Lower bound of the distance of two shapes, 0 if they may touch or the pair is not handled.
+// Shapes are in the order of the contact registers.
+static float32 b2ComputeSeparationBound(const b2Shape* shape1, const b2XForm& xf1, const b2Shape* shape2, const b2XForm& xf2)
+{
+	b2ShapeType type1 = shape1->GetType();
+	b2ShapeType type2 = shape2->GetType();
+	float32 separation = 0.0f;
+
+	if (type2 == e_circleShape)
+	{
+		const b2CircleShape* circle = (const b2CircleShape*)shape2;
+		b2Vec2 center = b2MulT(xf1, b2Mul(xf2, circle->GetLocalPosition()));
+
+		if (type1 == e_circleShape)
+		{
+			const b2CircleShape* circle1 = (const b2CircleShape*)shape1;
+			separation = b2Distance(circle1->GetLocalPosition(), center) - circle1->GetRadius();
+		}
+		else if (type1 == e_polygonShape)
+		{
+			// Any face of the polygon with the center in front bounds the distance.
+			const b2PolygonShape* polygon = (const b2PolygonShape*)shape1;
+			const b2Vec2* vertices = polygon->GetVertices();
+			const b2Vec2* normals = polygon->GetNormals();
+			separation = -B2_FLT_MAX;
+			for (int32 i = 0; i < polygon->GetVertexCount(); ++i)
+			{
+				separation = b2Max(separation, b2Dot(normals[i], center - vertices[i]));
+			}
+		}
+		else if (type1 == e_edgeShape)
+		{
+			// Distance of the center to the segment.
+			const b2EdgeShape* edge = (const b2EdgeShape*)shape1;
+			b2Vec2 d = center - edge->GetVertex1();
+			float32 t = b2Clamp(b2Dot(d, edge->GetDirectionVector()), 0.0f, edge->GetLength());
+			separation = b2Distance(center, edge->GetVertex1() + t * edge->GetDirectionVector());
+		}
+		else
+		{
+			return 0.0f;
+		}
+
+		separation -= circle->GetRadius();
+	}
+	else if (type1 == e_polygonShape && type2 == e_polygonShape)
+	{
+		const b2PolygonShape* polygon1 = (const b2PolygonShape*)shape1;
+		const b2PolygonShape* polygon2 = (const b2PolygonShape*)shape2;
+		separation = b2Max(
+			b2FaceSeparation(polygon1->GetVertices(), polygon1->GetNormals(), polygon1->GetVertexCount(), xf1,
+							 polygon2->GetVertices(), polygon2->GetVertexCount(), xf2),
+			b2FaceSeparation(polygon2->GetVertices(), polygon2->GetNormals(), polygon2->GetVertexCount(), xf2,
+							 polygon1->GetVertices(), polygon1->GetVertexCount(), xf1));
+	}
+	else if (type1 == e_polygonShape && type2 == e_edgeShape)
+	{
+		// The edge as a polygon of two vertices, with its normal on both sides.
+		const b2PolygonShape* polygon = (const b2PolygonShape*)shape1;
+		const b2EdgeShape* edge = (const b2EdgeShape*)shape2;
+		b2Vec2 edgeVertices[2] = {edge->GetVertex1(), edge->GetVertex2()};
+		b2Vec2 edgeNormals[2] = {edge->GetNormalVector(), -edge->GetNormalVector()};
+		separation = b2Max(
+			b2FaceSeparation(polygon->GetVertices(), polygon->GetNormals(), polygon->GetVertexCount(), xf1,
+							 edgeVertices, 2, xf2),
+			b2FaceSeparation(edgeVertices, edgeNormals, 2, xf2,
+							 polygon->GetVertices(), polygon->GetVertexCount(), xf1));
+	}
+
+	return b2Max(separation, 0.0f);
+}
+
+bool b2Contact::IsSeparated() const
+{
+	if (m_separationBound <= 0.0f)
+	{
+		return false;
+	}
+
+	// The farthest point of a shape moves less than the center motion plus the rotation
+	// times the sweep radius (of the core shape, so the TOI slop is added). Speculative
+	// contacts look ahead by a margin.
+	const b2Body* body1 = m_shape1->GetBody();
+	const b2Body* body2 = m_shape2->GetBody();
+	float32 radius1 = m_shape1->GetSweepRadius() + b2_toiSlop;
+	float32 radius2 = m_shape2->GetSweepRadius() + b2_toiSlop;
+	float32 motion = b2Distance(body1->GetWorldCenter(), m_center1) + b2Abs(body1->GetAngle() - m_angle1) * radius1;
+	motion += b2Distance(body2->GetWorldCenter(), m_center2) + b2Abs(body2->GetAngle() - m_angle2) * radius2;
+	motion += body1->GetSpeculativeDistance() + body2->GetSpeculativeDistance();
+
+	return motion < m_separationBound;
+}
+
+//MIGUEL MODIFICATION: Material table
+void b2Contact::MixMaterials(float32* friction, float32* restitution) const
+{
+	float32 friction1 = m_shape1->GetFriction();
+	float32 restitution1 = m_shape1->GetRestitution();
+	float32 friction2 = m_shape2->GetFriction();
+	float32 restitution2 = m_shape2->GetRestitution();
+
+	if (m_shape1->GetMaterial() != b2_nullMaterial)
+	{
+		const b2Material& material = m_shape1->GetBody()->GetWorld()->GetMaterial(m_shape1->GetMaterial());
+		friction1 = material.friction;
+		restitution1 = material.restitution;
+	}
+
+	if (m_shape2->GetMaterial() != b2_nullMaterial)
+	{
+		const b2Material& material = m_shape2->GetBody()->GetWorld()->GetMaterial(m_shape2->GetMaterial());
+		friction2 = material.friction;
+		restitution2 = material.restitution;
+	}
+
+	*friction = b2MixFriction(friction1, friction2);
+	*restitution = b2MixRestitution(restitution1, restitution2);
+}
+
 void b2Contact::Update(b2ContactListener* listener)
 {
 	int32 oldCount = GetManifoldCount();
@@ -157,14 +308,47 @@ void b2Contact::Update(b2ContactListener* listener)
 	b2Body* body1 = m_shape1->GetBody();
 	b2Body* body2 = m_shape2->GetBody();
 
+	//MIGUEL MODIFICATION: Separation bound. Apart shapes keep how far they are.
+	m_separationBound = 0.0f;
+	if (newCount == 0)
+	{
+		m_separationBound = b2ComputeSeparationBound(m_shape1, body1->GetXForm(), m_shape2, body2->GetXForm());
+		m_center1 = body1->GetWorldCenter();
+		m_center2 = body2->GetWorldCenter();
+		m_angle1 = body1->GetAngle();
+		m_angle2 = body2->GetAngle();
+	}
+
 	if (newCount == 0 && oldCount > 0)
 	{
 		body1->WakeUp();
 		body2->WakeUp();
 	}
 
+	//MIGUEL MODIFICATION: Persistent islands. Touching solid contacts join the islands of their bodies.
+	if ((m_flags & e_nonSolidFlag) == 0)
+	{
+		if (oldCount == 0 && newCount > 0)
+		{
+			body1->GetWorld()->LinkIslands(body1, body2);
+		}
+		else if (oldCount > 0 && newCount == 0)
+		{
+			body1->GetWorld()->UnlinkIslands(body1, body2);
+		}
+	}
+
 	// Slow contacts don't generate TOI events.
-	if (body1->IsStatic() || body1->IsBullet() || body2->IsStatic() || body2->IsBullet())
+	//MIGUEL MODIFICATION: Speculative contacts. Circle contacts between speculative or static
+	//bodies are handled by the contact solver, they don't need TOI either.
+	bool speculative = (body1->IsStatic() || body1->IsSpeculative()) &&
+						(body2->IsStatic() || body2->IsSpeculative()) &&
+						(m_shape1->GetType() == e_circleShape || m_shape2->GetType() == e_circleShape);
+	if (speculative)
+	{
+		m_flags |= e_slowFlag;
+	}
+	else if (body1->IsStatic() || body1->IsBullet() || body2->IsStatic() || body2->IsBullet())
 	{
 		m_flags &= ~e_slowFlag;
 	}
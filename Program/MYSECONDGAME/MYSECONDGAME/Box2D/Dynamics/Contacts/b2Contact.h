@@ -117,6 +117,8 @@ public:
 		e_slowFlag		= 0x0002,
 		e_islandFlag	= 0x0004,
 		e_toiFlag		= 0x0008,
+		e_reportedFlag	= 0x0010,	// MIGUEL MODIFICATION: Speculative contacts. The listener knows the point.
+		e_reusedFlag	= 0x0020,	// MIGUEL MODIFICATION: Manifold reuse. The last update kept the manifold.
 	};
 
 	static void AddType(b2ContactCreateFcn* createFcn, b2ContactDestroyFcn* destroyFcn,
@@ -125,12 +127,21 @@ public:
 	static b2Contact* Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator);
 	static void Destroy(b2Contact* contact, b2BlockAllocator* allocator);
 
-	b2Contact() : m_shape1(NULL), m_shape2(NULL) {}
+	b2Contact() : m_shape1(NULL), m_shape2(NULL), m_toiIndex(-1) {}
 	b2Contact(b2Shape* shape1, b2Shape* shape2);
 	virtual ~b2Contact() {}
 
 	void Update(b2ContactListener* listener);
 	virtual void Evaluate(b2ContactListener* listener) = 0;
+
+	// MIGUEL MODIFICATION: Separation bound. True if the shapes can't touch yet: they were apart
+	// by more than their bodies moved since the last update (Update is not needed).
+	bool IsSeparated() const;
+
+	// MIGUEL MODIFICATION: Material table. Mixed friction and restitution of the shapes, from the
+	// world materials for shapes with one.
+	void MixMaterials(float32* friction, float32* restitution) const;
+
 	static b2ContactRegister s_registers[e_shapeTypeCount][e_shapeTypeCount];
 	static bool s_initialized;
 
@@ -149,6 +160,17 @@ public:
 	b2Shape* m_shape2;
 
 	float32 m_toi;
+
+	// MIGUEL MODIFICATION: TOI event queue. Position in the world TOI queue, -1 if not queued.
+	int32 m_toiIndex;
+
+	// MIGUEL MODIFICATION: Separation bound. Lower bound of the distance of the shapes in the
+	// last update without points (0 if unknown or touching) and the body positions then.
+	float32 m_separationBound;
+	b2Vec2 m_center1;
+	b2Vec2 m_center2;
+	float32 m_angle1;
+	float32 m_angle2;
 };
 
 inline int32 b2Contact::GetManifoldCount() const
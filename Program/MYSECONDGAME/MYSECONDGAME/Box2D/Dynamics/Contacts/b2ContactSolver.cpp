@@ -24,11 +24,22 @@
 
 #define B2_DEBUG_SOLVER 0
 
-b2ContactSolver::b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator)
+b2ContactSolver::b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator,
+								 b2Body** bodies, int32 bodyCount)
 {
 	m_step = step;
 	m_allocator = allocator;
 
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	m_bodies = NULL;
+	m_bodyCount = 0;
+	m_batchMemory = NULL;
+	m_batches = NULL;
+	m_batchCount = 0;
+	m_colorCount = 0;
+	m_batchedCount = 0;
+	m_slotCount = 0;
+
 	m_constraintCount = 0;
 	for (int32 i = 0; i < contactCount; ++i)
 	{
@@ -50,8 +61,9 @@ b2ContactSolver::b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, i
 		int32 manifoldCount = contact->GetManifoldCount();
 		b2Manifold* manifolds = contact->GetManifolds();
 
-		float32 friction = b2MixFriction(shape1->GetFriction(), shape2->GetFriction());
-		float32 restitution = b2MixRestitution(shape1->GetRestitution(), shape2->GetRestitution());
+		//MIGUEL MODIFICATION: Material table. Read each step: material changes need no Refilter.
+		float32 friction, restitution;
+		contact->MixMaterials(&friction, &restitution);
 
 		b2Vec2 v1 = b1->m_linearVelocity;
 		b2Vec2 v2 = b2->m_linearVelocity;
@@ -75,6 +87,7 @@ b2ContactSolver::b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, i
 			cc->pointCount = manifold->pointCount;
 			cc->friction = friction;
 			cc->restitution = restitution;
+			cc->batched = false;
 
 			for (int32 k = 0; k < cc->pointCount; ++k)
 			{
@@ -176,13 +189,39 @@ b2ContactSolver::b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, i
 	}
 
 	b2Assert(count == m_constraintCount);
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+#ifndef TARGET_FLOAT32_IS_FIXED
+	if (step.contactSolverType == e_simdContactSolver && bodies != NULL)
+	{
+		BuildBatches(bodies, bodyCount);
+	}
+#else
+	B2_NOT_USED(bodies);
+	B2_NOT_USED(bodyCount);
+#endif
 }
 
 b2ContactSolver::~b2ContactSolver()
 {
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	if (m_batchMemory != NULL)
+	{
+		FreeBatches();
+	}
+
 	m_allocator->Free(m_constraints);
 }
 
+//MIGUEL MODIFICATION: SIMD contact solver mode
+void b2ContactSolver::GetStatistics(b2ContactSolverStatistics* stats) const
+{
+	stats->constraintCount = m_constraintCount;
+	stats->batchedConstraintCount = m_batchedCount;
+	stats->batchCount = m_batchCount;
+	stats->colorCount = m_colorCount;
+}
+
 void b2ContactSolver::InitVelocityConstraints(const b2TimeStep& step)
 {
 	// Warm start.
@@ -223,13 +262,30 @@ void b2ContactSolver::InitVelocityConstraints(const b2TimeStep& step)
 			}
 		}
 	}
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode. The batches start from the warm started impulses.
+	if (m_batchCount > 0)
+	{
+		LoadBatchImpulses();
+	}
 }
 
 void b2ContactSolver::SolveVelocityConstraints()
 {
+	//MIGUEL MODIFICATION: SIMD contact solver mode. Batches first, then the rest one by one.
+	if (m_batchCount > 0)
+	{
+		SolveVelocityBatches();
+	}
+
 	for (int32 i = 0; i < m_constraintCount; ++i)
 	{
 		b2ContactConstraint* c = m_constraints + i;
+		if (c->batched)
+		{
+			continue;
+		}
+
 		b2Body* b1 = c->body1;
 		b2Body* b2 = c->body2;
 		float32 w1 = b1->m_angularVelocity;
@@ -526,6 +582,12 @@ void b2ContactSolver::SolveVelocityConstraints()
 
 void b2ContactSolver::FinalizeVelocityConstraints()
 {
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	if (m_batchCount > 0)
+	{
+		StoreBatchImpulses();
+	}
+
 	for (int32 i = 0; i < m_constraintCount; ++i)
 	{
 		b2ContactConstraint* c = m_constraints + i;
@@ -545,9 +607,20 @@ bool b2ContactSolver::SolvePositionConstraints(float32 baumgarte)
 {
 	float32 minSeparation = 0.0f;
 
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	if (m_batchCount > 0)
+	{
+		minSeparation = SolvePositionBatches(baumgarte);
+	}
+
 	for (int32 i = 0; i < m_constraintCount; ++i)
 	{
 		b2ContactConstraint* c = m_constraints + i;
+		if (c->batched)
+		{
+			continue;
+		}
+
 		b2Body* b1 = c->body1;
 		b2Body* b2 = c->body2;
 		float32 invMass1 = b1->m_mass * b1->m_invMass;
@@ -27,6 +27,7 @@ class b2Contact;
 class b2Body;
 class b2Island;
 class b2StackAllocator;
+struct b2ContactBatch;
 
 struct b2ContactConstraintPoint
 {
@@ -55,12 +56,17 @@ struct b2ContactConstraint
 	float32 friction;
 	float32 restitution;
 	int32 pointCount;
+	//MIGUEL MODIFICATION: SIMD contact solver mode. Batched constraints are skipped by the scalar loops.
+	bool batched;
 };
 
 class b2ContactSolver
 {
 public:
-	b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator);
+	//MIGUEL MODIFICATION: SIMD contact solver mode. The SIMD mode is used if the step asks for it and
+	// the island bodies are given (their island index is the slot of their velocity and position).
+	b2ContactSolver(const b2TimeStep& step, b2Contact** contacts, int32 contactCount, b2StackAllocator* allocator,
+					b2Body** bodies = NULL, int32 bodyCount = 0);
 	~b2ContactSolver();
 
 	void InitVelocityConstraints(const b2TimeStep& step);
@@ -69,10 +75,42 @@ public:
 
 	bool SolvePositionConstraints(float32 baumgarte);
 
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	void GetStatistics(b2ContactSolverStatistics* stats) const;
+
 	b2TimeStep m_step;
 	b2StackAllocator* m_allocator;
 	b2ContactConstraint* m_constraints;
 	int m_constraintCount;
+
+private:
+	//MIGUEL MODIFICATION: SIMD contact solver mode (b2ContactSolverSIMD.cpp)
+	void BuildBatches(b2Body** bodies, int32 bodyCount);
+	void FreeBatches();
+	void LoadBatchImpulses();
+	void StoreBatchImpulses();
+	void SolveVelocityBatches();
+	float32 SolvePositionBatches(float32 baumgarte);
+	static void SetBatchLane(b2ContactBatch* batch, int32 lane, b2ContactConstraint* c, int32 slot1, int32 slot2);
+	int32 SetStaticSlot(int32 slot, const b2Body* body);
+
+	b2Body** m_bodies;
+	int32 m_bodyCount;
+
+	void* m_batchMemory;				// Unaligned block holding the batches
+	b2ContactBatch* m_batches;			// Batches, 16 byte aligned, sorted by color
+	int32 m_batchCount;
+	int32 m_colorCount;
+	int32 m_batchedCount;
+
+	// Body state gathered for the batches, indexed by slot (island index for the island bodies).
+	int32 m_slotCount;
+	float32* m_velocityX;
+	float32* m_velocityY;
+	float32* m_angularVelocity;
+	float32* m_positionX;
+	float32* m_positionY;
+	float32* m_angle;
 };
 
 #endif
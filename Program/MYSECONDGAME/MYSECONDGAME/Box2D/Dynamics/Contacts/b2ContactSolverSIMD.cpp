@@ -0,0 +1,639 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+//MIGUEL MODIFICATION: SIMD contact solver mode (see b2ContactSolver.h)
+//
+// Single point constraints are colored so that the constraints of one color share no
+// dynamic body, then packed in batches of 4 (one per SSE lane). Batches of a color are
+// independent, colors are solved one after the other. Static bodies are only read, so
+// any number of lanes may use them. Two point constraints (block solver) and the ones
+// that find no free color stay in the scalar loops of b2ContactSolver.
+
+#include "b2ContactSolver.h"
+#include "b2Contact.h"
+#include "../b2Body.h"
+#include "../../Common/b2StackAllocator.h"
+
+#ifndef TARGET_FLOAT32_IS_FIXED
+
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+
+#include <xmmintrin.h>
+
+typedef __m128 b2Float4;
+
+inline b2Float4 b2Load4(const float32* p) { return _mm_load_ps(p); }
+inline void b2Store4(float32* p, b2Float4 a) { _mm_store_ps(p, a); }
+inline b2Float4 b2Set4(float32 a, float32 b, float32 c, float32 d) { return _mm_setr_ps(a, b, c, d); }
+inline b2Float4 b2Splat4(float32 a) { return _mm_set1_ps(a); }
+inline b2Float4 b2Add4(b2Float4 a, b2Float4 b) { return _mm_add_ps(a, b); }
+inline b2Float4 b2Sub4(b2Float4 a, b2Float4 b) { return _mm_sub_ps(a, b); }
+inline b2Float4 b2Mul4(b2Float4 a, b2Float4 b) { return _mm_mul_ps(a, b); }
+inline b2Float4 b2Min4(b2Float4 a, b2Float4 b) { return _mm_min_ps(a, b); }
+inline b2Float4 b2Max4(b2Float4 a, b2Float4 b) { return _mm_max_ps(a, b); }
+
+#else
+
+// Plain version for targets without SSE. Same layout, one lane at a time.
+struct b2Float4
+{
+	float32 x[4];
+};
+
+inline b2Float4 b2Load4(const float32* p) { b2Float4 r; for (int32 i = 0; i < 4; ++i) r.x[i] = p[i]; return r; }
+inline void b2Store4(float32* p, b2Float4 a) { for (int32 i = 0; i < 4; ++i) p[i] = a.x[i]; }
+inline b2Float4 b2Set4(float32 a, float32 b, float32 c, float32 d) { b2Float4 r; r.x[0] = a; r.x[1] = b; r.x[2] = c; r.x[3] = d; return r; }
+inline b2Float4 b2Splat4(float32 a) { return b2Set4(a, a, a, a); }
+inline b2Float4 b2Add4(b2Float4 a, b2Float4 b) { for (int32 i = 0; i < 4; ++i) a.x[i] += b.x[i]; return a; }
+inline b2Float4 b2Sub4(b2Float4 a, b2Float4 b) { for (int32 i = 0; i < 4; ++i) a.x[i] -= b.x[i]; return a; }
+inline b2Float4 b2Mul4(b2Float4 a, b2Float4 b) { for (int32 i = 0; i < 4; ++i) a.x[i] *= b.x[i]; return a; }
+inline b2Float4 b2Min4(b2Float4 a, b2Float4 b) { for (int32 i = 0; i < 4; ++i) a.x[i] = b2Min(a.x[i], b.x[i]); return a; }
+inline b2Float4 b2Max4(b2Float4 a, b2Float4 b) { for (int32 i = 0; i < 4; ++i) a.x[i] = b2Max(a.x[i], b.x[i]); return a; }
+
+#endif
+
+const int32 b2_maxContactColors = 32;	// One bit per color in the body masks
+
+// 4 contact constraints in structure of arrays form. Sizes are multiples of 16 bytes.
+struct b2ContactBatch
+{
+	// Velocity constraints
+	float32 normalX[4];
+	float32 normalY[4];
+	float32 r1X[4];
+	float32 r1Y[4];
+	float32 r2X[4];
+	float32 r2Y[4];
+	float32 invMass1[4];
+	float32 invI1[4];
+	float32 invMass2[4];
+	float32 invI2[4];
+	float32 normalMass[4];
+	float32 tangentMass[4];
+	float32 velocityBias[4];
+	float32 friction[4];
+	float32 normalImpulse[4];
+	float32 tangentImpulse[4];
+
+	// Position constraints. Anchors are relative to the body centers of mass.
+	float32 localAnchor1X[4];
+	float32 localAnchor1Y[4];
+	float32 localAnchor2X[4];
+	float32 localAnchor2Y[4];
+	float32 separation[4];
+	float32 equalizedMass[4];
+	float32 positionInvMass1[4];
+	float32 positionInvI1[4];
+	float32 positionInvMass2[4];
+	float32 positionInvI2[4];
+
+	// Slots of the bodies in the gathered state: the island index of dynamic bodies, a slot of
+	// the lane for static bodies, the empty slot for empty lanes.
+	int32 slot1[4];
+	int32 slot2[4];
+	b2ContactConstraintPoint* points[4];	// NULL for empty lanes
+};
+
+void b2ContactSolver::SetBatchLane(b2ContactBatch* batch, int32 lane, b2ContactConstraint* c, int32 slot1, int32 slot2)
+{
+	b2ContactConstraintPoint* ccp = c->points + 0;
+	b2Body* b1 = c->body1;
+	b2Body* b2 = c->body2;
+
+	batch->normalX[lane] = c->normal.x;
+	batch->normalY[lane] = c->normal.y;
+	batch->r1X[lane] = ccp->r1.x;
+	batch->r1Y[lane] = ccp->r1.y;
+	batch->r2X[lane] = ccp->r2.x;
+	batch->r2Y[lane] = ccp->r2.y;
+	batch->invMass1[lane] = b1->m_invMass;
+	batch->invI1[lane] = b1->m_invI;
+	batch->invMass2[lane] = b2->m_invMass;
+	batch->invI2[lane] = b2->m_invI;
+	batch->normalMass[lane] = ccp->normalMass;
+	batch->tangentMass[lane] = ccp->tangentMass;
+	batch->velocityBias[lane] = ccp->velocityBias;
+	batch->friction[lane] = c->friction;
+	batch->normalImpulse[lane] = 0.0f;
+	batch->tangentImpulse[lane] = 0.0f;
+
+	b2Vec2 localAnchor1 = ccp->localAnchor1 - b1->GetLocalCenter();
+	b2Vec2 localAnchor2 = ccp->localAnchor2 - b2->GetLocalCenter();
+	batch->localAnchor1X[lane] = localAnchor1.x;
+	batch->localAnchor1Y[lane] = localAnchor1.y;
+	batch->localAnchor2X[lane] = localAnchor2.x;
+	batch->localAnchor2Y[lane] = localAnchor2.y;
+	batch->separation[lane] = ccp->separation;
+	batch->equalizedMass[lane] = ccp->equalizedMass;
+	batch->positionInvMass1[lane] = b1->m_mass * b1->m_invMass;
+	batch->positionInvI1[lane] = b1->m_mass * b1->m_invI;
+	batch->positionInvMass2[lane] = b2->m_mass * b2->m_invMass;
+	batch->positionInvI2[lane] = b2->m_mass * b2->m_invI;
+
+	batch->slot1[lane] = slot1;
+	batch->slot2[lane] = slot2;
+	batch->points[lane] = ccp;
+}
+
+// An empty lane has no mass and no bodies, so it never produces an impulse. Its slots are the
+// empty slot, which stays zero.
+static void b2ClearLane(b2ContactBatch* batch, int32 lane, int32 emptySlot)
+{
+	batch->normalX[lane] = 0.0f;
+	batch->normalY[lane] = 0.0f;
+	batch->r1X[lane] = 0.0f;
+	batch->r1Y[lane] = 0.0f;
+	batch->r2X[lane] = 0.0f;
+	batch->r2Y[lane] = 0.0f;
+	batch->invMass1[lane] = 0.0f;
+	batch->invI1[lane] = 0.0f;
+	batch->invMass2[lane] = 0.0f;
+	batch->invI2[lane] = 0.0f;
+	batch->normalMass[lane] = 0.0f;
+	batch->tangentMass[lane] = 0.0f;
+	batch->velocityBias[lane] = 0.0f;
+	batch->friction[lane] = 0.0f;
+	batch->normalImpulse[lane] = 0.0f;
+	batch->tangentImpulse[lane] = 0.0f;
+
+	batch->localAnchor1X[lane] = 0.0f;
+	batch->localAnchor1Y[lane] = 0.0f;
+	batch->localAnchor2X[lane] = 0.0f;
+	batch->localAnchor2Y[lane] = 0.0f;
+	batch->separation[lane] = B2_FLT_MAX;		// Never the minimum separation
+	batch->equalizedMass[lane] = 0.0f;
+	batch->positionInvMass1[lane] = 0.0f;
+	batch->positionInvI1[lane] = 0.0f;
+	batch->positionInvMass2[lane] = 0.0f;
+	batch->positionInvI2[lane] = 0.0f;
+
+	batch->slot1[lane] = emptySlot;
+	batch->slot2[lane] = emptySlot;
+	batch->points[lane] = NULL;
+}
+
+void b2ContactSolver::BuildBatches(b2Body** bodies, int32 bodyCount)
+{
+	m_bodies = bodies;
+	m_bodyCount = bodyCount;
+
+	// Worst case: every color but the last batch of each is full.
+	int32 maxBatchCount = b2Min(m_constraintCount, m_constraintCount / 4 + b2_maxContactColors);
+	m_batchMemory = m_allocator->Allocate(maxBatchCount * sizeof(b2ContactBatch) + 15);
+	m_batches = (b2ContactBatch*)(((size_t)m_batchMemory + 15) & ~(size_t)15);
+
+	// Slots: the island bodies, one for each single point constraint with a static body (at most),
+	// and the empty slot. Static bodies don't move during the solve, their state is copied once to
+	// the slots of their lanes, so gathers and scatters never branch. Scatters don't change it.
+	int32 staticCount = 0;
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+		if (c->pointCount == 1 && (c->body1->IsStatic() || c->body2->IsStatic()))
+		{
+			++staticCount;
+		}
+	}
+	m_slotCount = bodyCount + staticCount + 1;
+	int32 emptySlot = m_slotCount - 1;
+
+	m_velocityX = (float32*)m_allocator->Allocate(6 * m_slotCount * sizeof(float32));
+	m_velocityY = m_velocityX + m_slotCount;
+	m_angularVelocity = m_velocityY + m_slotCount;
+	m_positionX = m_angularVelocity + m_slotCount;
+	m_positionY = m_positionX + m_slotCount;
+	m_angle = m_positionY + m_slotCount;
+	m_velocityX[emptySlot] = 0.0f;
+	m_velocityY[emptySlot] = 0.0f;
+	m_angularVelocity[emptySlot] = 0.0f;
+	m_positionX[emptySlot] = 0.0f;
+	m_positionY[emptySlot] = 0.0f;
+	m_angle[emptySlot] = 0.0f;
+
+	// The island index of a body is its slot. Islands solved on the thread pool are copies
+	// of a bigger island, so refresh it. Static bodies are shared, never write them.
+	for (int32 i = 0; i < bodyCount; ++i)
+	{
+		if (bodies[i]->IsStatic() == false)
+		{
+			bodies[i]->m_islandIndex = i;
+		}
+	}
+
+	int32* colors = (int32*)m_allocator->Allocate(m_constraintCount * sizeof(int32));
+	uint32* bodyColors = (uint32*)m_allocator->Allocate(bodyCount * sizeof(uint32));
+	memset(bodyColors, 0, bodyCount * sizeof(uint32));
+
+	// Greedy coloring: the first color used by neither dynamic body.
+	int32 colorSizes[b2_maxContactColors];
+	for (int32 i = 0; i < b2_maxContactColors; ++i)
+	{
+		colorSizes[i] = 0;
+	}
+
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		b2ContactConstraint* c = m_constraints + i;
+		colors[i] = -1;
+
+		if (c->pointCount != 1)
+		{
+			continue;
+		}
+
+		int32 slot1 = c->body1->IsStatic() ? -1 : c->body1->m_islandIndex;
+		int32 slot2 = c->body2->IsStatic() ? -1 : c->body2->m_islandIndex;
+		b2Assert(slot1 < bodyCount && (slot1 < 0 || bodies[slot1] == c->body1));
+		b2Assert(slot2 < bodyCount && (slot2 < 0 || bodies[slot2] == c->body2));
+
+		uint32 used = 0;
+		if (slot1 >= 0) used |= bodyColors[slot1];
+		if (slot2 >= 0) used |= bodyColors[slot2];
+
+		if (used == 0xFFFFFFFF)
+		{
+			// Out of colors, leave it to the scalar loop.
+			continue;
+		}
+
+		int32 color = 0;
+		while (used & (1 << color))
+		{
+			++color;
+		}
+
+		uint32 bit = 1 << color;
+		if (slot1 >= 0) bodyColors[slot1] |= bit;
+		if (slot2 >= 0) bodyColors[slot2] |= bit;
+
+		colors[i] = color;
+		++colorSizes[color];
+		++m_batchedCount;
+	}
+
+	// First batch of each color.
+	int32 colorStarts[b2_maxContactColors];
+	int32 colorFill[b2_maxContactColors];
+	for (int32 i = 0; i < b2_maxContactColors; ++i)
+	{
+		colorStarts[i] = m_batchCount;
+		colorFill[i] = 0;
+		m_batchCount += (colorSizes[i] + 3) / 4;
+		if (colorSizes[i] > 0)
+		{
+			++m_colorCount;
+		}
+	}
+	b2Assert(m_batchCount <= maxBatchCount);
+
+	int32 staticSlot = bodyCount;
+	for (int32 i = 0; i < m_constraintCount; ++i)
+	{
+		int32 color = colors[i];
+		if (color < 0)
+		{
+			continue;
+		}
+
+		b2ContactConstraint* c = m_constraints + i;
+		int32 slot1 = c->body1->IsStatic() ? SetStaticSlot(staticSlot++, c->body1) : c->body1->m_islandIndex;
+		int32 slot2 = c->body2->IsStatic() ? SetStaticSlot(staticSlot++, c->body2) : c->body2->m_islandIndex;
+		b2Assert(staticSlot <= emptySlot);
+
+		int32 index = colorFill[color]++;
+		SetBatchLane(m_batches + colorStarts[color] + index / 4, index & 3, c, slot1, slot2);
+		c->batched = true;
+	}
+
+	// Fill the last batch of each color.
+	for (int32 i = 0; i < b2_maxContactColors; ++i)
+	{
+		for (int32 index = colorFill[i]; (index & 3) != 0; ++index)
+		{
+			b2ClearLane(m_batches + colorStarts[i] + index / 4, index & 3, emptySlot);
+		}
+	}
+
+	m_allocator->Free(bodyColors);
+	m_allocator->Free(colors);
+
+	if (m_batchCount == 0)
+	{
+		FreeBatches();
+	}
+}
+
+int32 b2ContactSolver::SetStaticSlot(int32 slot, const b2Body* body)
+{
+	m_velocityX[slot] = body->m_linearVelocity.x;
+	m_velocityY[slot] = body->m_linearVelocity.y;
+	m_angularVelocity[slot] = body->m_angularVelocity;
+	m_positionX[slot] = body->m_sweep.c.x;
+	m_positionY[slot] = body->m_sweep.c.y;
+	m_angle[slot] = body->m_sweep.a;
+	return slot;
+}
+
+void b2ContactSolver::FreeBatches()
+{
+	m_allocator->Free(m_velocityX);
+	m_allocator->Free(m_batchMemory);
+	m_batchMemory = NULL;
+	m_batches = NULL;
+}
+
+void b2ContactSolver::LoadBatchImpulses()
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactBatch* batch = m_batches + i;
+		for (int32 lane = 0; lane < 4; ++lane)
+		{
+			if (batch->points[lane] != NULL)
+			{
+				batch->normalImpulse[lane] = batch->points[lane]->normalImpulse;
+				batch->tangentImpulse[lane] = batch->points[lane]->tangentImpulse;
+			}
+		}
+	}
+}
+
+void b2ContactSolver::StoreBatchImpulses()
+{
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactBatch* batch = m_batches + i;
+		for (int32 lane = 0; lane < 4; ++lane)
+		{
+			if (batch->points[lane] != NULL)
+			{
+				batch->points[lane]->normalImpulse = batch->normalImpulse[lane];
+				batch->points[lane]->tangentImpulse = batch->tangentImpulse[lane];
+			}
+		}
+	}
+}
+
+// Gather a body value of the 4 lanes.
+inline b2Float4 b2Gather4(const float32* array, const int32* slots)
+{
+	return b2Set4(array[slots[0]], array[slots[1]], array[slots[2]], array[slots[3]]);
+}
+
+// Write back a value of the 4 lanes. The lanes of a batch have different dynamic bodies
+// (colors), the values of static bodies and empty lanes are written back unchanged.
+inline void b2Scatter4(float32* array, const int32* slots, b2Float4 value)
+{
+	float32 values[4];
+	memcpy(values, &value, sizeof(values));
+	array[slots[0]] = values[0];
+	array[slots[1]] = values[1];
+	array[slots[2]] = values[2];
+	array[slots[3]] = values[3];
+}
+
+void b2ContactSolver::SolveVelocityBatches()
+{
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		m_velocityX[i] = b->m_linearVelocity.x;
+		m_velocityY[i] = b->m_linearVelocity.y;
+		m_angularVelocity[i] = b->m_angularVelocity;
+	}
+
+	const b2Float4 zero = b2Splat4(0.0f);
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactBatch* batch = m_batches + i;
+
+		b2Float4 v1X = b2Gather4(m_velocityX, batch->slot1);
+		b2Float4 v1Y = b2Gather4(m_velocityY, batch->slot1);
+		b2Float4 w1 = b2Gather4(m_angularVelocity, batch->slot1);
+		b2Float4 v2X = b2Gather4(m_velocityX, batch->slot2);
+		b2Float4 v2Y = b2Gather4(m_velocityY, batch->slot2);
+		b2Float4 w2 = b2Gather4(m_angularVelocity, batch->slot2);
+
+		b2Float4 normalX = b2Load4(batch->normalX);
+		b2Float4 normalY = b2Load4(batch->normalY);
+		b2Float4 r1X = b2Load4(batch->r1X);
+		b2Float4 r1Y = b2Load4(batch->r1Y);
+		b2Float4 r2X = b2Load4(batch->r2X);
+		b2Float4 r2Y = b2Load4(batch->r2Y);
+		b2Float4 invMass1 = b2Load4(batch->invMass1);
+		b2Float4 invI1 = b2Load4(batch->invI1);
+		b2Float4 invMass2 = b2Load4(batch->invMass2);
+		b2Float4 invI2 = b2Load4(batch->invI2);
+
+		// Normal constraint, as the single point case of the scalar solver.
+		{
+			// Relative velocity at contact: dv = v2 + w2 x r2 - v1 - w1 x r1
+			b2Float4 dvX = b2Sub4(b2Sub4(v2X, b2Mul4(w2, r2Y)), b2Sub4(v1X, b2Mul4(w1, r1Y)));
+			b2Float4 dvY = b2Sub4(b2Add4(v2Y, b2Mul4(w2, r2X)), b2Add4(v1Y, b2Mul4(w1, r1X)));
+
+			b2Float4 vn = b2Add4(b2Mul4(dvX, normalX), b2Mul4(dvY, normalY));
+			b2Float4 lambda = b2Mul4(b2Load4(batch->normalMass), b2Sub4(b2Load4(batch->velocityBias), vn));
+
+			// Clamp the accumulated impulse
+			b2Float4 oldImpulse = b2Load4(batch->normalImpulse);
+			b2Float4 newImpulse = b2Max4(b2Add4(oldImpulse, lambda), zero);
+			lambda = b2Sub4(newImpulse, oldImpulse);
+			b2Store4(batch->normalImpulse, newImpulse);
+
+			// Apply contact impulse
+			b2Float4 PX = b2Mul4(lambda, normalX);
+			b2Float4 PY = b2Mul4(lambda, normalY);
+			v1X = b2Sub4(v1X, b2Mul4(invMass1, PX));
+			v1Y = b2Sub4(v1Y, b2Mul4(invMass1, PY));
+			w1 = b2Sub4(w1, b2Mul4(invI1, b2Sub4(b2Mul4(r1X, PY), b2Mul4(r1Y, PX))));
+			v2X = b2Add4(v2X, b2Mul4(invMass2, PX));
+			v2Y = b2Add4(v2Y, b2Mul4(invMass2, PY));
+			w2 = b2Add4(w2, b2Mul4(invI2, b2Sub4(b2Mul4(r2X, PY), b2Mul4(r2Y, PX))));
+		}
+
+		// Tangent constraint. tangent = normal x 1
+		{
+			b2Float4 tangentX = normalY;
+			b2Float4 tangentY = b2Sub4(zero, normalX);
+
+			b2Float4 dvX = b2Sub4(b2Sub4(v2X, b2Mul4(w2, r2Y)), b2Sub4(v1X, b2Mul4(w1, r1Y)));
+			b2Float4 dvY = b2Sub4(b2Add4(v2Y, b2Mul4(w2, r2X)), b2Add4(v1Y, b2Mul4(w1, r1X)));
+
+			b2Float4 vt = b2Add4(b2Mul4(dvX, tangentX), b2Mul4(dvY, tangentY));
+			b2Float4 lambda = b2Mul4(b2Load4(batch->tangentMass), b2Sub4(zero, vt));
+
+			// Clamp the accumulated force
+			b2Float4 maxFriction = b2Mul4(b2Load4(batch->friction), b2Load4(batch->normalImpulse));
+			b2Float4 oldImpulse = b2Load4(batch->tangentImpulse);
+			b2Float4 newImpulse = b2Max4(b2Min4(b2Add4(oldImpulse, lambda), maxFriction), b2Sub4(zero, maxFriction));
+			lambda = b2Sub4(newImpulse, oldImpulse);
+			b2Store4(batch->tangentImpulse, newImpulse);
+
+			// Apply contact impulse
+			b2Float4 PX = b2Mul4(lambda, tangentX);
+			b2Float4 PY = b2Mul4(lambda, tangentY);
+			v1X = b2Sub4(v1X, b2Mul4(invMass1, PX));
+			v1Y = b2Sub4(v1Y, b2Mul4(invMass1, PY));
+			w1 = b2Sub4(w1, b2Mul4(invI1, b2Sub4(b2Mul4(r1X, PY), b2Mul4(r1Y, PX))));
+			v2X = b2Add4(v2X, b2Mul4(invMass2, PX));
+			v2Y = b2Add4(v2Y, b2Mul4(invMass2, PY));
+			w2 = b2Add4(w2, b2Mul4(invI2, b2Sub4(b2Mul4(r2X, PY), b2Mul4(r2Y, PX))));
+		}
+
+		b2Scatter4(m_velocityX, batch->slot1, v1X);
+		b2Scatter4(m_velocityY, batch->slot1, v1Y);
+		b2Scatter4(m_angularVelocity, batch->slot1, w1);
+		b2Scatter4(m_velocityX, batch->slot2, v2X);
+		b2Scatter4(m_velocityY, batch->slot2, v2Y);
+		b2Scatter4(m_angularVelocity, batch->slot2, w2);
+	}
+
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		if (b->IsStatic())
+		{
+			continue;
+		}
+
+		b->m_linearVelocity.Set(m_velocityX[i], m_velocityY[i]);
+		b->m_angularVelocity = m_angularVelocity[i];
+	}
+}
+
+float32 b2ContactSolver::SolvePositionBatches(float32 baumgarte)
+{
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		m_positionX[i] = b->m_sweep.c.x;
+		m_positionY[i] = b->m_sweep.c.y;
+		m_angle[i] = b->m_sweep.a;
+	}
+
+	const b2Float4 zero = b2Splat4(0.0f);
+	const b2Float4 baumgarte4 = b2Splat4(baumgarte);
+	const b2Float4 linearSlop = b2Splat4(b2_linearSlop);
+	const b2Float4 maxCorrection = b2Splat4(-b2_maxLinearCorrection);
+	b2Float4 minSeparation = b2Splat4(0.0f);
+
+	for (int32 i = 0; i < m_batchCount; ++i)
+	{
+		b2ContactBatch* batch = m_batches + i;
+
+		b2Float4 c1X = b2Gather4(m_positionX, batch->slot1);
+		b2Float4 c1Y = b2Gather4(m_positionY, batch->slot1);
+		b2Float4 a1 = b2Gather4(m_angle, batch->slot1);
+		b2Float4 c2X = b2Gather4(m_positionX, batch->slot2);
+		b2Float4 c2Y = b2Gather4(m_positionY, batch->slot2);
+		b2Float4 a2 = b2Gather4(m_angle, batch->slot2);
+
+		// Rotations of the current angles. There is no SSE sine, so one lane at a time.
+		float32 angles1[4], angles2[4];
+		memcpy(angles1, &a1, sizeof(angles1));
+		memcpy(angles2, &a2, sizeof(angles2));
+		b2Float4 cos1 = b2Set4(cosf(angles1[0]), cosf(angles1[1]), cosf(angles1[2]), cosf(angles1[3]));
+		b2Float4 sin1 = b2Set4(sinf(angles1[0]), sinf(angles1[1]), sinf(angles1[2]), sinf(angles1[3]));
+		b2Float4 cos2 = b2Set4(cosf(angles2[0]), cosf(angles2[1]), cosf(angles2[2]), cosf(angles2[3]));
+		b2Float4 sin2 = b2Set4(sinf(angles2[0]), sinf(angles2[1]), sinf(angles2[2]), sinf(angles2[3]));
+
+		b2Float4 localAnchor1X = b2Load4(batch->localAnchor1X);
+		b2Float4 localAnchor1Y = b2Load4(batch->localAnchor1Y);
+		b2Float4 localAnchor2X = b2Load4(batch->localAnchor2X);
+		b2Float4 localAnchor2Y = b2Load4(batch->localAnchor2Y);
+
+		b2Float4 r1X = b2Sub4(b2Mul4(cos1, localAnchor1X), b2Mul4(sin1, localAnchor1Y));
+		b2Float4 r1Y = b2Add4(b2Mul4(sin1, localAnchor1X), b2Mul4(cos1, localAnchor1Y));
+		b2Float4 r2X = b2Sub4(b2Mul4(cos2, localAnchor2X), b2Mul4(sin2, localAnchor2Y));
+		b2Float4 r2Y = b2Add4(b2Mul4(sin2, localAnchor2X), b2Mul4(cos2, localAnchor2Y));
+
+		b2Float4 dpX = b2Sub4(b2Add4(c2X, r2X), b2Add4(c1X, r1X));
+		b2Float4 dpY = b2Sub4(b2Add4(c2Y, r2Y), b2Add4(c1Y, r1Y));
+
+		b2Float4 normalX = b2Load4(batch->normalX);
+		b2Float4 normalY = b2Load4(batch->normalY);
+
+		// Approximate the current separation.
+		b2Float4 separation = b2Add4(b2Add4(b2Mul4(dpX, normalX), b2Mul4(dpY, normalY)), b2Load4(batch->separation));
+
+		// Track max constraint error.
+		minSeparation = b2Min4(minSeparation, separation);
+
+		// Prevent large corrections and allow slop.
+		b2Float4 C = b2Mul4(baumgarte4, b2Max4(b2Min4(b2Add4(separation, linearSlop), zero), maxCorrection));
+
+		// Compute normal impulse
+		b2Float4 impulse = b2Sub4(zero, b2Mul4(b2Load4(batch->equalizedMass), C));
+
+		b2Float4 PX = b2Mul4(impulse, normalX);
+		b2Float4 PY = b2Mul4(impulse, normalY);
+
+		b2Float4 invMass1 = b2Load4(batch->positionInvMass1);
+		b2Float4 invI1 = b2Load4(batch->positionInvI1);
+		b2Float4 invMass2 = b2Load4(batch->positionInvMass2);
+		b2Float4 invI2 = b2Load4(batch->positionInvI2);
+
+		c1X = b2Sub4(c1X, b2Mul4(invMass1, PX));
+		c1Y = b2Sub4(c1Y, b2Mul4(invMass1, PY));
+		a1 = b2Sub4(a1, b2Mul4(invI1, b2Sub4(b2Mul4(r1X, PY), b2Mul4(r1Y, PX))));
+		c2X = b2Add4(c2X, b2Mul4(invMass2, PX));
+		c2Y = b2Add4(c2Y, b2Mul4(invMass2, PY));
+		a2 = b2Add4(a2, b2Mul4(invI2, b2Sub4(b2Mul4(r2X, PY), b2Mul4(r2Y, PX))));
+
+		b2Scatter4(m_positionX, batch->slot1, c1X);
+		b2Scatter4(m_positionY, batch->slot1, c1Y);
+		b2Scatter4(m_angle, batch->slot1, a1);
+		b2Scatter4(m_positionX, batch->slot2, c2X);
+		b2Scatter4(m_positionY, batch->slot2, c2Y);
+		b2Scatter4(m_angle, batch->slot2, a2);
+	}
+
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		b2Body* b = m_bodies[i];
+		if (b->IsStatic())
+		{
+			continue;
+		}
+
+		b->m_sweep.c.Set(m_positionX[i], m_positionY[i]);
+		b->m_sweep.a = m_angle[i];
+		b->SynchronizeTransform();
+	}
+
+	float32 separations[4];
+	memcpy(separations, &minSeparation, sizeof(separations));
+	return b2Min(b2Min(separations[0], separations[1]), b2Min(separations[2], separations[3]));
+}
+
+#else
+
+// The SIMD mode needs floating point, b2ContactSolver never builds batches.
+void b2ContactSolver::BuildBatches(b2Body** bodies, int32 bodyCount) { B2_NOT_USED(bodies); B2_NOT_USED(bodyCount); b2Assert(false); }
+int32 b2ContactSolver::SetStaticSlot(int32 slot, const b2Body* body) { B2_NOT_USED(body); b2Assert(false); return slot; }
+void b2ContactSolver::FreeBatches() { b2Assert(false); }
+void b2ContactSolver::LoadBatchImpulses() { b2Assert(false); }
+void b2ContactSolver::StoreBatchImpulses() { b2Assert(false); }
+void b2ContactSolver::SolveVelocityBatches() { b2Assert(false); }
+float32 b2ContactSolver::SolvePositionBatches(float32 baumgarte) { B2_NOT_USED(baumgarte); b2Assert(false); return 0.0f; }
+
+#endif
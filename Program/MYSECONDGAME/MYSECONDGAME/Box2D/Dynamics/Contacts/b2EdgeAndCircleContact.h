@@ -37,9 +37,11 @@ public:
 	~b2EdgeAndCircleContact() {}
 
 	void Evaluate(b2ContactListener* listener);
+	//MIGUEL MODIFICATION: Speculative contacts. Shapes up to margin apart get a point with positive separation.
 	void b2CollideEdgeAndCircle(b2Manifold* manifold,
 									  const b2EdgeShape* edge, const b2XForm& xf1,
-									  const b2CircleShape* circle, const b2XForm& xf2);
+									  const b2CircleShape* circle, const b2XForm& xf2,
+									  float32 margin = 0.0f);
 	b2Manifold* GetManifolds()
 	{
 		return &m_manifold;
@@ -18,12 +18,18 @@
 
 #include "b2PolyAndCircleContact.h"
 #include "../b2Body.h"
+#include "../b2World.h"
 #include "../b2WorldCallbacks.h"
 #include "../../Common/b2BlockAllocator.h"
+#include "../../Collision/Shapes/b2CircleShape.h"
 
 #include <new>
 #include <cstring>
 
+//MIGUEL MODIFICATION: Manifold reuse. Most motion of the points relative to the shapes
+//since the manifold was computed (the solver follows it from the anchors).
+const float32 b2_manifoldReuseDistance = 0.25f * b2_linearSlop;
+
 b2Contact* b2PolyAndCircleContact::Create(b2Shape* shape1, b2Shape* shape2, b2BlockAllocator* allocator)
 {
 	void* mem = allocator->Allocate(sizeof(b2PolyAndCircleContact));
@@ -42,6 +48,33 @@ b2PolyAndCircleContact::b2PolyAndCircleContact(b2Shape* s1, b2Shape* s2)
 	b2Assert(m_shape1->GetType() == e_polygonShape);
 	b2Assert(m_shape2->GetType() == e_circleShape);
 	m_manifold.pointCount = 0;
+	m_localCenter.SetZero();	//MIGUEL MODIFICATION: Manifold reuse
+	m_angle = 0.0f;
+}
+
+//MIGUEL MODIFICATION: Manifold reuse. Approximate, only if the world allows it.
+bool b2PolyAndCircleContact::IsManifoldReusable() const
+{
+	if (m_manifold.pointCount == 0 || (m_flags & e_reportedFlag) == 0 || m_shape1->GetBody()->GetWorld()->GetManifoldReuse() == false)
+	{
+		return false;
+	}
+
+	for (int32 i = 0; i < m_manifold.pointCount; ++i)
+	{
+		if (m_manifold.points[i].separation > 0.0f)
+		{
+			return false;
+		}
+	}
+
+	const b2Body* b1 = m_shape1->GetBody();
+	const b2Body* b2 = m_shape2->GetBody();
+	const b2CircleShape* circle = (const b2CircleShape*)m_shape2;
+	b2Vec2 localCenter = b2MulT(b1->GetXForm(), b2Mul(b2->GetXForm(), circle->GetLocalPosition()));
+	float32 angle = b2->GetAngle() - b1->GetAngle();
+	float32 motion = b2Distance(localCenter, m_localCenter) + b2Abs(angle - m_angle) * (circle->GetSweepRadius() + b2_toiSlop);
+	return motion < b2_manifoldReuseDistance;
 }
 
 void b2PolyAndCircleContact::Evaluate(b2ContactListener* listener)
@@ -49,18 +82,56 @@ void b2PolyAndCircleContact::Evaluate(b2ContactListener* listener)
 	b2Body* b1 = m_shape1->GetBody();
 	b2Body* b2 = m_shape2->GetBody();
 
+	//MIGUEL MODIFICATION: Manifold reuse. Touching shapes which almost didn't move relative to
+	//each other since the manifold was computed keep it. Its points are reported as persistent.
+	if (IsManifoldReusable())
+	{
+		m_flags |= e_reusedFlag;
+		if (listener != NULL)
+		{
+			b2ContactPoint cp;
+			cp.shape1 = m_shape1;
+			cp.shape2 = m_shape2;
+			MixMaterials(&cp.friction, &cp.restitution);	//MIGUEL MODIFICATION: Material table
+			cp.normal = m_manifold.normal;
+			for (int32 i = 0; i < m_manifold.pointCount; ++i)
+			{
+				b2ManifoldPoint* mp = m_manifold.points + i;
+				cp.position = b1->GetWorldPoint(mp->localPoint1);
+				b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
+				b2Vec2 v2 = b2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
+				cp.velocity = v2 - v1;
+				cp.separation = mp->separation;
+				cp.id = mp->id;
+				listener->Persist(&cp);
+			}
+		}
+		return;
+	}
+
+	//MIGUEL MODIFICATION: Manifold reuse. Relative pose of the new manifold.
+	m_flags &= ~e_reusedFlag;
+	const b2CircleShape* circle = (const b2CircleShape*)m_shape2;
+	m_localCenter = b2MulT(b1->GetXForm(), b2Mul(b2->GetXForm(), circle->GetLocalPosition()));
+	m_angle = b2->GetAngle() - b1->GetAngle();
+
 	b2Manifold m0;
 	memcpy(&m0, &m_manifold, sizeof(b2Manifold));
 
-	b2CollidePolygonAndCircle(&m_manifold, (b2PolygonShape*)m_shape1, b1->GetXForm(), (b2CircleShape*)m_shape2, b2->GetXForm());
+	//MIGUEL MODIFICATION: Speculative contacts. Look ahead by the motion of the next step. A point
+	//ahead of the shapes is solved, but the listener only hears about it once the shapes touch.
+	float32 margin = b1->GetSpeculativeDistance() + b2->GetSpeculativeDistance();
+	bool reported = (m_flags & e_reportedFlag) == e_reportedFlag;
+	m_flags &= ~e_reportedFlag;
+
+	b2CollidePolygonAndCircle(&m_manifold, (b2PolygonShape*)m_shape1, b1->GetXForm(), (b2CircleShape*)m_shape2, b2->GetXForm(), margin);
 
 	bool persisted[b2_maxManifoldPoints] = {false, false};
 
 	b2ContactPoint cp;
 	cp.shape1 = m_shape1;
 	cp.shape2 = m_shape2;
-	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
-	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+	MixMaterials(&cp.friction, &cp.restitution);	//MIGUEL MODIFICATION: Material table
 
 	// Match contact ids to facilitate warm starting.
 	if (m_manifold.pointCount > 0)
@@ -75,6 +146,12 @@ void b2PolyAndCircleContact::Evaluate(b2ContactListener* listener)
 			bool found = false;
 			b2ContactID id = mp->id;
 
+			bool touching = margin == 0.0f || mp->separation <= 0.0f;
+			if (touching)
+			{
+				m_flags |= e_reportedFlag;
+			}
+
 			for (int32 j = 0; j < m0.pointCount; ++j)
 			{
 				if (persisted[j] == true)
@@ -93,8 +170,8 @@ void b2PolyAndCircleContact::Evaluate(b2ContactListener* listener)
 					// A persistent point.
 					found = true;
 
-					// Report persistent point.
-					if (listener != NULL)
+					// Report persistent point (removed if it moved ahead of the shapes).
+					if (listener != NULL && reported)
 					{
 						cp.position = b1->GetWorldPoint(mp->localPoint1);
 						b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
@@ -103,14 +180,21 @@ void b2PolyAndCircleContact::Evaluate(b2ContactListener* listener)
 						cp.normal = m_manifold.normal;
 						cp.separation = mp->separation;
 						cp.id = id;
-						listener->Persist(&cp);
+						if (touching)
+						{
+							listener->Persist(&cp);
+						}
+						else
+						{
+							listener->Remove(&cp);
+						}
 					}
 					break;
 				}
 			}
 
 			// Report added point.
-			if (found == false && listener != NULL)
+			if ((found == false || reported == false) && touching && listener != NULL)
 			{
 				cp.position = b1->GetWorldPoint(mp->localPoint1);
 				b2Vec2 v1 = b1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
@@ -138,7 +222,7 @@ void b2PolyAndCircleContact::Evaluate(b2ContactListener* listener)
 	// Report removed points.
 	for (int32 i = 0; i < m0.pointCount; ++i)
 	{
-		if (persisted[i])
+		if (persisted[i] || reported == false)
 		{
 			continue;
 		}
@@ -38,7 +38,16 @@ public:
 		return &m_manifold;
 	}
 
+	// MIGUEL MODIFICATION: Manifold reuse. True if the shapes are touching and almost didn't move
+	// relative to each other since the manifold was computed (Evaluate keeps it).
+	bool IsManifoldReusable() const;
+
 	b2Manifold m_manifold;
+
+	// MIGUEL MODIFICATION: Manifold reuse. Circle center in the frame of the polygon and
+	// relative angle of the bodies when the manifold was computed.
+	b2Vec2 m_localCenter;
+	float32 m_angle;
 };
 
 #endif
@@ -61,8 +61,7 @@ void b2PolyAndEdgeContact::Evaluate(b2ContactListener* listener)
 	b2ContactPoint cp;
 	cp.shape1 = m_shape1;
 	cp.shape2 = m_shape2;
-	cp.friction = b2MixFriction(m_shape1->GetFriction(), m_shape2->GetFriction());
-	cp.restitution = b2MixRestitution(m_shape1->GetRestitution(), m_shape2->GetRestitution());
+	MixMaterials(&cp.friction, &cp.restitution);	//MIGUEL MODIFICATION: Material table
 
 	// Match contact ids to facilitate warm starting.
 	if (m_manifold.pointCount > 0)
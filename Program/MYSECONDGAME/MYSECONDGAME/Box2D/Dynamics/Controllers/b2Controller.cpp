@@ -48,6 +48,16 @@ void b2Controller::AddBody(b2Body* body)
 	if(body->m_controllerList)
 		body->m_controllerList->prevController = edge;
 	body->m_controllerList = edge;
+
+	//MIGUEL MODIFICATION: Persistent islands. The bodies of an island binding controller are in one island.
+	if (m_bindIsland)
+	{
+		b2Body* other = GetIslandBody(body);
+		if (other)
+		{
+			m_world->LinkIslands(body, other);
+		}
+	}
 }
 
 void b2Controller::RemoveBody(b2Body* body)
@@ -63,6 +73,16 @@ void b2Controller::RemoveBody(b2Body* body)
 	//Assert that we are removing a body that is currently attached to the controller
 	b2Assert(edge!=NULL);
 
+	//MIGUEL MODIFICATION: Persistent islands. The island may have to be split.
+	if (m_bindIsland)
+	{
+		b2Body* other = GetIslandBody(body);
+		if (other)
+		{
+			m_world->UnlinkIslands(body, other);
+		}
+	}
+
 	//Remove edge from controller list
 	if(edge->prevBody)
 		edge->prevBody->nextBody = edge->nextBody;
@@ -86,6 +106,17 @@ void b2Controller::RemoveBody(b2Body* body)
 
 void b2Controller::Clear(){
 
+	//MIGUEL MODIFICATION: Persistent islands. All the bodies are in one island, it may have to be split.
+	if (m_bindIsland && m_bodyList)
+	{
+		b2Body* body = GetIslandBody(NULL);
+		b2Body* other = body ? GetIslandBody(body) : NULL;
+		if (other)
+		{
+			m_world->UnlinkIslands(body, other);
+		}
+	}
+
 	while(m_bodyList)
 	{
 		b2ControllerEdge* edge = m_bodyList;
@@ -108,3 +139,16 @@ void b2Controller::Clear(){
 	m_bodyCount = 0;
 }
 
+//MIGUEL MODIFICATION: Persistent islands
+b2Body* b2Controller::GetIslandBody(b2Body* skip) const
+{
+	for (b2ControllerEdge* edge = m_bodyList; edge; edge = edge->nextBody)
+	{
+		if (edge->body != skip && edge->body->IsStatic() == false)
+		{
+			return edge->body;
+		}
+	}
+
+	return NULL;
+}
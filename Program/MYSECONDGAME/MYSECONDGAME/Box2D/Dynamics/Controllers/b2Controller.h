@@ -54,14 +54,26 @@ public:
 	/// Controllers override this to provide debug drawing.
 	virtual void Draw(b2DebugDraw *debugDraw) {B2_NOT_USED(debugDraw);};
 
+	//MIGUEL MODIFICATION: Body list functions are virtual, for controllers keeping their own body data.
 	/// Adds a body to the controller list.
-	void AddBody(b2Body* body);
+	virtual void AddBody(b2Body* body);
 
 	/// Removes a body from the controller list.
-	void RemoveBody(b2Body* body);
+	virtual void RemoveBody(b2Body* body);
 
 	/// Removes all bodies from the controller list.
-	void Clear();
+	virtual void Clear();
+
+	//MIGUEL MODIFICATION: World snapshots. Controllers keeping state between steps override these.
+	/// Get the number of values of the controller state.
+	virtual int32 GetStateSize() const { return 0; }
+
+	/// Copy the controller state (values changed at run time and impulses kept for warm starting).
+	/// @param values room for GetStateSize() values.
+	virtual void GetState(float32* values) const { (void)values; }
+
+	/// Restore a controller state copied with GetState.
+	virtual void SetState(const float32* values) { (void)values; }
 
 	/// Get the next controller in the world's body list.
 	b2Controller* GetNext();
@@ -81,10 +93,14 @@ protected:
 	b2ControllerEdge* m_bodyList;
 	int32 m_bodyCount;
 
+	//MIGUEL MODIFICATION: Island binding. If set, all the controller bodies are solved in the same island.
+	bool m_bindIsland;
+
 	b2Controller(const b2ControllerDef* def):
 		m_world(NULL),
 		m_bodyList(NULL),
 		m_bodyCount(0),
+		m_bindIsland(false),
 		m_prev(NULL),
 		m_next(NULL)
 		
@@ -94,6 +110,9 @@ protected:
 	virtual void Destroy(b2BlockAllocator* allocator) = 0;
 
 private:
+	//MIGUEL MODIFICATION: Persistent islands. A dynamic body of the controller other than the given one, or NULL.
+	b2Body* GetIslandBody(b2Body* skip) const;
+
 	b2Controller* m_prev;
 	b2Controller* m_next;
 
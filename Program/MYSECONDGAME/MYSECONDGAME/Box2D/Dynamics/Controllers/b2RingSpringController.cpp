@@ -0,0 +1,505 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2RingSpringController.h"
+#include "../../Common/b2BlockAllocator.h"
+
+#include <cstring>
+
+// Number of ring sized arrays in the data block.
+const int32 b2_ringArrayCount = 19;
+
+b2RingSpringController::b2RingSpringController(const b2RingSpringControllerDef* def) : b2Controller(def)
+{
+	skinLength = def->skinLength;
+	skinFrequencyHz = def->skinFrequencyHz;
+	skinDampingRatio = def->skinDampingRatio;
+	radialLength = def->radialLength;
+	radialFrequencyHz = def->radialFrequencyHz;
+	radialDampingRatio = def->radialDampingRatio;
+	iterations = def->iterations;
+
+	m_center = NULL;
+	m_ring = NULL;
+	m_ringCount = 0;
+	m_ringCapacity = 0;
+	m_data = NULL;
+	m_skinImpulse = NULL;
+	m_radialImpulse = NULL;
+
+	m_centerVelocity.SetZero();
+	m_centerInvMass = 0.0f;
+
+	// The ring and the center are one island.
+	m_bindIsland = true;
+}
+
+b2RingSpringController::~b2RingSpringController()
+{
+	if (m_ring != NULL)
+	{
+		b2Free(m_ring);
+		b2Free(m_data);
+	}
+}
+
+void b2RingSpringController::Reserve(int32 capacity)
+{
+	if (capacity <= m_ringCapacity)
+	{
+		return;
+	}
+
+	capacity = b2Max(capacity, 2 * m_ringCapacity);
+
+	b2Body** oldRing = m_ring;
+	float32* oldSkinImpulse = m_skinImpulse;
+	float32* oldRadialImpulse = m_radialImpulse;
+	float32* oldData = m_data;
+
+	m_ring = (b2Body**)b2Alloc(capacity * sizeof(b2Body*));
+	m_data = (float32*)b2Alloc(b2_ringArrayCount * capacity * sizeof(float32));
+
+	float32* p = m_data;
+	m_invMass = p; p += capacity;
+	m_vx = p; p += capacity;
+	m_vy = p; p += capacity;
+	m_skinUx = p; p += capacity;
+	m_skinUy = p; p += capacity;
+	m_skinGamma = p; p += capacity;
+	m_skinBias = p; p += capacity;
+	m_skinImpulse = p; p += capacity;
+	m_radialUx = p; p += capacity;
+	m_radialUy = p; p += capacity;
+	m_radialGamma = p; p += capacity;
+	m_radialBias = p; p += capacity;
+	m_radialImpulse = p; p += capacity;
+	m_diagonal = p; p += capacity;
+	m_offDiagonal = p; p += capacity;
+	m_rhs = p; p += capacity;
+	m_x = p; p += capacity;
+	m_z = p; p += capacity;
+	m_scratch = p; p += capacity;
+	b2Assert(p == m_data + b2_ringArrayCount * capacity);
+
+	if (oldRing != NULL)
+	{
+		memcpy(m_ring, oldRing, m_ringCount * sizeof(b2Body*));
+		memcpy(m_skinImpulse, oldSkinImpulse, m_ringCount * sizeof(float32));
+		memcpy(m_radialImpulse, oldRadialImpulse, m_ringCount * sizeof(float32));
+		b2Free(oldRing);
+		b2Free(oldData);
+	}
+
+	m_ringCapacity = capacity;
+}
+
+void b2RingSpringController::AddBody(b2Body* body)
+{
+	b2Controller::AddBody(body);
+
+	Reserve(m_ringCount + 1);
+	m_ring[m_ringCount] = body;
+	m_skinImpulse[m_ringCount] = 0.0f;
+	m_radialImpulse[m_ringCount] = 0.0f;
+	++m_ringCount;
+}
+
+void b2RingSpringController::RemoveBody(b2Body* body)
+{
+	b2Controller::RemoveBody(body);
+
+	if (body == m_center)
+	{
+		m_center = NULL;
+		return;
+	}
+
+	for (int32 i = 0; i < m_ringCount; ++i)
+	{
+		if (m_ring[i] == body)
+		{
+			memmove(m_ring + i, m_ring + i + 1, (m_ringCount - i - 1) * sizeof(b2Body*));
+			--m_ringCount;
+			break;
+		}
+	}
+
+	// The springs changed, don't warm start them.
+	for (int32 i = 0; i < m_ringCount; ++i)
+	{
+		m_skinImpulse[i] = 0.0f;
+		m_radialImpulse[i] = 0.0f;
+	}
+}
+
+void b2RingSpringController::Clear()
+{
+	b2Controller::Clear();
+
+	m_center = NULL;
+	m_ringCount = 0;
+}
+
+void b2RingSpringController::SetCenterBody(b2Body* body)
+{
+	if (m_center != NULL)
+	{
+		b2Controller::RemoveBody(m_center);
+	}
+
+	m_center = body;
+
+	if (m_center != NULL)
+	{
+		b2Controller::AddBody(m_center);
+	}
+}
+
+// Soft constraint coefficients, as in b2DistanceJoint. A zero frequency gives a stiff spring.
+static void b2ComputeSoftness(float32 invMass, float32 C, float32 frequencyHz, float32 dampingRatio,
+							  const b2TimeStep& step, float32* gamma, float32* bias)
+{
+	if (frequencyHz > 0.0f)
+	{
+		float32 mass = 1.0f / invMass;
+
+		// Frequency
+		float32 omega = 2.0f * b2_pi * frequencyHz;
+
+		// Damping coefficient
+		float32 d = 2.0f * mass * dampingRatio * omega;
+
+		// Spring stiffness
+		float32 k = mass * omega * omega;
+
+		*gamma = 1.0f / (step.dt * (d + step.dt * k));
+		*bias = C * step.dt * k * (*gamma);
+	}
+	else
+	{
+		*gamma = 0.0f;
+		*bias = b2_contactBaumgarte * step.inv_dt * C;
+	}
+}
+
+// Solve a tridiagonal system. Row i has diagonal d[i], off[i - 1] to the left and off[i] to the right.
+// r and x may be the same array.
+static void b2SolveTridiagonal(const float32* d, const float32* off, const float32* r, float32* x, float32* scratch, int32 n)
+{
+	float32 pivot = d[0];
+	x[0] = r[0] / pivot;
+	for (int32 i = 1; i < n; ++i)
+	{
+		scratch[i] = off[i - 1] / pivot;
+		pivot = d[i] - off[i - 1] * scratch[i];
+		b2Assert(pivot != 0.0f);
+		x[i] = (r[i] - off[i - 1] * x[i - 1]) / pivot;
+	}
+
+	for (int32 i = n - 2; i >= 0; --i)
+	{
+		x[i] -= scratch[i + 1] * x[i + 1];
+	}
+}
+
+// Solve a symmetric cyclic tridiagonal system: off[n - 1] joins the last and the first rows.
+// It is the tridiagonal system plus a rank 1 correction (Sherman-Morrison). d is modified.
+static void b2SolveCyclicTridiagonal(float32* d, const float32* off, const float32* r, float32* x, float32* z, float32* scratch, int32 n)
+{
+	b2Assert(n >= 3);
+
+	float32 corner = off[n - 1];
+	float32 gamma = -d[0];
+	d[0] -= gamma;
+	d[n - 1] -= corner * corner / gamma;
+
+	b2SolveTridiagonal(d, off, r, x, scratch, n);
+
+	memset(z, 0, n * sizeof(float32));
+	z[0] = gamma;
+	z[n - 1] = corner;
+	b2SolveTridiagonal(d, off, z, z, scratch, n);
+
+	float32 factor = (x[0] + corner * x[n - 1] / gamma) / (1.0f + z[0] + corner * z[n - 1] / gamma);
+	for (int32 i = 0; i < n; ++i)
+	{
+		x[i] -= factor * z[i];
+	}
+}
+
+// Skin spring i pushes body i and body i + 1. Neighbour springs share a body, so the
+// effective mass matrix is cyclic tridiagonal.
+void b2RingSpringController::SolveSkin()
+{
+	int32 n = m_ringCount;
+	for (int32 i = 0; i < n; ++i)
+	{
+		int32 j = i + 1 < n ? i + 1 : 0;
+		float32 ux = m_skinUx[i], uy = m_skinUy[i];
+
+		m_diagonal[i] = m_invMass[i] + m_invMass[j] + m_skinGamma[i];
+		m_offDiagonal[i] = -m_invMass[j] * (ux * m_skinUx[j] + uy * m_skinUy[j]);
+
+		float32 Cdot = ux * (m_vx[j] - m_vx[i]) + uy * (m_vy[j] - m_vy[i]);
+		m_rhs[i] = -(Cdot + m_skinBias[i] + m_skinGamma[i] * m_skinImpulse[i]);
+	}
+
+	b2SolveCyclicTridiagonal(m_diagonal, m_offDiagonal, m_rhs, m_x, m_z, m_scratch, n);
+
+	for (int32 i = 0; i < n; ++i)
+	{
+		int32 j = i + 1 < n ? i + 1 : 0;
+		float32 impulse = m_x[i];
+		m_skinImpulse[i] += impulse;
+
+		float32 Px = impulse * m_skinUx[i];
+		float32 Py = impulse * m_skinUy[i];
+		m_vx[i] -= m_invMass[i] * Px;
+		m_vy[i] -= m_invMass[i] * Py;
+		m_vx[j] += m_invMass[j] * Px;
+		m_vy[j] += m_invMass[j] * Py;
+	}
+}
+
+// Radial springs all share the center body: the effective mass matrix is D + m * U * U^T,
+// with D diagonal, m the center inverse mass and U the n x 2 matrix of spring directions.
+// Woodbury: x = D^-1 * (r - U * q), with (I + m * U^T * D^-1 * U) * q = m * U^T * D^-1 * r
+void b2RingSpringController::SolveRadial()
+{
+	int32 n = m_ringCount;
+	float32 m = m_centerInvMass;
+	b2Vec2 vc = m_centerVelocity;
+
+	float32 sxx = 0.0f, sxy = 0.0f, syy = 0.0f;
+	b2Vec2 t(0.0f, 0.0f);
+	for (int32 i = 0; i < n; ++i)
+	{
+		float32 ux = m_radialUx[i], uy = m_radialUy[i];
+
+		m_diagonal[i] = m_invMass[i] + m_radialGamma[i];
+		b2Assert(m_diagonal[i] > 0.0f);
+		float32 invD = 1.0f / m_diagonal[i];
+
+		float32 Cdot = ux * (m_vx[i] - vc.x) + uy * (m_vy[i] - vc.y);
+		float32 w = -(Cdot + m_radialBias[i] + m_radialGamma[i] * m_radialImpulse[i]) * invD;
+		m_x[i] = w;
+
+		sxx += ux * ux * invD;
+		sxy += ux * uy * invD;
+		syy += uy * uy * invD;
+		t.x += ux * w;
+		t.y += uy * w;
+	}
+
+	b2Mat22 K;
+	K.col1.Set(1.0f + m * sxx, m * sxy);
+	K.col2.Set(m * sxy, 1.0f + m * syy);
+	b2Vec2 q = K.Solve(m * t);
+
+	b2Vec2 P(0.0f, 0.0f);
+	for (int32 i = 0; i < n; ++i)
+	{
+		float32 ux = m_radialUx[i], uy = m_radialUy[i];
+		float32 impulse = m_x[i] - (ux * q.x + uy * q.y) / m_diagonal[i];
+		m_radialImpulse[i] += impulse;
+
+		m_vx[i] += m_invMass[i] * impulse * ux;
+		m_vy[i] += m_invMass[i] * impulse * uy;
+		P.x += impulse * ux;
+		P.y += impulse * uy;
+	}
+
+	m_centerVelocity -= m * P;
+}
+
+void b2RingSpringController::Step(const b2TimeStep& step)
+{
+	if (step.dt <= B2_FLT_EPSILON || m_center == NULL || m_ringCount < 3)
+	{
+		return;
+	}
+
+	int32 n = m_ringCount;
+
+	// A sleeping ring is left alone. If a part of it is awake the island search wakes the rest.
+	bool awake = m_center->IsSleeping() == false;
+	for (int32 i = 0; i < n && awake == false; ++i)
+	{
+		awake = m_ring[i]->IsSleeping() == false;
+	}
+
+	if (awake == false || m_center->IsFrozen())
+	{
+		return;
+	}
+
+	// Gather the body state.
+	float32 centerMass = m_center->GetMass();
+	m_centerInvMass = centerMass > 0.0f ? 1.0f / centerMass : 0.0f;
+	m_centerVelocity = m_center->GetLinearVelocity();
+	b2Vec2 center = m_center->GetWorldCenter();
+
+	for (int32 i = 0; i < n; ++i)
+	{
+		b2Body* b = m_ring[i];
+		float32 mass = b->GetMass();
+		m_invMass[i] = mass > 0.0f ? 1.0f / mass : 0.0f;
+		b2Vec2 v = b->GetLinearVelocity();
+		m_vx[i] = v.x;
+		m_vy[i] = v.y;
+	}
+
+	// Spring directions and softness for this step.
+	for (int32 i = 0; i < n; ++i)
+	{
+		int32 j = i + 1 < n ? i + 1 : 0;
+		b2Vec2 p = m_ring[i]->GetWorldCenter();
+
+		b2Vec2 u = m_ring[j]->GetWorldCenter() - p;
+		float32 length = u.Length();
+		if (length > b2_linearSlop)
+		{
+			u *= 1.0f / length;
+		}
+		else
+		{
+			u.SetZero();
+		}
+
+		float32 invMass = m_invMass[i] + m_invMass[j];
+		b2Assert(invMass > B2_FLT_EPSILON);
+		m_skinUx[i] = u.x;
+		m_skinUy[i] = u.y;
+		b2ComputeSoftness(invMass, length - skinLength, skinFrequencyHz, skinDampingRatio, step, m_skinGamma + i, m_skinBias + i);
+
+		u = p - center;
+		length = u.Length();
+		if (length > b2_linearSlop)
+		{
+			u *= 1.0f / length;
+		}
+		else
+		{
+			u.SetZero();
+		}
+
+		invMass = m_invMass[i] + m_centerInvMass;
+		b2Assert(invMass > B2_FLT_EPSILON);
+		m_radialUx[i] = u.x;
+		m_radialUy[i] = u.y;
+		b2ComputeSoftness(invMass, length - radialLength, radialFrequencyHz, radialDampingRatio, step, m_radialGamma + i, m_radialBias + i);
+	}
+
+	// Warm start.
+	if (step.warmStarting)
+	{
+		for (int32 i = 0; i < n; ++i)
+		{
+			int32 j = i + 1 < n ? i + 1 : 0;
+
+			// Scale the impulse to support a variable time step.
+			m_skinImpulse[i] *= step.dtRatio;
+			m_radialImpulse[i] *= step.dtRatio;
+
+			float32 Px = m_skinImpulse[i] * m_skinUx[i];
+			float32 Py = m_skinImpulse[i] * m_skinUy[i];
+			m_vx[i] -= m_invMass[i] * Px;
+			m_vy[i] -= m_invMass[i] * Py;
+			m_vx[j] += m_invMass[j] * Px;
+			m_vy[j] += m_invMass[j] * Py;
+
+			Px = m_radialImpulse[i] * m_radialUx[i];
+			Py = m_radialImpulse[i] * m_radialUy[i];
+			m_centerVelocity.x -= m_centerInvMass * Px;
+			m_centerVelocity.y -= m_centerInvMass * Py;
+			m_vx[i] += m_invMass[i] * Px;
+			m_vy[i] += m_invMass[i] * Py;
+		}
+	}
+	else
+	{
+		for (int32 i = 0; i < n; ++i)
+		{
+			m_skinImpulse[i] = 0.0f;
+			m_radialImpulse[i] = 0.0f;
+		}
+	}
+
+	for (int32 k = 0; k < iterations; ++k)
+	{
+		SolveSkin();
+		SolveRadial();
+	}
+
+	// Scatter the new velocities.
+	m_center->SetLinearVelocity(m_centerVelocity);
+	for (int32 i = 0; i < n; ++i)
+	{
+		m_ring[i]->SetLinearVelocity(b2Vec2(m_vx[i], m_vy[i]));
+	}
+}
+
+void b2RingSpringController::Draw(b2DebugDraw *debugDraw)
+{
+	b2Color color(0.5f, 0.8f, 0.8f);
+
+	for (int32 i = 0; i < m_ringCount; ++i)
+	{
+		int32 j = i + 1 < m_ringCount ? i + 1 : 0;
+		b2Vec2 p = m_ring[i]->GetWorldCenter();
+		debugDraw->DrawSegment(p, m_ring[j]->GetWorldCenter(), color);
+		if (m_center != NULL)
+		{
+			debugDraw->DrawSegment(m_center->GetWorldCenter(), p, color);
+		}
+	}
+}
+
+int32 b2RingSpringController::GetStateSize() const
+{
+	return 2 + 2 * m_ringCount;
+}
+
+void b2RingSpringController::GetState(float32* values) const
+{
+	values[0] = skinLength;
+	values[1] = radialLength;
+	memcpy(values + 2, m_skinImpulse, m_ringCount * sizeof(float32));
+	memcpy(values + 2 + m_ringCount, m_radialImpulse, m_ringCount * sizeof(float32));
+}
+
+void b2RingSpringController::SetState(const float32* values)
+{
+	skinLength = values[0];
+	radialLength = values[1];
+	memcpy(m_skinImpulse, values + 2, m_ringCount * sizeof(float32));
+	memcpy(m_radialImpulse, values + 2 + m_ringCount, m_ringCount * sizeof(float32));
+}
+
+void b2RingSpringController::Destroy(b2BlockAllocator* allocator)
+{
+	this->~b2RingSpringController();
+	allocator->Free(this, sizeof(b2RingSpringController));
+}
+
+b2RingSpringController* b2RingSpringControllerDef::Create(b2BlockAllocator* allocator)
+{
+	void* mem = allocator->Allocate(sizeof(b2RingSpringController));
+	return new (mem) b2RingSpringController(this);
+}
@@ -0,0 +1,183 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_RINGSPRINGCONTROLLER_H
+#define B2_RINGSPRINGCONTROLLER_H
+
+#include "b2Controller.h"
+
+//MIGUEL MODIFICATION: Direct solver for rings of springs (blob skins)
+
+class b2RingSpringControllerDef;
+
+/// Soft springs joining a closed ring of bodies to their neighbours (skin springs)
+/// and to a center body (radial springs). This replaces one b2DistanceJoint per spring.
+/// Each step the skin springs are solved as one cyclic tridiagonal system (Sherman-Morrison)
+/// and the radial springs, which all share the center body, as a diagonal plus rank 2
+/// system (Woodbury). Both solves are O(n) and exact, so the ring keeps its shape without
+/// raising the world velocity iterations. The iterations alternate the two solves.
+/// Springs act on the centers of mass: use bodies with fixed rotation.
+/// The bodies are kept in one island, so the ring sleeps and wakes as a whole.
+class b2RingSpringController : public b2Controller
+{
+public:
+	/// Rest length of skin springs.
+	float32 skinLength;
+	/// Skin springs stiffness, as in b2DistanceJointDef.
+	float32 skinFrequencyHz;
+	float32 skinDampingRatio;
+	/// Rest length of radial springs. It can be changed at any time (to shrink the ring).
+	float32 radialLength;
+	/// Radial springs stiffness, as in b2DistanceJointDef.
+	float32 radialFrequencyHz;
+	float32 radialDampingRatio;
+	/// Number of skin / radial solve turns per step.
+	int32 iterations;
+
+	/// @see b2Controller::Step
+	void Step(const b2TimeStep& step);
+
+	/// @see b2Controller::Draw
+	void Draw(b2DebugDraw *debugDraw);
+
+	/// @see b2Controller::GetStateSize
+	int32 GetStateSize() const;
+
+	/// @see b2Controller::GetState
+	void GetState(float32* values) const;
+
+	/// @see b2Controller::SetState
+	void SetState(const float32* values);
+
+	/// Adds a body to the end of the ring. Add them in ring order.
+	void AddBody(b2Body* body);
+
+	/// Removes a body from the ring (or the center body).
+	void RemoveBody(b2Body* body);
+
+	/// Removes all bodies.
+	void Clear();
+
+	/// Set the body all radial springs are attached to.
+	void SetCenterBody(b2Body* body);
+
+	/// Get the center body.
+	b2Body* GetCenterBody() const;
+
+	/// Get the number of bodies in the ring.
+	int32 GetRingBodyCount() const;
+
+	/// Get a body of the ring, in the order they were added.
+	b2Body* GetRingBody(int32 index) const;
+
+protected:
+	void Destroy(b2BlockAllocator* allocator);
+
+private:
+	friend class b2RingSpringControllerDef;
+	b2RingSpringController(const b2RingSpringControllerDef* def);
+	~b2RingSpringController();
+
+	void Reserve(int32 capacity);
+	void SolveSkin();
+	void SolveRadial();
+
+	b2Body* m_center;
+	b2Body** m_ring;
+	int32 m_ringCount;
+	int32 m_ringCapacity;
+
+	// One block of m_ringCapacity sized arrays.
+	float32* m_data;
+
+	// Body state, by ring index.
+	float32* m_invMass;
+	float32* m_vx;
+	float32* m_vy;
+	b2Vec2 m_centerVelocity;
+	float32 m_centerInvMass;
+
+	// Skin spring i joins body i and body i + 1. Radial spring i joins the center and body i.
+	float32* m_skinUx;
+	float32* m_skinUy;
+	float32* m_skinGamma;
+	float32* m_skinBias;
+	float32* m_skinImpulse;		// Accumulated, used for warm starting
+	float32* m_radialUx;
+	float32* m_radialUy;
+	float32* m_radialGamma;
+	float32* m_radialBias;
+	float32* m_radialImpulse;	// Accumulated, used for warm starting
+
+	// Solver scratch.
+	float32* m_diagonal;
+	float32* m_offDiagonal;
+	float32* m_rhs;
+	float32* m_x;
+	float32* m_z;
+	float32* m_scratch;
+};
+
+/// This class is used to build ring spring controllers
+class b2RingSpringControllerDef : public b2ControllerDef
+{
+public:
+	b2RingSpringControllerDef():
+		skinLength(1.0f),
+		skinFrequencyHz(40.0f),
+		skinDampingRatio(0.3f),
+		radialLength(1.0f),
+		radialFrequencyHz(2.0f),
+		radialDampingRatio(0.05f),
+		iterations(2)
+		{}
+
+	/// Rest length of skin springs.
+	float32 skinLength;
+	/// Skin springs stiffness.
+	float32 skinFrequencyHz;
+	float32 skinDampingRatio;
+	/// Rest length of radial springs.
+	float32 radialLength;
+	/// Radial springs stiffness.
+	float32 radialFrequencyHz;
+	float32 radialDampingRatio;
+	/// Number of skin / radial solve turns per step.
+	int32 iterations;
+
+private:
+	b2RingSpringController* Create(b2BlockAllocator* allocator);
+};
+
+inline b2Body* b2RingSpringController::GetCenterBody() const
+{
+	return m_center;
+}
+
+inline int32 b2RingSpringController::GetRingBodyCount() const
+{
+	return m_ringCount;
+}
+
+inline b2Body* b2RingSpringController::GetRingBody(int32 index) const
+{
+	b2Assert(0 <= index && index < m_ringCount);
+	return m_ring[index];
+}
+
+#endif
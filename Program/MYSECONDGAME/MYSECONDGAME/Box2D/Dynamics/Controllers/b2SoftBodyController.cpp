@@ -0,0 +1,478 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2RingSpringController.h"
+#include "b2SoftBodyController.h"
+#include "../../Common/b2BlockAllocator.h"
+
+#include <cstring>
+
+// Number of particle sized arrays in the data block.
+const int32 b2_softBodyArrayCount = 10;
+
+b2SoftBodyController::b2SoftBodyController(const b2SoftBodyControllerDef* def) : b2Controller(def)
+{
+	shapeStiffness = def->shapeStiffness;
+	shapeDamping = def->shapeDamping;
+	pressureStiffness = def->pressureStiffness;
+	pressure = def->pressure;
+	scale = def->scale;
+	iterations = def->iterations;
+
+	m_center = NULL;
+	m_particles = NULL;
+	m_particleCount = 0;
+	m_capacity = 0;
+	m_restPositions = NULL;
+	m_centerRestPosition.SetZero();
+	m_restDirty = true;
+	m_restArea = 0.0f;
+	m_count = 0;
+	m_data = NULL;
+
+	// The particles and the center are one island.
+	m_bindIsland = true;
+}
+
+b2SoftBodyController::~b2SoftBodyController()
+{
+	if (m_particles != NULL)
+	{
+		b2Free(m_particles);
+		b2Free(m_restPositions);
+		b2Free(m_data);
+	}
+}
+
+void b2SoftBodyController::Reserve(int32 capacity)
+{
+	if (capacity <= m_capacity)
+	{
+		return;
+	}
+
+	capacity = b2Max(capacity, 2 * m_capacity);
+
+	b2Body** oldParticles = m_particles;
+	b2Vec2* oldRestPositions = m_restPositions;
+	float32* oldData = m_data;
+
+	m_particles = (b2Body**)b2Alloc(capacity * sizeof(b2Body*));
+	m_restPositions = (b2Vec2*)b2Alloc(capacity * sizeof(b2Vec2));
+
+	// One more entry for the center.
+	int32 size = capacity + 1;
+	m_data = (float32*)b2Alloc(b2_softBodyArrayCount * size * sizeof(float32));
+
+	float32* p = m_data;
+	m_restX = p; p += size;
+	m_restY = p; p += size;
+	m_mass = p; p += size;
+	m_invMass = p; p += size;
+	m_px = p; p += size;
+	m_py = p; p += size;
+	m_vx = p; p += size;
+	m_vy = p; p += size;
+	m_gradX = p; p += size;
+	m_gradY = p; p += size;
+	b2Assert(p == m_data + b2_softBodyArrayCount * size);
+
+	if (oldParticles != NULL)
+	{
+		memcpy(m_particles, oldParticles, m_particleCount * sizeof(b2Body*));
+		memcpy(m_restPositions, oldRestPositions, m_particleCount * sizeof(b2Vec2));
+		b2Free(oldParticles);
+		b2Free(oldRestPositions);
+		b2Free(oldData);
+	}
+
+	m_capacity = capacity;
+	m_restDirty = true;
+}
+
+void b2SoftBodyController::AddBody(b2Body* body)
+{
+	b2Controller::AddBody(body);
+
+	Reserve(m_particleCount + 1);
+	m_particles[m_particleCount] = body;
+	m_restPositions[m_particleCount] = body->GetWorldCenter();
+	++m_particleCount;
+	m_restDirty = true;
+}
+
+void b2SoftBodyController::RemoveBody(b2Body* body)
+{
+	b2Controller::RemoveBody(body);
+
+	m_restDirty = true;
+
+	if (body == m_center)
+	{
+		m_center = NULL;
+		return;
+	}
+
+	for (int32 i = 0; i < m_particleCount; ++i)
+	{
+		if (m_particles[i] == body)
+		{
+			memmove(m_particles + i, m_particles + i + 1, (m_particleCount - i - 1) * sizeof(b2Body*));
+			memmove(m_restPositions + i, m_restPositions + i + 1, (m_particleCount - i - 1) * sizeof(b2Vec2));
+			--m_particleCount;
+			break;
+		}
+	}
+}
+
+void b2SoftBodyController::Clear()
+{
+	b2Controller::Clear();
+
+	m_center = NULL;
+	m_particleCount = 0;
+	m_restDirty = true;
+}
+
+void b2SoftBodyController::SetCenterBody(b2Body* body)
+{
+	if (m_center != NULL)
+	{
+		b2Controller::RemoveBody(m_center);
+	}
+
+	m_center = body;
+
+	if (m_center != NULL)
+	{
+		b2Controller::AddBody(m_center);
+		m_centerRestPosition = m_center->GetWorldCenter();
+	}
+
+	m_restDirty = true;
+}
+
+void b2SoftBodyController::ResetRestShape()
+{
+	for (int32 i = 0; i < m_particleCount; ++i)
+	{
+		m_restPositions[i] = m_particles[i]->GetWorldCenter();
+	}
+
+	if (m_center != NULL)
+	{
+		m_centerRestPosition = m_center->GetWorldCenter();
+	}
+
+	m_restDirty = true;
+}
+
+float32 b2SoftBodyController::GetRestArea() const
+{
+	float32 area = 0.0f;
+	for (int32 i = 0; i < m_particleCount; ++i)
+	{
+		int32 j = i + 1 < m_particleCount ? i + 1 : 0;
+		area += b2Cross(m_restPositions[i], m_restPositions[j]);
+	}
+
+	return 0.5f * area;
+}
+
+// Rest offsets from the rest center of mass, with the current masses.
+void b2SoftBodyController::ComputeRestShape()
+{
+	int32 n = m_particleCount;
+
+	float32 totalMass = 0.0f;
+	b2Vec2 center(0.0f, 0.0f);
+	for (int32 i = 0; i < n; ++i)
+	{
+		totalMass += m_mass[i];
+		center += m_mass[i] * m_restPositions[i];
+	}
+
+	if (m_center != NULL)
+	{
+		totalMass += m_mass[n];
+		center += m_mass[n] * m_centerRestPosition;
+	}
+
+	b2Assert(totalMass > 0.0f);
+	center *= 1.0f / totalMass;
+
+	for (int32 i = 0; i < n; ++i)
+	{
+		m_restX[i] = m_restPositions[i].x - center.x;
+		m_restY[i] = m_restPositions[i].y - center.y;
+	}
+
+	if (m_center != NULL)
+	{
+		m_restX[n] = m_centerRestPosition.x - center.x;
+		m_restY[n] = m_centerRestPosition.y - center.y;
+	}
+
+	m_restArea = GetRestArea();
+	m_restDirty = false;
+}
+
+// Area constraint on the ring. The area gradient of a particle is half its neighbours'
+// difference, turned 90 degrees. The gradients sum to zero, so momentum is kept.
+void b2SoftBodyController::SolvePressure(float32 targetArea, float32 inv_dt)
+{
+	int32 n = m_particleCount;
+
+	float32 area = 0.0f;
+	float32 invMassSum = 0.0f;
+	for (int32 i = 0; i < n; ++i)
+	{
+		int32 h = i > 0 ? i - 1 : n - 1;
+		int32 j = i + 1 < n ? i + 1 : 0;
+
+		area += m_px[i] * m_py[j] - m_px[j] * m_py[i];
+
+		m_gradX[i] = 0.5f * (m_py[j] - m_py[h]);
+		m_gradY[i] = 0.5f * (m_px[h] - m_px[j]);
+		invMassSum += m_invMass[i] * (m_gradX[i] * m_gradX[i] + m_gradY[i] * m_gradY[i]);
+	}
+	area *= 0.5f;
+
+	if (invMassSum < B2_FLT_EPSILON)
+	{
+		return;
+	}
+
+	float32 lambda = -pressureStiffness * (area - targetArea) / invMassSum;
+
+	for (int32 i = 0; i < n; ++i)
+	{
+		float32 dx = lambda * m_invMass[i] * m_gradX[i];
+		float32 dy = lambda * m_invMass[i] * m_gradY[i];
+		m_px[i] += dx;
+		m_py[i] += dy;
+		m_vx[i] += dx * inv_dt;
+		m_vy[i] += dy * inv_dt;
+	}
+}
+
+// Move towards the rest shape, rotated to best fit the current positions. In 2D the
+// rotation of the polar decomposition of Apq = sum(m * p * q^T) has a closed form.
+void b2SoftBodyController::SolveShape(float32 inv_dt)
+{
+	int32 count = m_count;
+
+	float32 totalMass = 0.0f;
+	float32 cx = 0.0f, cy = 0.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		totalMass += m_mass[i];
+		cx += m_mass[i] * m_px[i];
+		cy += m_mass[i] * m_py[i];
+	}
+	cx /= totalMass;
+	cy /= totalMass;
+
+	float32 a11 = 0.0f, a12 = 0.0f, a21 = 0.0f, a22 = 0.0f;
+	for (int32 i = 0; i < count; ++i)
+	{
+		float32 rx = m_mass[i] * (m_px[i] - cx);
+		float32 ry = m_mass[i] * (m_py[i] - cy);
+		a11 += rx * m_restX[i];
+		a12 += rx * m_restY[i];
+		a21 += ry * m_restX[i];
+		a22 += ry * m_restY[i];
+	}
+
+	b2Mat22 R(b2Atan2(a21 - a12, a11 + a22));
+	float32 c = scale * R.col1.x;
+	float32 s = scale * R.col1.y;
+
+	for (int32 i = 0; i < count; ++i)
+	{
+		if (m_invMass[i] == 0.0f)
+		{
+			continue;
+		}
+
+		float32 gx = cx + c * m_restX[i] - s * m_restY[i];
+		float32 gy = cy + s * m_restX[i] + c * m_restY[i];
+
+		float32 dx = shapeStiffness * (gx - m_px[i]);
+		float32 dy = shapeStiffness * (gy - m_py[i]);
+		m_px[i] += dx;
+		m_py[i] += dy;
+		m_vx[i] += dx * inv_dt;
+		m_vy[i] += dy * inv_dt;
+	}
+}
+
+void b2SoftBodyController::Step(const b2TimeStep& step)
+{
+	if (step.dt <= B2_FLT_EPSILON || m_particleCount < 3)
+	{
+		return;
+	}
+
+	int32 n = m_particleCount;
+
+	// A sleeping soft body is left alone. If a part of it is awake the island search wakes the rest.
+	bool awake = m_center != NULL && m_center->IsSleeping() == false;
+	for (int32 i = 0; i < n && awake == false; ++i)
+	{
+		awake = m_particles[i]->IsSleeping() == false;
+	}
+
+	if (awake == false || (m_center != NULL && m_center->IsFrozen()))
+	{
+		return;
+	}
+
+	// Gather the body state, the center last.
+	m_count = m_center != NULL ? n + 1 : n;
+
+	float32 totalMass = 0.0f;
+	b2Vec2 center(0.0f, 0.0f);
+	b2Vec2 velocity(0.0f, 0.0f);
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Body* b = i < n ? m_particles[i] : m_center;
+		float32 mass = b->GetMass();
+		m_mass[i] = mass;
+		m_invMass[i] = mass > 0.0f ? 1.0f / mass : 0.0f;
+
+		b2Vec2 p = b->GetWorldCenter();
+		b2Vec2 v = b->GetLinearVelocity();
+		m_px[i] = p.x;
+		m_py[i] = p.y;
+		m_vx[i] = v.x;
+		m_vy[i] = v.y;
+
+		totalMass += mass;
+		center += mass * p;
+		velocity += mass * v;
+	}
+
+	if (totalMass <= 0.0f)
+	{
+		return;
+	}
+
+	if (m_restDirty)
+	{
+		ComputeRestShape();
+	}
+
+	center *= 1.0f / totalMass;
+	velocity *= 1.0f / totalMass;
+
+	// Damp the deformation: blend the velocities with the rigid motion of the body.
+	if (shapeDamping > 0.0f)
+	{
+		float32 angularMomentum = 0.0f;
+		float32 inertia = 0.0f;
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			float32 rx = m_px[i] - center.x;
+			float32 ry = m_py[i] - center.y;
+			angularMomentum += m_mass[i] * (rx * (m_vy[i] - velocity.y) - ry * (m_vx[i] - velocity.x));
+			inertia += m_mass[i] * (rx * rx + ry * ry);
+		}
+
+		float32 omega = inertia > B2_FLT_EPSILON ? angularMomentum / inertia : 0.0f;
+
+		for (int32 i = 0; i < m_count; ++i)
+		{
+			if (m_invMass[i] == 0.0f)
+			{
+				continue;
+			}
+
+			float32 rx = m_px[i] - center.x;
+			float32 ry = m_py[i] - center.y;
+			m_vx[i] += shapeDamping * (velocity.x - omega * ry - m_vx[i]);
+			m_vy[i] += shapeDamping * (velocity.y + omega * rx - m_vy[i]);
+		}
+	}
+
+	// Predict the positions at the end of the step.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_px[i] += step.dt * m_vx[i];
+		m_py[i] += step.dt * m_vy[i];
+	}
+
+	float32 targetArea = pressure * scale * scale * m_restArea;
+	for (int32 k = 0; k < iterations; ++k)
+	{
+		SolvePressure(targetArea, step.inv_dt);
+		SolveShape(step.inv_dt);
+	}
+
+	// Scatter the new velocities.
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		b2Body* b = i < n ? m_particles[i] : m_center;
+		b->SetLinearVelocity(b2Vec2(m_vx[i], m_vy[i]));
+	}
+}
+
+void b2SoftBodyController::Draw(b2DebugDraw *debugDraw)
+{
+	b2Color color(0.8f, 0.5f, 0.8f);
+
+	for (int32 i = 0; i < m_particleCount; ++i)
+	{
+		int32 j = i + 1 < m_particleCount ? i + 1 : 0;
+		debugDraw->DrawSegment(m_particles[i]->GetWorldCenter(), m_particles[j]->GetWorldCenter(), color);
+	}
+
+	if (m_center != NULL)
+	{
+		debugDraw->DrawCircle(m_center->GetWorldCenter(), 0.1f, color);
+	}
+}
+
+int32 b2SoftBodyController::GetStateSize() const
+{
+	return 2;
+}
+
+void b2SoftBodyController::GetState(float32* values) const
+{
+	values[0] = scale;
+	values[1] = pressure;
+}
+
+void b2SoftBodyController::SetState(const float32* values)
+{
+	scale = values[0];
+	pressure = values[1];
+}
+
+void b2SoftBodyController::Destroy(b2BlockAllocator* allocator)
+{
+	this->~b2SoftBodyController();
+	allocator->Free(this, sizeof(b2SoftBodyController));
+}
+
+b2SoftBodyController* b2SoftBodyControllerDef::Create(b2BlockAllocator* allocator)
+{
+	void* mem = allocator->Allocate(sizeof(b2SoftBodyController));
+	return new (mem) b2SoftBodyController(this);
+}
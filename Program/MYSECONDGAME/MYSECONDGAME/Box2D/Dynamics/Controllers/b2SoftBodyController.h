@@ -0,0 +1,182 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_SOFTBODYCONTROLLER_H
+#define B2_SOFTBODYCONTROLLER_H
+
+#include "b2Controller.h"
+
+//MIGUEL MODIFICATION: Shape matching / pressure soft bodies (blobs without joints)
+
+class b2SoftBodyControllerDef;
+
+/// A soft body made of a closed ring of particle bodies and an optional center body.
+/// There are no joints: each step the particles are pulled towards the best rigid fit of
+/// their rest shape (shape matching, Mueller et al. 2005) and the area enclosed by the ring
+/// is kept by a gas pressure constraint. Both act on the positions predicted for the end of
+/// the step, and the corrections are applied as velocity changes, so the contacts solved by
+/// the world see them. Linear momentum is conserved.
+/// The rest shape is taken from the body positions when they are added.
+/// Particles act on their centers of mass: use bodies with fixed rotation.
+/// The bodies are kept in one island, so the soft body sleeps and wakes as a whole.
+class b2SoftBodyController : public b2Controller
+{
+public:
+	/// Fraction of the distance to the matched shape recovered in one step, from 0 to 1 (rigid).
+	float32 shapeStiffness;
+	/// Fraction of the deformation velocity removed in one step, from 0 to 1.
+	float32 shapeDamping;
+	/// Fraction of the area error recovered in one step, from 0 to 1.
+	float32 pressureStiffness;
+	/// Target area over the scaled rest area. Above 1 the body is inflated.
+	float32 pressure;
+	/// Scale of the rest shape. It can be changed at any time (to shrink the body).
+	float32 scale;
+	/// Number of pressure / shape matching turns per step.
+	int32 iterations;
+
+	/// @see b2Controller::Step
+	void Step(const b2TimeStep& step);
+
+	/// @see b2Controller::Draw
+	void Draw(b2DebugDraw *debugDraw);
+
+	/// @see b2Controller::GetStateSize
+	int32 GetStateSize() const;
+
+	/// @see b2Controller::GetState
+	void GetState(float32* values) const;
+
+	/// @see b2Controller::SetState
+	void SetState(const float32* values);
+
+	/// Adds a particle to the end of the ring. Add them in ring order.
+	void AddBody(b2Body* body);
+
+	/// Removes a particle (or the center body). The rest shape keeps the others.
+	void RemoveBody(b2Body* body);
+
+	/// Removes all bodies.
+	void Clear();
+
+	/// Set the center body. It takes part in shape matching, not in pressure.
+	void SetCenterBody(b2Body* body);
+
+	/// Get the center body.
+	b2Body* GetCenterBody() const;
+
+	/// Get the number of particles in the ring.
+	int32 GetParticleCount() const;
+
+	/// Get a particle of the ring, in the order they were added.
+	b2Body* GetParticle(int32 index) const;
+
+	/// Take the current body positions as the rest shape.
+	void ResetRestShape();
+
+	/// Get the area enclosed by the ring at rest (scale 1). Negative if the ring was added clockwise.
+	float32 GetRestArea() const;
+
+protected:
+	void Destroy(b2BlockAllocator* allocator);
+
+private:
+	friend class b2SoftBodyControllerDef;
+	b2SoftBodyController(const b2SoftBodyControllerDef* def);
+	~b2SoftBodyController();
+
+	void Reserve(int32 capacity);
+	void ComputeRestShape();
+	void SolvePressure(float32 targetArea, float32 inv_dt);
+	void SolveShape(float32 inv_dt);
+
+	b2Body* m_center;
+	b2Body** m_particles;
+	int32 m_particleCount;
+	int32 m_capacity;
+
+	// Rest positions as added, by ring index. The center is kept apart.
+	b2Vec2* m_restPositions;
+	b2Vec2 m_centerRestPosition;
+
+	// Rest shape about the rest center of mass, computed when the bodies change.
+	bool m_restDirty;
+	float32 m_restArea;
+	int32 m_count;		// Particles plus the center
+
+	// One block of m_capacity + 1 sized arrays. The center, if any, is the last entry.
+	float32* m_data;
+	float32* m_restX;	// Rest offset from the rest center of mass
+	float32* m_restY;
+	float32* m_mass;
+	float32* m_invMass;
+	float32* m_px;		// Predicted position
+	float32* m_py;
+	float32* m_vx;
+	float32* m_vy;
+	float32* m_gradX;	// Area gradient
+	float32* m_gradY;
+};
+
+/// This class is used to build soft body controllers
+class b2SoftBodyControllerDef : public b2ControllerDef
+{
+public:
+	b2SoftBodyControllerDef():
+		shapeStiffness(0.05f),
+		shapeDamping(0.05f),
+		pressureStiffness(0.5f),
+		pressure(1.0f),
+		scale(1.0f),
+		iterations(2)
+		{}
+
+	/// Fraction of the distance to the matched shape recovered in one step.
+	float32 shapeStiffness;
+	/// Fraction of the deformation velocity removed in one step.
+	float32 shapeDamping;
+	/// Fraction of the area error recovered in one step.
+	float32 pressureStiffness;
+	/// Target area over the scaled rest area.
+	float32 pressure;
+	/// Scale of the rest shape.
+	float32 scale;
+	/// Number of pressure / shape matching turns per step.
+	int32 iterations;
+
+private:
+	b2SoftBodyController* Create(b2BlockAllocator* allocator);
+};
+
+inline b2Body* b2SoftBodyController::GetCenterBody() const
+{
+	return m_center;
+}
+
+inline int32 b2SoftBodyController::GetParticleCount() const
+{
+	return m_particleCount;
+}
+
+inline b2Body* b2SoftBodyController::GetParticle(int32 index) const
+{
+	b2Assert(0 <= index && index < m_particleCount);
+	return m_particles[index];
+}
+
+#endif
@@ -207,3 +207,25 @@ float32 b2DistanceJoint::GetReactionTorque(float32 inv_dt) const
 	B2_NOT_USED(inv_dt);
 	return 0.0f;
 }
+
+//MIGUEL MODIFICATION: World snapshots
+int32 b2DistanceJoint::GetStateSize() const
+{
+	return 4;
+}
+
+void b2DistanceJoint::GetState(float32* values) const
+{
+	values[0] = m_impulse;
+	values[1] = m_length;
+	values[2] = m_frequencyHz;
+	values[3] = m_dampingRatio;
+}
+
+void b2DistanceJoint::SetState(const float32* values)
+{
+	m_impulse = values[0];
+	m_length = values[1];
+	m_frequencyHz = values[2];
+	m_dampingRatio = values[3];
+}
@@ -253,5 +253,18 @@ float32 b2GearJoint::GetRatio() const
 	return m_ratio;
 }
 
+//MIGUEL MODIFICATION: World snapshots
+int32 b2GearJoint::GetStateSize() const
+{
+	return 1;
+}
 
+void b2GearJoint::GetState(float32* values) const
+{
+	values[0] = m_impulse;
+}
 
+void b2GearJoint::SetState(const float32* values)
+{
+	m_impulse = values[0];
+}
@@ -126,6 +126,18 @@ public:
 	/// Get the reaction torque on body2.
 	virtual float32 GetReactionTorque(float32 inv_dt) const = 0;
 
+	//MIGUEL MODIFICATION: World snapshots
+	/// Get the number of values of the joint state.
+	virtual int32 GetStateSize() const = 0;
+
+	/// Copy the joint state: the impulses kept for warm starting and the
+	/// values that can be changed at run time (lengths, limits, motors).
+	/// @param values room for GetStateSize() values.
+	virtual void GetState(float32* values) const = 0;
+
+	/// Restore a joint state copied with GetState.
+	virtual void SetState(const float32* values) = 0;
+
 	/// Get the next joint the world joint list.
 	b2Joint* GetNext();
 
@@ -553,7 +553,33 @@ float32 b2LineJoint::GetMotorForce() const
 	return m_motorImpulse;
 }
 
+//MIGUEL MODIFICATION: World snapshots
+int32 b2LineJoint::GetStateSize() const
+{
+	return 9;
+}
 
+void b2LineJoint::GetState(float32* values) const
+{
+	values[0] = m_impulse.x;
+	values[1] = m_impulse.y;
+	values[2] = m_motorImpulse;
+	values[3] = m_motorSpeed;
+	values[4] = m_maxMotorForce;
+	values[5] = m_lowerTranslation;
+	values[6] = m_upperTranslation;
+	values[7] = m_enableMotor ? 1.0f : 0.0f;
+	values[8] = m_enableLimit ? 1.0f : 0.0f;
+}
 
-
-
+void b2LineJoint::SetState(const float32* values)
+{
+	m_impulse.Set(values[0], values[1]);
+	m_motorImpulse = values[2];
+	m_motorSpeed = values[3];
+	m_maxMotorForce = values[4];
+	m_lowerTranslation = values[5];
+	m_upperTranslation = values[6];
+	m_enableMotor = values[7] != 0.0f;
+	m_enableLimit = values[8] != 0.0f;
+}
@@ -151,3 +151,25 @@ float32 b2MouseJoint::GetReactionTorque(float32 inv_dt) const
 {
 	return inv_dt * 0.0f;
 }
+
+//MIGUEL MODIFICATION: World snapshots
+int32 b2MouseJoint::GetStateSize() const
+{
+	return 5;
+}
+
+void b2MouseJoint::GetState(float32* values) const
+{
+	values[0] = m_impulse.x;
+	values[1] = m_impulse.y;
+	values[2] = m_target.x;
+	values[3] = m_target.y;
+	values[4] = m_maxForce;
+}
+
+void b2MouseJoint::SetState(const float32* values)
+{
+	m_impulse.Set(values[0], values[1]);
+	m_target.Set(values[2], values[3]);
+	m_maxForce = values[4];
+}
@@ -70,6 +70,16 @@ public:
 	/// Implements b2Joint.
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	//MIGUEL MODIFICATION: World snapshots
+	/// @see b2Joint::GetStateSize
+	int32 GetStateSize() const;
+
+	/// @see b2Joint::GetState
+	void GetState(float32* values) const;
+
+	/// @see b2Joint::SetState
+	void SetState(const float32* values);
+
 	/// Use this to update the target point.
 	void SetTarget(const b2Vec2& target);
 
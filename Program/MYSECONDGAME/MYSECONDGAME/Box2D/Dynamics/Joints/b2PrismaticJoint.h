@@ -92,6 +92,16 @@ public:
 	b2Vec2 GetReactionForce(float32 inv_dt) const;
 	float32 GetReactionTorque(float32 inv_dt) const;
 
+	//MIGUEL MODIFICATION: World snapshots
+	/// @see b2Joint::GetStateSize
+	int32 GetStateSize() const;
+
+	/// @see b2Joint::GetState
+	void GetState(float32* values) const;
+
+	/// @see b2Joint::SetState
+	void SetState(const float32* values);
+
 	/// Get the current joint translation, usually in meters.
 	float32 GetJointTranslation() const;
 
@@ -426,3 +426,23 @@ float32 b2PulleyJoint::GetRatio() const
 {
 	return m_ratio;
 }
+
+//MIGUEL MODIFICATION: World snapshots
+int32 b2PulleyJoint::GetStateSize() const
+{
+	return 3;
+}
+
+void b2PulleyJoint::GetState(float32* values) const
+{
+	values[0] = m_impulse;
+	values[1] = m_limitImpulse1;
+	values[2] = m_limitImpulse2;
+}
+
+void b2PulleyJoint::SetState(const float32* values)
+{
+	m_impulse = values[0];
+	m_limitImpulse1 = values[1];
+	m_limitImpulse2 = values[2];
+}
@@ -472,3 +472,35 @@ void b2RevoluteJoint::SetLimits(float32 lower, float32 upper)
 	m_lowerAngle = lower;
 	m_upperAngle = upper;
 }
+
+//MIGUEL MODIFICATION: World snapshots
+int32 b2RevoluteJoint::GetStateSize() const
+{
+	return 10;
+}
+
+void b2RevoluteJoint::GetState(float32* values) const
+{
+	values[0] = m_impulse.x;
+	values[1] = m_impulse.y;
+	values[2] = m_impulse.z;
+	values[3] = m_motorImpulse;
+	values[4] = m_motorSpeed;
+	values[5] = m_maxMotorTorque;
+	values[6] = m_lowerAngle;
+	values[7] = m_upperAngle;
+	values[8] = m_enableMotor ? 1.0f : 0.0f;
+	values[9] = m_enableLimit ? 1.0f : 0.0f;
+}
+
+void b2RevoluteJoint::SetState(const float32* values)
+{
+	m_impulse.Set(values[0], values[1], values[2]);
+	m_motorImpulse = values[3];
+	m_motorSpeed = values[4];
+	m_maxMotorTorque = values[5];
+	m_lowerAngle = values[6];
+	m_upperAngle = values[7];
+	m_enableMotor = values[8] != 0.0f;
+	m_enableLimit = values[9] != 0.0f;
+}
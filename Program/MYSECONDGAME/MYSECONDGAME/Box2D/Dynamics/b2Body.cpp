@@ -51,6 +51,18 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 		m_flags |= e_posCorrectionFlag;
 	}
 
+	// MIGUEL MODIFICATION: Speculative contacts
+	if (bd->isSpeculative)
+	{
+		m_flags |= e_speculativeFlag;
+	}
+
+	// MIGUEL MODIFICATION: Adaptive iterations
+	if (bd->isSoftBody)
+	{
+		m_flags |= e_softBodyFlag;
+	}
+
 	m_world = world;
 
 	m_xf.position = bd->position;
@@ -78,6 +90,17 @@ b2Body::b2Body(const b2BodyDef* bd, b2World* world)
 
 	m_sleepTime = 0.0f;
 
+	// MIGUEL MODIFICATION: Persistent islands. The world adds the body to its island.
+	m_islandParent = NULL;
+	m_islandNext = NULL;
+	m_islandTail = this;
+	m_islandSize = 1;
+	m_islandRemoveCount = 0;
+	m_awakeIslandIndex = -1;
+
+	m_speculativeTranslation.SetZero();
+	m_speculativeDistance = 0.0f;
+
 	m_invMass = 0.0f;
 	m_I = 0.0f;
 	m_invI = 0.0f;
@@ -300,6 +323,9 @@ void b2Body::SetMass(const b2MassData* massData)
 		{
 			s->RefilterProxy(m_world->m_broadPhase, m_xf);
 		}
+
+		// MIGUEL MODIFICATION: Persistent islands. Static bodies are not part of islands.
+		m_world->UpdateIslandType(this);
 	}
 }
 
@@ -375,6 +401,21 @@ void b2Body::SetMassFromShapes()
 		{
 			s->RefilterProxy(m_world->m_broadPhase, m_xf);
 		}
+
+		// MIGUEL MODIFICATION: Persistent islands. Static bodies are not part of islands.
+		m_world->UpdateIslandType(this);
+	}
+}
+
+// MIGUEL MODIFICATION: Persistent islands. Waking a body wakes its whole island.
+void b2Body::WakeUp()
+{
+	m_flags &= ~e_sleepFlag;
+	m_sleepTime = 0.0f;
+
+	if (m_type == e_dynamicType)
+	{
+		m_world->WakeIsland(this);
 	}
 }
 
@@ -434,10 +475,19 @@ bool b2Body::SynchronizeShapes()
 	xf1.R.Set(m_sweep.a0);
 	xf1.position = m_sweep.c0 - b2Mul(xf1.R, m_sweep.localCenter);
 
+	// MIGUEL MODIFICATION: Speculative contacts. The proxies cover the motion of the next
+	// step instead of the last one, so the pairs exist before the shapes touch.
+	b2XForm xf2 = m_xf;
+	if (m_flags & e_speculativeFlag)
+	{
+		xf1 = m_xf;
+		xf2.position += m_speculativeTranslation;
+	}
+
 	bool inRange = true;
 	for (b2Shape* s = m_shapeList; s; s = s->m_next)
 	{
-		inRange = s->Synchronize(m_world->m_broadPhase, xf1, m_xf);
+		inRange = s->Synchronize(m_world->m_broadPhase, xf1, xf2);
 		if (inRange == false)
 		{
 			break;
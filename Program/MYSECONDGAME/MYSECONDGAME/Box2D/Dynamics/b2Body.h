@@ -55,6 +55,8 @@ struct b2BodyDef
 		isBullet = false;
 		//MIGUEL MODIFICATION
 		applyPosCorrection = true;
+		isSpeculative = false;
+		isSoftBody = false;
 	}
 
 	/// You can use this to initialized the mass properties of the body.
@@ -100,6 +102,16 @@ struct b2BodyDef
 
 	/// MIGUEL MODIFICATION: Position correction disabling
 	bool applyPosCorrection;
+
+	/// MIGUEL MODIFICATION: Speculative contacts
+	/// Is this a fast moving body whose circle shapes get contacts one step ahead? The
+	/// contact solver then stops it before it tunnels through static or other speculative
+	/// bodies, without time of impact sub-steps. Only the linear motion is predicted.
+	bool isSpeculative;
+
+	/// MIGUEL MODIFICATION: Adaptive iterations
+	/// Is this body part of a soft body (blob)? Its island gets the soft body iteration budget.
+	bool isSoftBody;
 };
 
 /// A rigid body.
@@ -285,6 +297,27 @@ public:
 
 	//MIGUEL MODIFICATION: Position correction disabling
 	bool IsPosCorrectionEnabled();
+
+	//MIGUEL MODIFICATION: Speculative contacts
+	/// Does this body get contacts one step ahead, instead of time of impact sub-steps?
+	bool IsSpeculative() const;
+
+	/// Should this body get contacts one step ahead, instead of time of impact sub-steps?
+	void SetSpeculative(bool flag);
+
+	/// Get the distance this body is expected to move in the next step (zero if not speculative).
+	float32 GetSpeculativeDistance() const;
+
+	//MIGUEL MODIFICATION: Adaptive iterations
+	/// Is this body part of a soft body? Its island is solved with the soft body iterations.
+	bool IsSoftBody() const;
+
+	/// Flag this body as part of a soft body.
+	void SetSoftBody(bool flag);
+
+	//MIGUEL MODIFICATION: World snapshots
+	/// Clear the force and torque applied to this body since the last step.
+	void ClearForces();
 private:
 
 	friend class b2World;
@@ -311,7 +344,9 @@ private:
 		e_allowSleepFlag	= 0x0010,
 		e_bulletFlag		= 0x0020,
 		e_fixedRotationFlag	= 0x0040,
-		e_posCorrectionFlag = 0x0080  // MIGUEL MODIFICATION: Position correction disabling
+		e_posCorrectionFlag = 0x0080,  // MIGUEL MODIFICATION: Position correction disabling
+		e_speculativeFlag	= 0x0100,  // MIGUEL MODIFICATION: Speculative contacts
+		e_softBodyFlag		= 0x0200   // MIGUEL MODIFICATION: Adaptive iterations
 	};
 
 	// m_type
@@ -369,6 +404,19 @@ private:
 
 	float32 m_sleepTime;
 
+	// MIGUEL MODIFICATION: Persistent islands. Dynamic bodies are grouped in islands by union-find.
+	// The root body keeps the list of bodies of the island, starting at itself.
+	b2Body* m_islandParent;			// NULL for the root
+	b2Body* m_islandNext;			// Next body in the island list
+	b2Body* m_islandTail;			// Root only: last body in the island list
+	int32 m_islandSize;				// Root only: number of bodies
+	int32 m_islandRemoveCount;		// Root only: constraints removed since the island was built (it may be split)
+	int32 m_awakeIslandIndex;		// Root only: position in the world awake island array, -1 if not there
+
+	// MIGUEL MODIFICATION: Speculative contacts. Motion expected in the next step (zero if not speculative).
+	b2Vec2 m_speculativeTranslation;
+	float32 m_speculativeDistance;
+
 	void* m_userData;
 };
 
@@ -507,12 +555,6 @@ inline void b2Body::AllowSleeping(bool flag)
 	}
 }
 
-inline void b2Body::WakeUp()
-{
-	m_flags &= ~e_sleepFlag;
-	m_sleepTime = 0.0f;
-}
-
 inline void b2Body::PutToSleep()
 {
 	m_flags |= e_sleepFlag;
@@ -618,4 +660,54 @@ inline bool b2Body::IsPosCorrectionEnabled()
 {
 	return ((m_flags & e_posCorrectionFlag) == e_posCorrectionFlag);
 }
+
+//MIGUEL MODIFICATION: Speculative contacts
+inline bool b2Body::IsSpeculative() const
+{
+	return (m_flags & e_speculativeFlag) == e_speculativeFlag;
+}
+
+inline void b2Body::SetSpeculative(bool flag)
+{
+	if (flag)
+	{
+		m_flags |= e_speculativeFlag;
+	}
+	else
+	{
+		m_flags &= ~e_speculativeFlag;
+		m_speculativeTranslation.SetZero();
+		m_speculativeDistance = 0.0f;
+	}
+}
+
+//MIGUEL MODIFICATION: Adaptive iterations
+inline bool b2Body::IsSoftBody() const
+{
+	return (m_flags & e_softBodyFlag) == e_softBodyFlag;
+}
+
+inline void b2Body::SetSoftBody(bool flag)
+{
+	if (flag)
+	{
+		m_flags |= e_softBodyFlag;
+	}
+	else
+	{
+		m_flags &= ~e_softBodyFlag;
+	}
+}
+
+//MIGUEL MODIFICATION: World snapshots
+inline void b2Body::ClearForces()
+{
+	m_force.SetZero();
+	m_torque = 0.0f;
+}
+
+inline float32 b2Body::GetSpeculativeDistance() const
+{
+	return m_speculativeDistance;
+}
 #endif
@@ -19,6 +19,8 @@
 #include "b2ContactManager.h"
 #include "b2World.h"
 #include "b2Body.h"
+#include "../Collision/b2Collision.h"
+#include <new>
 
 // This is a callback from the broadphase when two AABB proxies begin
 // to overlap. We create a b2Contact to manage the narrow phase.
@@ -50,6 +52,17 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 		return &m_nullContact;
 	}
 
+	//MIGUEL MODIFICATION: Trigger volumes. A trigger pair is kept instead of a contact.
+	if (shape1->IsTrigger() || shape2->IsTrigger())
+	{
+		if (shape1->IsTrigger() && shape2->IsTrigger())
+		{
+			return &m_nullContact;
+		}
+
+		return CreateTrigger(shape1, shape2);
+	}
+
 	// Call the factory.
 	b2Contact* c = b2Contact::Create(shape1, shape2, &m_world->m_blockAllocator);
 
@@ -107,9 +120,6 @@ void* b2ContactManager::PairAdded(void* proxyUserData1, void* proxyUserData2)
 // to overlap. We retire the b2Contact.
 void b2ContactManager::PairRemoved(void* proxyUserData1, void* proxyUserData2, void* pairUserData)
 {
-	B2_NOT_USED(proxyUserData1);
-	B2_NOT_USED(proxyUserData2);
-
 	if (pairUserData == NULL)
 	{
 		return;
@@ -121,6 +131,15 @@ void b2ContactManager::PairRemoved(void* proxyUserData1, void* proxyUserData2, v
 		return;
 	}
 
+	//MIGUEL MODIFICATION: Trigger volumes
+	b2Shape* shape1 = (b2Shape*)proxyUserData1;
+	b2Shape* shape2 = (b2Shape*)proxyUserData2;
+	if (shape1->IsTrigger() || shape2->IsTrigger())
+	{
+		DestroyTrigger((b2TriggerPair*)pairUserData);
+		return;
+	}
+
 	// An attached body is being destroyed, we must destroy this contact
 	// immediately to avoid orphaned shape pointers.
 	Destroy(c);
@@ -136,8 +155,7 @@ void b2ContactManager::Destroy(b2Contact* c)
 	b2ContactPoint cp;
 	cp.shape1 = shape1;
 	cp.shape2 = shape2;
-	cp.friction = b2MixFriction(shape1->GetFriction(), shape2->GetFriction());
-	cp.restitution = b2MixRestitution(shape1->GetRestitution(), shape2->GetRestitution());
+	c->MixMaterials(&cp.friction, &cp.restitution);	//MIGUEL MODIFICATION: Material table
 
 	// Inform the user that this contact is ending.
 	int32 manifoldCount = c->GetManifoldCount();
@@ -153,6 +171,13 @@ void b2ContactManager::Destroy(b2Contact* c)
 			for (int32 j = 0; j < manifold->pointCount; ++j)
 			{
 				b2ManifoldPoint* mp = manifold->points + j;
+
+				//MIGUEL MODIFICATION: Speculative contacts. Points ahead of the shapes were never added.
+				if (mp->separation > 0.0f)
+				{
+					continue;
+				}
+
 				cp.position = body1->GetWorldPoint(mp->localPoint1);
 				b2Vec2 v1 = body1->GetLinearVelocityFromLocalPoint(mp->localPoint1);
 				b2Vec2 v2 = body2->GetLinearVelocityFromLocalPoint(mp->localPoint2);
@@ -164,6 +189,15 @@ void b2ContactManager::Destroy(b2Contact* c)
 		}
 	}
 
+	//MIGUEL MODIFICATION: TOI event queue. Contacts can be destroyed while it is in use.
+	m_world->m_toiQueue.Remove(c);
+
+	//MIGUEL MODIFICATION: Persistent islands
+	if (manifoldCount > 0 && (c->m_flags & b2Contact::e_nonSolidFlag) == 0)
+	{
+		m_world->UnlinkIslands(body1, body2);
+	}
+
 	// Remove from the world.
 	if (c->m_prev)
 	{
@@ -222,16 +256,168 @@ void b2ContactManager::Destroy(b2Contact* c)
 // contact list.
 void b2ContactManager::Collide()
 {
+	//MIGUEL MODIFICATION: Persistent islands. The contacts of the awake bodies are found from the
+	//awake islands, not from the whole contact list. They are gathered first, as updating them can
+	//merge and wake islands.
+	b2Contact** contacts = (b2Contact**)m_world->m_stackAllocator.Allocate(m_world->m_contactCount * sizeof(b2Contact*));
+	int32 contactCount = 0;
+
+	for (int32 i = 0; i < m_world->m_awakeIslandCount; ++i)
+	{
+		for (b2Body* b = m_world->m_awakeIslands[i]; b; b = b->m_islandNext)
+		{
+			if (b->IsSleeping())
+			{
+				continue;
+			}
+
+			for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+			{
+				// A contact between two awake bodies is taken once, from its first body.
+				b2Body* other = cn->other;
+				if (other->IsStatic() == false && other->IsSleeping() == false && cn->contact->GetShape1()->GetBody() != b)
+				{
+					continue;
+				}
+
+				b2Assert(contactCount < m_world->m_contactCount);
+				contacts[contactCount++] = cn->contact;
+			}
+		}
+	}
+
 	// Update awake contacts.
-	for (b2Contact* c = m_world->m_contactList; c; c = c->GetNext())
+	//MIGUEL MODIFICATION: Separation bound. Contacts which shapes can't touch yet are skipped.
+	b2CollideStatistics& stats = m_world->m_collideStatistics;
+	for (int32 i = 0; i < contactCount; ++i)
 	{
-		b2Body* body1 = c->GetShape1()->GetBody();
-		b2Body* body2 = c->GetShape2()->GetBody();
-		if (body1->IsSleeping() && body2->IsSleeping())
+		b2Contact* c = contacts[i];
+		if (c->IsSeparated())
 		{
+			++stats.skippedCount;
 			continue;
 		}
 
 		c->Update(m_world->m_contactListener);
+		++stats.evaluatedCount;
+		if (c->m_flags & b2Contact::e_reusedFlag)
+		{
+			++stats.reusedCount;
+		}
+	}
+
+	m_world->m_stackAllocator.Free(contacts);
+}
+
+//MIGUEL MODIFICATION: Trigger volumes
+b2TriggerPair* b2ContactManager::CreateTrigger(b2Shape* shape1, b2Shape* shape2)
+{
+	void* mem = m_world->m_blockAllocator.Allocate(sizeof(b2TriggerPair));
+	b2TriggerPair* pair = new (mem) b2TriggerPair;
+
+	if (shape1->IsTrigger())
+	{
+		pair->trigger = shape1;
+		pair->shape = shape2;
+	}
+	else
+	{
+		pair->trigger = shape2;
+		pair->shape = shape1;
+	}
+	pair->touching = false;
+
+	// Insert into the world.
+	pair->prev = NULL;
+	pair->next = m_world->m_triggerList;
+	if (m_world->m_triggerList != NULL)
+	{
+		m_world->m_triggerList->prev = pair;
+	}
+	m_world->m_triggerList = pair;
+
+	++m_world->m_triggerCount;
+	return pair;
+}
+
+//MIGUEL MODIFICATION: Trigger volumes. A shape still inside the trigger exits it.
+void b2ContactManager::DestroyTrigger(b2TriggerPair* pair)
+{
+	// A shape inside exits, as b2ContactManager::Destroy reports the points of a contact removed.
+	if (pair->touching)
+	{
+		++m_world->m_triggerStatistics.exitCount;
+		if (m_world->m_triggerListener != NULL)
+		{
+			m_world->m_triggerListener->Exit(pair->trigger, pair->shape);
+		}
+	}
+
+	// Remove from the world.
+	if (pair->prev)
+	{
+		pair->prev->next = pair->next;
+	}
+
+	if (pair->next)
+	{
+		pair->next->prev = pair->prev;
+	}
+
+	if (pair == m_world->m_triggerList)
+	{
+		m_world->m_triggerList = pair->next;
+	}
+
+	m_world->m_blockAllocator.Free(pair, sizeof(b2TriggerPair));
+	--m_world->m_triggerCount;
+}
+
+//MIGUEL MODIFICATION: Trigger volumes. The pairs with an awake body are tested for overlap
+//with the core shapes (b2Distance). The shapes touch when their cores are closer than the
+//skin they were shrunk by.
+void b2ContactManager::UpdateTriggers()
+{
+	b2TriggerStatistics& stats = m_world->m_triggerStatistics;
+	stats.pairCount = m_world->m_triggerCount;
+
+	for (b2TriggerPair* pair = m_world->m_triggerList; pair; pair = pair->next)
+	{
+		b2Body* body1 = pair->trigger->GetBody();
+		b2Body* body2 = pair->shape->GetBody();
+		bool active1 = body1->IsStatic() == false && body1->IsSleeping() == false;
+		bool active2 = body2->IsStatic() == false && body2->IsSleeping() == false;
+		if (active1 == false && active2 == false)
+		{
+			continue;
+		}
+
+		++stats.testedCount;
+
+		b2Vec2 x1, x2;
+		float32 distance = b2Distance(&x1, &x2, pair->trigger, body1->GetXForm(), pair->shape, body2->GetXForm());
+		bool touching = distance < 2.0f * b2_toiSlop;
+		if (touching == pair->touching)
+		{
+			continue;
+		}
+
+		pair->touching = touching;
+		if (touching)
+		{
+			++stats.enterCount;
+			if (m_world->m_triggerListener != NULL)
+			{
+				m_world->m_triggerListener->Enter(pair->trigger, pair->shape);
+			}
+		}
+		else
+		{
+			++stats.exitCount;
+			if (m_world->m_triggerListener != NULL)
+			{
+				m_world->m_triggerListener->Exit(pair->trigger, pair->shape);
+			}
+		}
 	}
 }
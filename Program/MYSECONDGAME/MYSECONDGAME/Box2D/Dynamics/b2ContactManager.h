@@ -24,8 +24,21 @@
 
 class b2World;
 class b2Contact;
+class b2Shape;
 struct b2TimeStep;
 
+//MIGUEL MODIFICATION: Trigger volumes
+/// Broad-phase pair of a trigger shape and another shape, kept instead of a contact.
+/// It has no manifold: the shapes are tested for overlap each step.
+struct b2TriggerPair
+{
+	b2Shape* trigger;
+	b2Shape* shape;
+	b2TriggerPair* prev;
+	b2TriggerPair* next;
+	bool touching;
+};
+
 // Delegate of b2World.
 class b2ContactManager : public b2PairCallback
 {
@@ -42,6 +55,11 @@ public:
 
 	void Collide();
 
+	//MIGUEL MODIFICATION: Trigger volumes
+	b2TriggerPair* CreateTrigger(b2Shape* shape1, b2Shape* shape2);
+	void DestroyTrigger(b2TriggerPair* pair);
+	void UpdateTriggers();
+
 	b2World* m_world;
 
 	// This lets us provide broadphase proxy pair user data for
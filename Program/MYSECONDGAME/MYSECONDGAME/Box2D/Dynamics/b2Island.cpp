@@ -165,6 +165,11 @@ b2Island::b2Island(
 
 	m_velocities = (b2Velocity*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Velocity));
 	m_positions = (b2Position*)m_allocator->Allocate(m_bodyCapacity * sizeof(b2Position));
+
+	//MIGUEL MODIFICATION: Adaptive iterations
+	m_class = e_defaultIsland;
+	m_velocityIterationCount = 0;
+	m_positionIterationCount = 0;
 }
 
 b2Island::~b2Island()
@@ -177,6 +182,33 @@ b2Island::~b2Island()
 	m_allocator->Free(m_bodies);
 }
 
+//MIGUEL MODIFICATION: Adaptive iterations
+b2IslandClass b2Island::Classify() const
+{
+	int32 dynamicCount = 0;
+	for (int32 i = 0; i < m_bodyCount; ++i)
+	{
+		const b2Body* b = m_bodies[i];
+		if (b->IsSoftBody())
+		{
+			return e_softBodyIsland;
+		}
+
+		if (!b->IsStatic())
+		{
+			++dynamicCount;
+		}
+	}
+
+	// Bodies resting on each other have at least one contact per body.
+	if (dynamicCount >= b2_stackIslandBodyCount && m_contactCount >= dynamicCount)
+	{
+		return e_stackIsland;
+	}
+
+	return e_defaultIsland;
+}
+
 //MIGUEL MODIFICATION: Position correction disabling 
 void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSleep, bool applyPosCorrection)
 {
@@ -244,7 +276,9 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 
 	}
 
-	b2ContactSolver contactSolver(step, m_contacts, m_contactCount, m_allocator);
+	//MIGUEL MODIFICATION: SIMD contact solver mode, selected by the step. It needs the island bodies.
+	b2ContactSolver contactSolver(step, m_contacts, m_contactCount, m_allocator, m_bodies, m_bodyCount);
+	contactSolver.GetStatistics(&m_contactSolverStatistics);
 
 	// Initialize velocity constraints.
 	contactSolver.InitVelocityConstraints(step);
@@ -254,15 +288,55 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 		m_joints[i]->InitVelocityConstraints(step);
 	}
 
+	//MIGUEL MODIFICATION: Adaptive iterations. Iterations of the island class. With adaptive
+	//iterations, velocities are kept before each iteration to see if the iteration changed them.
+	m_class = Classify();
+	const int32 velocityIterations = step.islandVelocityIterations[m_class];
+	const int32 positionIterations = step.islandPositionIterations[m_class];
+	const float32 linIterTolSqr = b2_linearIterationTolerance * b2_linearIterationTolerance;
+	const float32 angIterTolSqr = b2_angularIterationTolerance * b2_angularIterationTolerance;
+	m_velocityIterationCount = 0;
+	m_positionIterationCount = 0;
+
 	// Solve velocity constraints.
-	for (int32 i = 0; i < step.velocityIterations; ++i)
+	for (int32 i = 0; i < velocityIterations; ++i)
 	{
+		bool checkVelocities = step.adaptiveIterations && i + 1 >= b2_minVelocityIterations;
+		if (checkVelocities)
+		{
+			for (int32 j = 0; j < m_bodyCount; ++j)
+			{
+				m_velocities[j].v = m_bodies[j]->m_linearVelocity;
+				m_velocities[j].w = m_bodies[j]->m_angularVelocity;
+			}
+		}
+
 		for (int32 j = 0; j < m_jointCount; ++j)
 		{
 			m_joints[j]->SolveVelocityConstraints(step);
 		}
 
 		contactSolver.SolveVelocityConstraints();
+		++m_velocityIterationCount;
+
+		//MIGUEL MODIFICATION: Adaptive iterations
+		if (checkVelocities)
+		{
+			bool velocitiesOkay = true;
+			for (int32 j = 0; j < m_bodyCount && velocitiesOkay; ++j)
+			{
+				const b2Body* b = m_bodies[j];
+				b2Vec2 dv = b->m_linearVelocity - m_velocities[j].v;
+				float32 dw = b->m_angularVelocity - m_velocities[j].w;
+				velocitiesOkay = b2Dot(dv, dv) <= linIterTolSqr && dw * dw <= angIterTolSqr;
+			}
+
+			if (velocitiesOkay)
+			{
+				// Exit early if the velocities settled.
+				break;
+			}
+		}
 	}
 
 	// Post-solve (store impulses for warm starting).
@@ -294,9 +368,10 @@ void b2Island::Solve(const b2TimeStep& step, const b2Vec2& gravity, bool allowSl
 	//MIGUEL MODIFICATION: Position correction disabling
 	if(applyPosCorrection)
 	{
-		for (int32 i = 0; i < step.positionIterations; ++i)
+		for (int32 i = 0; i < positionIterations; ++i)
 		{
 			bool contactsOkay = contactSolver.SolvePositionConstraints(b2_contactBaumgarte);
+			++m_positionIterationCount;	//MIGUEL MODIFICATION: Adaptive iterations
 
 			bool jointsOkay = true;
 			for (int32 i = 0; i < m_jointCount; ++i)
@@ -470,6 +545,13 @@ void b2Island::Report(b2ContactConstraint* constraints)
 			{
 				b2ManifoldPoint* point = manifold->points + k;
 				b2ContactConstraintPoint* ccp = cc->points + k;
+
+				//MIGUEL MODIFICATION: Speculative contacts. Points ahead of the shapes are not reported.
+				if (point->separation > 0.0f)
+				{
+					continue;
+				}
+
 				cr.position = b1->GetWorldPoint(point->localPoint1);
 
 				// TOI constraint results are not stored, so get
@@ -21,6 +21,7 @@
 
 #include "../Common/b2Math.h"
 #include "b2Body.h"
+#include "b2World.h"
 
 class b2Contact;
 class b2Joint;
@@ -82,6 +83,9 @@ public:
 
 	void Report(b2ContactConstraint* constraints);
 
+	//MIGUEL MODIFICATION: Adaptive iterations
+	b2IslandClass Classify() const;
+
 	b2StackAllocator* m_allocator;
 	b2ContactListener* m_listener;
 
@@ -100,7 +104,13 @@ public:
 	int32 m_contactCapacity;
 	int32 m_jointCapacity;
 
+	//MIGUEL MODIFICATION: Adaptive iterations. Class and iterations done in the last Solve.
+	b2IslandClass m_class;
+	int32 m_velocityIterationCount;
 	int32 m_positionIterationCount;
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode. Counters of the last Solve.
+	b2ContactSolverStatistics m_contactSolverStatistics;
 };
 
 #endif
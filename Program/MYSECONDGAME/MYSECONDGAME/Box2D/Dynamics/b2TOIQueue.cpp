@@ -0,0 +1,166 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#include "b2TOIQueue.h"
+#include "Contacts/b2Contact.h"
+
+#include <string.h>
+
+b2TOIQueue::b2TOIQueue()
+{
+	m_entries = NULL;
+	m_count = 0;
+	m_capacity = 0;
+	m_maxCount = 0;
+}
+
+b2TOIQueue::~b2TOIQueue()
+{
+	Clear();
+	if (m_entries)
+	{
+		b2Free(m_entries);
+	}
+}
+
+void b2TOIQueue::Push(b2Contact* contact, float32 toi)
+{
+	int32 index = contact->m_toiIndex;
+	if (index != -1)
+	{
+		// Already queued: move it up or down.
+		b2Assert(m_entries[index].contact == contact);
+		float32 oldTOI = m_entries[index].toi;
+		m_entries[index].toi = toi;
+		if (toi < oldTOI)
+		{
+			SiftUp(index);
+		}
+		else
+		{
+			SiftDown(index);
+		}
+		return;
+	}
+
+	if (m_count == m_capacity)
+	{
+		int32 capacity = b2Max(2 * m_capacity, 64);
+		b2TOIEntry* entries = (b2TOIEntry*)b2Alloc(capacity * sizeof(b2TOIEntry));
+		if (m_entries)
+		{
+			memcpy(entries, m_entries, m_count * sizeof(b2TOIEntry));
+			b2Free(m_entries);
+		}
+		m_entries = entries;
+		m_capacity = capacity;
+	}
+
+	b2TOIEntry entry;
+	entry.toi = toi;
+	entry.contact = contact;
+	Set(m_count, entry);
+	++m_count;
+	m_maxCount = b2Max(m_maxCount, m_count);
+	SiftUp(m_count - 1);
+}
+
+void b2TOIQueue::Remove(b2Contact* contact)
+{
+	int32 index = contact->m_toiIndex;
+	if (index == -1)
+	{
+		return;
+	}
+
+	b2Assert(m_entries[index].contact == contact);
+	contact->m_toiIndex = -1;
+	--m_count;
+
+	if (index == m_count)
+	{
+		return;
+	}
+
+	// Fill the hole with the last entry and restore the heap order.
+	float32 oldTOI = m_entries[index].toi;
+	Set(index, m_entries[m_count]);
+	if (m_entries[index].toi < oldTOI)
+	{
+		SiftUp(index);
+	}
+	else
+	{
+		SiftDown(index);
+	}
+}
+
+void b2TOIQueue::Clear()
+{
+	for (int32 i = 0; i < m_count; ++i)
+	{
+		m_entries[i].contact->m_toiIndex = -1;
+	}
+	m_count = 0;
+}
+
+void b2TOIQueue::Set(int32 index, const b2TOIEntry& entry)
+{
+	m_entries[index] = entry;
+	entry.contact->m_toiIndex = index;
+}
+
+void b2TOIQueue::SiftUp(int32 index)
+{
+	b2TOIEntry entry = m_entries[index];
+	while (index > 0)
+	{
+		int32 parent = (index - 1) >> 1;
+		if (m_entries[parent].toi <= entry.toi)
+		{
+			break;
+		}
+		Set(index, m_entries[parent]);
+		index = parent;
+	}
+	Set(index, entry);
+}
+
+void b2TOIQueue::SiftDown(int32 index)
+{
+	b2TOIEntry entry = m_entries[index];
+	for (;;)
+	{
+		int32 child = 2 * index + 1;
+		if (child >= m_count)
+		{
+			break;
+		}
+		if (child + 1 < m_count && m_entries[child + 1].toi < m_entries[child].toi)
+		{
+			++child;
+		}
+		if (entry.toi <= m_entries[child].toi)
+		{
+			break;
+		}
+		Set(index, m_entries[child]);
+		index = child;
+	}
+	Set(index, entry);
+}
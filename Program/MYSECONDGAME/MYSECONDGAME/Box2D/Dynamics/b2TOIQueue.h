@@ -0,0 +1,88 @@
+/*
+* Copyright (c) 2009 Miguel Angel Quinones
+*
+* This software is provided 'as-is', without any express or implied
+* warranty.  In no event will the authors be held liable for any damages
+* arising from the use of this software.
+* Permission is granted to anyone to use this software for any purpose,
+* including commercial applications, and to alter it and redistribute it
+* freely, subject to the following restrictions:
+* 1. The origin of this software must not be misrepresented; you must not
+* claim that you wrote the original software. If you use this software
+* in a product, an acknowledgment in the product documentation would be
+* appreciated but is not required.
+* 2. Altered source versions must be plainly marked as such, and must not be
+* misrepresented as being the original software.
+* 3. This notice may not be removed or altered from any source distribution.
+*/
+
+#ifndef B2_TOI_QUEUE_H
+#define B2_TOI_QUEUE_H
+
+#include "../Common/b2Settings.h"
+
+//MIGUEL MODIFICATION: TOI event queue (see b2World::SolveTOI)
+
+class b2Contact;
+
+/// A binary min heap of contacts keyed by their time of impact. Each queued contact
+/// knows its position in the heap (b2Contact::m_toiIndex), so its key can be changed or
+/// it can be removed without a search. The storage grows as needed and is kept between steps.
+class b2TOIQueue
+{
+public:
+	b2TOIQueue();
+	~b2TOIQueue();
+
+	/// Queue a contact, or change its time of impact if it is queued.
+	void Push(b2Contact* contact, float32 toi);
+
+	/// Remove a contact if it is queued.
+	void Remove(b2Contact* contact);
+
+	/// Remove all the contacts.
+	void Clear();
+
+	/// Get the contact with the earliest time of impact. The queue must not be empty.
+	b2Contact* GetMin() const;
+
+	/// Get the earliest time of impact. The queue must not be empty.
+	float32 GetMinTOI() const;
+
+	int32 GetCount() const { return m_count; }
+
+	/// Get the largest number of contacts queued at once since the last reset.
+	int32 GetMaxCount() const { return m_maxCount; }
+	void ResetMaxCount() { m_maxCount = m_count; }
+
+private:
+
+	struct b2TOIEntry
+	{
+		float32 toi;
+		b2Contact* contact;
+	};
+
+	void SiftUp(int32 index);
+	void SiftDown(int32 index);
+	void Set(int32 index, const b2TOIEntry& entry);
+
+	b2TOIEntry* m_entries;
+	int32 m_count;
+	int32 m_capacity;
+	int32 m_maxCount;
+};
+
+inline b2Contact* b2TOIQueue::GetMin() const
+{
+	b2Assert(m_count > 0);
+	return m_entries[0].contact;
+}
+
+inline float32 b2TOIQueue::GetMinTOI() const
+{
+	b2Assert(m_count > 0);
+	return m_entries[0].toi;
+}
+
+#endif
@@ -22,13 +22,17 @@
 #include "Joints/b2PulleyJoint.h"
 #include "Contacts/b2Contact.h"
 #include "Contacts/b2ContactSolver.h"
+#include "../Common/b2ThreadPool.h"
+#include "../Common/b2Timer.h"
 #include "../Collision/b2Collision.h"
 #include "../Collision/Shapes/b2CircleShape.h"
 #include "../Collision/Shapes/b2PolygonShape.h"
 #include "../Collision/Shapes/b2EdgeShape.h"
 #include <new>
+#include <algorithm>
+#include <cstring>
 
-b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
+b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, b2BroadPhaseType broadPhaseType)
 {
 	m_destructionListener = NULL;
 	m_boundaryListener = NULL;
@@ -49,6 +53,49 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 	m_warmStarting = true;
 	m_continuousPhysics = true;
 
+	//MIGUEL MODIFICATION: Parallel island solving
+	m_threadPool = NULL;
+	m_solverAllocators = NULL;
+	m_stackAllocatorSize = b2_stackSize;	//MIGUEL MODIFICATION: Allocator statistics
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	m_contactSolverType = e_scalarContactSolver;
+	memset(&m_contactSolverStatistics, 0, sizeof(b2ContactSolverStatistics));
+	memset(&m_toiStatistics, 0, sizeof(b2TOIStatistics));
+
+	//MIGUEL MODIFICATION: Material table
+	m_materialCount = 0;
+
+	//MIGUEL MODIFICATION: Adaptive iterations
+	m_adaptiveIterations = false;
+	for (int32 i = 0; i < e_islandClassCount; ++i)
+	{
+		m_islandVelocityIterations[i] = 0;
+		m_islandPositionIterations[i] = 0;
+	}
+	memset(&m_iterationStatistics, 0, sizeof(b2IterationStatistics));
+
+	//MIGUEL MODIFICATION: Trigger volumes
+	m_triggerList = NULL;
+	m_triggerCount = 0;
+	m_triggerListener = NULL;
+	memset(&m_triggerStatistics, 0, sizeof(b2TriggerStatistics));
+
+	//MIGUEL MODIFICATION: Separation bound and manifold reuse
+	memset(&m_collideStatistics, 0, sizeof(b2CollideStatistics));
+	m_manifoldReuse = false;
+
+	//MIGUEL MODIFICATION: Step profiling
+	memset(&m_profile, 0, sizeof(b2Profile));
+	memset(&m_averageProfile, 0, sizeof(b2Profile));
+	m_profileListener.m_listener = NULL;
+	m_profileListener.m_time = 0.0f;
+
+	//MIGUEL MODIFICATION: Persistent islands
+	m_awakeIslands = NULL;
+	m_awakeIslandCount = 0;
+	m_awakeIslandCapacity = 0;
+
 	m_allowSleep = doSleep;
 	m_gravity = gravity;
 
@@ -58,7 +105,8 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 
 	m_contactManager.m_world = this;
 	void* mem = b2Alloc(sizeof(b2BroadPhase));
-	m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager);
+	//MIGUEL MODIFICATION: Broad-phase algorithm selection
+	m_broadPhase = new (mem) b2BroadPhase(worldAABB, &m_contactManager, broadPhaseType);
 
 	b2BodyDef bd;
 	m_groundBody = CreateBody(&bd);
@@ -66,9 +114,24 @@ b2World::b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep)
 
 b2World::~b2World()
 {
+	//MIGUEL MODIFICATION: Parallel island solving
+	SetSolverThreadCount(1);
+
+	//MIGUEL MODIFICATION: Controllers may own memory (b2RingSpringController)
+	while (m_controllerList)
+	{
+		DestroyController(m_controllerList);
+	}
+
 	DestroyBody(m_groundBody);
 	m_broadPhase->~b2BroadPhase();
 	b2Free(m_broadPhase);
+
+	//MIGUEL MODIFICATION: Persistent islands
+	if (m_awakeIslands)
+	{
+		b2Free(m_awakeIslands);
+	}
 }
 
 void b2World::SetDestructionListener(b2DestructionListener* listener)
@@ -91,6 +154,12 @@ void b2World::SetContactListener(b2ContactListener* listener)
 	m_contactListener = listener;
 }
 
+//MIGUEL MODIFICATION: Trigger volumes
+void b2World::SetTriggerListener(b2TriggerListener* listener)
+{
+	m_triggerListener = listener;
+}
+
 void b2World::SetDebugDraw(b2DebugDraw* debugDraw)
 {
 	m_debugDraw = debugDraw;
@@ -117,6 +186,12 @@ b2Body* b2World::CreateBody(const b2BodyDef* def)
 	m_bodyList = b;
 	++m_bodyCount;
 
+	//MIGUEL MODIFICATION: Persistent islands. A new dynamic body is an island of its own.
+	if (b->IsStatic() == false && b->IsSleeping() == false)
+	{
+		AddAwakeIsland(b);
+	}
+
 	return b;
 }
 
@@ -171,6 +246,12 @@ void b2World::DestroyBody(b2Body* b)
 		b2Shape::Destroy(s0, &m_blockAllocator);
 	}
 
+	//MIGUEL MODIFICATION: Persistent islands. The other bodies of its island are grouped again.
+	if (b->IsStatic() == false)
+	{
+		SplitIsland(FindIsland(b), b);
+	}
+
 	// Remove world body list.
 	if (b->m_prev)
 	{
@@ -223,6 +304,9 @@ b2Joint* b2World::CreateJoint(const b2JointDef* def)
 	if (j->m_body2->m_jointList) j->m_body2->m_jointList->prev = &j->m_node2;
 	j->m_body2->m_jointList = &j->m_node2;
 
+	//MIGUEL MODIFICATION: Persistent islands
+	LinkIslands(j->m_body1, j->m_body2);
+
 	// If the joint prevents collisions, then reset collision filtering.
 	if (def->collideConnected == false)
 	{
@@ -267,6 +351,9 @@ void b2World::DestroyJoint(b2Joint* j)
 	body1->WakeUp();
 	body2->WakeUp();
 
+	//MIGUEL MODIFICATION: Persistent islands
+	UnlinkIslands(body1, body2);
+
 	// Remove from body 1.
 	if (j->m_node1.prev)
 	{
@@ -352,6 +439,390 @@ void b2World::DestroyController(b2Controller* controller)
 	b2Controller::Destroy(controller, &m_blockAllocator);
 }
 
+//MIGUEL MODIFICATION: Persistent islands
+// The dynamic bodies connected by touching contacts, joints or island binding controllers are
+// kept in the same island (union-find, the root keeps the list of bodies). Islands are merged
+// as soon as a constraint is added. Removing a constraint only marks the island, it is split
+// at the start of the next Solve (see UpdateAwakeIslands). Static bodies are always alone.
+// An island is awake (its root is in the awake island array) or asleep as a whole, all its
+// bodies share its sleep flag (see ValidateIslands).
+
+b2Body* b2World::FindIsland(b2Body* body)
+{
+	b2Body* root = body;
+	while (root->m_islandParent)
+	{
+		root = root->m_islandParent;
+	}
+
+	// Path compression.
+	while (body != root)
+	{
+		b2Body* parent = body->m_islandParent;
+		body->m_islandParent = root;
+		body = parent;
+	}
+
+	return root;
+}
+
+void b2World::LinkIslands(b2Body* body1, b2Body* body2)
+{
+	if (body1->IsStatic() || body2->IsStatic())
+	{
+		return;
+	}
+
+	b2Body* root1 = FindIsland(body1);
+	b2Body* root2 = FindIsland(body2);
+	if (root1 == root2)
+	{
+		return;
+	}
+
+	// The bigger island keeps its root.
+	if (root1->m_islandSize < root2->m_islandSize)
+	{
+		b2Swap(root1, root2);
+	}
+
+	// The merged island is solved if one of them was, the sleeping one wakes up.
+	if (root1->m_awakeIslandIndex != -1 || root2->m_awakeIslandIndex != -1)
+	{
+		WakeIsland(root1);
+		WakeIsland(root2);
+	}
+	RemoveAwakeIsland(root2);
+
+	root2->m_islandParent = root1;
+	root1->m_islandTail->m_islandNext = root2;
+	root1->m_islandTail = root2->m_islandTail;
+	root1->m_islandSize += root2->m_islandSize;
+	root1->m_islandRemoveCount += root2->m_islandRemoveCount;
+}
+
+void b2World::UnlinkIslands(b2Body* body1, b2Body* body2)
+{
+	if (body1->IsStatic() || body2->IsStatic())
+	{
+		return;
+	}
+
+	++FindIsland(body1)->m_islandRemoveCount;
+}
+
+// Wakes all the bodies of the island, as the island solve would.
+void b2World::WakeIsland(b2Body* body)
+{
+	b2Assert(body->IsStatic() == false);
+	b2Body* root = FindIsland(body);
+	if (root->m_awakeIslandIndex != -1)
+	{
+		return;
+	}
+
+	for (b2Body* b = root; b; b = b->m_islandNext)
+	{
+		b->m_flags &= ~b2Body::e_sleepFlag;
+	}
+
+	AddAwakeIsland(root);
+}
+
+//MIGUEL MODIFICATION: World snapshots
+void b2World::SetIslandAwake(b2Body* body, bool flag)
+{
+	b2Assert(m_lock == false);
+	b2Assert(body->IsStatic() == false);
+	b2Body* root = FindIsland(body);
+	if (flag)
+	{
+		WakeIsland(root);
+	}
+	else
+	{
+		RemoveAwakeIsland(root);
+	}
+
+	for (b2Body* b = root; b; b = b->m_islandNext)
+	{
+		if (flag)
+		{
+			b->m_sleepTime = 0.0f;
+		}
+		else
+		{
+			b->PutToSleep();
+		}
+	}
+}
+
+void b2World::AddAwakeIsland(b2Body* root)
+{
+	if (root->m_awakeIslandIndex != -1)
+	{
+		return;
+	}
+
+	if (m_awakeIslandCount == m_awakeIslandCapacity)
+	{
+		int32 capacity = b2Max(2 * m_awakeIslandCapacity, 64);
+		b2Body** islands = (b2Body**)b2Alloc(capacity * sizeof(b2Body*));
+		if (m_awakeIslands)
+		{
+			memcpy(islands, m_awakeIslands, m_awakeIslandCount * sizeof(b2Body*));
+			b2Free(m_awakeIslands);
+		}
+		m_awakeIslands = islands;
+		m_awakeIslandCapacity = capacity;
+	}
+
+	root->m_awakeIslandIndex = m_awakeIslandCount;
+	m_awakeIslands[m_awakeIslandCount++] = root;
+}
+
+void b2World::RemoveAwakeIsland(b2Body* root)
+{
+	int32 index = root->m_awakeIslandIndex;
+	if (index == -1)
+	{
+		return;
+	}
+
+	b2Assert(m_awakeIslands[index] == root);
+	b2Body* last = m_awakeIslands[--m_awakeIslandCount];
+	m_awakeIslands[index] = last;
+	last->m_awakeIslandIndex = index;
+	root->m_awakeIslandIndex = -1;
+}
+
+// Groups the bodies of an island again from their constraints. The removed body (if any)
+// is left alone.
+void b2World::SplitIsland(b2Body* root, b2Body* removed)
+{
+	b2Assert(root->m_islandParent == NULL);
+	RemoveAwakeIsland(root);
+
+	int32 count = root->m_islandSize;
+	b2Body** bodies = (b2Body**)m_stackAllocator.Allocate(count * sizeof(b2Body*));
+	int32 i = 0;
+	for (b2Body* b = root; b; b = b->m_islandNext)
+	{
+		bodies[i++] = b;
+	}
+	b2Assert(i == count);
+
+	for (i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		b2Assert(b->m_awakeIslandIndex == -1);
+		b->m_islandParent = NULL;
+		b->m_islandNext = NULL;
+		b->m_islandTail = b;
+		b->m_islandSize = 1;
+		b->m_islandRemoveCount = 0;
+	}
+
+	for (i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		if (b == removed)
+		{
+			continue;
+		}
+
+		for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+		{
+			b2Contact* c = cn->contact;
+			if ((c->m_flags & b2Contact::e_nonSolidFlag) == 0 && c->GetManifoldCount() > 0 && cn->other != removed)
+			{
+				LinkIslands(b, cn->other);
+			}
+		}
+
+		for (b2JointEdge* jn = b->m_jointList; jn; jn = jn->next)
+		{
+			if (jn->other != removed)
+			{
+				LinkIslands(b, jn->other);
+			}
+		}
+
+		for (b2ControllerEdge* ce = b->m_controllerList; ce; ce = ce->nextController)
+		{
+			b2Controller* controller = ce->controller;
+			if (controller->m_bindIsland)
+			{
+				b2Body* other = controller->GetIslandBody(b);
+				if (other && other != removed)
+				{
+					LinkIslands(b, other);
+				}
+			}
+		}
+	}
+
+	// The new islands with an awake body are solved.
+	for (i = 0; i < count; ++i)
+	{
+		b2Body* b = bodies[i];
+		if (b != removed && (b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag)) == 0)
+		{
+			WakeIsland(b);
+		}
+	}
+
+	m_stackAllocator.Free(bodies);
+}
+
+// Drops the islands that fell asleep in the solve. Both solves call it once all the islands are
+// solved, so the order of the awake islands, and of the next steps, is the same.
+void b2World::RemoveSleepingIslands()
+{
+	for (int32 i = 0; i < m_awakeIslandCount; )
+	{
+		// The whole island sleeps or none of it.
+		b2Body* root = m_awakeIslands[i];
+		if (root->IsSleeping())
+		{
+			// The last island takes its place.
+			RemoveAwakeIsland(root);
+			continue;
+		}
+
+		++i;
+	}
+}
+
+// Called when the body type changes.
+void b2World::UpdateIslandType(b2Body* body)
+{
+	if (body->IsStatic())
+	{
+		SplitIsland(FindIsland(body), body);
+		return;
+	}
+
+	// It has no touching contacts yet, they were destroyed when the proxies were filtered again.
+	for (b2JointEdge* jn = body->m_jointList; jn; jn = jn->next)
+	{
+		LinkIslands(body, jn->other);
+	}
+
+	for (b2ControllerEdge* ce = body->m_controllerList; ce; ce = ce->nextController)
+	{
+		b2Controller* controller = ce->controller;
+		if (controller->m_bindIsland)
+		{
+			b2Body* other = controller->GetIslandBody(body);
+			if (other)
+			{
+				LinkIslands(body, other);
+			}
+		}
+	}
+
+	if (body->IsSleeping() == false)
+	{
+		WakeIsland(body);
+	}
+}
+
+// Drops the islands with no awake body from the awake island array, and splits the awake
+// islands that lost constraints, so the solved islands are the ones a full search would find.
+// Sleeping islands are split when they wake up.
+void b2World::UpdateAwakeIslands()
+{
+	for (int32 i = 0; i < m_awakeIslandCount; )
+	{
+		b2Body* root = m_awakeIslands[i];
+
+		bool awake = false;
+		for (b2Body* b = root; b; b = b->m_islandNext)
+		{
+			if ((b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag)) == 0)
+			{
+				awake = true;
+				break;
+			}
+		}
+
+		if (awake == false)
+		{
+			// The last island takes its place.
+			RemoveAwakeIsland(root);
+			continue;
+		}
+
+		if (root->m_islandRemoveCount > 0)
+		{
+			// The last island takes its place, the new islands go to the end.
+			SplitIsland(root, NULL);
+			continue;
+		}
+
+		++i;
+	}
+}
+
+// Debug check, between steps: an island is awake (its root is in the awake island array) or
+// asleep, and all its bodies share that state. Frozen bodies are left out.
+void b2World::ValidateIslands()
+{
+#ifdef _DEBUG
+	for (int32 i = 0; i < m_awakeIslandCount; ++i)
+	{
+		b2Body* root = m_awakeIslands[i];
+		b2Assert(root->m_islandParent == NULL);
+		b2Assert(root->m_awakeIslandIndex == i);
+	}
+
+	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	{
+		if (b->IsStatic())
+		{
+			b2Assert(b->m_islandParent == NULL && b->m_awakeIslandIndex == -1);
+			continue;
+		}
+
+		b2Body* root = FindIsland(b);
+		if (b == root)
+		{
+			int32 count = 0;
+			for (b2Body* ib = root; ib; ib = ib->m_islandNext)
+			{
+				b2Assert(FindIsland(ib) == root);
+				++count;
+			}
+			b2Assert(count == root->m_islandSize);
+		}
+		else
+		{
+			b2Assert(b->m_awakeIslandIndex == -1);
+		}
+
+		if (b->IsFrozen() == false)
+		{
+			b2Assert(b->IsSleeping() == (root->m_awakeIslandIndex == -1));
+		}
+
+		// Touching solid contacts and joints never cross islands.
+		for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+		{
+			b2Contact* c = cn->contact;
+			if ((c->m_flags & b2Contact::e_nonSolidFlag) == 0 && c->GetManifoldCount() > 0 && cn->other->IsStatic() == false)
+			{
+				b2Assert(FindIsland(cn->other) == root);
+			}
+		}
+		for (b2JointEdge* jn = b->m_jointList; jn; jn = jn->next)
+		{
+			b2Assert(jn->other->IsStatic() || FindIsland(jn->other) == root);
+		}
+	}
+#endif
+}
+
 void b2World::Refilter(b2Shape* shape)
 {
 	b2Assert(m_lock == false);
@@ -362,176 +833,617 @@ void b2World::Refilter(b2Shape* shape)
 // Find islands, integrate and solve constraints, solve position constraints
 void b2World::Solve(const b2TimeStep& step)
 {
+	b2Timer timer;	//MIGUEL MODIFICATION: Step profiling
+
 	// Step all controlls
 	for(b2Controller* controller = m_controllerList;controller;controller=controller->m_next)
 	{
 		controller->Step(step);
 	}
 
-	// Size the island for the worst case.
-	b2Island island(m_bodyCount, m_contactCount, m_jointCount, &m_stackAllocator, m_contactListener);
+	//MIGUEL MODIFICATION: Step profiling
+	m_profile.controllers = timer.GetMilliseconds();
+	timer.Reset();
 
-	// Clear all the island flags.
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
+	//MIGUEL MODIFICATION: Persistent islands
+	UpdateAwakeIslands();
+
+	m_profile.islands = timer.GetMilliseconds();	//MIGUEL MODIFICATION: Step profiling
+
+	//MIGUEL MODIFICATION: Parallel island solving
+	if (m_threadPool != NULL)
 	{
-		b->m_flags &= ~b2Body::e_islandFlag;
+		SolveIslandsParallel(step);
 	}
-	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	else
 	{
-		c->m_flags &= ~b2Contact::e_islandFlag;
+		SolveIslands(step);
 	}
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+
+	timer.Reset();	//MIGUEL MODIFICATION: Step profiling
+
+	// Synchronize shapes, check for out of range bodies.
+	//MIGUEL MODIFICATION: Persistent islands. Only the bodies of awake islands can move.
+	for (int32 i = 0; i < m_awakeIslandCount; ++i)
+	for (b2Body* b = m_awakeIslands[i]; b; b = b->m_islandNext)
 	{
-		j->m_islandFlag = false;
+		if (b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+		{
+			continue;
+		}
+
+		//MIGUEL MODIFICATION: Speculative contacts. Predict the motion of the next step.
+		if (b->m_flags & b2Body::e_speculativeFlag)
+		{
+			b->m_speculativeTranslation = step.dt * b->m_linearVelocity;
+			b->m_speculativeDistance = b->m_speculativeTranslation.Length();
+		}
+		
+		// Update shapes (for broad-phase). If the shapes go out of
+		// the world AABB then shapes and contacts may be destroyed,
+		// including contacts that are
+		bool inRange = b->SynchronizeShapes();
+
+		// Did the body's shapes leave the world?
+		if (inRange == false && m_boundaryListener != NULL)
+		{
+			m_boundaryListener->Violation(b);
+		}
 	}
 
-	// Build and simulate all awake islands.
-	int32 stackSize = m_bodyCount;
-	b2Body** stack = (b2Body**)m_stackAllocator.Allocate(stackSize * sizeof(b2Body*));
-	for (b2Body* seed = m_bodyList; seed; seed = seed->m_next)
+	// Commit shape proxy movements to the broad-phase so that new contacts are created.
+	// Also, some contacts can be destroyed.
+	m_broadPhase->Commit();
+
+	m_profile.broadphase = timer.GetMilliseconds();	//MIGUEL MODIFICATION: Step profiling
+}
+
+//MIGUEL MODIFICATION: Island search, shared by the serial and the parallel solve.
+// Appends the island of the root body to the island (it is not cleared first).
+// Returns false if a body in the island has position correction disabled.
+//MIGUEL MODIFICATION: Persistent islands. The dynamic bodies are taken from the island list,
+//the search only collects the constraints and the static bodies.
+bool b2World::BuildIsland(b2Body* root, b2Island* island)
+{
+	b2Assert(root->m_islandParent == NULL);
+
+	//MIGUEL MODIFICATION: Position correction disabling
+	bool applyposcorrection(true);
+
+	for (b2Body* b = root; b; b = b->m_islandNext)
 	{
-		if (seed->m_flags & (b2Body::e_islandFlag | b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+		//MIGUEL MODIFICATION: Position correction disabling 
+		applyposcorrection = applyposcorrection && ((b->m_flags & b2Body::e_posCorrectionFlag) == b2Body::e_posCorrectionFlag);
+		island->Add(b);
+
+		// Make sure the body is awake.
+		b->m_flags &= ~b2Body::e_sleepFlag;
+
+		// Search all contacts connected to this body.
+		for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
 		{
-			continue;
+			// Has this contact already been added to an island?
+			if (cn->contact->m_flags & (b2Contact::e_islandFlag | b2Contact::e_nonSolidFlag))
+			{
+				continue;
+			}
+
+			// Is this contact touching?
+			if (cn->contact->GetManifoldCount() == 0)
+			{
+				continue;
+			}
+
+			island->Add(cn->contact);
+			cn->contact->m_flags |= b2Contact::e_islandFlag;
+
+			// Static bodies are added once to each island they touch.
+			b2Body* other = cn->other;
+			b2Assert(other->IsStatic() || FindIsland(other) == root);
+			if (other->IsStatic() && (other->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				island->Add(other);
+				other->m_flags |= b2Body::e_islandFlag;
+				other->m_flags &= ~b2Body::e_sleepFlag;
+			}
 		}
 
-		if (seed->IsStatic())
+		// Search all joints connect to this body.
+		for (b2JointEdge* jn = b->m_jointList; jn; jn = jn->next)
 		{
-			continue;
+			if (jn->joint->m_islandFlag == true)
+			{
+				continue;
+			}
+
+			island->Add(jn->joint);
+			jn->joint->m_islandFlag = true;
+
+			b2Body* other = jn->other;
+			b2Assert(other->IsStatic() || FindIsland(other) == root);
+			if (other->IsStatic() && (other->m_flags & b2Body::e_islandFlag) == 0)
+			{
+				island->Add(other);
+				other->m_flags |= b2Body::e_islandFlag;
+				other->m_flags &= ~b2Body::e_sleepFlag;
+			}
 		}
+	}
+
+	return applyposcorrection;
+}
 
-		// Reset island and stack.
+// Solve the islands one by one on this thread.
+//MIGUEL MODIFICATION: Persistent islands. The island flags are clear between steps, so there is
+//nothing to reset here. The islands that fall asleep leave the awake island array.
+void b2World::SolveIslands(const b2TimeStep& step)
+{
+	// Size the island for the worst case.
+	b2Island island(m_bodyCount, m_contactCount, m_jointCount, &m_stackAllocator, m_contactListener);
+
+	//MIGUEL MODIFICATION: Step profiling
+	b2Timer timer;
+	float32 solveTime = 0.0f;
+
+	// Build and simulate all awake islands.
+	for (int32 i = 0; i < m_awakeIslandCount; ++i)
+	{
+		b2Body* root = m_awakeIslands[i];
+
+		// Reset island.
 		island.Clear();
-		int32 stackCount = 0;
-		stack[stackCount++] = seed;
-		seed->m_flags |= b2Body::e_islandFlag;
 
 		//MIGUEL MODIFICATION: Position correction disabling
-		bool applyposcorrection(true);
-
-		// Perform a depth first search (DFS) on the constraint graph.
-		while (stackCount > 0)
-		{
-			// Grab the next body off the stack and add it to the island.
-			b2Body* b = stack[--stackCount];
+		bool applyposcorrection = BuildIsland(root, &island);
 
-			//MIGUEL MODIFICATION: Position correction disabling 
-			applyposcorrection = applyposcorrection && ((b->m_flags & b2Body::e_posCorrectionFlag) == b2Body::e_posCorrectionFlag);
-			island.Add(b);
+		//MIGUEL MODIFICATION: Step profiling
+		b2Timer solveTimer;
+		island.Solve(step, m_gravity, m_allowSleep, applyposcorrection);
+		solveTime += solveTimer.GetMilliseconds();
+		++m_profile.islandCount;
 
-			// Make sure the body is awake.
-			b->m_flags &= ~b2Body::e_sleepFlag;
+		//MIGUEL MODIFICATION: SIMD contact solver mode
+		AddContactSolverStatistics(island.m_contactSolverStatistics);
+		//MIGUEL MODIFICATION: Adaptive iterations
+		AddIterationStatistics(island.m_class, island.m_velocityIterationCount, island.m_positionIterationCount);
 
-			// To keep islands as small as possible, we don't
-			// propagate islands across static bodies.
+		// Post solve cleanup.
+		for (int32 j = 0; j < island.m_bodyCount; ++j)
+		{
+			// Allow static bodies to participate in other islands.
+			b2Body* b = island.m_bodies[j];
 			if (b->IsStatic())
 			{
-				continue;
+				b->m_flags &= ~b2Body::e_islandFlag;
+			}
+			else
+			{
+				// Reset the TOI sweep.
+				b->m_sweep.t0 = 0.0f;
 			}
+		}
+		for (int32 j = 0; j < island.m_contactCount; ++j)
+		{
+			island.m_contacts[j]->m_flags &= ~b2Contact::e_islandFlag;
+		}
+		for (int32 j = 0; j < island.m_jointCount; ++j)
+		{
+			island.m_joints[j]->m_islandFlag = false;
+		}
+	}
 
-			// Search all contacts connected to this body.
-			for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+	RemoveSleepingIslands();
+
+	//MIGUEL MODIFICATION: Step profiling. Building and cleanup go to the island time.
+	m_profile.solve = solveTime;
+	m_profile.islands += timer.GetMilliseconds() - solveTime;
+}
+
+//MIGUEL MODIFICATION: Parallel island solving
+// The islands of a step, as ranges of the flat island built by SolveIslandsParallel.
+struct b2IslandRange
+{
+	int32 bodyStart;
+	int32 bodyCount;
+	int32 contactStart;
+	int32 contactCount;
+	int32 jointStart;
+	int32 jointCount;
+	int32 resultStart;
+	int32 resultCount;
+	int32 reportedCount;	// results stored by the island solve
+	bool applyPosCorrection;
+	b2ContactSolverStatistics contactSolverStatistics;
+	//MIGUEL MODIFICATION: Adaptive iterations
+	b2IslandClass islandClass;
+	int32 velocityIterationCount;
+	int32 positionIterationCount;
+};
+
+// Stores the contact results of one island, so they are reported later in order.
+class b2ContactResultRecorder : public b2ContactListener
+{
+public:
+	b2ContactResultRecorder(b2ContactResult* results, int32 capacity)
+	{
+		m_results = results;
+		m_count = 0;
+		m_capacity = capacity;
+	}
+
+	void Result(const b2ContactResult* point)
+	{
+		b2Assert(m_count < m_capacity);
+		m_results[m_count++] = *point;
+	}
+
+	b2ContactResult* m_results;
+	int32 m_count;
+	int32 m_capacity;
+};
+
+struct b2IslandSolveContext
+{
+	const b2TimeStep* step;
+	b2Vec2 gravity;
+	bool allowSleep;
+	const b2Island* islands;
+	b2IslandRange* ranges;
+	const int32* order;
+	b2WorkerAllocator* allocators;
+	b2ContactResult* results;
+};
+
+// Bigger islands first, so the workers end at about the same time.
+struct b2IslandSizeGreater
+{
+	bool operator()(int32 index1, int32 index2) const
+	{
+		const b2IslandRange* r1 = ranges + index1;
+		const b2IslandRange* r2 = ranges + index2;
+		int32 size1 = r1->bodyCount + r1->contactCount + r1->jointCount;
+		int32 size2 = r2->bodyCount + r2->contactCount + r2->jointCount;
+		return size1 > size2;
+	}
+
+	const b2IslandRange* ranges;
+};
+
+static void b2SolveIslandTask(void* context, int32 taskIndex, int32 workerIndex)
+{
+	const b2IslandSolveContext* solveContext = (const b2IslandSolveContext*)context;
+	b2IslandRange* range = solveContext->ranges + solveContext->order[taskIndex];
+	const b2Island* islands = solveContext->islands;
+
+	b2ContactResultRecorder recorder(solveContext->results + range->resultStart, range->resultCount);
+	b2ContactListener* listener = solveContext->results ? &recorder : NULL;
+
+	b2Island island(range->bodyCount, range->contactCount, range->jointCount, &solveContext->allocators[workerIndex].stackAllocator, listener);
+
+	// Copy the pointers, as b2Island::Add would write the island index of
+	// static bodies that other workers share.
+	memcpy(island.m_bodies, islands->m_bodies + range->bodyStart, range->bodyCount * sizeof(b2Body*));
+	memcpy(island.m_contacts, islands->m_contacts + range->contactStart, range->contactCount * sizeof(b2Contact*));
+	memcpy(island.m_joints, islands->m_joints + range->jointStart, range->jointCount * sizeof(b2Joint*));
+	island.m_bodyCount = range->bodyCount;
+	island.m_contactCount = range->contactCount;
+	island.m_jointCount = range->jointCount;
+
+	island.Solve(*solveContext->step, solveContext->gravity, solveContext->allowSleep, range->applyPosCorrection);
+	range->contactSolverStatistics = island.m_contactSolverStatistics;
+	range->islandClass = island.m_class;	//MIGUEL MODIFICATION: Adaptive iterations
+	range->velocityIterationCount = island.m_velocityIterationCount;
+	range->positionIterationCount = island.m_positionIterationCount;
+	range->reportedCount = recorder.m_count;
+
+	b2Assert(recorder.m_count == range->resultCount || listener == NULL);
+}
+
+// Find all islands first, then solve them on the thread pool. Islands share
+// nothing but static bodies, which have zero inverse mass, so each solver writes
+// them the values they already hold (or the same sleep flag).
+void b2World::SolveIslandsParallel(const b2TimeStep& step)
+{
+	// A static body may be part of many islands, once per contact or joint at most.
+	b2Island islands(m_bodyCount + m_contactCount + m_jointCount, m_contactCount, m_jointCount, &m_stackAllocator, NULL);
+
+	b2Timer timer;	//MIGUEL MODIFICATION: Step profiling
+
+	b2IslandRange* ranges = (b2IslandRange*)m_stackAllocator.Allocate(m_bodyCount * sizeof(b2IslandRange));
+	int32 islandCount = 0;
+	int32 resultCount = 0;
+
+	// Find all awake islands, in the same order as the serial solve.
+	//MIGUEL MODIFICATION: Persistent islands
+	for (int32 k = 0; k < m_awakeIslandCount; ++k)
+	{
+		b2Assert(islandCount < m_bodyCount);
+		b2IslandRange* range = ranges + islandCount;
+		range->bodyStart = islands.m_bodyCount;
+		range->contactStart = islands.m_contactCount;
+		range->jointStart = islands.m_jointCount;
+
+		range->applyPosCorrection = BuildIsland(m_awakeIslands[k], &islands);
+
+		range->bodyCount = islands.m_bodyCount - range->bodyStart;
+		range->contactCount = islands.m_contactCount - range->contactStart;
+		range->jointCount = islands.m_jointCount - range->jointStart;
+
+		// Room for the contact results, one per manifold point.
+		//MIGUEL MODIFICATION: Speculative contacts. Points ahead of the shapes are not reported
+		//(see b2Island::Report), they get no room.
+		range->resultStart = resultCount;
+		range->resultCount = 0;
+		range->reportedCount = 0;
+		if (m_contactListener != NULL)
+		{
+			for (int32 i = range->contactStart; i < islands.m_contactCount; ++i)
 			{
-				// Has this contact already been added to an island?
-				if (cn->contact->m_flags & (b2Contact::e_islandFlag | b2Contact::e_nonSolidFlag))
+				b2Contact* c = islands.m_contacts[i];
+				b2Manifold* manifolds = c->GetManifolds();
+				for (int32 j = 0; j < c->GetManifoldCount(); ++j)
 				{
-					continue;
+					for (int32 k = 0; k < manifolds[j].pointCount; ++k)
+					{
+						if (manifolds[j].points[k].separation <= 0.0f)
+						{
+							++range->resultCount;
+						}
+					}
 				}
+			}
+		}
+		resultCount += range->resultCount;
 
-				// Is this contact touching?
-				if (cn->contact->GetManifoldCount() == 0)
-				{
-					continue;
-				}
+		// Allow static bodies to participate in other islands.
+		for (int32 i = range->bodyStart; i < islands.m_bodyCount; ++i)
+		{
+			b2Body* b = islands.m_bodies[i];
+			if (b->IsStatic())
+			{
+				b->m_flags &= ~b2Body::e_islandFlag;
+			}
+		}
 
-				island.Add(cn->contact);
-				cn->contact->m_flags |= b2Contact::e_islandFlag;
+		++islandCount;
+	}
 
-				b2Body* other = cn->other;
+	int32* order = (int32*)m_stackAllocator.Allocate(islandCount * sizeof(int32));
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		order[i] = i;
+	}
+	b2IslandSizeGreater greater;
+	greater.ranges = ranges;
+	std::sort(order, order + islandCount, greater);
 
-				// Was the other body already added to this island?
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	b2ContactResult* results = NULL;
+	if (m_contactListener != NULL)
+	{
+		results = (b2ContactResult*)m_stackAllocator.Allocate(resultCount * sizeof(b2ContactResult));
+	}
+
+	b2IslandSolveContext context;
+	context.step = &step;
+	context.gravity = m_gravity;
+	context.allowSleep = m_allowSleep;
+	context.islands = &islands;
+	context.ranges = ranges;
+	context.order = order;
+	context.allocators = m_solverAllocators;
+	context.results = results;
+
+	//MIGUEL MODIFICATION: Step profiling
+	m_profile.islands += timer.GetMilliseconds();
+	m_profile.islandCount = islandCount;
+	timer.Reset();
+
+	m_threadPool->Run(b2SolveIslandTask, &context, islandCount);
+
+	m_profile.solve = timer.GetMilliseconds();	//MIGUEL MODIFICATION: Step profiling
+	timer.Reset();
+
+	//MIGUEL MODIFICATION: Persistent islands. Post solve cleanup, see SolveIslands.
+	for (int32 i = 0; i < islands.m_bodyCount; ++i)
+	{
+		b2Body* b = islands.m_bodies[i];
+		if (b->IsStatic() == false)
+		{
+			b->m_sweep.t0 = 0.0f;
+		}
+	}
+	for (int32 i = 0; i < islands.m_contactCount; ++i)
+	{
+		islands.m_contacts[i]->m_flags &= ~b2Contact::e_islandFlag;
+	}
+	for (int32 i = 0; i < islands.m_jointCount; ++i)
+	{
+		islands.m_joints[i]->m_islandFlag = false;
+	}
+	RemoveSleepingIslands();
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	for (int32 i = 0; i < islandCount; ++i)
+	{
+		AddContactSolverStatistics(ranges[i].contactSolverStatistics);
+		AddIterationStatistics(ranges[i].islandClass, ranges[i].velocityIterationCount, ranges[i].positionIterationCount);	//MIGUEL MODIFICATION: Adaptive iterations
+	}
+
+	m_profile.islands += timer.GetMilliseconds();	//MIGUEL MODIFICATION: Step profiling
+	timer.Reset();
+
+	// Report the contact results in island order, as the serial solve does. Only the
+	// results the islands stored are reported.
+	if (m_contactListener != NULL)
+	{
+		for (int32 i = 0; i < islandCount; ++i)
+		{
+			const b2IslandRange* range = ranges + i;
+			for (int32 j = 0; j < range->reportedCount; ++j)
+			{
+				m_contactListener->Result(results + range->resultStart + j);
+			}
+		}
+
+		m_stackAllocator.Free(results);
+	}
+
+	m_stackAllocator.Free(order);
+	m_stackAllocator.Free(ranges);
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+	m_profile.solve += timer.GetMilliseconds();	//MIGUEL MODIFICATION: Step profiling
+}
 
-			// Search all joints connect to this body.
-			for (b2JointEdge* jn = b->m_jointList; jn; jn = jn->next)
-			{
-				if (jn->joint->m_islandFlag == true)
-				{
-					continue;
-				}
+void b2World::SetSolverThreadCount(int32 count)
+{
+	b2Assert(m_lock == false);
+	b2Assert(count > 0);
 
-				island.Add(jn->joint);
-				jn->joint->m_islandFlag = true;
+	if (count == GetSolverThreadCount())
+	{
+		return;
+	}
 
-				b2Body* other = jn->other;
-				if (other->m_flags & b2Body::e_islandFlag)
-				{
-					continue;
-				}
+	if (m_threadPool != NULL)
+	{
+		int32 workerCount = m_threadPool->GetWorkerCount();
+		m_threadPool->~b2ThreadPool();
+		b2Free(m_threadPool);
+		m_threadPool = NULL;
 
-				b2Assert(stackCount < stackSize);
-				stack[stackCount++] = other;
-				other->m_flags |= b2Body::e_islandFlag;
-			}
+		for (int32 i = 0; i < workerCount; ++i)
+		{
+			m_solverAllocators[i].~b2WorkerAllocator();
 		}
+		b2Free(m_solverAllocators);
+		m_solverAllocators = NULL;
+	}
 
-		island.Solve(step, m_gravity, m_allowSleep, applyposcorrection);
+	if (count > 1)
+	{
+		void* mem = b2Alloc(sizeof(b2ThreadPool));
+		m_threadPool = new (mem) b2ThreadPool(count);
 
-		// Post solve cleanup.
-		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		m_solverAllocators = (b2WorkerAllocator*)b2Alloc(count * sizeof(b2WorkerAllocator));
+		for (int32 i = 0; i < count; ++i)
 		{
-			// Allow static bodies to participate in other islands.
-			b2Body* b = island.m_bodies[i];
-			if (b->IsStatic())
-			{
-				b->m_flags &= ~b2Body::e_islandFlag;
-			}
+			new (m_solverAllocators + i) b2WorkerAllocator;
+			m_solverAllocators[i].stackAllocator.Reserve(m_stackAllocatorSize);	//MIGUEL MODIFICATION: Allocator statistics
 		}
 	}
+}
 
-	m_stackAllocator.Free(stack);
+int32 b2World::GetSolverThreadCount() const
+{
+	return m_threadPool != NULL ? m_threadPool->GetWorkerCount() : 1;
+}
 
-	// Synchronize shapes, check for out of range bodies.
-	for (b2Body* b = m_bodyList; b; b = b->GetNext())
+//MIGUEL MODIFICATION: Allocator statistics
+void b2World::SetStackAllocatorSize(int32 size)
+{
+	b2Assert(m_lock == false);
+	b2Assert(size > 0);
+
+	m_stackAllocatorSize = size;
+	m_stackAllocator.Reserve(size);
+	if (m_threadPool != NULL)
 	{
-		if (b->m_flags & (b2Body::e_sleepFlag | b2Body::e_frozenFlag))
+		for (int32 i = 0; i < m_threadPool->GetWorkerCount(); ++i)
 		{
-			continue;
+			m_solverAllocators[i].stackAllocator.Reserve(size);
 		}
+	}
+}
 
-		if (b->IsStatic())
-		{
-			continue;
-		}
-		
-		// Update shapes (for broad-phase). If the shapes go out of
-		// the world AABB then shapes and contacts may be destroyed,
-		// including contacts that are
-		bool inRange = b->SynchronizeShapes();
+//MIGUEL MODIFICATION: Allocator statistics
+void b2World::GetAllocatorStatistics(b2AllocatorStatistics* stats) const
+{
+	memset(stats, 0, sizeof(b2AllocatorStatistics));
+	m_stackAllocator.GetStatistics(&stats->stack);
+	m_blockAllocator.GetStatistics(&stats->block);
 
-		// Did the body's shapes leave the world?
-		if (inRange == false && m_boundaryListener != NULL)
+	if (m_threadPool == NULL)
+	{
+		return;
+	}
+
+	stats->workerCount = m_threadPool->GetWorkerCount();
+	for (int32 i = 0; i < stats->workerCount; ++i)
+	{
+		b2StackAllocatorStatistics stack;
+		m_solverAllocators[i].stackAllocator.GetStatistics(&stack);
+		stats->workerStack.capacity += stack.capacity;
+		stats->workerStack.maxAllocation = b2Max(stats->workerStack.maxAllocation, stack.maxAllocation);
+		stats->workerStack.heapCount += stack.heapCount;
+		stats->workerStack.growCount += stack.growCount;
+
+		b2BlockAllocatorStatistics block;
+		m_solverAllocators[i].blockAllocator.GetStatistics(&block);
+		for (int32 j = 0; j < b2_blockSizes; ++j)
 		{
-			m_boundaryListener->Violation(b);
+			stats->workerBlock.blockCount[j] += block.blockCount[j];
+			stats->workerBlock.maxBlockCount[j] += block.maxBlockCount[j];
+			stats->workerBlock.allocationCount[j] += block.allocationCount[j];
+			stats->workerBlock.chunkCount[j] += block.chunkCount[j];
 		}
 	}
+}
 
-	// Commit shape proxy movements to the broad-phase so that new contacts are created.
-	// Also, some contacts can be destroyed.
-	m_broadPhase->Commit();
+//MIGUEL MODIFICATION: SIMD contact solver mode
+void b2World::AddContactSolverStatistics(const b2ContactSolverStatistics& stats)
+{
+	m_contactSolverStatistics.constraintCount += stats.constraintCount;
+	m_contactSolverStatistics.batchedConstraintCount += stats.batchedConstraintCount;
+	m_contactSolverStatistics.batchCount += stats.batchCount;
+	m_contactSolverStatistics.colorCount += stats.colorCount;
+}
+
+//MIGUEL MODIFICATION: Material table
+int32 b2World::CreateMaterial(float32 friction, float32 restitution)
+{
+	if (m_materialCount == b2_maxMaterials)
+	{
+		return b2_nullMaterial;
+	}
+
+	m_materials[m_materialCount].friction = friction;
+	m_materials[m_materialCount].restitution = restitution;
+	return m_materialCount++;
+}
+
+//MIGUEL MODIFICATION: Material table. Contacts mix the materials when they are solved or
+//reported, so there is nothing else to update.
+void b2World::SetMaterial(int32 material, float32 friction, float32 restitution)
+{
+	b2Assert(0 <= material && material < m_materialCount);
+	m_materials[material].friction = friction;
+	m_materials[material].restitution = restitution;
+}
+
+//MIGUEL MODIFICATION: Adaptive iterations
+void b2World::SetIslandIterations(b2IslandClass islandClass, int32 velocityIterations, int32 positionIterations)
+{
+	b2Assert(0 <= islandClass && islandClass < e_islandClassCount);
+	b2Assert(velocityIterations >= 0 && positionIterations >= 0);
+	m_islandVelocityIterations[islandClass] = velocityIterations;
+	m_islandPositionIterations[islandClass] = positionIterations;
+}
+
+//MIGUEL MODIFICATION: Adaptive iterations
+void b2World::AddIterationStatistics(b2IslandClass islandClass, int32 velocityIterations, int32 positionIterations)
+{
+	++m_iterationStatistics.islandCount[islandClass];
+	m_iterationStatistics.velocityIterations[islandClass] += velocityIterations;
+	m_iterationStatistics.positionIterations[islandClass] += positionIterations;
+	++m_iterationStatistics.velocityHistogram[b2Min(velocityIterations, b2_iterationHistogramSize - 1)];
+	++m_iterationStatistics.positionHistogram[b2Min(positionIterations, b2_iterationHistogramSize - 1)];
 }
 
 // Find TOI contacts and solve them.
 void b2World::SolveTOI(const b2TimeStep& step)
 {
+	b2Timer timer;	//MIGUEL MODIFICATION: TOI event queue
+
 	// Reserve an island and a queue for TOI island solution.
 	b2Island island(m_bodyCount, b2_maxTOIContactsPerIsland, b2_maxTOIJointsPerIsland, &m_stackAllocator, m_contactListener);
 	
@@ -546,112 +1458,63 @@ void b2World::SolveTOI(const b2TimeStep& step)
 	int32 queueCapacity = m_bodyCount;
 	b2Body** queue = (b2Body**)m_stackAllocator.Allocate(queueCapacity* sizeof(b2Body*));
 
-	for (b2Body* b = m_bodyList; b; b = b->m_next)
-	{
-		b->m_flags &= ~b2Body::e_islandFlag;
-		b->m_sweep.t0 = 0.0f;
-	}
-
-	for (b2Contact* c = m_contactList; c; c = c->m_next)
+	//MIGUEL MODIFICATION: Persistent islands. The island flags are clear and the sweeps of the
+	//awake bodies were reset by Solve. Only contacts with an awake body can have TOI events.
+	for (int32 i = 0; i < m_awakeIslandCount; ++i)
+	for (b2Body* b = m_awakeIslands[i]; b; b = b->m_islandNext)
 	{
-		// Invalidate TOI
-		c->m_flags &= ~(b2Contact::e_toiFlag | b2Contact::e_islandFlag);
+		for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+		{
+			// Invalidate TOI
+			cn->contact->m_flags &= ~b2Contact::e_toiFlag;
+		}
 	}
 
-	for (b2Joint* j = m_jointList; j; j = j->m_next)
+	//MIGUEL MODIFICATION: TOI event queue. The times of impact are computed once and kept in a
+	//heap. After each sub-step only the contacts of the bodies it moved are computed again.
+	m_toiQueue.Clear();
+	m_toiQueue.ResetMaxCount();
+	for (int32 i = 0; i < m_awakeIslandCount; ++i)
+	for (b2Body* b = m_awakeIslands[i]; b; b = b->m_islandNext)
 	{
-            j->m_islandFlag = false;
+		for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+		{
+			if ((cn->contact->m_flags & b2Contact::e_toiFlag) == 0)
+			{
+				UpdateTOI(cn->contact);
+			}
+		}
 	}
 
 	// Find TOI events and solve them.
 	for (;;)
 	{
 		// Find the first TOI.
-		b2Contact* minContact = NULL;
-		float32 minTOI = 1.0f;
-
-		for (b2Contact* c = m_contactList; c; c = c->m_next)
-		{
-			if (c->m_flags & (b2Contact::e_slowFlag | b2Contact::e_nonSolidFlag))
-			{
-				continue;
-			}
-
-			// TODO_ERIN keep a counter on the contact, only respond to M TOIs per contact.
-
-			float32 toi = 1.0f;
-			if (c->m_flags & b2Contact::e_toiFlag)
-			{
-				// This contact has a valid cached TOI.
-				toi = c->m_toi;
-			}
-			else
-			{
-				// Compute the TOI for this contact.
-				b2Shape* s1 = c->GetShape1();
-				b2Shape* s2 = c->GetShape2();
-				b2Body* b1 = s1->GetBody();
-				b2Body* b2 = s2->GetBody();
-
-				if ((b1->IsStatic() || b1->IsSleeping()) && (b2->IsStatic() || b2->IsSleeping()))
-				{
-					continue;
-				}
-
-				// Put the sweeps onto the same time interval.
-				float32 t0 = b1->m_sweep.t0;
-				
-				if (b1->m_sweep.t0 < b2->m_sweep.t0)
-				{
-					t0 = b2->m_sweep.t0;
-					b1->m_sweep.Advance(t0);
-				}
-				else if (b2->m_sweep.t0 < b1->m_sweep.t0)
-				{
-					t0 = b1->m_sweep.t0;
-					b2->m_sweep.Advance(t0);
-				}
-
-				b2Assert(t0 < 1.0f);
-
-				// Compute the time of impact.
-				toi = b2TimeOfImpact(c->m_shape1, b1->m_sweep, c->m_shape2, b2->m_sweep);
-
-				b2Assert(0.0f <= toi && toi <= 1.0f);
-
-				// If the TOI is in range ...
-				if (0.0f < toi && toi < 1.0f)
-				{
-					// Interpolate on the actual range.
-					toi = b2Min((1.0f - toi) * t0 + toi, 1.0f);
-				}
-
-
-				c->m_toi = toi;
-				c->m_flags |= b2Contact::e_toiFlag;
-			}
-
-			if (B2_FLT_EPSILON < toi && toi < minTOI)
-			{
-				// This is the minimum TOI found so far.
-				minContact = c;
-				minTOI = toi;
-			}
-		}
-
-		if (minContact == NULL || 1.0f - 100.0f * B2_FLT_EPSILON < minTOI)
+		if (m_toiQueue.GetCount() == 0)
 		{
 			// No more TOI events. Done!
 			break;
 		}
 
+		b2Contact* minContact = m_toiQueue.GetMin();
+		float32 minTOI = m_toiQueue.GetMinTOI();
+		m_toiQueue.Remove(minContact);
+		++m_toiStatistics.eventCount;
+
 		// Advance the bodies to the TOI.
 		b2Shape* s1 = minContact->GetShape1();
 		b2Shape* s2 = minContact->GetShape2();
 		b2Body* b1 = s1->GetBody();
 		b2Body* b2 = s2->GetBody();
-		b1->Advance(minTOI);
-		b2->Advance(minTOI);
+		//MIGUEL MODIFICATION: Persistent islands. Static sweeps are not reset each step any more.
+		if (b1->IsStatic() == false)
+		{
+			b1->Advance(minTOI);
+		}
+		if (b2->IsStatic() == false)
+		{
+			b2->Advance(minTOI);
+		}
 
 		// The TOI contact likely has some new contact points.
 		minContact->Update(m_contactListener);
@@ -661,6 +1524,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		{
 			// This shouldn't happen. Numerical error?
 			//b2Assert(false);
+			UpdateTOI(minContact);
 			continue;
 		}
 
@@ -704,6 +1568,9 @@ void b2World::SolveTOI(const b2TimeStep& step)
 				continue;
 			}
 
+			//MIGUEL MODIFICATION: Persistent islands. Its island is solved again in the next step.
+			WakeIsland(b);
+
 			// Search all contacts connected to this body.
 			for (b2ContactEdge* cEdge = b->m_contactList; cEdge; cEdge = cEdge->next)
 			{
@@ -793,6 +1660,7 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		subStep.dtRatio = 0.0f;
 		subStep.velocityIterations = step.velocityIterations;
 		subStep.positionIterations = step.positionIterations;
+		subStep.contactSolverType = e_scalarContactSolver;	//MIGUEL MODIFICATION: TOI islands are small, always scalar
 
 		island.SolveTOI(subStep, applyposcorrection);
 
@@ -849,20 +1717,203 @@ void b2World::SolveTOI(const b2TimeStep& step)
 		// Commit shape proxy movements to the broad-phase so that new contacts are created.
 		// Also, some contacts can be destroyed.
 		m_broadPhase->Commit();
+
+		//MIGUEL MODIFICATION: TOI event queue. Every contact of the island is in the list of one of
+		//its dynamic bodies, and new contacts are too, so this queues all the invalidated events.
+		for (int32 i = 0; i < island.m_bodyCount; ++i)
+		{
+			b2Body* b = island.m_bodies[i];
+			if (b->IsStatic())
+			{
+				continue;
+			}
+
+			for (b2ContactEdge* cn = b->m_contactList; cn; cn = cn->next)
+			{
+				if ((cn->contact->m_flags & b2Contact::e_toiFlag) == 0)
+				{
+					UpdateTOI(cn->contact);
+				}
+			}
+		}
 	}
 
+	m_toiQueue.Clear();
 	m_stackAllocator.Free(queue);
+
+	//MIGUEL MODIFICATION: TOI event queue
+	m_toiStatistics.maxQueueCount = m_toiQueue.GetMaxCount();
+	m_toiStatistics.time = timer.GetMilliseconds();
+}
+
+//MIGUEL MODIFICATION: TOI event queue
+// Computes the TOI of a contact (as the old search loop did) and queues it if it is an event.
+void b2World::UpdateTOI(b2Contact* c)
+{
+	if (c->m_flags & (b2Contact::e_slowFlag | b2Contact::e_nonSolidFlag))
+	{
+		m_toiQueue.Remove(c);
+		return;
+	}
+
+	// TODO_ERIN keep a counter on the contact, only respond to M TOIs per contact.
+
+	b2Shape* s1 = c->GetShape1();
+	b2Shape* s2 = c->GetShape2();
+	b2Body* b1 = s1->GetBody();
+	b2Body* b2 = s2->GetBody();
+
+	//MIGUEL MODIFICATION: Persistent islands. The sweeps of static and sleeping bodies are not
+	//reset each step, they are taken as not moving over the sweep of the other body.
+	bool fixed1 = b1->IsStatic() || b1->IsSleeping();
+	bool fixed2 = b2->IsStatic() || b2->IsSleeping();
+	if (fixed1 && fixed2)
+	{
+		m_toiQueue.Remove(c);
+		return;
+	}
+
+	b2Sweep sweep1 = b1->m_sweep;
+	b2Sweep sweep2 = b2->m_sweep;
+	float32 t0;
+
+	if (fixed1)
+	{
+		t0 = sweep2.t0;
+		sweep1.c0 = sweep1.c;
+		sweep1.a0 = sweep1.a;
+		sweep1.t0 = t0;
+	}
+	else if (fixed2)
+	{
+		t0 = sweep1.t0;
+		sweep2.c0 = sweep2.c;
+		sweep2.a0 = sweep2.a;
+		sweep2.t0 = t0;
+	}
+	else
+	{
+		// Put the sweeps onto the same time interval.
+		t0 = b1->m_sweep.t0;
+
+		if (b1->m_sweep.t0 < b2->m_sweep.t0)
+		{
+			t0 = b2->m_sweep.t0;
+			b1->m_sweep.Advance(t0);
+		}
+		else if (b2->m_sweep.t0 < b1->m_sweep.t0)
+		{
+			t0 = b1->m_sweep.t0;
+			b2->m_sweep.Advance(t0);
+		}
+
+		sweep1 = b1->m_sweep;
+		sweep2 = b2->m_sweep;
+	}
+
+	b2Assert(t0 < 1.0f);
+
+	// Compute the time of impact.
+	float32 toi = b2TimeOfImpact(c->m_shape1, sweep1, c->m_shape2, sweep2);
+	++m_toiStatistics.computeCount;
+
+	b2Assert(0.0f <= toi && toi <= 1.0f);
+
+	// If the TOI is in range ...
+	if (0.0f < toi && toi < 1.0f)
+	{
+		// Interpolate on the actual range.
+		toi = b2Min((1.0f - toi) * t0 + toi, 1.0f);
+	}
+
+	c->m_toi = toi;
+	c->m_flags |= b2Contact::e_toiFlag;
+
+	// Only events inside the step are queued.
+	if (B2_FLT_EPSILON < toi && toi <= 1.0f - 100.0f * B2_FLT_EPSILON)
+	{
+		m_toiQueue.Push(c, toi);
+	}
+	else
+	{
+		m_toiQueue.Remove(c);
+	}
+}
+//MIGUEL MODIFICATION: Step profiling
+// Weight of a step in the rolling averages of the profile (about the last 20 steps).
+const float32 b2_profileAverageWeight = 0.05f;
+
+static void b2AverageTime(float32* average, float32 time)
+{
+	*average += b2_profileAverageWeight * (time - *average);
+}
+
+void b2ProfileContactListener::Add(const b2ContactPoint* point)
+{
+	b2Timer timer;
+	m_listener->Add(point);
+	m_time += timer.GetMilliseconds();
+}
+
+void b2ProfileContactListener::Persist(const b2ContactPoint* point)
+{
+	b2Timer timer;
+	m_listener->Persist(point);
+	m_time += timer.GetMilliseconds();
+}
+
+void b2ProfileContactListener::Remove(const b2ContactPoint* point)
+{
+	b2Timer timer;
+	m_listener->Remove(point);
+	m_time += timer.GetMilliseconds();
 }
+
+void b2ProfileContactListener::Result(const b2ContactResult* point)
+{
+	b2Timer timer;
+	m_listener->Result(point);
+	m_time += timer.GetMilliseconds();
+}
+
 //MIGUEL MODIFICATION: RESET FORCES TRIGGERING
 void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIterations, bool resetForces)
 {
 	m_lock = true;
 
+	//MIGUEL MODIFICATION: Step profiling. The contact callbacks of the step go through the
+	//profile listener, which times them.
+	b2Timer stepTimer;
+	memset(&m_profile, 0, sizeof(b2Profile));
+	b2ContactListener* contactListener = m_contactListener;
+	if (contactListener != NULL)
+	{
+		m_profileListener.m_listener = contactListener;
+		m_profileListener.m_time = 0.0f;
+		m_contactListener = &m_profileListener;
+	}
+
+	//MIGUEL MODIFICATION: Pair table lookup statistics are kept per step
+	m_broadPhase->m_pairManager.ResetStatistics();
+	memset(&m_contactSolverStatistics, 0, sizeof(b2ContactSolverStatistics));
+	memset(&m_toiStatistics, 0, sizeof(b2TOIStatistics));	//MIGUEL MODIFICATION: TOI event queue
+	memset(&m_collideStatistics, 0, sizeof(b2CollideStatistics));	//MIGUEL MODIFICATION: Separation bound
+	memset(&m_iterationStatistics, 0, sizeof(b2IterationStatistics));	//MIGUEL MODIFICATION: Adaptive iterations
+	memset(&m_triggerStatistics, 0, sizeof(b2TriggerStatistics));	//MIGUEL MODIFICATION: Trigger volumes
+
 	b2TimeStep step;
 	step.dt = dt;
 	step.velocityIterations	= velocityIterations;
 	step.positionIterations = positionIterations;
 	step.resetForces = resetForces;  //MIGUEL MODIFICATION: RESET FORCES TRIGGERING
+	step.contactSolverType = m_contactSolverType;	//MIGUEL MODIFICATION: SIMD contact solver mode
+	//MIGUEL MODIFICATION: Adaptive iterations. Classes without budget use the step iterations.
+	step.adaptiveIterations = m_adaptiveIterations;
+	for (int32 i = 0; i < e_islandClassCount; ++i)
+	{
+		step.islandVelocityIterations[i] = m_islandVelocityIterations[i] > 0 ? m_islandVelocityIterations[i] : velocityIterations;
+		step.islandPositionIterations[i] = m_islandPositionIterations[i] > 0 ? m_islandPositionIterations[i] : positionIterations;
+	}
 	if (dt > 0.0f)
 	{
 		step.inv_dt = 1.0f / dt;
@@ -877,7 +1928,9 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	step.warmStarting = m_warmStarting;
 	
 	// Update contacts.
+	b2Timer timer;	//MIGUEL MODIFICATION: Step profiling
 	m_contactManager.Collide();
+	m_profile.collide = timer.GetMilliseconds();
 
 	// Integrate velocities, solve velocity constraints, and integrate positions.
 	if (step.dt > 0.0f)
@@ -888,13 +1941,53 @@ void b2World::Step(float32 dt, int32 velocityIterations, int32 positionIteration
 	// Handle TOI events.
 	if (m_continuousPhysics && step.dt > 0.0f)
 	{
+		timer.Reset();
 		SolveTOI(step);
+		m_profile.solveTOI = timer.GetMilliseconds();
+	}
+
+	//MIGUEL MODIFICATION: Trigger volumes. Tested once the bodies are in their final positions.
+	if (m_triggerCount > 0)
+	{
+		timer.Reset();
+		m_contactManager.UpdateTriggers();
+		m_triggerStatistics.time = timer.GetMilliseconds();
 	}
 
 	// Draw debug information.
+	timer.Reset();
 	DrawDebugData();
+	m_profile.debugDraw = timer.GetMilliseconds();
 
 	m_inv_dt0 = step.inv_dt;
+
+	//MIGUEL MODIFICATION: Step profiling
+	if (contactListener != NULL)
+	{
+		m_contactListener = contactListener;
+		m_profile.listeners = m_profileListener.m_time;
+	}
+	m_profile.bodyCount = m_bodyCount;
+	m_profile.contactCount = m_contactCount;
+	m_profile.jointCount = m_jointCount;
+	m_profile.step = stepTimer.GetMilliseconds();
+
+	b2AverageTime(&m_averageProfile.step, m_profile.step);
+	b2AverageTime(&m_averageProfile.collide, m_profile.collide);
+	b2AverageTime(&m_averageProfile.controllers, m_profile.controllers);
+	b2AverageTime(&m_averageProfile.islands, m_profile.islands);
+	b2AverageTime(&m_averageProfile.solve, m_profile.solve);
+	b2AverageTime(&m_averageProfile.broadphase, m_profile.broadphase);
+	b2AverageTime(&m_averageProfile.solveTOI, m_profile.solveTOI);
+	b2AverageTime(&m_averageProfile.listeners, m_profile.listeners);
+	b2AverageTime(&m_averageProfile.debugDraw, m_profile.debugDraw);
+	m_averageProfile.bodyCount = m_profile.bodyCount;
+	m_averageProfile.contactCount = m_profile.contactCount;
+	m_averageProfile.jointCount = m_profile.jointCount;
+	m_averageProfile.islandCount = m_profile.islandCount;
+
+	ValidateIslands();	//MIGUEL MODIFICATION: Persistent islands
+
 	m_lock = false;
 }
 
@@ -952,6 +2045,56 @@ b2Shape* b2World::RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2*
 	return shape;
 }
 
+//MIGUEL MODIFICATION: Callback queries
+// Broad-phase callback that reports the shapes to a b2QueryCallback.
+class b2WorldQueryWrapper
+{
+public:
+	bool QueryCallback(void* userData)
+	{
+		return callback->ReportShape((b2Shape*)userData);
+	}
+
+	b2QueryCallback* callback;
+};
+
+// Broad-phase callback that reports the hit shapes to a b2RaycastCallback. The sort key only keeps
+// the hit fraction, so the segment is tested again for the normal of the reported shapes.
+class b2WorldRaycastWrapper
+{
+public:
+	bool QueryCallback(void* userData)
+	{
+		b2Shape* shape = (b2Shape*)userData;
+		float32 lambda = 0.0f;
+		b2Vec2 normal(0.0f, 0.0f);
+		shape->TestSegment(shape->GetBody()->GetXForm(), &lambda, &normal, *segment, 1.0f);
+		return callback->ReportShape(shape, lambda, normal);
+	}
+
+	b2RaycastCallback* callback;
+	const b2Segment* segment;
+};
+
+void b2World::Query(b2QueryCallback* callback, const b2AABB& aabb)
+{
+	b2WorldQueryWrapper wrapper;
+	wrapper.callback = callback;
+	m_broadPhase->Query(&wrapper, aabb);
+}
+
+void b2World::Raycast(b2RaycastCallback* callback, const b2Segment& segment, bool solidShapes, void* userData)
+{
+	m_raycastSegment = &segment;
+	m_raycastUserData = userData;
+	m_raycastSolidShape = solidShapes;
+
+	b2WorldRaycastWrapper wrapper;
+	wrapper.callback = callback;
+	wrapper.segment = &segment;
+	m_broadPhase->QuerySegment(&wrapper, segment, &RaycastSortKey);
+}
+
 void b2World::DrawShape(b2Shape* shape, const b2XForm& xf, const b2Color& color, bool core)
 {
 	b2Color coreColor(0.9f, 0.6f, 0.6f);
@@ -1115,36 +2258,28 @@ void b2World::DrawDebugData()
 	if (flags & b2DebugDraw::e_pairBit)
 	{
 		b2BroadPhase* bp = m_broadPhase;
-		b2Vec2 invQ;
-		invQ.Set(1.0f / bp->m_quantizationFactor.x, 1.0f / bp->m_quantizationFactor.y);
 		b2Color color(0.9f, 0.9f, 0.3f);
 
-		for (int32 i = 0; i < b2_tableCapacity; ++i)
+		//MIGUEL MODIFICATION: Open addressing pair table, walk the slots
+		for (int32 i = 0; i < bp->m_pairManager.m_tableCapacity; ++i)
 		{
-			uint16 index = bp->m_pairManager.m_hashTable[i];
-			while (index != b2_nullPair)
+			int32 index = bp->m_pairManager.m_hashTable[i].pairIndex;
+			if (index == b2_nullPair)
 			{
-				b2Pair* pair = bp->m_pairManager.m_pairs + index;
-				b2Proxy* p1 = bp->m_proxyPool + pair->proxyId1;
-				b2Proxy* p2 = bp->m_proxyPool + pair->proxyId2;
-
-				b2AABB b1, b2;
-				b1.lowerBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p1->lowerBounds[0]].value;
-				b1.lowerBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p1->lowerBounds[1]].value;
-				b1.upperBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p1->upperBounds[0]].value;
-				b1.upperBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p1->upperBounds[1]].value;
-				b2.lowerBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p2->lowerBounds[0]].value;
-				b2.lowerBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p2->lowerBounds[1]].value;
-				b2.upperBound.x = bp->m_worldAABB.lowerBound.x + invQ.x * bp->m_bounds[0][p2->upperBounds[0]].value;
-				b2.upperBound.y = bp->m_worldAABB.lowerBound.y + invQ.y * bp->m_bounds[1][p2->upperBounds[1]].value;
-
-				b2Vec2 x1 = 0.5f * (b1.lowerBound + b1.upperBound);
-				b2Vec2 x2 = 0.5f * (b2.lowerBound + b2.upperBound);
-
-				m_debugDraw->DrawSegment(x1, x2, color);
-
-				index = pair->next;
+				continue;
 			}
+
+			b2Pair* pair = bp->m_pairManager.m_pairs + index;
+
+			//MIGUEL MODIFICATION: Boxes through the broad-phase, valid for any algorithm
+			b2AABB b1, b2;
+			bp->GetFatAABB(pair->proxyId1, &b1);
+			bp->GetFatAABB(pair->proxyId2, &b2);
+
+			b2Vec2 x1 = 0.5f * (b1.lowerBound + b1.upperBound);
+			b2Vec2 x2 = 0.5f * (b2.lowerBound + b2.upperBound);
+
+			m_debugDraw->DrawSegment(x1, x2, color);
 		}
 	}
 
@@ -1154,30 +2289,28 @@ void b2World::DrawDebugData()
 		b2Vec2 worldLower = bp->m_worldAABB.lowerBound;
 		b2Vec2 worldUpper = bp->m_worldAABB.upperBound;
 
-		b2Vec2 invQ;
-		invQ.Set(1.0f / bp->m_quantizationFactor.x, 1.0f / bp->m_quantizationFactor.y);
 		b2Color color(0.9f, 0.3f, 0.9f);
-		for (int32 i = 0; i < b2_maxProxies; ++i)
+		//MIGUEL MODIFICATION: Walk the shapes instead of the proxy pool, valid for any algorithm
+		for (b2Body* body = m_bodyList; body; body = body->GetNext())
 		{
-			b2Proxy* p = bp->m_proxyPool + i;
-			if (p->IsValid() == false)
+			for (b2Shape* s = body->GetShapeList(); s; s = s->GetNext())
 			{
-				continue;
-			}
+				if (s->m_proxyId == b2_nullProxy)
+				{
+					continue;
+				}
 
-			b2AABB b;
-			b.lowerBound.x = worldLower.x + invQ.x * bp->m_bounds[0][p->lowerBounds[0]].value;
-			b.lowerBound.y = worldLower.y + invQ.y * bp->m_bounds[1][p->lowerBounds[1]].value;
-			b.upperBound.x = worldLower.x + invQ.x * bp->m_bounds[0][p->upperBounds[0]].value;
-			b.upperBound.y = worldLower.y + invQ.y * bp->m_bounds[1][p->upperBounds[1]].value;
+				b2AABB b;
+				bp->GetFatAABB(s->m_proxyId, &b);
 
-			b2Vec2 vs[4];
-			vs[0].Set(b.lowerBound.x, b.lowerBound.y);
-			vs[1].Set(b.upperBound.x, b.lowerBound.y);
-			vs[2].Set(b.upperBound.x, b.upperBound.y);
-			vs[3].Set(b.lowerBound.x, b.upperBound.y);
+				b2Vec2 vs[4];
+				vs[0].Set(b.lowerBound.x, b.lowerBound.y);
+				vs[1].Set(b.upperBound.x, b.lowerBound.y);
+				vs[2].Set(b.upperBound.x, b.upperBound.y);
+				vs[3].Set(b.lowerBound.x, b.upperBound.y);
 
-			m_debugDraw->DrawPolygon(vs, 4, color);
+				m_debugDraw->DrawPolygon(vs, 4, color);
+			}
 		}
 
 		b2Vec2 vs[4];
@@ -1236,6 +2369,7 @@ void b2World::DrawDebugData()
 void b2World::Validate()
 {
 	m_broadPhase->Validate();
+	ValidateIslands();	//MIGUEL MODIFICATION: Persistent islands
 }
 
 int32 b2World::GetProxyCount() const
@@ -1248,6 +2382,16 @@ int32 b2World::GetPairCount() const
 	return m_broadPhase->m_pairManager.m_pairCount;
 }
 
+b2BroadPhaseType b2World::GetBroadPhaseType() const
+{
+	return m_broadPhase->GetType();
+}
+
+void b2World::GetPairStatistics(b2PairStatistics* stats) const
+{
+	m_broadPhase->m_pairManager.GetStatistics(stats);
+}
+
 bool b2World::InRange(const b2AABB& aabb) const
 {
 	return m_broadPhase->InRange(aabb);
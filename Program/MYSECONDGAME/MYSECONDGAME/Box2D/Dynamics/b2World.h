@@ -24,6 +24,8 @@
 #include "../Common/b2StackAllocator.h"
 #include "b2ContactManager.h"
 #include "b2WorldCallbacks.h"
+#include "b2TOIQueue.h"
+#include "../Collision/b2BroadPhase.h"
 
 struct b2AABB;
 struct b2ShapeDef;
@@ -36,6 +38,124 @@ class b2Contact;
 class b2BroadPhase;
 class b2Controller;
 class b2ControllerDef;
+class b2Island;
+class b2ThreadPool;
+
+//MIGUEL MODIFICATION: SIMD contact solver mode
+/// Contact solver used by b2Island::Solve. The SIMD solver batches single point
+/// contacts in groups of 4 that share no bodies (graph coloring) and solves them with SSE.
+enum b2ContactSolverType
+{
+	e_scalarContactSolver,
+	e_simdContactSolver
+};
+
+/// MIGUEL MODIFICATION: Contact solver counters, summed over the islands of the last step.
+struct b2ContactSolverStatistics
+{
+	int32 constraintCount;			///< all contact constraints
+	int32 batchedConstraintCount;	///< constraints solved in SIMD batches
+	int32 batchCount;				///< batches of 4 lanes
+	int32 colorCount;				///< colors (sequential groups of batches), summed over islands
+};
+
+/// MIGUEL MODIFICATION: Continuous collision counters of the last step.
+struct b2TOIStatistics
+{
+	int32 eventCount;		///< TOI events solved (sub-step islands)
+	int32 computeCount;		///< times of impact computed
+	int32 maxQueueCount;	///< most events queued at once
+	float32 time;			///< milliseconds spent in b2World::SolveTOI
+};
+
+/// MIGUEL MODIFICATION: Narrow-phase counters of the last step (awake contacts).
+struct b2CollideStatistics
+{
+	int32 evaluatedCount;	///< contacts updated
+	int32 skippedCount;		///< contacts not updated: shapes apart by more than their bodies moved
+	int32 reusedCount;		///< updated polygon and circle contacts which kept their manifold (almost not moved)
+};
+
+//MIGUEL MODIFICATION: Adaptive iterations
+/// Kind of island, each one solved with its own iteration budget (b2World::SetIslandIterations).
+enum b2IslandClass
+{
+	e_defaultIsland,
+	e_stackIsland,		///< at least b2_stackIslandBodyCount dynamic bodies, as many contacts
+	e_softBodyIsland,	///< has a body flagged as soft body
+	e_islandClassCount
+};
+
+/// MIGUEL MODIFICATION: Adaptive iterations. Iterations done by the islands of the last step.
+struct b2IterationStatistics
+{
+	int32 islandCount[e_islandClassCount];			///< islands solved of each class
+	int32 velocityIterations[e_islandClassCount];	///< velocity iterations, summed over the islands of a class
+	int32 positionIterations[e_islandClassCount];	///< position iterations, summed over the islands of a class
+	int32 velocityHistogram[b2_iterationHistogramSize];	///< islands by velocity iterations done
+	int32 positionHistogram[b2_iterationHistogramSize];	///< islands by position iterations done
+};
+
+/// MIGUEL MODIFICATION: Trigger volumes. Trigger pair counters of the last step.
+struct b2TriggerStatistics
+{
+	int32 pairCount;		///< trigger pairs (broad-phase pairs with a trigger shape)
+	int32 testedCount;		///< pairs tested for overlap (with an awake body)
+	int32 enterCount;		///< shapes which entered a trigger
+	int32 exitCount;		///< shapes which exited a trigger, pairs destroyed by the step included (Exit calls)
+	float32 time;			///< milliseconds spent updating the trigger pairs
+};
+
+/// MIGUEL MODIFICATION: Allocator statistics. Memory owned by a solver worker: only its thread uses it.
+struct b2WorkerAllocator
+{
+	b2StackAllocator stackAllocator;	///< per step memory (islands solved by the worker)
+	b2BlockAllocator blockAllocator;	///< small objects kept between steps
+};
+
+/// MIGUEL MODIFICATION: Allocator statistics. Those of the solver workers are summed (high-water
+/// mark of the biggest worker).
+struct b2AllocatorStatistics
+{
+	b2StackAllocatorStatistics stack;			///< world stack allocator
+	b2StackAllocatorStatistics workerStack;		///< solver workers stack allocators
+	b2BlockAllocatorStatistics block;			///< world block allocator
+	b2BlockAllocatorStatistics workerBlock;		///< solver workers block allocators
+	int32 workerCount;							///< solver workers with own allocators (0 if solving on one thread)
+};
+
+/// MIGUEL MODIFICATION: Step profiling. Milliseconds spent in the phases of b2World::Step
+/// and the world counts after it.
+struct b2Profile
+{
+	float32 step;			///< whole step
+	float32 collide;		///< narrow-phase (contacts updated by the contact manager)
+	float32 controllers;	///< controllers step
+	float32 islands;		///< awake islands update and island building
+	float32 solve;			///< velocity and position solve of the islands
+	float32 broadphase;		///< shapes synchronization and broad-phase commit (new pairs)
+	float32 solveTOI;		///< continuous collision
+	float32 listeners;		///< contact listener callbacks (included in the phases above)
+	float32 debugDraw;		///< debug draw done in the step
+	int32 bodyCount;
+	int32 contactCount;
+	int32 jointCount;
+	int32 islandCount;		///< awake islands solved
+};
+
+/// MIGUEL MODIFICATION: Step profiling. Forwards the contact callbacks of a step to the
+/// registered listener, timing them.
+class b2ProfileContactListener : public b2ContactListener
+{
+public:
+	void Add(const b2ContactPoint* point);
+	void Persist(const b2ContactPoint* point);
+	void Remove(const b2ContactPoint* point);
+	void Result(const b2ContactResult* point);
+
+	b2ContactListener* m_listener;
+	float32 m_time;
+};
 
 struct b2TimeStep
 {
@@ -47,6 +167,12 @@ struct b2TimeStep
 	bool warmStarting;
 	//MIGUEL MODIFICATION: Reset forces triggering
 	bool resetForces;
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	b2ContactSolverType contactSolverType;
+	//MIGUEL MODIFICATION: Adaptive iterations. Budget of each island class, early out of velocity iterations.
+	int32 islandVelocityIterations[e_islandClassCount];
+	int32 islandPositionIterations[e_islandClassCount];
+	bool adaptiveIterations;
 };
 
 /// The world class manages all physics entities, dynamic simulation,
@@ -59,7 +185,9 @@ public:
 	/// @param worldAABB a bounding box that completely encompasses all your shapes.
 	/// @param gravity the world gravity vector.
 	/// @param doSleep improve performance by not simulating inactive bodies.
-	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep);
+	/// @param broadPhaseType the broad-phase algorithm (MIGUEL MODIFICATION). The dynamic tree
+	/// has no proxy limit; sweep and prune is limited to b2_maxProxies.
+	b2World(const b2AABB& worldAABB, const b2Vec2& gravity, bool doSleep, b2BroadPhaseType broadPhaseType = e_sweepAndPruneBroadPhase);
 
 	/// Destruct the world. All physics entities are destroyed and all heap memory is released.
 	~b2World();
@@ -77,6 +205,9 @@ public:
 	/// Register a contact event listener
 	void SetContactListener(b2ContactListener* listener);
 
+	/// MIGUEL MODIFICATION: Trigger volumes. Register a trigger event listener.
+	void SetTriggerListener(b2TriggerListener* listener);
+
 	/// Register a routine for debug drawing. The debug draw functions are called
 	/// inside the b2World::Step method, so make sure your renderer is ready to
 	/// consume draw commands when you call Step().
@@ -152,6 +283,22 @@ public:
 	/// @returns the colliding shape shape, or null if not found
 	b2Shape* RaycastOne(const b2Segment& segment, float32* lambda, b2Vec2* normal, bool solidShapes, void* userData);
 
+	//MIGUEL MODIFICATION: Callback queries
+	/// Query the world for all shapes that potentially overlap the provided AABB, without a count
+	/// limit and without allocations. Each shape is reported to the callback, which can stop the query.
+	/// @param callback the user implemented callback.
+	/// @param aabb the query box.
+	void Query(b2QueryCallback* callback, const b2AABB& aabb);
+
+	/// Query the world for the shapes that intersect a given segment, without allocations. Shapes are
+	/// reported to the callback in order of intersection, with the hit fraction and normal, until it stops the ray cast.
+	/// Without a count limit. With the dynamic tree the shapes past the one that stops the ray cast are not tested.
+	/// @param callback the user implemented callback.
+	/// @param segment defines the begin and end point of the ray cast, from p1 to p2.
+	/// @param solidShapes determines if shapes that the ray starts in are counted as hits.
+	/// @param userData passed through the worlds contact filter, with method RayCollide.
+	void Raycast(b2RaycastCallback* callback, const b2Segment& segment, bool solidShapes, void* userData);
+
 	/// Check if the AABB is within the broadphase limits.
 	bool InRange(const b2AABB& aabb) const;
 
@@ -170,15 +317,97 @@ public:
 	/// @return the head of the world controller list.
 	b2Controller* GetControllerList();
 
+	//MIGUEL MODIFICATION: World snapshots
+	/// Get the world contact list. With the returned contact, use b2Contact::GetNext to get
+	/// the next contact in the world list. A NULL contact indicates the end of the list.
+	/// @return the head of the world contact list.
+	b2Contact* GetContactList();
+
+	/// Wake up or put to sleep the whole island of a dynamic body (its bodies share the sleep state).
+	/// Bodies put to sleep lose their velocity, force and torque.
+	void SetIslandAwake(b2Body* body, bool flag);
+
 	/// Re-filter a shape. This re-runs contact filtering on a shape.
 	void Refilter(b2Shape* shape);
 
+	/// MIGUEL MODIFICATION: Material table. Add a material, referenced by shapes (b2ShapeDef::material,
+	/// b2Shape::SetMaterial). Returns b2_nullMaterial if the table is full (b2_maxMaterials).
+	int32 CreateMaterial(float32 friction, float32 restitution);
+
+	/// MIGUEL MODIFICATION: Material table. Change a material. The contacts of its shapes, sleeping
+	/// ones included, use it from the next step on: contacts are not destroyed (warm starting is kept).
+	void SetMaterial(int32 material, float32 friction, float32 restitution);
+
+	/// MIGUEL MODIFICATION: Material table. Get a material.
+	const b2Material& GetMaterial(int32 material) const;
+
+	/// MIGUEL MODIFICATION: Material table. Get the number of materials created.
+	int32 GetMaterialCount() const { return m_materialCount; }
+
 	/// Enable/disable warm starting. For testing.
 	void SetWarmStarting(bool flag) { m_warmStarting = flag; }
 
 	/// Enable/disable continuous physics. For testing.
 	void SetContinuousPhysics(bool flag) { m_continuousPhysics = flag; }
 
+	/// MIGUEL MODIFICATION: Solve islands on this many threads, the calling thread included.
+	/// With 1 (the default) islands are solved one by one on the calling thread. Contact results
+	/// are reported after all islands are solved, in the same order as the serial solve.
+	void SetSolverThreadCount(int32 count);
+
+	/// MIGUEL MODIFICATION: Get the number of threads solving islands.
+	int32 GetSolverThreadCount() const;
+
+	/// MIGUEL MODIFICATION: Set the arena size of the stack allocators (world and solver workers).
+	/// They grow to the memory needed anyway, this avoids growing in the first steps of big levels.
+	void SetStackAllocatorSize(int32 size);
+
+	/// MIGUEL MODIFICATION: Get the stack allocators high-water marks and the block allocators usage.
+	void GetAllocatorStatistics(b2AllocatorStatistics* stats) const;
+
+	/// MIGUEL MODIFICATION: Select the contact solver. Scalar by default.
+	void SetContactSolverType(b2ContactSolverType type) { m_contactSolverType = type; }
+	b2ContactSolverType GetContactSolverType() const { return m_contactSolverType; }
+
+	/// MIGUEL MODIFICATION: Stop the velocity iterations of an island once its body velocities
+	/// settle (position iterations always stop when the errors are small). Off by default.
+	void SetAdaptiveIterations(bool flag) { m_adaptiveIterations = flag; }
+	bool GetAdaptiveIterations() const { return m_adaptiveIterations; }
+
+	/// MIGUEL MODIFICATION: Set the iteration budget of the islands of a class. Zero (the default)
+	/// uses the iterations passed to Step.
+	void SetIslandIterations(b2IslandClass islandClass, int32 velocityIterations, int32 positionIterations);
+
+	/// MIGUEL MODIFICATION: Get the iterations done by the islands in the last time step.
+	void GetIterationStatistics(b2IterationStatistics* stats) const { *stats = m_iterationStatistics; }
+
+	/// MIGUEL MODIFICATION: Get the contact solver counters of the last time step.
+	void GetContactSolverStatistics(b2ContactSolverStatistics* stats) const { *stats = m_contactSolverStatistics; }
+
+	/// MIGUEL MODIFICATION: Get the continuous collision counters of the last time step.
+	void GetTOIStatistics(b2TOIStatistics* stats) const { *stats = m_toiStatistics; }
+
+	/// MIGUEL MODIFICATION: Get the narrow-phase counters of the last time step.
+	void GetCollideStatistics(b2CollideStatistics* stats) const { *stats = m_collideStatistics; }
+
+	/// MIGUEL MODIFICATION: Get the trigger pair counters of the last time step.
+	void GetTriggerStatistics(b2TriggerStatistics* stats) const { *stats = m_triggerStatistics; }
+
+	/// MIGUEL MODIFICATION: Polygon and circle contacts whose shapes almost didn't move relative to
+	/// each other (less than a quarter of the linear slop) keep their manifold instead of colliding
+	/// again. This is an approximation: the points and separations are the old ones, so stacks
+	/// settle differently. Off by default. The separation bound skip of apart contacts is exact
+	/// and always on.
+	void SetManifoldReuse(bool flag) { m_manifoldReuse = flag; }
+	bool GetManifoldReuse() const { return m_manifoldReuse; }
+
+	/// MIGUEL MODIFICATION: Get the phase times and counts of the last time step.
+	void GetProfile(b2Profile* profile) const { *profile = m_profile; }
+
+	/// MIGUEL MODIFICATION: Get the rolling average of the phase times (about the last
+	/// 20 steps). The counts are the ones of the last time step.
+	void GetAverageProfile(b2Profile* profile) const { *profile = m_averageProfile; }
+
 	/// Perform validation of internal data structures.
 	void Validate();
 
@@ -188,6 +417,12 @@ public:
 	/// Get the number of broad-phase pairs.
 	int32 GetPairCount() const;
 
+	/// MIGUEL MODIFICATION: Get the broad-phase algorithm this world was created with.
+	b2BroadPhaseType GetBroadPhaseType() const;
+
+	/// MIGUEL MODIFICATION: Get the pair table statistics. Lookup and probe counts cover the last time step.
+	void GetPairStatistics(b2PairStatistics* stats) const;
+
 	/// Get the number of bodies.
 	int32 GetBodyCount() const;
 
@@ -211,12 +446,40 @@ public:
 private:
 
 	friend class b2Body;
+	friend class b2Contact;
 	friend class b2ContactManager;
 	friend class b2Controller;
 
 	void Solve(const b2TimeStep& step);
 	void SolveTOI(const b2TimeStep& step);
 
+	//MIGUEL MODIFICATION: TOI event queue
+	void UpdateTOI(b2Contact* contact);
+
+	//MIGUEL MODIFICATION: Persistent islands
+	b2Body* FindIsland(b2Body* body);
+	void LinkIslands(b2Body* body1, b2Body* body2);
+	void UnlinkIslands(b2Body* body1, b2Body* body2);
+	void WakeIsland(b2Body* body);
+	void AddAwakeIsland(b2Body* root);
+	void RemoveAwakeIsland(b2Body* root);
+	void SplitIsland(b2Body* root, b2Body* removed);
+	void UpdateIslandType(b2Body* body);
+	void UpdateAwakeIslands();
+	void RemoveSleepingIslands();
+	void ValidateIslands();
+
+	//MIGUEL MODIFICATION: Parallel island solving
+	bool BuildIsland(b2Body* root, b2Island* island);
+	void SolveIslands(const b2TimeStep& step);
+	void SolveIslandsParallel(const b2TimeStep& step);
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	void AddContactSolverStatistics(const b2ContactSolverStatistics& stats);
+
+	//MIGUEL MODIFICATION: Adaptive iterations
+	void AddIterationStatistics(b2IslandClass islandClass, int32 velocityIterations, int32 positionIterations);
+
 	void DrawJoint(b2Joint* joint);
 	void DrawShape(b2Shape* shape, const b2XForm& xf, const b2Color& color, bool core);
 	//MIGUEL MODIFICATION:
@@ -271,6 +534,49 @@ private:
 
 	// This is for debugging the solver.
 	bool m_continuousPhysics;
+
+	//MIGUEL MODIFICATION: Parallel island solving. One stack allocator per worker.
+	b2ThreadPool* m_threadPool;
+	b2WorkerAllocator* m_solverAllocators;	//MIGUEL MODIFICATION: Allocator statistics. Block allocator per worker too.
+	int32 m_stackAllocatorSize;
+
+	//MIGUEL MODIFICATION: SIMD contact solver mode
+	b2ContactSolverType m_contactSolverType;
+	b2ContactSolverStatistics m_contactSolverStatistics;
+
+	//MIGUEL MODIFICATION: Material table
+	b2Material m_materials[b2_maxMaterials];
+	int32 m_materialCount;
+
+	//MIGUEL MODIFICATION: Adaptive iterations
+	bool m_adaptiveIterations;
+	int32 m_islandVelocityIterations[e_islandClassCount];
+	int32 m_islandPositionIterations[e_islandClassCount];
+	b2IterationStatistics m_iterationStatistics;
+
+	//MIGUEL MODIFICATION: Persistent islands. Roots of the islands that may be awake.
+	b2Body** m_awakeIslands;
+	int32 m_awakeIslandCount;
+	int32 m_awakeIslandCapacity;
+
+	//MIGUEL MODIFICATION: TOI event queue. Only used inside SolveTOI, the storage is kept.
+	b2TOIQueue m_toiQueue;
+	b2TOIStatistics m_toiStatistics;
+
+	//MIGUEL MODIFICATION: Trigger volumes. Pairs of trigger shapes, which have no contact.
+	b2TriggerPair* m_triggerList;
+	int32 m_triggerCount;
+	b2TriggerListener* m_triggerListener;
+	b2TriggerStatistics m_triggerStatistics;
+
+	//MIGUEL MODIFICATION: Separation bound and manifold reuse
+	b2CollideStatistics m_collideStatistics;
+	bool m_manifoldReuse;
+
+	//MIGUEL MODIFICATION: Step profiling
+	b2Profile m_profile;
+	b2Profile m_averageProfile;
+	b2ProfileContactListener m_profileListener;
 };
 
 inline b2Body* b2World::GetGroundBody()
@@ -293,6 +599,18 @@ inline b2Controller* b2World::GetControllerList()
 	return m_controllerList;
 }
 
+inline b2Contact* b2World::GetContactList()
+{
+	return m_contactList;
+}
+
+//MIGUEL MODIFICATION: Material table
+inline const b2Material& b2World::GetMaterial(int32 material) const
+{
+	b2Assert(0 <= material && material < m_materialCount);
+	return m_materials[material];
+}
+
 inline int32 b2World::GetBodyCount() const
 {
 	return m_bodyCount;
@@ -109,6 +109,50 @@ public:
 	virtual void Result(const b2ContactResult* point) { B2_NOT_USED(point); }
 };
 
+//MIGUEL MODIFICATION: Trigger volumes
+/// Implement this class to know when shapes begin and end overlapping trigger shapes
+/// (b2ShapeDef::isTrigger). Called at the end of b2World::Step, and when a shape inside
+/// a trigger is destroyed or refiltered.
+/// @warning You cannot create/destroy Box2D entities inside these callbacks.
+class b2TriggerListener
+{
+public:
+	virtual ~b2TriggerListener() {}
+
+	/// Called when a shape begins overlapping a trigger.
+	virtual void Enter(b2Shape* trigger, b2Shape* shape) { (void)trigger; (void)shape; }
+
+	/// Called when a shape stops overlapping a trigger.
+	virtual void Exit(b2Shape* trigger, b2Shape* shape) { (void)trigger; (void)shape; }
+};
+
+//MIGUEL MODIFICATION: Callback queries
+/// Implement this class to receive the shapes found by b2World::Query.
+/// @warning You cannot create/destroy Box2D entities or query the world inside this callback.
+class b2QueryCallback
+{
+public:
+	virtual ~b2QueryCallback() {}
+
+	/// Called for each shape whose AABB overlaps the query AABB.
+	/// @return false to terminate the query.
+	virtual bool ReportShape(b2Shape* shape) = 0;
+};
+
+/// Implement this class to receive the shapes hit by b2World::Raycast, nearest first.
+/// @warning You cannot create/destroy Box2D entities or query the world inside this callback.
+class b2RaycastCallback
+{
+public:
+	virtual ~b2RaycastCallback() {}
+
+	/// Called for each shape hit by the segment.
+	/// @param lambda the hit fraction: the point is p = (1 - lambda) * segment.p1 + lambda * segment.p2.
+	/// @param normal the normal at the hit point (not set if the segment starts inside a solid shape).
+	/// @return false to terminate the ray cast.
+	virtual bool ReportShape(b2Shape* shape, float32 lambda, const b2Vec2& normal) = 0;
+};
+
 /// Color for debug drawing. Each value has the range [0,1].
 struct b2Color
 {
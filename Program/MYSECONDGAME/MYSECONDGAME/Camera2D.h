@@ -69,6 +69,7 @@ public:
 	virtual void MoveTo(const Vector2& newposition) = 0;//Command to move to a new position
 	virtual void Rotate(float speed)= 0;;				//Make an increment in angle
 	virtual void Zoom(bool positive)= 0;;				//Apply a multiplication of zoom
+	virtual void Interpolate(float alpha) {}			//Place camera between last two updates (rendering between physics steps)
 	//----- PUBLIC VARIABLES ------
 
 protected:
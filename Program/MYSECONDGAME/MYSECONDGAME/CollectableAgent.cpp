@@ -69,6 +69,7 @@ bool CollectableAgent::HandleEvent(const EventData& data)
 			//Drop collected!
 			//Destroy body
 			mPhysicsManager->DestroyBody(mParams.physicbody);
+			mParams.physicbody = NULL;
 			mCollected = true; //Memorize collected
 			//Send event as drop was collected
 			SingletonGameEventMgr::Instance()->QueueEvent(
@@ -86,6 +87,13 @@ void CollectableAgent::HandleOutOfLimits(const OutOfLimitsEventData&)
 	mOutOfLimits = true;
 }	
 
+//Back to state after level load
+bool CollectableAgent::Restart()
+{
+	//Collected drops change the level (count of drops)
+	return (mActive && !mCollected && !mOutOfLimits);
+}
+
 //Create from params
 void CollectableAgent::Create( const GameAgentPar *params)	
 {
@@ -107,6 +115,12 @@ void CollectableAgent::Create( const GameAgentPar *params)
 //Destroy agent
 void CollectableAgent::Destroy()
 {
+	//IF - Body not destroyed yet (not collected): no body has to point to this agent once deleted
+	if(mParams.physicbody)
+	{
+		mPhysicsManager->DestroyBody(mParams.physicbody);
+		mParams.physicbody = NULL;
+	}//IF
 	//Finally, update internal tracking
 	mActive = false;
 }
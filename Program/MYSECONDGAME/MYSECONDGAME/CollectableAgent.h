@@ -62,6 +62,8 @@ public:
 	  mCollected(false),
 	  mOutOfLimits(false)
 	{
+		//No contacts processed (player detects collection)
+		_subscribeContacts(0);
 	}
 	virtual ~CollectableAgent(){ _release(); }
 	//----- VALUES GET/SET ---------------
@@ -75,6 +77,7 @@ public:
 	virtual void HandleOutOfLimits(const OutOfLimitsEventData& data);//Handle out of limits
 	virtual void Create( const GameAgentPar *params);				//Create from params
 	virtual void Destroy();											//Destroy body
+	virtual bool Restart();											//Back to state after level load
 
 protected:
 	//---- INTERNAL VARIABLES ----
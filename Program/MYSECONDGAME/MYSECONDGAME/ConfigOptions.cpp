@@ -47,6 +47,9 @@ void ConfigOptions::_parseConfigOptions()
 	Element: GFX Atts: ResX(number) ResY(number) Fullscreeen(number)
 	Element: Physics Atts: 	TimeStepInv(number)	Iterations(number) GravityX(number) GravityY(number)
 							AABBxmax(number) AABBymax(number) AABBxmin(number) AABBymin(number) UnitScaling(number)    
+							BroadPhase("SAP" or "DynamicTree") SolverThreads(number)
+							ContactSolver("Scalar" or "SIMD") PhysicsThread(0 or 1) BakeStaticGeometry(0 or 1)
+							AdaptiveIterations(0 or 1) StackIterations(number) SoftBodyIterations(number)
 	*/
 	
 	//Open and load document
@@ -108,6 +111,52 @@ void ConfigOptions::_parseConfigOptions()
 	physicssection->GetAttribute("UnitScaling",&scale);
 	if(scale < 0.01f || scale > 200.0f)
 		throw(GenericException("Error reading file '" + mFileName +"' Bad value of Unit scaling",GenericException::FILE_CONFIG_INCORRECT));
+	//Broad-phase algorithm
+	std::string broadphasename;
+	b2BroadPhaseType broadphase;
+	physicssection->GetAttribute("BroadPhase",&broadphasename);
+	if(broadphasename == "SAP")
+		broadphase = e_sweepAndPruneBroadPhase;
+	else if(broadphasename == "DynamicTree")
+		broadphase = e_dynamicTreeBroadPhase;
+	else
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of BroadPhase",GenericException::FILE_CONFIG_INCORRECT));
+	//Island solver threads
+	int solverthreads;
+	physicssection->GetAttribute("SolverThreads",&solverthreads);
+	if(solverthreads < 1 || solverthreads > 16)
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of SolverThreads",GenericException::FILE_CONFIG_INCORRECT));
+	//Contact solver
+	std::string contactsolvername;
+	b2ContactSolverType contactsolver;
+	physicssection->GetAttribute("ContactSolver",&contactsolvername);
+	if(contactsolvername == "Scalar")
+		contactsolver = e_scalarContactSolver;
+	else if(contactsolvername == "SIMD")
+		contactsolver = e_simdContactSolver;
+	else
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of ContactSolver",GenericException::FILE_CONFIG_INCORRECT));
+	//Physics thread
+	int physicsthread;
+	physicssection->GetAttribute("PhysicsThread",&physicsthread);
+	if(physicsthread != 1 && physicsthread != 0)
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of PhysicsThread",GenericException::FILE_CONFIG_INCORRECT));
+	//Static geometry baking
+	int bakestaticgeometry;
+	physicssection->GetAttribute("BakeStaticGeometry",&bakestaticgeometry);
+	if(bakestaticgeometry != 1 && bakestaticgeometry != 0)
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of BakeStaticGeometry",GenericException::FILE_CONFIG_INCORRECT));
+	//Adaptive iterations
+	int adaptiveiterations;
+	physicssection->GetAttribute("AdaptiveIterations",&adaptiveiterations);
+	if(adaptiveiterations != 1 && adaptiveiterations != 0)
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of AdaptiveIterations",GenericException::FILE_CONFIG_INCORRECT));
+	//Iterations of stacks and soft bodies (0 = general ones)
+	int stackiterations, softbodyiterations;
+	physicssection->GetAttribute("StackIterations",&stackiterations);
+	physicssection->GetAttribute("SoftBodyIterations",&softbodyiterations);
+	if(stackiterations < 0 || stackiterations > 20 || softbodyiterations < 0 || softbodyiterations > 20)
+		throw(GenericException("Error reading file '" + mFileName +"' Bad value of StackIterations or SoftBodyIterations",GenericException::FILE_CONFIG_INCORRECT));
 	
 	//Copy values to structure
 	mPhysicsConfig.iterations = iterations;
@@ -116,6 +165,14 @@ void ConfigOptions::_parseConfigOptions()
 	mPhysicsConfig.worldaabbmax = aabbmax;
 	mPhysicsConfig.worldaabbmin = aabbmin;
 	mPhysicsConfig.globalscale = scale;
+	mPhysicsConfig.broadphase = broadphase;
+	mPhysicsConfig.solverthreads = solverthreads;
+	mPhysicsConfig.contactsolver = contactsolver;
+	mPhysicsConfig.physicsthread = (physicsthread == 1);
+	mPhysicsConfig.bakestaticgeometry = (bakestaticgeometry == 1);
+	mPhysicsConfig.adaptiveiterations = (adaptiveiterations == 1);
+	mPhysicsConfig.stackiterations = stackiterations;
+	mPhysicsConfig.softbodyiterations = softbodyiterations;
 	}
 	//**********************************************************************
 }
\ No newline at end of file
@@ -52,16 +52,32 @@ typedef struct PhysicsConfig
 	gravity(b2Vec2(0.0f,-10.0f)),
 	worldaabbmax(b2Vec2(10.0f,10.0f)),
 	worldaabbmin(b2Vec2(-10.0f,-10.0f)),
-	globalscale(10.0f)
+	globalscale(10.0f),
+	broadphase(e_sweepAndPruneBroadPhase),
+	solverthreads(1),
+	contactsolver(e_scalarContactSolver),
+	physicsthread(false),
+	bakestaticgeometry(false),
+	adaptiveiterations(false),
+	stackiterations(0),
+	softbodyiterations(0)
 	{}
 	//Generic constructor
-	PhysicsConfig(float tstep,int iter,const b2Vec2& grav,const b2Vec2& aabbmax,const b2Vec2& aabbmin,float scale):
+	PhysicsConfig(float tstep,int iter,const b2Vec2& grav,const b2Vec2& aabbmax,const b2Vec2& aabbmin,float scale,b2BroadPhaseType bphase,int sthreads,b2ContactSolverType csolver,bool pthread,bool bake,bool adaptive,int stackiter,int softiter):
 	timestep(tstep),
 	iterations(iter),
 	gravity(grav),
 	worldaabbmax(aabbmax),
 	worldaabbmin(aabbmin),
-	globalscale(scale)
+	globalscale(scale),
+	broadphase(bphase),
+	solverthreads(sthreads),
+	contactsolver(csolver),
+	physicsthread(pthread),
+	bakestaticgeometry(bake),
+	adaptiveiterations(adaptive),
+	stackiterations(stackiter),
+	softbodyiterations(softiter)
 	{}
 	float timestep;
 	int	iterations;
@@ -69,6 +85,14 @@ typedef struct PhysicsConfig
 	b2Vec2 worldaabbmax;
 	b2Vec2 worldaabbmin;
 	float globalscale;
+	b2BroadPhaseType broadphase;	//Broad-phase algorithm: sweep and prune or dynamic tree
+	int solverthreads;				//Threads solving physics islands (1 = no threading)
+	b2ContactSolverType contactsolver;	//Contact solver: scalar or SIMD (4 contacts at a time)
+	bool physicsthread;				//World stepped in its own thread while the frame is rendered
+	bool bakestaticgeometry;		//Static bodies of levels merged in edge chains when loaded (in-game)
+	bool adaptiveiterations;		//Velocity iterations of a group of bodies stop when velocities settle
+	int stackiterations;			//Iterations of stacked bodies groups (0 = general iterations)
+	int softbodyiterations;			//Iterations of soft bodies (blobs) groups (0 = general iterations)
 }PhysicsConfig;
 
 class ConfigOptions
@@ -1605,6 +1605,10 @@ void EditorLogic::_init()
 								  physicsconf.iterations,
 								  physicsconf.worldaabbmax,
 								  physicsconf.worldaabbmin,
+								  physicsconf.broadphase,
+								  physicsconf.solverthreads,
+								  physicsconf.contactsolver,
+								  false,	//Editor steps world in update
 								  SingletonIndieLib::Instance()->Box2DDebugRender)
 					);
 
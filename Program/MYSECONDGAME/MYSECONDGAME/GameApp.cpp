@@ -97,6 +97,7 @@ void GameApp::Run()
 	//Local variables for timing
 	float dt(0.0f);
 	float gametimestepms (g_ConfigOptions.GetPhysicsConfiguration().timestep * 1000);
+	bool vsync (g_ConfigOptions.GetGFXConfiguration().vsync);	//Frames wait for screen refresh
 
 	IndieLibManager *Ilib (SingletonIndieLib::Instance());
 	mMainTimer.Start();
@@ -135,15 +136,12 @@ void GameApp::Run()
 
 		//--------FPS LIMITING----------------
 		dt = mMainTimer.GetTicks();
-		//Patch to work in high-speed hardware (I dont interpolate and those things
-		//as it complicates drawing, displaying, etc.. Instead, a generic sleep is done
-		//to keep things nice... (http://gafferongames.com/game-physics/fix-your-timestep/)
-		//It is not nice and shouldnt be used in a serious comercial game... but...
-		//Generally, the effect will be LIMITING FPS. For my game is not a problem. Why want
+		//Rendering interpolates between physics steps (http://gafferongames.com/game-physics/fix-your-timestep/),
+		//so frame rate doesnt need to match physics. With vsync frames are limited by the screen refresh.
+		//Without it, a generic sleep is done in high-speed hardware to keep things nice... Why want
 		//500 FPS if 100 FPS is enough for my eye? Waste of power? It serves purpose to cap FPS
-		//and to adapt with dt throghout the game... Is this solution for GAME LOOP for this project
-		//IF - dt big enough (floats division and that stuff... ;))
-		if(dt >0.0001)
+		//IF - No vsync and dt big enough (floats division and that stuff... ;))
+		if(!vsync && dt >0.0001)
 		{
 			//IF - Surpassed max framerate (4 times timestep for physics engine)
 			if((gametimestepms / dt ) > 4.0f)
@@ -151,8 +149,8 @@ void GameApp::Run()
 				//Sleep nicely to fill this time without updating
 				::Sleep(static_cast<DWORD>(gametimestepms - dt));
 			}
-		}//ELSE IF - Too fast (out of precission)
-		else if(dt <= 0.0001)
+		}//ELSE IF - No vsync and too fast (out of precission)
+		else if(!vsync && dt <= 0.0001)
 		{
 			::Sleep(static_cast<DWORD>(1));
 		}//IF
@@ -106,6 +106,9 @@ typedef struct BlobDeathInfo  //Blob death info
 	float radius;
 	//"Affected" bodies by death of blob
 	std::vector<b2Body*> affectedbodies;
+	//Handles of agents of affected bodies, taken when the event is queued to handle it later (a body
+	//can be destroyed before: it is only used if its agent is still alive). Empty if not queued
+	std::vector<AgentHandle> affectedhandles;
 }BlobDeathInfo;
 
 typedef struct ShootBlobCommand  //Shoot a new blob command
@@ -260,6 +263,7 @@ public:
 	Vector2 GetPosition() const { return mBlobDeathInfo.position; }
 	float GetRadius() const { return mBlobDeathInfo.radius; }
 	bool IsMainBlob() const { return mBlobDeathInfo.mainblob; }
+	const BlobDeathInfo& GetInfo() const { return mBlobDeathInfo; }
 
 	//Quite ugly but I wont modify / Just to work in a nice fast way
 	std::vector<b2Body*>::const_iterator GetFirstAffectedBody() const { return mBlobDeathInfo.affectedbodies.begin(); }
@@ -28,6 +28,8 @@ typedef enum GameEventType
 	Event_PersistantCollision,
 	Event_DeletedCollision,
 	Event_CollisionResult,
+	Event_TriggerEnter,	//Trigger events (shape entered/exited a trigger shape, no contact), only sent to agents
+	Event_TriggerExit,
 	Event_OutOfLimits,  //Out of limits physics event
 	Event_RenderInLayer, //Render other stuff than entities in a given layer
 	Event_SolidCollision,  //Solid collision
@@ -120,6 +120,12 @@ void GameKeyBoard::Update(float)
 		}
 	}
 
+	//--------Physics profile-----------
+	if(input->OnKeyPress(IND_F2))
+	{
+		mOverlay->TogglePhysicsProfile();
+	}
+
 	//--------Exit-----------
 	if(input->IsKeyPressed(IND_ESCAPE))
 	{
@@ -14,4 +14,16 @@
 //Materials for solid bodies
 typedef enum MaterialType{GENERIC = 0, WOODISH = 1, METALLIC = 2, STONE = 3}MaterialType;
 
+//Reference to an agent: slot in agents manager table and generation of the slot when it was taken.
+//It can be checked after the agent is deleted (the slot generation changes)
+typedef struct AgentHandle
+{
+	AgentHandle():
+	slot(-1),
+	generation(0)
+	{}
+	int slot;
+	unsigned int generation;
+}AgentHandle;
+
 #endif
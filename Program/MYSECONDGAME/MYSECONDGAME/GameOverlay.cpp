@@ -23,6 +23,8 @@
 #include "Camera2D.h"
 #include "SoundManager.h"
 #include "ResourceManager.h"
+#include "PhysicsSim.h"
+#include "PhysicsManager.h"
 
 //Global config options declaration
 extern ConfigOptions g_ConfigOptions;  //Global properties of game
@@ -64,6 +66,9 @@ void GameOverlay::Update(float dt)
 	mCounter += dt;
 	mPositionUpdateDelay += dt;
 
+	//Physics step profile (if shown)
+	_updatePhysicsProfile(dt);
+
 
 	//Debug text is updated by messages
 	//Messages text is updated by events
@@ -184,6 +189,19 @@ void GameOverlay::Update(float dt)
 	}//IF
 }
 
+//Show physics step profile instead of debug text (any build)
+void GameOverlay::TogglePhysicsProfile()
+{
+	mShowPhysicsProfile = !mShowPhysicsProfile;
+	//Shown at next update, or debug text back
+	mProfileCounter = PROFILEDISPLAYTIME;
+	if(!mShowPhysicsProfile)
+	{
+		SpritePointer debugtext = mOverlayAssets->GetEntity("DebugText");
+		debugtext->SetText(const_cast<char*>(mDebugText.c_str()));
+	}
+}
+
 //Render necessary elements
 void GameOverlay::Render()	
 {
@@ -468,10 +486,13 @@ bool GameOverlay::_handleEvents(const EventData& theevent)
 		std::string newmsg = data.GetString();;
 		mDebugMSGstream<<"\n"<<linenum<<":";
 		mDebugMSGstream<<newmsg;
-		//Just display the messages
+		//Just display the messages (not while physics profile is shown)
 		mDebugText = mDebugMSGstream.str();
-		SpritePointer debugtext = mOverlayAssets->GetEntity("DebugText");
-		debugtext->SetText(const_cast<char*>(mDebugText.c_str()));
+		if(!mShowPhysicsProfile)
+		{
+			SpritePointer debugtext = mOverlayAssets->GetEntity("DebugText");
+			debugtext->SetText(const_cast<char*>(mDebugText.c_str()));
+		}
 		eventprocessed = true;
 	}
 
@@ -560,6 +581,68 @@ void GameOverlay::_resetVariables()
 	mGameOver = false;
 }
 
+//Physics step profile text (averaged, from time to time)
+void GameOverlay::_updatePhysicsProfile(float dt)
+{
+	//IF - Not shown or shown a moment ago
+	mProfileCounter += dt;
+	if(!mShowPhysicsProfile || mProfileCounter < PROFILEDISPLAYTIME)
+		return;
+
+	mProfileCounter = 0.0f;
+	PhysicsManagerPointer physics = mGame->GetPhysicsManager();
+	//IF - No level loaded
+	if(!physics)
+		return;
+
+	//Copies taken by physics manager in its update (world can be in use by physics thread now)
+	const b2Profile& profile = physics->GetAverageStepProfile();
+	std::stringstream ss;
+	ss.setf(std::ios::fixed);
+	ss.precision(2);
+	ss<<"PHYSICS STEP(ms): "<<profile.step<<" Collide: "<<profile.collide
+	  <<" Islands: "<<profile.islands<<" Solve: "<<profile.solve
+	  <<" Broadphase: "<<profile.broadphase<<" TOI: "<<profile.solveTOI
+	  <<" Callbacks: "<<profile.listeners
+	  <<"\nBodies: "<<profile.bodyCount<<" Contacts: "<<profile.contactCount
+	  <<" Joints: "<<profile.jointCount<<" Islands: "<<profile.islandCount;
+	const b2CollideStatistics& collidestats = physics->GetCollideStatistics();
+	ss<<" Collided: "<<collidestats.evaluatedCount<<" Skipped: "<<collidestats.skippedCount<<" Reused: "<<collidestats.reusedCount;
+	const b2AllocatorStatistics& allocatorstats = physics->GetAllocatorStatistics();
+	int blocks(0);
+	int workerblocks(0);
+	for(int i = 0; i < b2_blockSizes; ++i)
+	{
+		blocks += allocatorstats.block.blockCount[i];
+		workerblocks += allocatorstats.workerBlock.blockCount[i];
+	}
+	ss<<"\nStack(KB): "<<allocatorstats.stack.maxAllocation / 1024<<"/"<<allocatorstats.stack.capacity / 1024
+	  <<" Workers: "<<allocatorstats.workerStack.maxAllocation / 1024<<"/"<<allocatorstats.workerStack.capacity / 1024
+	  <<" Heap: "<<allocatorstats.stack.heapCount + allocatorstats.workerStack.heapCount<<" Blocks: "<<blocks<<"/"<<workerblocks;
+	//Average iterations of island classes and velocity iterations histogram (last update)
+	static const char* classnames[e_islandClassCount] = {"Default","Stack","Soft"};
+	const b2IterationStatistics& iterationstats = physics->GetIterationStatistics();
+	ss<<"\nIterations(vel/pos)";
+	for(int i = 0; i < e_islandClassCount; ++i)
+	{
+		int islands = b2Max(iterationstats.islandCount[i],1);
+		ss<<" "<<classnames[i]<<": "<<static_cast<float>(iterationstats.velocityIterations[i]) / islands
+		  <<"/"<<static_cast<float>(iterationstats.positionIterations[i]) / islands;
+	}
+	ss<<" Histogram:";
+	for(int i = 0; i < b2_iterationHistogramSize; ++i)
+		ss<<" "<<iterationstats.velocityHistogram[i];
+	//Trigger pairs (collectables) tested instead of contacts (last update)
+	const b2TriggerStatistics& triggerstats = physics->GetTriggerStatistics();
+	ss<<"\nTriggers: "<<triggerstats.pairCount<<" Tested: "<<triggerstats.testedCount
+	  <<" Enter: "<<triggerstats.enterCount<<" Exit: "<<triggerstats.exitCount
+	  <<" Time(ms): "<<triggerstats.time;
+
+	mProfileText = ss.str();
+	SpritePointer debugtext = mOverlayAssets->GetEntity("DebugText");
+	debugtext->SetText(const_cast<char*>(mProfileText.c_str()));
+}
+
 void GameOverlay::_release()
 {
 	//Input controllers
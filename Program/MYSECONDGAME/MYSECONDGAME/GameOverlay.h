@@ -32,6 +32,10 @@ class EventData;
 class GameOverlayListener;
 class GameMouse;
 class GameKeyBoard;
+class PhysicsSim;
+
+//Definitions
+const float PROFILEDISPLAYTIME = 1000.0f;	//Time between physics step profiles shown (ms)
 
 class GameOverlay
 {
@@ -39,7 +43,8 @@ class GameOverlay
 
 public:
 	//----- CONSTRUCTORS/DESTRUCTORS -----
-	GameOverlay():
+	GameOverlay(PhysicsSim* gameptr):
+	  mGame(gameptr),
 	  mGameMouse(NULL), 
 	  mGameKeyBoard(NULL),
 	  mScaleFactor(0),
@@ -53,7 +58,9 @@ public:
 	  mDebugLines(0),
 	  mLastHealth(0.0f),
 	  mLevelCompleted(false),
-	  mGameOver(false)
+	  mGameOver(false),
+	  mShowPhysicsProfile(false),
+	  mProfileCounter(0.0f)
 	{	
 		_init();
 		SingletonLogMgr::Instance()->AddNewLine("GameOverlay","Overlay created and ready",LOGNORMAL);
@@ -71,6 +78,7 @@ public:
 	void Render();				//Render necessary elements
 	void ToggleCameraMode() { mFreeCameraMode = !mFreeCameraMode; }; //Toggle camera mode
 	bool IsFreeCamera() { return mFreeCameraMode; }
+	void TogglePhysicsProfile();	//Show physics step profile instead of debug text (any build)
 	//----- PUBLIC VARIABLES ------
 
 protected:
@@ -81,6 +89,8 @@ protected:
 	float mCounter;				//Timing variable
 	float mPositionUpdateDelay;	//Timing variable
 
+	PhysicsSim* mGame;				//Game logic (physics manager changes with levels)
+
 	GameMouse* mGameMouse;			//Input controllers pointers
 	GameKeyBoard* mGameKeyBoard;
 
@@ -95,12 +105,15 @@ protected:
 	float mLastHealth;				//To update health and with camera modes correctly
 	bool mLevelCompleted;			//Tracking of level completed
 	bool mGameOver;					//Tracking of game over
+	bool mShowPhysicsProfile;		//Physics step profile shown in debug text
+	float mProfileCounter;			//Time since physics step profile shown
 	
 	//Text for font entities in overlay
 	std::string mDebugText;
 	std::string mMessagesText;
 	std::string mCollectedText;
 	std::string mHealthText;
+	std::string mProfileText;
 
 	//Debug messages
 	int mDebugLines;
@@ -110,6 +123,7 @@ protected:
 	void _init();
 	void _resetVariables();
 	void _release();
+	void _updatePhysicsProfile(float dt);	//Physics step profile text (averaged, from time to time)
 	//Event handling
 	bool _handleEvents(const EventData& theevent);
 };
@@ -50,22 +50,51 @@ public:
 	//----- CONSTRUCTORS/DESTRUCTORS -----
 	IAgent()
 	{
+		//By default all contacts are wanted
+		_subscribeContacts(CONTACTALLMASK);
 	};
 	virtual ~IAgent(){}
 	//----- VALUES GET/SET ---------------
 	virtual AgentType GetType() = 0;		//Get the agent type
 	virtual bool IsAlive() = 0;             //Get if agent was destroyed
+	const AgentHandle& GetHandle() const { return mHandle; }		//Get handle in agents manager
+	void SetHandle(const AgentHandle& handle) { mHandle = handle; }	//Set by agents manager when created
+	unsigned int GetContactSubscription(AgentType othertype) const { return mContactSubscriptions[othertype + 1]; } //Contact states wanted (mask) with agents of a type (UNKNOWN: bodies without agent)
 	//----- OTHER FUNCTIONS --------------
 	virtual void UpdateState(float) = 0;								//Update object status
 	virtual bool HandleCollision(const CollisionEventData&)=0;	//Process possible collisions
+	virtual void HandleCollisions(const AgentContact* contacts, int count)	//Process collisions of an update (all of this agent)
+	{
+		//LOOP - Default: process one by one
+		for(int i = 0; i < count; ++i)
+		{
+			CollisionEventData collevent(contacts[i].type,*contacts[i].info);
+			collevent.SetActiveBody(contacts[i].activebody); //Memorize this is the body
+			HandleCollision(collevent);
+		}//LOOP END
+	}
 	virtual bool HandleEvent(const EventData&)=0;						//Process possible events	
 	virtual void HandleOutOfLimits(const OutOfLimitsEventData&)=0;							//Process out of limits
 	virtual void Create( const GameAgentPar*) = 0;				//Create from params
 	virtual void Destroy() = 0;											//Destroy
+	virtual bool Restart() { return false; }							//Back to state after level load (world restored by physics manager). False if level must be loaded again
+	virtual void InterpolateGFX() {}									//Place graphics between last two physics steps (every frame)
 
 protected:
 	//---- INTERNAL VARIABLES ----
+	AgentHandle mHandle;	//Handle in agents manager (collisions dispatching)
+	unsigned int mContactSubscriptions[COUNT + 1];	//Contact states wanted by other agent type (UNKNOWN first)
 	//---- INTERNAL FUNCTIONS ----
+	//Declare contacts wanted: contacts nobody wants are not buffered by physics manager
+	void _subscribeContacts(AgentType othertype, unsigned int statesmask) { mContactSubscriptions[othertype + 1] = statesmask; }
+	void _subscribeContacts(unsigned int statesmask)	//With all agent types
+	{
+		//LOOP - All types (and no agent)
+		for(int i = 0; i <= COUNT; ++i)
+		{
+			mContactSubscriptions[i] = statesmask;
+		}//LOOP END
+	}
 };
 
 #endif
@@ -18,6 +18,9 @@ const float IndieCamera2D::ZOOMCHANGESPEED = 0.04f;
 //Periodically called to make movements/zooms... etc internally
 void IndieCamera2D::Update(float dt)
 {
+	//Memorize values to interpolate from
+	mPreviousPositionPix = mPositionPix;
+	mPreviousZoom = mZoom;
 	
 	//Movement calculations 
 	//IF - Automovement active
@@ -84,6 +87,7 @@ void IndieCamera2D::SetPosition(const Vector2& newposition)
 	mPosition = newposition;
 	mPositionPix = SingletonIndieLib::Instance()->FromCoordToPix(mPosition);
 	_checkBoundariesOfPosition();
+	mPreviousPositionPix = mPositionPix; //Jump (not interpolated)
 	//Make changes to real camera
 	mIndCamera.SetPosition(static_cast<int>(mPositionPix.x),
 						   static_cast<int>(mPositionPix.y)
@@ -96,6 +100,7 @@ void IndieCamera2D::SetPositionPix(const Vector2& newpositionpix)
 	mPositionPix = newpositionpix;
 	mPosition = SingletonIndieLib::Instance()->FromPixToCoord(mPositionPix);
 	_checkBoundariesOfPosition();
+	mPreviousPositionPix = mPositionPix; //Jump (not interpolated)
 	//Make changes to real camera
 	mIndCamera.SetPosition(static_cast<int>(mPositionPix.x),
 						   static_cast<int>(mPositionPix.y)
@@ -110,11 +115,21 @@ void IndieCamera2D::SetZoom(float newzoom)
 	if(mZoom < mMinZoom) mZoom = mMinZoom;
 	
 	mIndCamera.SetZoom(mZoom);
+	mPreviousZoom = mZoom; //Jump (not interpolated)
 
 	mDesiredZoom = mZoom; //No difference (instant change in uptate fcn)
 }
 
 
+//Place camera between last two updates (rendering between physics steps)
+void IndieCamera2D::Interpolate(float alpha)
+{
+	Vector2 positionpix (mPreviousPositionPix + (mPositionPix - mPreviousPositionPix) * alpha);
+	mIndCamera.SetPosition(static_cast<int>(positionpix.x),
+						   static_cast<int>(positionpix.y));
+	mIndCamera.SetZoom(mPreviousZoom + (mZoom - mPreviousZoom) * alpha);
+}
+
 //Sets this camera as current in IndieLib
 void IndieCamera2D::SetAsCurrent()
 {
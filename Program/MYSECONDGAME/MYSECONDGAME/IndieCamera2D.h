@@ -33,13 +33,15 @@ public:
 		mAutoMove(false),
 		mRotationSpeed(0.0f),
 		mScreenWidth(screenwidth),
-		mScreenHeight(screenheight)
+		mScreenHeight(screenheight),
+		mPreviousZoom(zoom)
 	{
 		//Debug assert
 		assert(zoom > 0);
 		//Update coords in pixels
 		mPositionPix = Vector2(mPosition.x * globalscale,
 				   screenheight - mPosition.y * globalscale);
+		mPreviousPositionPix = mPositionPix;
 		//Setup indielib camera
 		mIndCamera.SetZoom(zoom);
 
@@ -62,6 +64,7 @@ public:
 	virtual void MoveTo(const Vector2& newposition);//Command to move to a new position		
 	virtual void Rotate(float speed);				//Make an increment in angle
 	virtual void Zoom(bool positive);				//Apply a multiplication of zoom
+	virtual void Interpolate(float alpha);			//Place camera between last two updates (rendering between physics steps)
 	//----- PUBLIC VARIABLES ------
 
 private:
@@ -73,6 +76,8 @@ private:
 	float mRotationSpeed;		//Speed of rotation of camera
 	float mScreenWidth;			//Screen width (to limits moves)
 	float mScreenHeight;		//Screen height in pixels (for scaling reasons)
+	Vector2 mPreviousPositionPix;	//Values before last update (interpolation)
+	float mPreviousZoom;
 	//----- INTERNAL FUNCTIONS -----
 	void _checkBoundariesOfPosition();
 
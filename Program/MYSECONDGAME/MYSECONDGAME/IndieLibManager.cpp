@@ -108,6 +108,16 @@ void IndieLibManager::UpdateCameras(float dt)
 		(*itr)->Update(dt);
 	}//LOOP END	
 }
+//Place cameras between last two updates (rendering between physics steps)
+void IndieLibManager::InterpolateCameras(float alpha)
+{
+	CamerasListIterator itr;
+	//LOOP - All cameras
+	for(itr = mCamerasList.begin();itr!=mCamerasList.end();++itr)
+	{
+		(*itr)->Interpolate(alpha);
+	}//LOOP END	
+}
 //Get a camera to manipulate it
 Camera2DPointer IndieLibManager::GetCamera(const std::string &name)
 {
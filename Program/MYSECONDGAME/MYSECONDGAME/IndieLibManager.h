@@ -74,6 +74,7 @@ public:
 	Camera2DPointer RegisterCamera(const std::string &name, float zoomfactor, const Vector2 &position, int layer);  //Register a new camera
 	void DeRegisterCamera(const std::string &name);
 	void UpdateCameras(float dt);
+	void InterpolateCameras(float alpha);	//Place cameras between last two updates (rendering between physics steps)
 
 	//GFX Utilites
 	void ScaleToFit(IND_Entity2d* entity, IND_Surface* originsurface,int finalx, int finaly);
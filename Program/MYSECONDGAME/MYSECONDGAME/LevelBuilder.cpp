@@ -19,6 +19,10 @@
 #include "SpriteBuilder.h"
 #include "Camera2D.h"
 #include "GameLogicDefs.h"
+#include "ConfigOptions.h"
+
+//Global config options declaration
+extern ConfigOptions g_ConfigOptions;  //Global properties of game
 
 //Load a level given the level name
 void LevelBuilder::LoadLevel(const std::string& filepath, const std::string& levelname, bool assetsonly)
@@ -178,6 +182,11 @@ void LevelBuilder::LoadLevel(const std::string& filepath, const std::string& lev
 		{
 			throw GenericException("Failure while reading '" + filepath + "' Defined elements to collect and created collectable agents mistmatch!! - Review file",GenericException::FILE_CONFIG_INCORRECT);
 		}
+
+		//IF - In-game: static bodies merged in edge chains (fewer proxies and contacts, no seams between tiles).
+		//Editor keeps them as they are to save the level
+		if(mGameLogicptr && g_ConfigOptions.GetPhysicsConfiguration().bakestaticgeometry)
+			mGameLogicptr->GetPhysicsManager()->BakeStaticBodies(mStaticBodies);
 	}
 	catch (std::exception& e) //Catch exceptions
 	{
@@ -524,6 +533,9 @@ void LevelBuilder::_processBodyEntity(ticpp::Iterator<ticpp::Element> theentity,
 		IAgent* thenewagent = mGameLogicptr->GetAgentsManager()->CreateNewAgent(entId,&bodyagentparams);
 		//Double-reference this body to the agent
 		body->SetUserData(thenewagent);   //NOTE: CAREFUL WHEN CASTING BACK THIS! IT HAS TO BE STATIC_CAST TO SOLIDBODYAGENT*
+		//Static bodies can be baked when all level is loaded
+		if(isstatic)
+			mStaticBodies.push_back(entId);
 		
 		SingletonLogMgr::Instance()->AddNewLine("LevelBuilder::_init","Body Agent '" + entId + "' created",LOGDEBUG);
 	}//ELSE - Editor mode
@@ -974,7 +986,7 @@ void LevelBuilder::_processCollectableEntity(ticpp::Iterator<ticpp::Element> the
 	else
 		GenericException("Failure while reading '" + filepath + " Element '" + entId + "' Should have an Animation, Image or Font associated!",GenericException::FILE_CONFIG_INCORRECT);
 	
-	//A COLLECTABLE is like a body, but it has no shapes but a bounding circle or rectangle, which is sensor
+	//A COLLECTABLE is like a body, but it has no shapes but a bounding circle or rectangle, which is a trigger (sensor without contacts)
 	b2BodyDef bodydefinition;
 	bodydefinition.allowSleep = true;
 	bodydefinition.position = b2Vec2(x,y);  //Position data
@@ -1014,6 +1026,7 @@ void LevelBuilder::_processCollectableEntity(ticpp::Iterator<ticpp::Element> the
 			//newpolygondef.friction = friction;
 			newpolygondef.vertexCount = order;
 			newpolygondef.isSensor =  true;			//NOTE THAT IS SENSOR
+			newpolygondef.isTrigger = true;			//Trigger: enter/exit events, no contacts
 			
 			//LOOP - Set vertices data of polygon
 			for(int i = 0; i<order; i++)
@@ -1055,6 +1068,7 @@ void LevelBuilder::_processCollectableEntity(ticpp::Iterator<ticpp::Element> the
 			//newcircledef.friction = friction;
 			newcircledef.radius = radius;
 			newcircledef.isSensor =  true;			//NOTE THAT IS SENSOR
+			newcircledef.isTrigger = true;			//Trigger: enter/exit events, no contacts
 			
 			float32 x,y;
 			_getVerticesData(verticesdata,x,y,0);
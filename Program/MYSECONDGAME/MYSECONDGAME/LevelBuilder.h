@@ -19,6 +19,7 @@
 
 #include <string>
 #include <sstream>
+#include <vector>
 //Class dependencies
 #include "XMLParser.h"
 #include "LogManager.h"
@@ -62,6 +63,7 @@ protected:
 	GameLevelPointer mLevelPointer;//The level pointer
 	PhysicsSim* mGameLogicptr;    //Pointer to game logic
 	EditorLogic* mEditorLogicptr; //Pointer to editor logic 
+	std::vector<std::string> mStaticBodies;	//Static bodies created (baked when level is loaded in-game)
 	//----- INTERNAL FUNCTIONS -----
 	//Builder functions
 	void _processParallaxLayer(ticpp::Iterator<ticpp::Element> theentity, const std::string &filepath);
@@ -23,8 +23,7 @@ void MainGameScreen::ExecuteEnter()
 		mMainGame = new PhysicsSim();
 
 	if(!mOverlay)
-		//mOverlay = new GameOverlay(mMainGame);
-		mOverlay = new GameOverlay();
+		mOverlay = new GameOverlay(mMainGame);
 
 	//Load first level in game logic
 	mMainGame->LoadFirstLevel();
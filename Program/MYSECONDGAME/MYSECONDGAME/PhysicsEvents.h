@@ -32,7 +32,9 @@ public:
 			         mType == Event_NewCollision || 
 					 mType == Event_PersistantCollision || 
 					 mType == Event_DeletedCollision || 
-					 mType == Event_CollisionResult
+					 mType == Event_CollisionResult ||
+					 mType == Event_TriggerEnter ||
+					 mType == Event_TriggerExit
 				  );
 	  }
 	~CollisionEventData()
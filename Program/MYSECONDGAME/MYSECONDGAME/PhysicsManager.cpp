@@ -12,9 +12,15 @@
 #include "PhysicsManager.h"
 #include "PhysicsEvents.h"
 #include "GameEvents.h"
+#include "IAgent.h"
+#include "PhysicsThread.h"
+#include "Box2D\Common\b2Timer.h"
+#include <sstream>
+#include <algorithm>
 
 //Definition of static members
 const std::string PhysicsManager::MouseJointName = "TheMouseJoint";
+const std::string PhysicsManager::BakedGeometryName = "TheBakedGeometry";
 int GameContactListener::debugcollisionsnum = 0;
 //******************************CONTACT LISTENER IMPLEMENTATION***********************************
 void GameContactListener::Add(const b2ContactPoint* point)
@@ -27,14 +33,18 @@ void GameContactListener::Add(const b2ContactPoint* point)
 		//deal with them in an update function. All points are stored/created inside a container in physics manager.
 		//Here we add new points, or modify existing ones
 
+		//IF - No agent wants this contact: not buffered
+		if(!mPhysicsMgr->_isContactSubscribed(point->shape1,point->shape2,ADDED))
+			return;
+
 		//Create new collision point info
 		ContactInfoKey id(point->shape1,point->id.key,point->shape2,ADDED);
 
 		//Create new point
 		ContactInfo pointinfo(*point);	 
 		pointinfo.state = ADDED;		//Created with ADDED STATE
-		PhysicsManager::ContactPointMapPair insertionpair(id,pointinfo);
-		mPhysicsMgr->mContactPoints.insert(insertionpair);
+		mPhysicsMgr->_takeAgentHandles(pointinfo);
+		mPhysicsMgr->mContactPoints.Add(id,pointinfo);
 
 	}//IF
 }
@@ -49,14 +59,18 @@ void GameContactListener::Persist(const b2ContactPoint* point)
 		//deal with them in an update function. All points are stored/created inside a container in physics manager.
 		//Here we add new points, or modify existing ones
 		
+		//IF - No agent wants this contact: not buffered
+		if(!mPhysicsMgr->_isContactSubscribed(point->shape1,point->shape2,PERSISTED))
+			return;
+
 		//Create new collision point info
 		ContactInfoKey id(point->shape1,point->id.key,point->shape2,PERSISTED);
 		
 		//Update/create new point
 		ContactInfo pointinfo(*point);		
 		pointinfo.state = PERSISTED;		//Created with PERSISTED STATE
-		PhysicsManager::ContactPointMapPair insertionpair(id,pointinfo);
-		mPhysicsMgr->mContactPoints.insert(insertionpair);
+		mPhysicsMgr->_takeAgentHandles(pointinfo);
+		mPhysicsMgr->mContactPoints.Add(id,pointinfo);
 			
 	}//IF
 }
@@ -71,14 +85,18 @@ void GameContactListener::Remove(const b2ContactPoint* point)
 		//deal with them in an update function. All points are stored/created inside a container in physics manager.
 		//Here we add new points, or modify existing ones
 
+		//IF - No agent wants this contact: not buffered
+		if(!mPhysicsMgr->_isContactSubscribed(point->shape1,point->shape2,REMOVED))
+			return;
+
 		//Create new collision point info
 		ContactInfoKey id(point->shape1,point->id.key,point->shape2,REMOVED);
 		
 		//Create new point
 		ContactInfo pointinfo(*point);		//Created with ADDED STATE
 		pointinfo.state = REMOVED;			//Change to deleted state
-		PhysicsManager::ContactPointMapPair insertionpair(id,pointinfo);
-		mPhysicsMgr->mContactPoints.insert(insertionpair);
+		mPhysicsMgr->_takeAgentHandles(pointinfo);
+		mPhysicsMgr->mContactPoints.Add(id,pointinfo);
 	}//IF
 
 }
@@ -90,14 +108,155 @@ void GameContactListener::Result(const b2ContactResult* point)
 	//deal with them in an update function. All COLLISION RESULTS are stored in different container, 
 	//as it has different meaning in BOX2D
 
+	//IF - No agent wants this contact: not buffered
+	if(!mPhysicsMgr->_isContactSubscribed(point->shape1,point->shape2,RESULT))
+		return;
+
 	//Build contact info key data to map in container
 	ContactInfoKey id(point->shape1,point->id.key,point->shape2,RESULT);
 	
 	//Update/create new point
 	ContactInfo pointinfo(*point);	 
 	pointinfo.state = RESULT;		//Created with RESULT STATE
-	PhysicsManager::ContactResultsMapPair insertionpair(id,pointinfo);
-	mPhysicsMgr->mContactResults.insert(insertionpair);
+	mPhysicsMgr->_takeAgentHandles(pointinfo);
+	mPhysicsMgr->mContactResults.Add(id,pointinfo);
+}
+
+void GameContactListener::Enter(b2Shape* trigger, b2Shape* shape)
+{
+	//IF - Listen to collisions
+	if(!mIgnoreCollisions)
+	{
+		//Custom handle - a shape entered a trigger: Box2D made no contact for it (no manifold), so it is
+		//buffered as a contact point without contact data
+
+		//IF - No agent wants this trigger event: not buffered
+		if(!mPhysicsMgr->_isContactSubscribed(trigger,shape,TRIGGERENTER))
+			return;
+
+		ContactInfoKey id(trigger,0,shape,TRIGGERENTER);
+		ContactInfo pointinfo(trigger,shape,TRIGGERENTER);
+		mPhysicsMgr->_takeAgentHandles(pointinfo);
+		mPhysicsMgr->mContactPoints.Add(id,pointinfo);
+	}//IF
+}
+
+void GameContactListener::Exit(b2Shape* trigger, b2Shape* shape)
+{
+	//IF - Listen to collisions
+	if(!mIgnoreCollisions)
+	{
+		//Custom handle - a shape exited a trigger (or was destroyed inside it)
+
+		//IF - No agent wants this trigger event: not buffered
+		if(!mPhysicsMgr->_isContactSubscribed(trigger,shape,TRIGGEREXIT))
+			return;
+
+		ContactInfoKey id(trigger,0,shape,TRIGGEREXIT);
+		ContactInfo pointinfo(trigger,shape,TRIGGEREXIT);
+		mPhysicsMgr->_takeAgentHandles(pointinfo);
+		mPhysicsMgr->mContactPoints.Add(id,pointinfo);
+	}//IF
+}
+
+//******************************CONTACT BUFFER IMPLEMENTATION*************************************
+//Reserve room for entries
+void ContactInfoBuffer::Reserve(int capacity)
+{
+	assert(capacity >= 0);
+	mKeys.reserve(capacity);
+	mInfos.reserve(capacity);
+	mOrder.reserve(capacity);
+	mSwap.reserve(capacity);
+}
+
+//Add an entry
+void ContactInfoBuffer::Add(const ContactInfoKey& key, const ContactInfo& info)
+{
+	//IF - No room left (vectors will allocate)
+	if(mInfos.size() == mInfos.capacity())
+	{
+		++mGrowCount;
+	}//IF
+
+	mKeys.push_back(key);
+	mInfos.push_back(info);
+}
+
+//Sort entries by key: Stable LSD radix sort of indexes, 8 bits per pass. Repeated keys (same
+//point in more than one physics step of an update) are dropped keeping the first, as the map
+//insertion did before
+void ContactInfoBuffer::Sort()
+{
+	int count(static_cast<int>(mKeys.size()));
+	//IF - No room left for indexes (vectors will allocate)
+	if(mOrder.capacity() < mKeys.size())
+	{
+		++mGrowCount;
+	}//IF
+	mOrder.resize(count);
+	mSwap.resize(count);
+
+	//LOOP - Start in adding order
+	for(int i = 0; i < count; ++i)
+	{
+		mOrder[i] = i;
+	}//LOOP END
+
+	//LOOP - Radix sort passes
+	for(int pass = 0; pass < ContactInfoKey::RADIXDIGITS; ++pass)
+	{
+		int histogram[256] = {0};
+		//LOOP - Count digits
+		for(int i = 0; i < count; ++i)
+		{
+			++histogram[mKeys[i].GetRadixDigit(pass)];
+		}//LOOP END
+
+		//IF - All keys have the same digit (usual for high bytes of pointers and ids): skip pass
+		if(count == 0 || histogram[mKeys[0].GetRadixDigit(pass)] == count)
+			continue;
+
+		//LOOP - Digits start offsets
+		int offset(0);
+		for(int digit = 0; digit < 256; ++digit)
+		{
+			int digitcount(histogram[digit]);
+			histogram[digit] = offset;
+			offset += digitcount;
+		}//LOOP END
+
+		//LOOP - Scatter indexes in current order (keeps it for same digits)
+		for(int i = 0; i < count; ++i)
+		{
+			int index(mOrder[i]);
+			mSwap[histogram[mKeys[index].GetRadixDigit(pass)]++] = index;
+		}//LOOP END
+
+		mOrder.swap(mSwap);
+	}//LOOP END
+
+	//LOOP - Drop repeated keys
+	mSortedCount = 0;
+	for(int i = 0; i < count; ++i)
+	{
+		//IF - Different to last kept key
+		if(mSortedCount == 0 || !(mKeys[mOrder[i]] == mKeys[mOrder[mSortedCount - 1]]))
+		{
+			mOrder[mSortedCount++] = mOrder[i];
+		}//IF
+	}//LOOP END
+}
+
+//Remove all entries (storage is kept)
+void ContactInfoBuffer::Clear()
+{
+	mKeys.clear();
+	mInfos.clear();
+	mOrder.clear();
+	mSwap.clear();
+	mSortedCount = 0;
+	mGrowCount = 0;
 }
 
 //******************************BOUNDARY LISTENER IMPLMEMENTATION*********************************
@@ -120,6 +279,187 @@ void GameBoundaryListener::Violation(b2Body* body)
 											  );
 }
 
+//******************************QUERY CALLBACKS IMPLEMENTATION************************************
+//Box2D query callback sending shapes to a game visitor (optionally only shapes containing a point)
+class PhysicsQueryCallback : public b2QueryCallback
+{
+public:
+	PhysicsQueryCallback(IPhysicsQueryVisitor* visitor):
+	  mVisitor(visitor),
+	  mQueryIndex(0),
+	  mTestPoint(false),
+	  mPoint(0.0f,0.0f)
+	{}
+
+	bool ReportShape(b2Shape* shape)
+	{
+		//IF - Point query: shape must contain it
+		if(mTestPoint && !shape->TestPoint(shape->GetBody()->GetXForm(),mPoint))
+			return true;
+
+		return mVisitor->VisitShape(shape,mQueryIndex);
+	}
+
+	IPhysicsQueryVisitor* mVisitor;
+	int mQueryIndex;
+	bool mTestPoint;
+	b2Vec2 mPoint;
+};
+
+//Box2D ray cast callback sending hits to a game visitor
+class PhysicsRaycastCallback : public b2RaycastCallback
+{
+public:
+	PhysicsRaycastCallback(IPhysicsRaycastVisitor* visitor):
+	  mVisitor(visitor),
+	  mQueryIndex(0),
+	  mSegment(NULL)
+	{}
+
+	bool ReportShape(b2Shape* shape, float32 lambda, const b2Vec2& normal)
+	{
+		RaycastHit hit;
+		hit.shape = shape;
+		hit.point = mSegment->p1 + lambda * (mSegment->p2 - mSegment->p1);
+		hit.normal = normal;
+		hit.fraction = lambda;
+		return mVisitor->VisitHit(hit,mQueryIndex);
+	}
+
+	IPhysicsRaycastVisitor* mVisitor;
+	int mQueryIndex;
+	const b2Segment* mSegment;
+};
+
+//Visitor to find first body containing a point
+class FirstBodyVisitor : public IPhysicsQueryVisitor
+{
+public:
+	FirstBodyVisitor(bool includestatic):
+	  mIncludeStatic(includestatic),
+	  mFoundBody(NULL)
+	{}
+
+	bool VisitShape(b2Shape* shape, int queryindex)
+	{
+		b2Body* shapebody = GetShapeSourceBody(shape);
+		if ((!shapebody->IsStatic()&& shapebody->GetMass() > 0.0f && !mIncludeStatic)
+			 ||
+			 mIncludeStatic)
+		{
+			mFoundBody = shapebody;
+			return false;	//Found: stop
+		}
+		return true;
+	}
+
+	bool mIncludeStatic;
+	b2Body* mFoundBody;
+};
+
+//Visitor to collect bodies (each body once)
+class BodiesCollectorVisitor : public IPhysicsQueryVisitor
+{
+public:
+	BodiesCollectorVisitor(std::vector<b2Body*>& foundbodies, bool includestatic):
+	  mFoundBodies(foundbodies),
+	  mFirstFound(foundbodies.size()),
+	  mIncludeStatic(includestatic)
+	{}
+
+	bool VisitShape(b2Shape* shape, int queryindex)
+	{
+		b2Body* shapebody(GetShapeSourceBody(shape));
+		if ((shapebody->IsDynamic()&& shapebody->GetMass() > 0.0f && !mIncludeStatic)
+			 ||
+			 mIncludeStatic)
+		{
+			//IF - Not found yet (bodies with more than one shape)
+			if(std::find(mFoundBodies.begin() + mFirstFound, mFoundBodies.end(), shapebody) == mFoundBodies.end())
+				mFoundBodies.push_back(shapebody);
+		}
+		return true;
+	}
+
+	std::vector<b2Body*>& mFoundBodies;
+	size_t mFirstFound;
+	bool mIncludeStatic;
+};
+
+//Visitor to find a specific body
+class BodyFinderVisitor : public IPhysicsQueryVisitor
+{
+public:
+	BodyFinderVisitor(b2Body* bodytofind):
+	  mBodyToFind(bodytofind),
+	  mFound(false)
+	{}
+
+	bool VisitShape(b2Shape* shape, int queryindex)
+	{
+		//IF - Is this body the asked one to find?
+		if(GetShapeSourceBody(shape) == mBodyToFind)
+		{
+			mFound = true;
+			return false;	//Found: stop
+		}
+		return true;
+	}
+
+	b2Body* mBodyToFind;
+	bool mFound;
+};
+
+//******************************STATIC GEOMETRY BAKING HELPERS************************************
+//Edge of a polygon to bake (welded vertices, polygons are counter clockwise)
+typedef struct BakeEdge
+{
+	int vertex1;
+	int vertex2;
+	b2Shape* source;	//Polygon it comes from
+	bool removed;		//Shared by two polygons (interior edge)
+}BakeEdge;
+
+//Segment of a baked chain: collinear edges of the same material are merged in one
+typedef struct BakeSegment
+{
+	int vertex1;
+	int vertex2;
+	b2Shape* material;				//Polygon giving friction, restitution and filtering
+	std::vector<b2Body*> bodies;	//Bodies it was baked from
+}BakeSegment;
+
+//Index of a welded vertex (vertices closer than tolerance are the same one)
+static int WeldVertex(std::vector<b2Vec2>& vertices, const b2Vec2& vertex, float32 tolerance)
+{
+	//LOOP - Find a vertex close enough (linear search, done once at level load)
+	for(size_t i = 0; i < vertices.size(); ++i)
+	{
+		b2Vec2 distance(vertices[i] - vertex);
+		if(b2Dot(distance,distance) < tolerance * tolerance)
+			return static_cast<int>(i);
+	}//LOOP END
+
+	vertices.push_back(vertex);
+	return static_cast<int>(vertices.size() - 1);
+}
+
+//Edges can be in the same chain without seams (same contact response)
+static bool SameBakeMaterial(b2Shape* shape1, b2Shape* shape2)
+{
+	const b2FilterData& filter1 = shape1->GetFilterData();
+	const b2FilterData& filter2 = shape2->GetFilterData();
+	return (shape1->GetFriction() == shape2->GetFriction()
+			&&
+			shape1->GetRestitution() == shape2->GetRestitution()
+			&&
+			filter1.categoryBits == filter2.categoryBits
+			&&
+			filter1.maskBits == filter2.maskBits
+			&&
+			filter1.groupIndex == filter2.groupIndex);
+}
+
 //******************************PHYSICS MANAGER IMPLEMENTATION************************************
 //Update simulation
 void PhysicsManager::Update(float dt)
@@ -143,6 +483,26 @@ void PhysicsManager::Update(float dt)
 	mBodiesToDestroyVec.clear();
 	//mpContactListener->ListenCollisions(); //Liste to collisions again*/
 
+	//IF - Physics thread: steps handed last frame were done while the game did the rest of the frame
+	if(mpPhysicsThread)
+	{
+		_waitSteps();
+		mThreadStatistics = mThreadCounters;
+		memset(&mThreadCounters,0,sizeof(PhysicsThreadStatistics));
+
+		//IF - No steps handed last frame (results of older steps are not repeated)
+		if(mThreadStatistics.steps == 0)
+		{
+			mPhysicsStepped = false;
+			mTimeStepped = 0.0f;
+		}//IF
+
+		//Commands received while stepping (world can be used now)
+		_runCommands();
+
+		//Rendering is one frame behind: completed steps are the ones handed last frame (time left then)
+		mInterpolationTime = mTimeAccumulator;
+	}//IF
 
 	//---------------------Make advance in the world simulation--------------------
 	//Timestep sync with FPS using fixed timestep for physics engine
@@ -156,77 +516,127 @@ void PhysicsManager::Update(float dt)
 	if(mTimeAccumulator > MAXACCUMTIME)
 		mTimeAccumulator = MAXACCUMTIME;
 
-	mPhysicsStepped = false;
-	mTimeStepped = 0.0f;
-	//LOOP - Step physics any time as needed using fixed timestep
+	//Steps needed using fixed timestep
+	int steps(0);
 	while(mTimeAccumulator >= mTimestepms)
 	{
-		//Recalculate new values for time-stepping
-		mTimeStepped += mTimestepms;
 		mTimeAccumulator -= mTimestepms;
-		
-		//Perform a step of simulation of physics world
-		mpTheWorld->Step(mTimeStep,  //Timestep
-			             mIterations, //Velocity solver iterations
-						 mIterations,   //Position solver iterations
-						 mTimeAccumulator<mTimestepms //Is it necessary to reset forces after step? (No more steps in this update)
-						 );
+		++steps;
+	}
 
-		mPhysicsStepped = true;
-	}//LOOP END
+	//IF - Physics thread: steps are handed to it when game logic of the frame is done (StartSteps).
+	//Stepping results and buffered contacts are the ones of the steps handed last frame
+	if(mpPhysicsThread)
+	{
+		mPendingSteps += steps;
+	}
+	else //ELSE - Steps done now
+	{
+		_stepWorld(steps);
+		//IF - Stepped: rendering interpolates from transforms stored before last step
+		if(steps > 0)
+			mPreviousFront = 1 - mPreviousFront;
+		mInterpolationTime = mTimeAccumulator;
+	}//IF
+
+	//Step profile and counters (world is not in use by physics thread now, overlay shows them in any build)
+	mpTheWorld->GetProfile(&mStepProfile);
+	mpTheWorld->GetAverageProfile(&mAverageStepProfile);
+	mpTheWorld->GetCollideStatistics(&mCollideStatistics);
+	mpTheWorld->GetAllocatorStatistics(&mAllocatorStatistics);
 
-	mpTheWorld->Validate();
 	//---------------------Send collision events-------------------------------
 	//As creator of Box2D suggests, contact points in step of physics simulation are 
 	//buffered for processing now. Points are stored in a custom structure "ContactInfo"
 	//and its state reflects the result of the processing in successive callbacks: new, persistent, deleted
 	//Points in state deleted have to be deleted after processing.
-	ContactPointsMapIterator it;
+	//Buffers are sorted by key first (same order the old map had). Points added while events are sent
+	//(bodies destroyed by event handlers) are not sent: the shapes are already gone
+	mContactPoints.Sort();
+	mContactResults.Sort();
+
+	//Store buffers usage
+	mContactBufferStatistics.points = mContactPoints.GetCount();
+	mContactBufferStatistics.pointscapacity = mContactPoints.GetCapacity();
+	mContactBufferStatistics.results = mContactResults.GetCount();
+	mContactBufferStatistics.resultscapacity = mContactResults.GetCapacity();
+	mContactBufferStatistics.grows = mContactPoints.GetGrowCount() + mContactResults.GetGrowCount();
+	//IF - Buffers had to grow (heap allocations)
+	if(mContactBufferStatistics.grows > 0)
+	{
+		std::stringstream ss;
+		ss<<"Contact buffers grown to "<<mContactBufferStatistics.pointscapacity<<" points and "<<mContactBufferStatistics.resultscapacity<<" results";
+		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::Update",ss.str(),LOGNORMAL);
+	}//IF
 
-	//LOOP - Pass all contact points and generate corresponding event
-	for (it = mContactPoints.begin(); it != mContactPoints.end(); it++)
+	//Store contact callbacks filtering since last update (contacts may be removed between updates too)
+	mContactFilterStatistics = mContactFilterCounters;
+	memset(&mContactFilterCounters,0,sizeof(ContactFilterStatistics));
+
+	//IF - Collisions dispatcher: contacts are delivered grouped by agent
+	if(mpCollisionDispatcher)
+	{
+		//Points of bodies destroyed by collision handlers are not buffered (shapes would be gone when processed)
+		mpContactListener->IgnoreCollisions();
+		mpCollisionDispatcher->DispatchCollisions(mContactPoints,mContactResults);
+		mpContactListener->ListenCollisions();
+
+		//After processing, delete all data for this step
+		mContactPoints.Clear();
+		mContactResults.Clear();
+	}
+	else //ELSE - One event per contact
 	{
-		//Check in which state is the point
-		switch((*it).second.state)
+		int pointscount(mContactPoints.GetSortedCount());
+		//LOOP - Pass all contact points and generate corresponding event
+		for (int i = 0; i < pointscount; ++i)
 		{
-		case ADDED: //The point was added - new collision event
-			{
-				//Call method to send event
-				_sendNewContactEvent((*it).second);		
-			}
-			break;
-		case PERSISTED: //The point was persisting more than one step - persisted collision event
-			{
-				//Call method to send event
-				_sendPersitedContactEvent((*it).second);
-			}
-			break;
-		case REMOVED: //The point was removed - deleted collision event
+			const ContactInfo& info = mContactPoints.GetSortedInfo(i);
+			//Check in which state is the point
+			switch(info.state)
 			{
-				//Call method to send event
-				_sendDeleteContactEvent((*it).second);
+			case ADDED: //The point was added - new collision event
+				{
+					//Call method to send event
+					_sendNewContactEvent(info);		
+				}
+				break;
+			case PERSISTED: //The point was persisting more than one step - persisted collision event
+				{
+					//Call method to send event
+					_sendPersitedContactEvent(info);
+				}
+				break;
+			case REMOVED: //The point was removed - deleted collision event
+				{
+					//Call method to send event
+					_sendDeleteContactEvent(info);
+				}
+				break;
+			case TRIGGERENTER: //Trigger events are only delivered to agents (collisions dispatcher)
+			case TRIGGEREXIT:
+				break;
 			}
-			break;
-		}
-	}//LOOP END
+		}//LOOP END
 	
-	//After processing contact points, delete all data for this step
-	mContactPoints.clear();
+		//After processing contact points, delete all data for this step
+		mContactPoints.Clear();
 
-	//Process contact results
-	ContactResultsMapIterator itr;
-	//LOOP - Process contact results callbacks
-	for (itr = mContactResults.begin(); itr != mContactResults.end(); itr++)
-	{
-		//Assert good state
-		assert((*itr).second.state == RESULT);
+		int resultscount(mContactResults.GetSortedCount());
+		//LOOP - Process contact results callbacks
+		for (int i = 0; i < resultscount; ++i)
+		{
+			const ContactInfo& info = mContactResults.GetSortedInfo(i);
+			//Assert good state
+			assert(info.state == RESULT);
 		
-		//Call method to send event
-		_sendContactResultEvent((*itr).second);		
-	}//LOOP END
+			//Call method to send event
+			_sendContactResultEvent(info);		
+		}//LOOP END
 
-	//After processing contact results, delete all data for this step
-	mContactResults.clear();
+		//After processing contact results, delete all data for this step
+		mContactResults.Clear();
+	}//IF
 
 	//---------------------Send "out of limits" events----------------------------
 	OutofBoundsVecIterator boditr;
@@ -244,9 +654,405 @@ void PhysicsManager::Update(float dt)
 //Debug render call
 void PhysicsManager::DebugRender()
 {
+	//IF - No debug draw (dont wait for physics thread)
+	if(!mDebugDraw)
+		return;
+
+	WaitForSteps();
 	mpTheWorld->DrawDebugData();
 }
 
+//Hand steps to physics thread (game logic of frame done)
+void PhysicsManager::StartSteps()
+{
+	//IF - No physics thread or no steps to do
+	if(!mpPhysicsThread || mPendingSteps == 0)
+		return;
+
+	assert(!mStepping);
+
+	//State when steps are handed is the first frame of the batch (bodies created or moved in update are there).
+	//Last step published by the thread is read before: its transforms before the step are kept to interpolate
+	mpStepSnapshot->Read();
+	++mBatch;
+	mpStepSnapshot->Publish(mpTheWorld,mBatch,0,mPendingSteps);
+	mpStepSnapshot->Read();
+
+	mThreadCounters.steps += mPendingSteps;
+	mpPhysicsThread->BeginSteps(mPendingSteps);
+	mPendingSteps = 0;
+	mStepping = true;
+}
+
+//Returns when physics thread is done (world can be used)
+void PhysicsManager::WaitForSteps()
+{
+	//IF - Physics thread stepping
+	if(mStepping)
+	{
+		++mThreadCounters.syncs;
+		_waitSteps();
+	}//IF
+}
+
+//Command event handled by handler in next update (world can be used then)
+void PhysicsManager::QueueCommand(EventDataPointer const& command, IEventListener* handler)
+{
+	assert(handler);
+	QueuedCommand queued;
+	queued.command = command;
+	queued.handler = handler;
+	mCommands.push_back(queued);
+	++mThreadCounters.commands;
+}
+
+//Newest step done by physics thread is read, never waits (once per rendered frame). False if none newer
+bool PhysicsManager::ReadStepSnapshot()
+{
+	//IF - Physics thread not stepping (world is read)
+	if(!mStepping)
+		return false;
+
+	//IF - No step published since last read
+	if(!mpStepSnapshot->Read())
+		return false;
+
+	++mThreadCounters.reads;
+	return true;
+}
+
+//Last completed transform of body (while physics thread steps: step snapshot read)
+b2XForm PhysicsManager::GetBodyTransform(b2Body* body) const
+{
+	assert(body);
+	//IF - World not in use by physics thread
+	if(!mStepping)
+		return body->GetXForm();
+
+	const StepBody* state = mpStepSnapshot->FindBody(body);
+	//IF - Published by physics thread (or when steps were handed)
+	if(state)
+		return state->xform;
+
+	//Static bodies are not stored (steps dont move them)
+	assert(body->IsStatic());
+	return body->GetXForm();
+}
+
+//Touching contacts of a dynamic body after last completed step (appended, returns number found)
+int PhysicsManager::GetBodyContacts(b2Body* body, std::vector<StepContact>& contacts) const
+{
+	assert(body);
+	//IF - Physics thread stepping: contacts of step snapshot read
+	if(mStepping)
+		return mpStepSnapshot->GetBodyContacts(body,contacts);
+
+	return PhysicsStepSnapshot::AddWorldContacts(mpTheWorld,body,contacts);
+}
+
+//Time of rendered frame between last two physics steps (0-1)
+float32 PhysicsManager::GetInterpolationFactor() const
+{
+	float32 time (mInterpolationTime);
+	//IF - Physics thread stepping: time depends on the step read (when steps were handed it is the one left before them)
+	if(mStepping)
+	{
+		const StepFrame& frame (mpStepSnapshot->GetFrame());
+		//IF - Last step of batch: time left after the steps handed
+		if(frame.step == frame.steps)
+			time = mTimeAccumulator;
+		else if(frame.step > 0) //ELSE - Step in the middle of batch: shown as it is
+			time = mTimestepms;
+	}//IF
+
+	float32 alpha (time / mTimestepms);
+	return b2Clamp(alpha,0.0f,1.0f);
+}
+
+//Transform of body to render (between last two physics steps)
+b2XForm PhysicsManager::GetInterpolatedTransform(b2Body* body) const
+{
+	b2XForm current;
+	b2XForm last;
+	//IF - Physics thread stepping: transforms before and after the step read
+	if(mStepping)
+	{
+		const StepBody* state = mpStepSnapshot->FindBody(body);
+		//IF - Static body (steps dont move it)
+		if(!state)
+			return GetBodyTransform(body);
+		current = state->xform;
+		last = state->previous;
+	}
+	else //ELSE - Transforms stored before last step
+	{
+		current = body->GetXForm();
+		BodyTransform tofind;
+		tofind.body = body;
+		const std::vector<BodyTransform>& previous (mPreviousTransforms[mPreviousFront]);
+		std::vector<BodyTransform>::const_iterator itr = std::lower_bound(previous.begin(),previous.end(),tofind);
+		//IF - Body didnt move in last step (sleeping, static or new)
+		if(itr == previous.end() || (*itr).body != body)
+			return current;
+		last = (*itr).xform;
+	}//IF
+
+	float32 alpha (GetInterpolationFactor());
+	b2XForm interpolated;
+	interpolated.position = (1.0f - alpha) * last.position + alpha * current.position;
+	//Rotate by shortest angle
+	float32 lastangle (last.R.GetAngle());
+	float32 rotation (current.R.GetAngle() - lastangle);
+	if(rotation > b2_pi)
+		rotation -= 2.0f * b2_pi;
+	else if(rotation < -b2_pi)
+		rotation += 2.0f * b2_pi;
+	interpolated.R.Set(lastangle + alpha * rotation);
+
+	return interpolated;
+}
+
+//Steps of simulation (in update or physics thread)
+void PhysicsManager::_stepWorld(int steps)
+{
+	mPhysicsStepped = false;
+	mTimeStepped = 0.0f;
+	memset(&mTOIStatistics,0,sizeof(b2TOIStatistics));
+	memset(&mIterationStatistics,0,sizeof(b2IterationStatistics));
+	memset(&mTriggerStatistics,0,sizeof(b2TriggerStatistics));
+	//LOOP - Step physics any time as needed using fixed timestep
+	for(int i = 0; i < steps; ++i)
+	{
+		//Recalculate new values for time-stepping
+		mTimeStepped += mTimestepms;
+
+		//IF - Last step: store transforms before it (rendering interpolates)
+		if(i == steps - 1)
+			_storePreviousTransforms();
+		//IF - Physics thread: transforms before step are published with the state after it
+		if(mpStepSnapshot)
+		{
+			b2Timer timer;
+			mpStepSnapshot->BeginStep(mpTheWorld);
+			mThreadPublishTime += timer.GetMilliseconds();
+		}//IF
+		
+		//Perform a step of simulation of physics world
+		mpTheWorld->Step(mTimeStep,  //Timestep
+			             mIterations, //Velocity solver iterations
+						 mIterations,   //Position solver iterations
+						 i == steps - 1 //Is it necessary to reset forces after step? (No more steps in this update)
+						 );
+
+		//IF - Physics thread: state after step is published (game reads it while next steps are done)
+		if(mpStepSnapshot)
+		{
+			b2Timer timer;
+			mpStepSnapshot->Publish(mpTheWorld,mBatch,i + 1,steps);
+			mThreadPublishTime += timer.GetMilliseconds();
+		}//IF
+
+		//Sum continuous collision counters of the step
+		b2TOIStatistics toistats;
+		mpTheWorld->GetTOIStatistics(&toistats);
+		mTOIStatistics.eventCount += toistats.eventCount;
+		mTOIStatistics.computeCount += toistats.computeCount;
+		mTOIStatistics.maxQueueCount = b2Max(mTOIStatistics.maxQueueCount,toistats.maxQueueCount);
+		mTOIStatistics.time += toistats.time;
+		//Sum islands iterations of the step
+		b2IterationStatistics iterationstats;
+		mpTheWorld->GetIterationStatistics(&iterationstats);
+		//LOOP - Island classes
+		for(int j = 0; j < e_islandClassCount; ++j)
+		{
+			mIterationStatistics.islandCount[j] += iterationstats.islandCount[j];
+			mIterationStatistics.velocityIterations[j] += iterationstats.velocityIterations[j];
+			mIterationStatistics.positionIterations[j] += iterationstats.positionIterations[j];
+		}//LOOP END
+		//LOOP - Histogram bins
+		for(int j = 0; j < b2_iterationHistogramSize; ++j)
+		{
+			mIterationStatistics.velocityHistogram[j] += iterationstats.velocityHistogram[j];
+			mIterationStatistics.positionHistogram[j] += iterationstats.positionHistogram[j];
+		}//LOOP END
+		//Sum trigger pairs counters of the step
+		b2TriggerStatistics triggerstats;
+		mpTheWorld->GetTriggerStatistics(&triggerstats);
+		mTriggerStatistics.pairCount = triggerstats.pairCount;
+		mTriggerStatistics.testedCount += triggerstats.testedCount;
+		mTriggerStatistics.enterCount += triggerstats.enterCount;
+		mTriggerStatistics.exitCount += triggerstats.exitCount;
+		mTriggerStatistics.time += triggerstats.time;
+		++mContactFilterCounters.steps;
+
+		mPhysicsStepped = true;
+	}//LOOP END
+
+	//IF - Physics stepped: count awake and sleeping bodies (a resting level should have almost no awake bodies)
+	if(mPhysicsStepped)
+	{
+		mAwakeBodiesCount = 0;
+		mSleepingBodiesCount = 0;
+		//LOOP - Dynamic bodies only
+		for(b2Body* body = mpTheWorld->GetBodyList(); body; body = body->GetNext())
+		{
+			if(body->IsStatic())
+				continue;
+			if(body->IsSleeping())
+				++mSleepingBodiesCount;
+			else
+				++mAwakeBodiesCount;
+		}//LOOP END
+	}//IF
+
+	#ifdef _DEBUGGING
+	//Debug: world structures validated some steps only (slow)
+	mValidateCounter += steps;
+	if(mValidateCounter >= VALIDATESTEPS)
+	{
+		mValidateCounter = 0;
+		mpTheWorld->Validate();
+	}//IF
+	#endif
+}
+
+//Transforms of moving bodies before last step (rendering interpolates)
+void PhysicsManager::_storePreviousTransforms()
+{
+	//Buffer not read by rendering (physics thread can be stepping)
+	std::vector<BodyTransform>& previous (mPreviousTransforms[1 - mPreviousFront]);
+	previous.clear();
+	//LOOP - Awake dynamic bodies only
+	for(b2Body* body = mpTheWorld->GetBodyList(); body; body = body->GetNext())
+	{
+		if(body->IsStatic() || body->IsSleeping() || body->IsFrozen())
+			continue;
+		BodyTransform transform;
+		transform.body = body;
+		transform.xform = body->GetXForm();
+		previous.push_back(transform);
+	}//LOOP END
+	std::sort(previous.begin(),previous.end());
+}
+
+//Steps in physics thread (step time is measured)
+void PhysicsManager::_threadSteps(void* context, int steps)
+{
+	PhysicsManager* manager = static_cast<PhysicsManager*>(context);
+	manager->mThreadPublishTime = 0.0f;
+	b2Timer timer;
+	manager->_stepWorld(steps);
+	manager->mThreadStepTime = timer.GetMilliseconds();
+}
+
+//Physics thread creation
+void PhysicsManager::_startPhysicsThread()
+{
+	assert(!mpPhysicsThread);
+	mpPhysicsThread = new PhysicsThread(_threadSteps,this);
+	//IF - Thread not created
+	if(!mpPhysicsThread->IsRunning())
+	{
+		delete mpPhysicsThread;
+		mpPhysicsThread = NULL;
+		throw GenericException("Physics thread could not be created",GenericException::LIBRARY_ERROR);
+	}//IF
+	mpStepSnapshot = new PhysicsStepSnapshot();
+
+	SingletonLogMgr::Instance()->AddNewLine("PhysicsManager","Physics thread started",LOGNORMAL);
+}
+
+//Physics thread deletion (steps in course are finished)
+void PhysicsManager::_stopPhysicsThread()
+{
+	//IF - Physics thread exists
+	if(mpPhysicsThread)
+	{
+		_waitSteps();
+		delete mpPhysicsThread;
+		mpPhysicsThread = NULL;
+		delete mpStepSnapshot;
+		mpStepSnapshot = NULL;
+
+		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager","Physics thread finished",LOGNORMAL);
+	}//IF
+}
+
+//Wait for physics thread and count times
+void PhysicsManager::_waitSteps()
+{
+	//IF - Nothing to wait
+	if(!mStepping)
+		return;
+
+	b2Timer timer;
+	mpPhysicsThread->WaitSteps();
+	mStepping = false;
+	mPreviousFront = 1 - mPreviousFront;	//Previous transforms written by steps are read now
+	mThreadCounters.waittime += timer.GetMilliseconds();
+	mThreadCounters.steptime += mThreadStepTime;
+	mThreadCounters.publishtime += mThreadPublishTime;
+}
+
+//Handle commands received while stepping. Only the listener which queued a command handles it: the
+//other listeners of the event had it when it was triggered
+void PhysicsManager::_runCommands()
+{
+	assert(!mStepping);
+	//IF - No commands
+	if(mCommands.empty())
+		return;
+
+	//LOOP - Handle every command in order received (not stepping: handlers dont queue more)
+	for(size_t i = 0; i < mCommands.size(); ++i)
+	{
+		mCommands[i].handler->HandleEvent(*mCommands[i].command);
+	}//LOOP END
+
+	mCommands.clear();
+}
+
+//Edges baked from a body are destroyed with it (edges merged from more bodies stay for the others)
+void PhysicsManager::_destroyBakedShapes(b2Body* sourcebody)
+{
+	//IF - Baked geometry body destroyed: all edges are gone
+	if(sourcebody == mpBakedBody)
+	{
+		//LOOP - Bodies baked are not pointed anymore
+		for(b2Shape* shape = mpBakedBody->GetShapeList(); shape; shape = shape->GetNext())
+			shape->SetUserData(NULL);
+		mBakedShapes.clear();
+		mpBakedBody = NULL;
+		return;
+	}//IF
+
+	BakedShapesMapIterator itr = mBakedShapes.find(sourcebody);
+	//IF - Body not baked
+	if(itr == mBakedShapes.end())
+		return;
+
+	std::vector<b2Shape*> shapes;
+	shapes.swap((*itr).second);
+	mBakedShapes.erase(itr);
+
+	//LOOP - Destroy edges only this body had
+	for(std::vector<b2Shape*>::iterator shapeitr = shapes.begin(); shapeitr != shapes.end(); ++shapeitr)
+	{
+		b2Body* otherbody(NULL);
+		//LOOP - Find other body baked in this edge
+		for(itr = mBakedShapes.begin(); itr != mBakedShapes.end() && !otherbody; ++itr)
+		{
+			if(std::find((*itr).second.begin(),(*itr).second.end(),*shapeitr) != (*itr).second.end())
+				otherbody = (*itr).first;
+		}//LOOP END
+
+		if(otherbody)
+			(*shapeitr)->SetUserData(otherbody);
+		else
+			mpBakedBody->DestroyShape(*shapeitr);
+	}//LOOP END
+}
+
 //Get a body and return its pointer
 b2Body* PhysicsManager::GetBody(const std::string &name)
 {
@@ -299,6 +1105,7 @@ b2Joint* PhysicsManager::GetJoint(const std::string &name)
 //Create a body given some parameters preconstructed
 b2Body *PhysicsManager::CreateBody(const b2BodyDef* definition,const std::string& name)
 {
+	WaitForSteps();
 	//Be sure body doesnt exist already
 	PhysBodiesMapIterator itr = mBodiesMap.find(name);
 
@@ -308,6 +1115,16 @@ b2Body *PhysicsManager::CreateBody(const b2BodyDef* definition,const std::string
 		b2Body* newbody = mpTheWorld->CreateBody(definition);
 		//Add it to maps
 		mBodiesMap[name] = newbody;
+		//Body could have memory of a destroyed one: it has no previous transform
+		BodyTransform tofind;
+		tofind.body = newbody;
+		std::vector<BodyTransform>& previous (mPreviousTransforms[mPreviousFront]);
+		std::vector<BodyTransform>::iterator previtr = std::lower_bound(previous.begin(),previous.end(),tofind);
+		if(previtr != previous.end() && (*previtr).body == newbody)
+			previous.erase(previtr);
+		if(mpStepSnapshot)
+			mpStepSnapshot->ForgetBody(newbody);
+		mSnapshotValid = false;	//World changed
 		return newbody;
 	}
 	else
@@ -321,6 +1138,7 @@ b2Body *PhysicsManager::CreateBody(const b2BodyDef* definition,const std::string
 //Destroy a body by name
 void PhysicsManager::DestroyBody(const std::string& name)
 {
+	WaitForSteps();
 	//First find requested body
 	PhysBodiesMapIterator itr = mBodiesMap.find(name);
 	
@@ -328,8 +1146,10 @@ void PhysicsManager::DestroyBody(const std::string& name)
 	if(itr != mBodiesMap.end())
 	{
 		//mBodiesToDestroyVec.push_back((*itr).second);//Push pointer to container to-delete
+		_destroyBakedShapes((*itr).second);
 		mpTheWorld->DestroyBody((*itr).second); //Destroy directly a body, box2d stores active and to-delete bodies internally
 		mBodiesMap.erase(itr); //Delete reference in active bodies
+		mSnapshotValid = false;	//World changed
 	}
 	else //ELSE - Body not found
 		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::DestroyBody","Error: intent to destroy non-existent body: " + name,LOGEXCEPTION);
@@ -340,6 +1160,7 @@ void PhysicsManager::DestroyBody(const std::string& name)
 //Destroy body by pointer
 void PhysicsManager::DestroyBody(b2Body* bodypointer)
 {
+	WaitForSteps();
 	//First be sure requested body pointer exists
 	PhysBodiesMapIterator itr;
 	bool found = false;
@@ -351,8 +1172,10 @@ void PhysicsManager::DestroyBody(b2Body* bodypointer)
 		{
 			found = true;
 			//mBodiesToDestroyVec.push_back((*itr).second);//Push pointer to container to-delete
+			_destroyBakedShapes((*itr).second);
 			mpTheWorld->DestroyBody((*itr).second);  //Destroy directly a body, box2d stores active and to-delete bodies internally
 			mBodiesMap.erase(itr); //Delete reference in active bodies
+			mSnapshotValid = false;	//World changed
 			break;
 		}
 	}//LOOP END
@@ -368,12 +1191,14 @@ void PhysicsManager::DestroyBody(b2Body* bodypointer)
 //Create a circular shape
 void PhysicsManager::CreateCircleShape(b2CircleDef* definition, const std::string &bodyname)
 {
+	WaitForSteps();
 	PhysBodiesMapIterator itr = mBodiesMap.find(bodyname);
 
 	if(itr != mBodiesMap.end())
 	{
 		//Add shape to body
 		(*itr).second->CreateShape(definition);
+		mSnapshotValid = false;	//World changed
 	}
 	else
 		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::CreateCircleShape","Error: intent to create shape to non-existent body: " + bodyname,LOGEXCEPTION);
@@ -382,6 +1207,7 @@ void PhysicsManager::CreateCircleShape(b2CircleDef* definition, const std::strin
 //Create a polygonal shape
 void PhysicsManager::CreatePolygonShape(b2PolygonDef* definition, const std::string &bodyname)
 {
+	WaitForSteps();
 	if(definition->vertexCount > b2_maxPolygonVertices)
 		throw GenericException("Encountered a polygon definition with too many vertexs",GenericException::INVALIDPARAMS);
 	
@@ -393,6 +1219,7 @@ void PhysicsManager::CreatePolygonShape(b2PolygonDef* definition, const std::str
 	{
 		//Add shape to body
 		(*itr).second->CreateShape(definition);
+		mSnapshotValid = false;	//World changed
 	}
 	else
 		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::CreatePolygonShape","Error: intent to create shape to non-existent body: " + bodyname,LOGEXCEPTION);
@@ -402,6 +1229,7 @@ void PhysicsManager::CreatePolygonShape(b2PolygonDef* definition, const std::str
 //Destroy a given shape from its parent body
 void PhysicsManager::DestroyShape(b2Shape* theshape, const std::string& parentbodyname)
 {
+	WaitForSteps();
 	//First find requested body
 	PhysBodiesMapIterator itr = mBodiesMap.find(parentbodyname);
 	
@@ -409,6 +1237,7 @@ void PhysicsManager::DestroyShape(b2Shape* theshape, const std::string& parentbo
 	{
 		//Delete it
 		(*itr).second->DestroyShape(theshape);
+		mSnapshotValid = false;	//World changed
 	}
 	else
 		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::DestroyShape","Error: intent to destroy shape in non-existent body: " + parentbodyname,LOGEXCEPTION);
@@ -417,19 +1246,23 @@ void PhysicsManager::DestroyShape(b2Shape* theshape, const std::string& parentbo
 //Create a mouse joint; only one can exist, attached to a body
 void PhysicsManager::CreateMouseJoint(b2MouseJointDef* jointdef)
 {	
+	WaitForSteps();
 	//Add first anchor body to mousejoint
 	jointdef->body1 = mpTheWorld->GetGroundBody();
 	mJointsMap[MouseJointName] = mpTheWorld->CreateJoint(jointdef);
+	mSnapshotValid = false;	//World changed
 }
 
 //Destroy the only mouse joint
 void PhysicsManager::DestroyMouseJoint()
 {
+	WaitForSteps();
 	//Check mouse joint really exists
 	JointsMapIterator itr = mJointsMap.find(MouseJointName);
 	if(itr != mJointsMap.end())
 	{
 		mpTheWorld->DestroyJoint((*itr).second);
+		mSnapshotValid = false;	//World changed
 		mJointsMap.erase(itr);
 	}
 	else
@@ -439,6 +1272,7 @@ void PhysicsManager::DestroyMouseJoint()
 //Create a distance joint
 bool PhysicsManager::CreateDistanceJoint(b2DistanceJointDef* definition, const std::string &jointname, const std::string& body1, const std::string& body2, const b2Vec2& worldpoint1, const b2Vec2& worldpoint2)
 {
+	WaitForSteps();
 	//Name of joint has to be coherent
 	JointsMapIterator jointitr = mJointsMap.find(jointname);
 	//IF - Name of joint is not correct
@@ -459,6 +1293,7 @@ bool PhysicsManager::CreateDistanceJoint(b2DistanceJointDef* definition, const s
 			//Modify params and create body
 			definition->Initialize((*itrbody1).second,(*itrbody2).second,worldpoint1,worldpoint2);
 			b2Joint* newjoint = mpTheWorld->CreateJoint(definition);
+			mSnapshotValid = false;	//World changed
 			if(newjoint)
 				mJointsMap[jointname] = newjoint;	
 			else 
@@ -474,6 +1309,7 @@ bool PhysicsManager::CreateDistanceJoint(b2DistanceJointDef* definition, const s
 //Create a revolute joint
 bool PhysicsManager::CreateRevoluteJoint(b2RevoluteJointDef* definition, const std::string &jointname, const std::string& body1, const std::string& body2, const b2Vec2& worldpoint)
 {
+	WaitForSteps();
 	//Name of joint has to be coherent
 	JointsMapIterator jointitr = mJointsMap.find(jointname);
 	//IF - Name of joint is not correct
@@ -511,6 +1347,7 @@ bool PhysicsManager::CreateRevoluteJoint(b2RevoluteJointDef* definition, const s
 
 			definition->Initialize(body1ptr,body2ptr,worldpoint);
 			b2Joint* newjoint = mpTheWorld->CreateJoint(definition);
+			mSnapshotValid = false;	//World changed
 			if(newjoint)
 				mJointsMap[jointname] = newjoint;
 			else 
@@ -526,6 +1363,7 @@ bool PhysicsManager::CreateRevoluteJoint(b2RevoluteJointDef* definition, const s
 //Create a prismatic joint
 bool PhysicsManager::CreatePrismaticJoint(b2PrismaticJointDef* definition, const std::string &jointname, const std::string& body1, const std::string& body2, const b2Vec2& worldpoint, const b2Vec2& axis)
 {
+	WaitForSteps();
 	//Name of joint has to be coherent
 	JointsMapIterator jointitr = mJointsMap.find(jointname);
 	//IF - Name of joint is not correct
@@ -546,6 +1384,7 @@ bool PhysicsManager::CreatePrismaticJoint(b2PrismaticJointDef* definition, const
 			//Modify params and create body
 			definition->Initialize((*itrbody1).second,(*itrbody2).second,worldpoint,axis);
 			b2Joint* newjoint = mpTheWorld->CreateJoint(definition);
+			mSnapshotValid = false;	//World changed
 
 			if(newjoint)
 				mJointsMap[jointname] = newjoint;
@@ -562,6 +1401,7 @@ bool PhysicsManager::CreatePrismaticJoint(b2PrismaticJointDef* definition, const
 //Create a Pulley joint
 bool PhysicsManager::CreatePulleyJoint(b2PulleyJointDef* definition, const std::string &jointname, const std::string& body1, const std::string& body2)
 {
+	WaitForSteps();
 	//Name of joint has to be coherent
 	JointsMapIterator jointitr = mJointsMap.find(jointname);
 	//IF - Name of joint is not correct
@@ -583,6 +1423,7 @@ bool PhysicsManager::CreatePulleyJoint(b2PulleyJointDef* definition, const std::
 			definition->body1 = (*itrbody1).second;
 			definition->body2 = (*itrbody2).second;
 			b2Joint* newjoint = mpTheWorld->CreateJoint(definition);
+			mSnapshotValid = false;	//World changed
 			if(newjoint)
 				mJointsMap[jointname] = newjoint;
 			else
@@ -598,77 +1439,308 @@ bool PhysicsManager::CreatePulleyJoint(b2PulleyJointDef* definition, const std::
 //Destroy any joint by name
 void PhysicsManager::DestroyJoint(const std::string& jointname)
 {
+	WaitForSteps();
 	//Check mouse joint really exists
 	JointsMapIterator itr = mJointsMap.find(jointname);
 	if(itr != mJointsMap.end())
 	{
 		mpTheWorld->DestroyJoint((*itr).second);
+		mSnapshotValid = false;	//World changed
 		mJointsMap.erase(itr);
 	}
 	else
 		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::DestroyMouseJoint","Error: intent to destroy non-existent joint!: " + jointname,LOGEXCEPTION);
 }
 
-//Query for bodies in a point (through AABB)
-b2Body* PhysicsManager::QueryforBodies(const b2Vec2 &thepoint, bool includestatic)
+//Create a controller (world steps it before solving bodies)
+b2Controller* PhysicsManager::CreateController(b2ControllerDef* definition)
 {
-	// Query the world for overlapping shapes with a point (very small aabb)
-	
-	// Make a small box to query
-	b2AABB aabb;
-	b2Vec2 d(0.001f, 0.001f);
-	aabb.lowerBound = thepoint - d;
-	aabb.upperBound = thepoint + d;
+	WaitForSteps();
+	assert(definition);
+	mSnapshotValid = false;	//World changed
+	return mpTheWorld->CreateController(definition);
+}
 
-	//Create a list of maximum number of shapes to find
-	b2Shape* shapes[MAXFOUNDSHAPES];
-	int32 count = mpTheWorld->Query(aabb, shapes, MAXFOUNDSHAPES);
-	b2Body* body = NULL;
-	//LOOP - Search every result
-	for (int i = 0; i < count; ++i)
+//Destroy a controller (bodies attached are not destroyed)
+void PhysicsManager::DestroyController(b2Controller* controller)
+{
+	WaitForSteps();
+	assert(controller);
+	mpTheWorld->DestroyController(controller);
+	mSnapshotValid = false;	//World changed
+}
+
+//Merge polygons of static bodies in edge chains: interior edges are dropped
+int PhysicsManager::BakeStaticBodies(const std::vector<std::string>& bodynames)
+{
+	WaitForSteps();
+	b2Timer timer;
+	const float32 tolerance(b2_linearSlop);	//Vertices closer than this are welded
+	int proxiesbefore(mpTheWorld->GetProxyCount());
+
+	std::vector<b2Body*> bakedbodies;
+	std::vector<b2Vec2> vertices;	//Welded vertices (world coordinates)
+	std::vector<BakeEdge> edges;
+	int polygons(0);
+
+	//LOOP - Take edges of polygons of static bodies
+	std::vector<std::string>::const_iterator nameitr;
+	for(nameitr = bodynames.begin(); nameitr != bodynames.end(); ++nameitr)
 	{
-		b2Body* shapeBody = shapes[i]->GetBody();
-		if ((!shapeBody->IsStatic()&& shapeBody->GetMass() > 0.0f && !includestatic)
-			 ||
-			 includestatic)
+		PhysBodiesMapIterator itr = mBodiesMap.find(*nameitr);
+		if(itr == mBodiesMap.end())
+		{
+			SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::BakeStaticBodies","Error: intent to bake non-existent body: " + (*nameitr),LOGEXCEPTION);
+			continue;
+		}
+		b2Body* body = (*itr).second;
+
+		//Only static bodies made of solid polygons (circles and sensors keep their own body)
+		bool bakeable(body->IsStatic() && body->GetShapeList() && body != mpBakedBody && mBakedShapes.find(body) == mBakedShapes.end());
+		for(b2Shape* shape = body->GetShapeList(); shape && bakeable; shape = shape->GetNext())
+			bakeable = (shape->GetType() == e_polygonShape && !shape->IsSensor());
+		if(!bakeable)
+			continue;
+
+		bakedbodies.push_back(body);
+		const b2XForm& xf = body->GetXForm();
+		//LOOP - Edges of polygons in world coordinates
+		for(b2Shape* shape = body->GetShapeList(); shape; shape = shape->GetNext())
 		{
-			bool inside = shapes[i]->TestPoint(shapeBody->GetXForm(), thepoint);
-			if (inside)
+			const b2PolygonShape* polygon = static_cast<const b2PolygonShape*>(shape);
+			const b2Vec2* localvertices = polygon->GetVertices();
+			int32 count = polygon->GetVertexCount();
+			int firstvertex = WeldVertex(vertices,b2Mul(xf,localvertices[0]),tolerance);
+			int vertex1 = firstvertex;
+			for(int32 i = 1; i <= count; ++i)
 			{
-				body = shapes[i]->GetBody();
-				return body;
+				int vertex2 = (i == count) ? firstvertex : WeldVertex(vertices,b2Mul(xf,localvertices[i]),tolerance);
+				//IF - Not collapsed by welding
+				if(vertex1 != vertex2)
+				{
+					BakeEdge edge = {vertex1,vertex2,shape,false};
+					edges.push_back(edge);
+				}
+				vertex1 = vertex2;
 			}
-		}
+			++polygons;
+		}//LOOP END
 	}//LOOP END
 
-	return NULL;
-}
+	//IF - Nothing to bake
+	if(bakedbodies.empty())
+		return 0;
 
-//Query for bodies inside AABB
-std::vector<b2Body*> PhysicsManager::QueryforBodies(const b2AABB &boundingbox, bool includestatic)
-{
-	//Vector to return
-	std::vector<b2Body*> bodiesvector;
-	//Create a list of maximum number of shapes to find
-	b2Shape* shapes[MAXFOUNDSHAPES];
-	int32 count = mpTheWorld->Query(boundingbox, shapes, MAXFOUNDSHAPES);
+	//LOOP - Split edges where a vertex of other polygon lies on them (so shared parts match)
+	std::vector<BakeEdge> splitedges;
+	splitedges.reserve(edges.size());
+	for(std::vector<BakeEdge>::iterator edgeitr = edges.begin(); edgeitr != edges.end(); ++edgeitr)
+	{
+		b2Vec2 start(vertices[(*edgeitr).vertex1]);
+		b2Vec2 direction(vertices[(*edgeitr).vertex2] - start);
+		float32 length2(b2Dot(direction,direction));
+		std::vector<std::pair<float32,int> > onedge;
+		for(size_t i = 0; i < vertices.size(); ++i)
+		{
+			int vertex(static_cast<int>(i));
+			if(vertex == (*edgeitr).vertex1 || vertex == (*edgeitr).vertex2)
+				continue;
+			b2Vec2 relative(vertices[i] - start);
+			float32 fraction(b2Dot(relative,direction) / length2);
+			b2Vec2 distance(relative - fraction * direction);
+			if(fraction > 0.0f && fraction < 1.0f && b2Dot(distance,distance) < tolerance * tolerance)
+				onedge.push_back(std::pair<float32,int>(fraction,vertex));
+		}
+		std::sort(onedge.begin(),onedge.end());
 
-	//LOOP - Append results to return vector
-	for(int i = 0; i < count; ++i)
+		BakeEdge piece = (*edgeitr);
+		for(size_t i = 0; i < onedge.size(); ++i)
+		{
+			piece.vertex2 = onedge[i].second;
+			splitedges.push_back(piece);
+			piece.vertex1 = piece.vertex2;
+		}
+		piece.vertex2 = (*edgeitr).vertex2;
+		splitedges.push_back(piece);
+	}//LOOP END
+	edges.swap(splitedges);
+
+	//LOOP - Drop edges shared by two polygons (same vertices, opposite directions): they are interior
+	std::map<std::pair<int,int>,int> unpaired;
+	for(size_t i = 0; i < edges.size(); ++i)
 	{
-		b2Body* shapebody(shapes[i]->GetBody());
-		if ((shapebody->IsDynamic()&& shapebody->GetMass() > 0.0f && !includestatic)
-			 ||
-			 includestatic)
+		std::map<std::pair<int,int>,int>::iterator twinitr = unpaired.find(std::pair<int,int>(edges[i].vertex2,edges[i].vertex1));
+		if(twinitr != unpaired.end())
 		{
-			bodiesvector.push_back(shapebody);
+			edges[i].removed = true;
+			edges[(*twinitr).second].removed = true;
+			unpaired.erase(twinitr);
 		}
+		else
+			unpaired.insert(std::pair<std::pair<int,int>,int>(std::pair<int,int>(edges[i].vertex1,edges[i].vertex2),static_cast<int>(i)));
+	}//LOOP END
+
+	//Outline edges going out and coming in each vertex
+	std::vector<std::vector<int> > outgoing(vertices.size());
+	std::vector<int> incoming(vertices.size(),0);
+	for(size_t i = 0; i < edges.size(); ++i)
+	{
+		if(edges[i].removed)
+			continue;
+		outgoing[edges[i].vertex1].push_back(static_cast<int>(i));
+		++incoming[edges[i].vertex2];
 	}
-	//LOOP END
 
+	//Body for baked geometry
+	if(!mpBakedBody)
+	{
+		b2BodyDef bakeddef;
+		mpBakedBody = CreateBody(&bakeddef,BakedGeometryName);
+		if(!mpBakedBody)
+			throw GenericException("Static geometry could not be baked (body name used): " + BakedGeometryName,GenericException::INVALIDPARAMS);
+	}
+
+	//LOOP - Build chains following the outline: open ones first (from vertices with more edges going out than in), then loops
+	int edgescount(0);
+	int chainscount(0);
+	std::vector<BakeSegment> segments;
+	std::vector<b2Vec2> chainvertices;
+	for(int pass = 0; pass < 2; ++pass)
+	{
+		for(size_t startvertex = 0; startvertex < vertices.size(); ++startvertex)
+		{
+			while(!outgoing[startvertex].empty()
+				  &&
+				  (pass == 1 || static_cast<int>(outgoing[startvertex].size()) > incoming[startvertex]))
+			{
+				segments.clear();
+				int current(static_cast<int>(startvertex));
+				//LOOP - Follow edges until the chain ends or closes
+				do
+				{
+					const BakeEdge& edge = edges[outgoing[current].back()];
+					outgoing[current].pop_back();
+					--incoming[edge.vertex2];
+
+					bool merged(false);
+					//IF - Nothing else joins here: collinear edge of the same material extends previous segment
+					if(!segments.empty() && outgoing[current].empty() && incoming[current] == 0 && SameBakeMaterial(segments.back().material,edge.source))
+					{
+						BakeSegment& previous = segments.back();
+						b2Vec2 direction(vertices[edge.vertex2] - vertices[previous.vertex1]);
+						float32 length(direction.Length());
+						float32 offset(b2Cross(direction,vertices[current] - vertices[previous.vertex1]));
+						if(length > B2_FLT_EPSILON && b2Abs(offset) < tolerance * length && b2Dot(direction,vertices[current] - vertices[previous.vertex1]) > 0.0f)
+						{
+							previous.vertex2 = edge.vertex2;
+							if(std::find(previous.bodies.begin(),previous.bodies.end(),edge.source->GetBody()) == previous.bodies.end())
+								previous.bodies.push_back(edge.source->GetBody());
+							merged = true;
+						}
+					}//IF
+					if(!merged)
+					{
+						BakeSegment segment;
+						segment.vertex1 = edge.vertex1;
+						segment.vertex2 = edge.vertex2;
+						segment.material = edge.source;
+						segment.bodies.push_back(edge.source->GetBody());
+						segments.push_back(segment);
+					}
+					current = edge.vertex2;
+				}while(current != static_cast<int>(startvertex) && !outgoing[current].empty());
+				//LOOP END
+
+				//A loop needs 3 edges, and one material (chains are split where material changes)
+				bool loop(current == static_cast<int>(startvertex) && segments.size() > 2);
+				for(size_t i = 1; i < segments.size() && loop; ++i)
+					loop = SameBakeMaterial(segments[i].material,segments[0].material);
+
+				//LOOP - Create chains of segments with the same material
+				size_t first(0);
+				while(first < segments.size())
+				{
+					size_t last(first + 1);
+					while(last < segments.size() && SameBakeMaterial(segments[last].material,segments[first].material))
+						++last;
+
+					chainvertices.clear();
+					if(!loop)
+						chainvertices.push_back(vertices[segments[first].vertex1]);
+					for(size_t i = first; i < last; ++i)
+						chainvertices.push_back(vertices[segments[i].vertex2]);
+
+					b2EdgeChainDef chaindef;
+					chaindef.vertices = &chainvertices[0];
+					chaindef.vertexCount = static_cast<int32>(chainvertices.size());
+					chaindef.isALoop = loop;
+					chaindef.friction = segments[first].material->GetFriction();
+					chaindef.restitution = segments[first].material->GetRestitution();
+					chaindef.filter = segments[first].material->GetFilterData();
+					mpBakedBody->CreateShape(&chaindef);
+
+					//LOOP - Edges are added to front of body shapes list: last segment first
+					b2Shape* shape = mpBakedBody->GetShapeList();
+					for(size_t i = last; i > first; --i, shape = shape->GetNext())
+					{
+						const BakeSegment& segment = segments[i - 1];
+						shape->SetUserData(segment.bodies.front());	//Edge stands for the body it comes from
+						for(std::vector<b2Body*>::const_iterator bodyitr = segment.bodies.begin(); bodyitr != segment.bodies.end(); ++bodyitr)
+							mBakedShapes[*bodyitr].push_back(shape);
+					}//LOOP END
+
+					edgescount += static_cast<int>(last - first);
+					++chainscount;
+					first = last;
+				}//LOOP END
+			}
+		}
+	}//LOOP END
+
+	//LOOP - Baked bodies lose their polygons (body stays for its name, agent and joints)
+	for(std::vector<b2Body*>::iterator bodyitr = bakedbodies.begin(); bodyitr != bakedbodies.end(); ++bodyitr)
+	{
+		mBakedShapes[*bodyitr];	//Baked even if all its edges were interior
+		while((*bodyitr)->GetShapeList())
+			(*bodyitr)->DestroyShape((*bodyitr)->GetShapeList());
+	}//LOOP END
+	mSnapshotValid = false;	//World changed
+
+	//Store statistics
+	mBakeStatistics.bodies += static_cast<int>(bakedbodies.size());
+	mBakeStatistics.polygons += polygons;
+	mBakeStatistics.edges += edgescount;
+	mBakeStatistics.chains += chainscount;
+	mBakeStatistics.proxiesbefore = proxiesbefore;
+	mBakeStatistics.proxiesafter = mpTheWorld->GetProxyCount();
+	mBakeStatistics.baketime = timer.GetMilliseconds();
+
+	std::stringstream ss;
+	ss<<"Static geometry baked: "<<bakedbodies.size()<<" bodies ("<<polygons<<" polygons) in "<<chainscount<<" chains of "<<edgescount<<" edges. "
+	  <<"Proxies: "<<proxiesbefore<<" -> "<<mBakeStatistics.proxiesafter<<" Time: "<<mBakeStatistics.baketime<<" ms";
+	SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::BakeStaticBodies",ss.str(),LOGNORMAL);
+
+	return static_cast<int>(bakedbodies.size());
+}
+
+//Query for bodies in a point (through AABB)
+b2Body* PhysicsManager::QueryforBodies(const b2Vec2 &thepoint, bool includestatic)
+{
+	FirstBodyVisitor visitor(includestatic);
+	QueryPoint(thepoint,&visitor);
+
+	return visitor.mFoundBody;
+}
+
+//Query for bodies inside AABB
+int PhysicsManager::QueryforBodies(const b2AABB &boundingbox, std::vector<b2Body*>& foundbodies, bool includestatic)
+{
+	//Bodies are appended to given vector
+	size_t previoussize(foundbodies.size());
+	BodiesCollectorVisitor visitor(foundbodies,includestatic);
+	QueryAABB(boundingbox,&visitor);
 
-	//Return a COPY of the created vector (Ugly but works fine with vector of pointers (small size) and limited vector size)
-	return bodiesvector;
+	return static_cast<int>(foundbodies.size() - previoussize);
 }
 
 //Query for a specific body inside an AABB
@@ -687,43 +1759,471 @@ bool PhysicsManager::QueryforoneBody(const b2AABB &boundingbox, const std::strin
 		return false;
 	}
 
-	//Create a list of maximum number of shapes to find
-	b2Shape* shapes[MAXFOUNDSHAPES];
-	int32 count = mpTheWorld->Query(boundingbox, shapes, MAXFOUNDSHAPES);
-	//LOOP - Search every result
-	for (int i = 0; i < count; ++i)
+	BodyFinderVisitor visitor(thebody);
+	QueryAABB(boundingbox,&visitor);
+
+	return visitor.mFound;
+}
+
+//Query for shapes which AABB overlaps the box
+void PhysicsManager::QueryAABB(const b2AABB &boundingbox, IPhysicsQueryVisitor* visitor, int queryindex)
+{
+	WaitForSteps();
+	assert(visitor);
+	PhysicsQueryCallback callback(visitor);
+	callback.mQueryIndex = queryindex;
+	mpTheWorld->Query(&callback,boundingbox);
+}
+
+//Query for shapes of a batch of boxes
+void PhysicsManager::QueryAABBs(const b2AABB* boxes, int count, IPhysicsQueryVisitor* visitor)
+{
+	WaitForSteps();
+	assert(visitor);
+	assert(boxes || count == 0);
+	PhysicsQueryCallback callback(visitor);
+	//LOOP - Query every box
+	for(int i = 0; i < count; ++i)
 	{
-		b2Body* shapeBody = shapes[i]->GetBody();
-		//IF - Is this body the asked one to find?
-		if(shapeBody == thebody)
+		callback.mQueryIndex = i;
+		mpTheWorld->Query(&callback,boxes[i]);
+	}//LOOP END
+}
+
+//Query for shapes containing a point
+void PhysicsManager::QueryPoint(const b2Vec2 &thepoint, IPhysicsQueryVisitor* visitor, int queryindex)
+{
+	WaitForSteps();
+	assert(visitor);
+	PhysicsQueryCallback callback(visitor);
+	callback.mQueryIndex = queryindex;
+	callback.mTestPoint = true;
+	callback.mPoint = thepoint;
+
+	// Make a small box to query
+	b2AABB aabb;
+	b2Vec2 d(0.001f, 0.001f);
+	aabb.lowerBound = thepoint - d;
+	aabb.upperBound = thepoint + d;
+	mpTheWorld->Query(&callback,aabb);
+}
+
+//Query for shapes containing points of a batch
+void PhysicsManager::QueryPoints(const b2Vec2* points, int count, IPhysicsQueryVisitor* visitor)
+{
+	WaitForSteps();
+	assert(visitor);
+	assert(points || count == 0);
+	PhysicsQueryCallback callback(visitor);
+	callback.mTestPoint = true;
+	b2Vec2 d(0.001f, 0.001f);
+	//LOOP - Query every point
+	for(int i = 0; i < count; ++i)
+	{
+		callback.mQueryIndex = i;
+		callback.mPoint = points[i];
+		b2AABB aabb;
+		aabb.lowerBound = points[i] - d;
+		aabb.upperBound = points[i] + d;
+		mpTheWorld->Query(&callback,aabb);
+	}//LOOP END
+}
+
+//Ray cast a segment: hits are reported from start to end
+void PhysicsManager::RaycastSegment(const b2Segment &segment, IPhysicsRaycastVisitor* visitor, bool solidshapes, int queryindex)
+{
+	WaitForSteps();
+	assert(visitor);
+	PhysicsRaycastCallback callback(visitor);
+	callback.mQueryIndex = queryindex;
+	callback.mSegment = &segment;
+	mpTheWorld->Raycast(&callback,segment,solidshapes,NULL);
+}
+
+//Ray cast a batch of segments
+void PhysicsManager::RaycastSegments(const b2Segment* segments, int count, IPhysicsRaycastVisitor* visitor, bool solidshapes)
+{
+	WaitForSteps();
+	assert(visitor);
+	assert(segments || count == 0);
+	PhysicsRaycastCallback callback(visitor);
+	//LOOP - Cast every segment
+	for(int i = 0; i < count; ++i)
+	{
+		callback.mQueryIndex = i;
+		callback.mSegment = &segments[i];
+		mpTheWorld->Raycast(&callback,segments[i],solidshapes,NULL);
+	}//LOOP END
+}
+
+//Store state of world (bodies, joints, controllers and contacts warm starting)
+void PhysicsManager::TakeSnapshot()
+{
+	WaitForSteps();
+	b2Timer timer;
+	//Containers are cleared, not released: storage is reused by next snapshots
+	mBodiesSnapshot.clear();
+	mJointsSnapshot.clear();
+	mControllersSnapshot.clear();
+	mContactsSnapshot.clear();
+
+	//LOOP - Store bodies state
+	for(b2Body* body = mpTheWorld->GetBodyList(); body; body = body->GetNext())
+	{
+		BodySnapshot bodystate;
+		bodystate.body = body;
+		bodystate.position = body->GetPosition();
+		bodystate.angle = body->GetAngle();
+		bodystate.linearvelocity = body->GetLinearVelocity();
+		bodystate.angularvelocity = body->GetAngularVelocity();
+		bodystate.sleeping = body->IsSleeping();
+		mBodiesSnapshot.push_back(bodystate);
+	}//LOOP END
+
+	//LOOP - Store joints state
+	for(b2Joint* joint = mpTheWorld->GetJointList(); joint; joint = joint->GetNext())
+	{
+		size_t offset(mJointsSnapshot.size());
+		mJointsSnapshot.resize(offset + joint->GetStateSize());
+		if(joint->GetStateSize() > 0)
+			joint->GetState(&mJointsSnapshot[offset]);
+	}//LOOP END
+
+	//LOOP - Store controllers state
+	for(b2Controller* controller = mpTheWorld->GetControllerList(); controller; controller = controller->GetNext())
+	{
+		size_t offset(mControllersSnapshot.size());
+		mControllersSnapshot.resize(offset + controller->GetStateSize());
+		if(controller->GetStateSize() > 0)
+			controller->GetState(&mControllersSnapshot[offset]);
+	}//LOOP END
+
+	//LOOP - Store contact points impulses
+	for(b2Contact* contact = mpTheWorld->GetContactList(); contact; contact = contact->GetNext())
+	{
+		b2Manifold* manifolds = contact->GetManifolds();
+		//LOOP - All points of all manifolds
+		for(int32 i = 0; i < contact->GetManifoldCount(); ++i)
 		{
-			return true;
+			for(int32 j = 0; j < manifolds[i].pointCount; ++j)
+			{
+				const b2ManifoldPoint& point = manifolds[i].points[j];
+				ContactPointSnapshot pointstate;
+				pointstate.shape1 = contact->GetShape1();
+				pointstate.shape2 = contact->GetShape2();
+				pointstate.id = point.id.key;
+				pointstate.normalimpulse = point.normalImpulse;
+				pointstate.tangentimpulse = point.tangentImpulse;
+				mContactsSnapshot.push_back(pointstate);
+			}
+		}//LOOP END
+	}//LOOP END
+	std::sort(mContactsSnapshot.begin(),mContactsSnapshot.end());
+
+	mSnapshotValid = true;
+
+	//Store statistics
+	mSnapshotStatistics.bodies = static_cast<int>(mBodiesSnapshot.size());
+	mSnapshotStatistics.jointvalues = static_cast<int>(mJointsSnapshot.size());
+	mSnapshotStatistics.controllervalues = static_cast<int>(mControllersSnapshot.size());
+	mSnapshotStatistics.contactpoints = static_cast<int>(mContactsSnapshot.size());
+	mSnapshotStatistics.bytes = static_cast<int>(mBodiesSnapshot.size() * sizeof(BodySnapshot)
+												 + (mJointsSnapshot.size() + mControllersSnapshot.size()) * sizeof(float32)
+												 + mContactsSnapshot.size() * sizeof(ContactPointSnapshot));
+	mSnapshotStatistics.capturetime = timer.GetMilliseconds();
+	mSnapshotStatistics.restoretime = 0.0f;
+	mSnapshotStatistics.restores = 0;
+
+	std::stringstream ss;
+	ss<<"World snapshot taken: "<<mSnapshotStatistics.bytes<<" bytes ("<<mSnapshotStatistics.bodies<<" bodies, "
+	  <<mSnapshotStatistics.contactpoints<<" contact points) in "<<mSnapshotStatistics.capturetime<<" ms";
+	SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::TakeSnapshot",ss.str(),LOGNORMAL);
+}
+
+//Back to stored state of world. Nothing is created or parsed: bodies, joints and controllers are the same
+bool PhysicsManager::RestoreSnapshot()
+{
+	WaitForSteps();
+	//IF - No snapshot or world changed (bodies, joints or controllers created or destroyed)
+	if(!mSnapshotValid)
+		return false;
+
+	//LOOP - Frozen bodies (out of world) cant be moved
+	for(b2Body* body = mpTheWorld->GetBodyList(); body; body = body->GetNext())
+	{
+		if(body->IsFrozen())
+			return false;
+	}//LOOP END
+
+	b2Timer timer;
+
+	//Pending work of current state is discarded
+	mTimeAccumulator = 0.0f;
+	mInterpolationTime = 0.0f;
+	mPreviousTransforms[0].clear();
+	mPreviousTransforms[1].clear();
+	if(mpStepSnapshot)
+		mpStepSnapshot->Clear();
+	mPendingSteps = 0;
+	mCommands.clear();
+	mOutofBoundsBodies.clear();
+	mContactPoints.Clear();
+	mContactResults.Clear();
+
+	std::vector<BodySnapshot>::const_iterator boditr;
+	//LOOP - Restore positions (static bodies dont move)
+	for(boditr = mBodiesSnapshot.begin(); boditr != mBodiesSnapshot.end(); ++boditr)
+	{
+		if(!(*boditr).body->IsStatic())
+			(*boditr).body->SetXForm((*boditr).position,(*boditr).angle);
+	}//LOOP END
+	//LOOP - Restore sleep state by islands: whole island sleeps, then the ones with an awake body wake up
+	for(int awake = 0; awake < 2; ++awake)
+	{
+		for(boditr = mBodiesSnapshot.begin(); boditr != mBodiesSnapshot.end(); ++boditr)
+		{
+			if(!(*boditr).body->IsStatic() && (*boditr).sleeping != (awake == 1))
+				mpTheWorld->SetIslandAwake((*boditr).body,awake == 1);
 		}
 	}//LOOP END
+	//LOOP - Restore velocities of awake bodies, no forces pending
+	for(boditr = mBodiesSnapshot.begin(); boditr != mBodiesSnapshot.end(); ++boditr)
+	{
+		b2Body* body = (*boditr).body;
+		if(body->IsStatic())
+			continue;
 
-	return false;
+		body->ClearForces();
+		if(!body->IsSleeping())
+		{
+			body->SetLinearVelocity((*boditr).linearvelocity);
+			body->SetAngularVelocity((*boditr).angularvelocity);
+		}
+	}//LOOP END
+
+	//LOOP - Restore joints state (same joints in same order)
+	size_t offset(0);
+	for(b2Joint* joint = mpTheWorld->GetJointList(); joint; joint = joint->GetNext())
+	{
+		if(joint->GetStateSize() > 0)
+			joint->SetState(&mJointsSnapshot[offset]);
+		offset += joint->GetStateSize();
+	}//LOOP END
+	assert(offset == mJointsSnapshot.size());
+
+	//LOOP - Restore controllers state
+	offset = 0;
+	for(b2Controller* controller = mpTheWorld->GetControllerList(); controller; controller = controller->GetNext())
+	{
+		if(controller->GetStateSize() > 0)
+			controller->SetState(&mControllersSnapshot[offset]);
+		offset += controller->GetStateSize();
+	}//LOOP END
+	assert(offset == mControllersSnapshot.size());
+
+	//LOOP - Restore warm starting of current contacts (not stored ones start from 0)
+	for(b2Contact* contact = mpTheWorld->GetContactList(); contact; contact = contact->GetNext())
+	{
+		b2Manifold* manifolds = contact->GetManifolds();
+		ContactPointSnapshot key;
+		key.shape1 = contact->GetShape1();
+		key.shape2 = contact->GetShape2();
+		//LOOP - All points of all manifolds
+		for(int32 i = 0; i < contact->GetManifoldCount(); ++i)
+		{
+			for(int32 j = 0; j < manifolds[i].pointCount; ++j)
+			{
+				b2ManifoldPoint& point = manifolds[i].points[j];
+				key.id = point.id.key;
+				std::vector<ContactPointSnapshot>::const_iterator found = std::lower_bound(mContactsSnapshot.begin(),mContactsSnapshot.end(),key);
+				//IF - Point stored
+				if(found != mContactsSnapshot.end() && !(key < (*found)))
+				{
+					point.normalImpulse = (*found).normalimpulse;
+					point.tangentImpulse = (*found).tangentimpulse;
+				}
+				else
+				{
+					point.normalImpulse = 0.0f;
+					point.tangentImpulse = 0.0f;
+				}
+			}
+		}//LOOP END
+	}//LOOP END
+
+	//Store statistics
+	mSnapshotStatistics.restoretime = timer.GetMilliseconds();
+	mSnapshotStatistics.restores++;
+
+	std::stringstream ss;
+	ss<<"World snapshot restored ("<<mSnapshotStatistics.bytes<<" bytes) in "<<mSnapshotStatistics.restoretime<<" ms";
+	SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::RestoreSnapshot",ss.str(),LOGNORMAL);
+
+	return true;
+}
+
+//Iterations of stacks and soft bodies (0 = general ones), early out of velocity iterations
+void PhysicsManager::SetIslandIterations(bool adaptive, int32 stackiterations, int32 softbodyiterations)
+{
+	WaitForSteps();
+	assert(stackiterations >= 0 && softbodyiterations >= 0);
+	mpTheWorld->SetAdaptiveIterations(adaptive);
+	mpTheWorld->SetIslandIterations(e_stackIsland,stackiterations,stackiterations);
+	mpTheWorld->SetIslandIterations(e_softBodyIsland,softbodyiterations,softbodyiterations);
+
+	std::stringstream ss;
+	ss<<"Island iterations set: Adaptive: "<<adaptive<<" Stacks: "<<stackiterations<<" Soft bodies: "<<softbodyiterations;
+	SingletonLogMgr::Instance()->AddNewLine("PhysicsManager::SetIslandIterations",ss.str(),LOGNORMAL);
 }
 
 //Changes de friction of all shapes within the body
 void PhysicsManager::ChangeFrictionofBody(b2Body* thebody, float newfriction)
+{
+	WaitForSteps();
+	_changeFrictionofBody(thebody,newfriction);
+}
+
+//Changes friction of many bodies at once (bodies wetted by blob death...)
+void PhysicsManager::ChangeFrictionofBodies(const std::vector<b2Body*>& bodies, const std::vector<float>& newfrictions)
+{
+	WaitForSteps();
+	assert(bodies.size() == newfrictions.size());
+
+	//LOOP - Change friction of all bodies
+	for(unsigned int i = 0; i < bodies.size(); ++i)
+	{
+		_changeFrictionofBody(bodies[i],newfrictions[i]);
+	}//LOOP END
+}
+
+//Adds a material (friction and restitution shared by shapes)
+int PhysicsManager::CreateMaterial(float friction, float restitution)
+{
+	WaitForSteps();
+	assert(friction >= 0.0f && restitution >= 0.0f);
+
+	int material = mpTheWorld->CreateMaterial(friction,restitution);
+	//IF - Materials table full
+	if(material == b2_nullMaterial)
+		throw GenericException("Physics materials table is full, material can not be created",GenericException::LIBRARY_ERROR);
+
+	return material;
+}
+
+//Changes a material: shapes with it (and their contacts) use it from next step
+void PhysicsManager::ChangeMaterial(int material, float friction, float restitution)
+{
+	WaitForSteps();
+	assert(friction >= 0.0f && restitution >= 0.0f);
+
+	//Materials are not in world snapshot
+	mSnapshotValid = false;
+
+	mpTheWorld->SetMaterial(material,friction,restitution);
+}
+
+//Sets the material of all shapes within the body (b2_nullMaterial: own friction and restitution)
+void PhysicsManager::SetMaterialofBody(b2Body* thebody, int material)
+{
+	WaitForSteps();
+	assert(thebody);
+
+	//Materials are not in world snapshot
+	mSnapshotValid = false;
+
+	//LOOP - Set material of all body's shapes
+	for(b2Shape* nextshape = thebody->GetShapeList(); nextshape; nextshape = nextshape->GetNext())
+	{
+		nextshape->SetMaterial(material);
+	}//LOOP END
+
+	//IF - Body was baked: its edges in static geometry
+	BakedShapesMapIterator bakeditr = mBakedShapes.find(thebody);
+	if(bakeditr != mBakedShapes.end())
+	{
+		std::vector<b2Shape*>::iterator shapeitr;
+		//LOOP - Set material of baked edges
+		for(shapeitr = (*bakeditr).second.begin(); shapeitr != (*bakeditr).second.end(); ++shapeitr)
+		{
+			(*shapeitr)->SetMaterial(material);
+		}//LOOP END
+	}//IF
+}
+
+//Changes friction of all shapes within the body (world not in use by physics thread)
+void PhysicsManager::_changeFrictionofBody(b2Body* thebody, float newfriction)
 {
 	//Parameters correctness
 	assert(thebody);
 	assert(newfriction >= 0.0f);
 
+	//Friction is not in world snapshot
+	mSnapshotValid = false;
+
 	//Get body's shape list
 	b2Shape* nextshape = thebody->GetShapeList();
 
 	//LOOP - Change friction of all body's shapes
 	while(nextshape)
 	{
-		//Modify friction
+		//Modify friction. Contacts read it when solved: no need to refilter the shape (it would
+		//destroy existing contacts, losing warm starting)
 		nextshape->SetFriction(newfriction);
-		//Finally, recompute cached contact data (if existed). If not updated, friction in this
-		//existing contact will remain the same
-		mpTheWorld->Refilter(nextshape);
 		nextshape = nextshape->GetNext();
 	}//LOOP
+
+	//IF - Body was baked: its edges in static geometry
+	BakedShapesMapIterator bakeditr = mBakedShapes.find(thebody);
+	if(bakeditr != mBakedShapes.end())
+	{
+		std::vector<b2Shape*>::iterator shapeitr;
+		//LOOP - Change friction of baked edges
+		for(shapeitr = (*bakeditr).second.begin(); shapeitr != (*bakeditr).second.end(); ++shapeitr)
+		{
+			(*shapeitr)->SetFriction(newfriction);
+		}//LOOP END
+	}//IF
+}
+
+//Store handles of contact agents: they are checked when dispatching, as agents can be deleted before.
+//Only taken with a dispatcher registered (agents manager alive, so agents pointers are valid)
+void PhysicsManager::_takeAgentHandles(ContactInfo& info)
+{
+	//IF - Collisions dispatcher registered
+	if(mpCollisionDispatcher)
+	{
+		if(info.agent1)
+			info.agenthandle1 = info.agent1->GetHandle();
+		if(info.agent2)
+			info.agenthandle2 = info.agent2->GetHandle();
+	}//IF
+}
+
+//Check if some agent of the contact wants it (subscriptions by state and other agent type).
+//Without dispatcher contacts are sent as events, so all are wanted
+bool PhysicsManager::_isContactSubscribed(b2Shape* shape1, b2Shape* shape2, ContactState state)
+{
+	++mContactFilterCounters.received[state];
+	//IF - No collisions dispatcher
+	if(!mpCollisionDispatcher)
+		return true;
+
+	IAgent* agent1 = static_cast<IAgent*>(GetShapeSourceBody(shape1)->GetUserData());
+	IAgent* agent2 = static_cast<IAgent*>(GetShapeSourceBody(shape2)->GetUserData());
+	AgentType type1 = agent1 ? agent1->GetType() : UNKNOWN;
+	AgentType type2 = agent2 ? agent2->GetType() : UNKNOWN;
+	unsigned int statemask = 1 << state;
+
+	//IF - Wanted by one of the agents
+	if((agent1 && (agent1->GetContactSubscription(type2) & statemask))
+		||
+		(agent2 && (agent2->GetContactSubscription(type1) & statemask)))
+	{
+		return true;
+	}//IF
+
+	++mContactFilterCounters.dropped[state];
+	return false;
 }
 
 //Events sending - New Contact
@@ -19,15 +19,18 @@
 
 //Library dependencies	
 #include <map>
+#include <vector>
 #include "Box2D\Box2D.h"
 //Class dependencies
 #include "LogManager.h"
 #include "GenericException.h"
 #include "GameEventManager.h"
+#include "GameLogicDefs.h"
+#include "PhysicsStepSnapshot.h"
 
 //---------------Custom physics contact listener (collision detection)-----------------------
 class PhysicsManager;
-class GameContactListener : public b2ContactListener
+class GameContactListener : public b2ContactListener, public b2TriggerListener
 {
 public:
 	//----- CONSTRUCTORS/DESTRUCTORS -----
@@ -44,6 +47,8 @@ public:
 	void Persist(const b2ContactPoint* point);	//Custom handle - a contact point persisted for more than one timestep
 	void Remove(const b2ContactPoint* point);	//Custom handle - a contact point was deleted
     void Result(const b2ContactResult* point);	//Custom handle - Collision result parameters
+	void Enter(b2Shape* trigger, b2Shape* shape);	//Custom handle - a shape entered a trigger (no contact)
+	void Exit(b2Shape* trigger, b2Shape* shape);	//Custom handle - a shape exited a trigger (no contact)
 	//Overriding of collision handling
 	void IgnoreCollisions() { mIgnoreCollisions = true; }
 	void ListenCollisions() { mIgnoreCollisions = false; }
@@ -54,11 +59,28 @@ private:
 };
 
 //Definitions
-const int MAXFOUNDSHAPES = 15;
+const int CONTACTBUFFERRESERVE = 512;	//Contact points (and results) room reserved at start
+const int VALIDATESTEPS = 100;			//Steps between validations of world structures (debug mode)
 
 //Custom contact info to analyze and use in-game
-enum ContactState {ADDED, PERSISTED, REMOVED, RESULT};
+enum ContactState {ADDED, PERSISTED, REMOVED, RESULT, TRIGGERENTER, TRIGGEREXIT};
+const int CONTACTSTATESCOUNT = 6;
+//Contact states as mask bits (agents subscriptions to contacts)
+const unsigned int CONTACTADDEDMASK = 1 << ADDED;
+const unsigned int CONTACTPERSISTEDMASK = 1 << PERSISTED;
+const unsigned int CONTACTREMOVEDMASK = 1 << REMOVED;
+const unsigned int CONTACTRESULTMASK = 1 << RESULT;
+const unsigned int CONTACTTRIGGERENTERMASK = 1 << TRIGGERENTER;
+const unsigned int CONTACTTRIGGEREXITMASK = 1 << TRIGGEREXIT;
+const unsigned int CONTACTALLMASK = CONTACTADDEDMASK | CONTACTPERSISTEDMASK | CONTACTREMOVEDMASK | CONTACTRESULTMASK
+									| CONTACTTRIGGERENTERMASK | CONTACTTRIGGEREXITMASK;
 class IAgent;
+//Body a shape stands for in game: edges of baked static geometry keep the body they were baked from
+inline b2Body* GetShapeSourceBody(b2Shape* shape)
+{
+	b2Body* sourcebody = static_cast<b2Body*>(shape->GetUserData());
+	return sourcebody ? sourcebody : shape->GetBody();
+}
 //Contact info structure: 2 parts can be parametrized: Contact (static) info, and Result (dynamic result) info
 typedef struct ContactInfo
 {
@@ -70,17 +92,17 @@ typedef struct ContactInfo
 	  restitution(point.restitution),
 	  friction(point.friction),
 	  relvelocity(point.velocity),
-	  agent1(static_cast<IAgent*>(point.shape1->GetBody()->GetUserData())),
-	  agent2(static_cast<IAgent*>(point.shape2->GetBody()->GetUserData())),
+	  agent1(static_cast<IAgent*>(GetShapeSourceBody(point.shape1)->GetUserData())),
+	  agent2(static_cast<IAgent*>(GetShapeSourceBody(point.shape2)->GetUserData())),
 	  collidedshape1(point.shape1),
 	  collidedshape2(point.shape2),
-	  collidedbody1(point.shape1->GetBody()),
-	  collidedbody2(point.shape2->GetBody()),
+	  collidedbody1(GetShapeSourceBody(point.shape1)),
+	  collidedbody2(GetShapeSourceBody(point.shape2)),
 	  normalimpulse(0.0f),  //Result data initialized to 0
 	  tangentimpulse(0.0f),  //Result data initialized to 0
 	  contactid(point.id.key),
 	  state(ADDED)
-	  {}
+	  {}  //Agents handles are taken when buffered
 
     //Construction with collision result
 	ContactInfo(const b2ContactResult& result):
@@ -90,21 +112,43 @@ typedef struct ContactInfo
 	  restitution(0.0f), //Contact data initialized to 0
 	  friction(0.0f), //Contact data initialized to 0
 	  relvelocity(0.0f,0.0f), //Contact data initialized to 0
-	  agent1(static_cast<IAgent*>(result.shape1->GetBody()->GetUserData())),
-	  agent2(static_cast<IAgent*>(result.shape2->GetBody()->GetUserData())),
+	  agent1(static_cast<IAgent*>(GetShapeSourceBody(result.shape1)->GetUserData())),
+	  agent2(static_cast<IAgent*>(GetShapeSourceBody(result.shape2)->GetUserData())),
 	  collidedshape1(result.shape1),
 	  collidedshape2(result.shape2),
-	  collidedbody1(result.shape1->GetBody()),
-	  collidedbody2(result.shape2->GetBody()),
+	  collidedbody1(GetShapeSourceBody(result.shape1)),
+	  collidedbody2(GetShapeSourceBody(result.shape2)),
 	  normalimpulse(result.normalImpulse),
 	  tangentimpulse(result.tangentImpulse),
 	  contactid(result.id.key),
 	  state(RESULT)
-	  {}
+	  {}  //Agents handles are taken when buffered
+
+	//Construction with trigger event (shape 1 is the trigger). There is no contact: only positions and velocity
+	ContactInfo(b2Shape* trigger, b2Shape* shape, ContactState triggerstate):
+	  position(shape->GetBody()->GetPosition()),
+	  normal(0.0f,0.0f),
+	  separation(0.0f),
+	  restitution(0.0f),
+	  friction(0.0f),
+	  relvelocity(shape->GetBody()->GetLinearVelocity() - trigger->GetBody()->GetLinearVelocity()),
+	  agent1(static_cast<IAgent*>(GetShapeSourceBody(trigger)->GetUserData())),
+	  agent2(static_cast<IAgent*>(GetShapeSourceBody(shape)->GetUserData())),
+	  collidedshape1(trigger),
+	  collidedshape2(shape),
+	  collidedbody1(GetShapeSourceBody(trigger)),
+	  collidedbody2(GetShapeSourceBody(shape)),
+	  normalimpulse(0.0f),
+	  tangentimpulse(0.0f),
+	  contactid(0),
+	  state(triggerstate)
+	  { assert(triggerstate == TRIGGERENTER || triggerstate == TRIGGEREXIT); }  //Agents handles are taken when buffered
 
 	//Both sides info
 	IAgent* agent1;
 	IAgent* agent2;
+	AgentHandle agenthandle1;	//To check agents still exist when dispatching
+	AgentHandle agenthandle2;
 	b2Body* collidedbody1;
 	b2Body* collidedbody2;
 	b2Shape* collidedshape1;
@@ -127,10 +171,13 @@ typedef struct ContactInfo
 	ContactState state;
 }ContactInfo;
 
-//Custom key to store contacts info in an ordered map
+//Custom key to store contacts info in an ordered container
 class ContactInfoKey
 {
 public:
+	//Number of 8 bit digits used to radix sort keys
+	static const int RADIXDIGITS = 1 + 2 * sizeof(b2Shape*) + sizeof(uint32);
+
 	ContactInfoKey(b2Shape* shape1, uint32 contactid, b2Shape* shape2,const ContactState& state):
 	mShape1(shape1),
 	mContactId(contactid),
@@ -154,6 +201,33 @@ public:
 		else
 			return false;
 	}
+	//Operator equal to compare
+	bool operator ==(const ContactInfoKey& tocompare) const
+	{
+		return (mContactId == tocompare.mContactId
+				&&
+				mShape1 == tocompare.mShape1
+				&&
+				mShape2 == tocompare.mShape2
+				&&
+				mState == tocompare.mState);
+	}
+	//Digit of a radix sort pass: least significant first, so sorting gives the same order as operator <
+	unsigned int GetRadixDigit(int pass) const
+	{
+		assert(pass >= 0 && pass < RADIXDIGITS);
+		const int pointerdigits(static_cast<int>(sizeof(b2Shape*)));
+		if(pass == 0)
+			return static_cast<unsigned int>(mState) & 0xFF;
+		pass -= 1;
+		if(pass < pointerdigits)
+			return static_cast<unsigned int>(reinterpret_cast<size_t>(mShape2) >> (8 * pass)) & 0xFF;
+		pass -= pointerdigits;
+		if(pass < pointerdigits)
+			return static_cast<unsigned int>(reinterpret_cast<size_t>(mShape1) >> (8 * pass)) & 0xFF;
+		pass -= pointerdigits;
+		return (mContactId >> (8 * pass)) & 0xFF;
+	}
 private:
 	//Internal variables
 	b2Shape* mShape1;
@@ -162,6 +236,183 @@ private:
 	ContactState mState;
 };
 
+//Flat contact buffer: contact infos are appended while physics steps and sorted by key when
+//processed (radix sort). Storage is reserved once and kept, so no allocations in steady state
+class ContactInfoBuffer
+{
+public:
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+	ContactInfoBuffer():
+	  mSortedCount(0),
+	  mGrowCount(0)
+	{}
+	~ContactInfoBuffer()
+	{}
+	//----- GET/SET FUNCTIONS -----
+	int GetCount() const { return static_cast<int>(mInfos.size()); }			//Added entries
+	int GetCapacity() const { return static_cast<int>(mInfos.capacity()); }	//Room for entries
+	int GetGrowCount() const { return mGrowCount; }		//Times storage had to grow since last clear
+	int GetSortedCount() const { return mSortedCount; }	//Entries with different keys (after sorting)
+	const ContactInfo& GetSortedInfo(int index) const { assert(index >= 0 && index < mSortedCount); return mInfos[mOrder[index]]; }
+	//----- OTHER FUNCTIONS -----
+	void Reserve(int capacity);	//Reserve room for entries
+	void Add(const ContactInfoKey& key, const ContactInfo& info);	//Add an entry
+	void Sort();	//Sort entries by key, repeated keys are dropped (first added is kept)
+	void Clear();	//Remove all entries (storage is kept)
+private:
+	//----- INTERNAL VARIABLES -----
+	std::vector<ContactInfoKey> mKeys;	//Keys and infos, in adding order
+	std::vector<ContactInfo> mInfos;
+	std::vector<int> mOrder;			//Sorted entries indexes
+	std::vector<int> mSwap;				//Radix sort pass destination
+	int mSortedCount;
+	int mGrowCount;
+};
+
+//Contact buffers usage in last update
+typedef struct ContactBufferStatistics
+{
+	int points;			//Contact points buffered
+	int pointscapacity;	//Room for contact points
+	int results;		//Contact results buffered
+	int resultscapacity;//Room for contact results
+	int grows;			//Times a buffer had to grow (heap allocations)
+}ContactBufferStatistics;
+
+//Contact callbacks filtering by agents subscriptions (callbacks since last update, all steps)
+typedef struct ContactFilterStatistics
+{
+	int received[CONTACTSTATESCOUNT];	//Callbacks by contact state
+	int dropped[CONTACTSTATESCOUNT];	//Callbacks not buffered: no agent wanted them
+	int steps;							//Physics steps
+}ContactFilterStatistics;
+
+//Contact delivered to an agent: buffered info, type of collision and the agent's body
+typedef struct AgentContact
+{
+	GameEventType type;
+	const ContactInfo* info;
+	b2Body* activebody;
+}AgentContact;
+
+//Collisions dispatch stage: receives sorted contact buffers of an update to deliver them to agents.
+//Buffers are valid until the call returns
+class ICollisionDispatcher
+{
+public:
+	virtual ~ICollisionDispatcher(){}
+	virtual void DispatchCollisions(const ContactInfoBuffer& points, const ContactInfoBuffer& results) = 0;
+};
+
+//Spatial queries visiting: shapes are reported one by one as found, so there is no limit of results
+//and nothing is allocated. Return false to stop the current query (batched queries go on with the next one)
+class IPhysicsQueryVisitor
+{
+public:
+	virtual ~IPhysicsQueryVisitor(){}
+	virtual bool VisitShape(b2Shape* shape, int queryindex) = 0;
+};
+
+//Ray cast hit of a shape (hits are reported from segment start to segment end)
+typedef struct RaycastHit
+{
+	b2Shape* shape;
+	b2Vec2 point;
+	b2Vec2 normal;
+	float32 fraction;	//Fraction of the segment to the hit point (0 if the segment starts inside the shape)
+}RaycastHit;
+
+class IPhysicsRaycastVisitor
+{
+public:
+	virtual ~IPhysicsRaycastVisitor(){}
+	virtual bool VisitHit(const RaycastHit& hit, int queryindex) = 0;
+};
+
+//World snapshot: state of the world taken after level load, restored to restart it without creating it again
+typedef struct BodySnapshot
+{
+	b2Body* body;
+	b2Vec2 position;
+	float32 angle;
+	b2Vec2 linearvelocity;
+	float32 angularvelocity;
+	bool sleeping;
+}BodySnapshot;
+
+typedef struct ContactPointSnapshot	//Warm starting impulses of a contact point
+{
+	b2Shape* shape1;
+	b2Shape* shape2;
+	uint32 id;
+	float32 normalimpulse;
+	float32 tangentimpulse;
+	//Operator less - than to search them (ordered by shapes and id)
+	bool operator <(const ContactPointSnapshot& tocompare) const
+	{
+		if(shape1 != tocompare.shape1)
+			return shape1 < tocompare.shape1; //Ugly pointer less-than compare...
+		else if(shape2 != tocompare.shape2)
+			return shape2 < tocompare.shape2; //Ugly pointer less-than compare...
+		else
+			return id < tocompare.id;
+	}
+}ContactPointSnapshot;
+
+typedef struct WorldSnapshotStatistics
+{
+	int bytes;				//Snapshot size
+	int bodies;				//Elements in snapshot
+	int jointvalues;
+	int controllervalues;
+	int contactpoints;
+	float capturetime;		//Time to take the snapshot (ms)
+	float restoretime;		//Time of last restore (ms)
+	int restores;			//Times restored
+}WorldSnapshotStatistics;
+
+//Transform of a body before last step (rendering interpolates)
+typedef struct BodyTransform
+{
+	b2Body* body;
+	b2XForm xform;
+	//Operator less - than to search them (ordered by body)
+	bool operator <(const BodyTransform& tocompare) const
+	{
+		return body < tocompare.body; //Ugly pointer less-than compare...
+	}
+}BodyTransform;
+
+//Event received while stepping, handled in next update by the listener which queued it (not triggered again)
+typedef struct QueuedCommand
+{
+	EventDataPointer command;
+	IEventListener* handler;
+}QueuedCommand;
+
+typedef struct PhysicsThreadStatistics
+{
+	int steps;				//Steps handed to physics thread
+	float steptime;			//Time stepping in physics thread (ms)
+	float publishtime;		//Time publishing step snapshots in physics thread (ms, part of steptime)
+	float waittime;			//Time game waited for the thread (ms)
+	int syncs;				//Waits before update (world used while stepping)
+	int commands;			//Commands queued while stepping
+	int reads;				//Step snapshots read by game thread while stepping
+}PhysicsThreadStatistics;
+
+//Static geometry baked at level load
+typedef struct BakeStatistics
+{
+	int bodies;				//Static bodies baked (kept without shapes)
+	int polygons;			//Polygons replaced by edges
+	int edges;				//Edges created (shared ones dropped, collinear ones merged)
+	int chains;				//Edge chains created
+	int proxiesbefore;		//Broad-phase proxies before and after baking
+	int proxiesafter;
+	float baketime;			//Time to bake (ms)
+}BakeStatistics;
+
 //------------------------------Custom boundary listener--------------------------------------
 class PhysicsManager;
 class GameBoundaryListener : public b2BoundaryListener 
@@ -185,7 +436,7 @@ private:
 
 
 //------------------------------Physics manager-----------------------------------------------
-
+class PhysicsThread;
 class PhysicsManager
 {
 	//Friend class is Contact Listener and boundary listener (callbacks from Box2d)
@@ -194,6 +445,7 @@ class PhysicsManager
 	//Definitions
 public:
 	static const std::string MouseJointName;
+	static const std::string BakedGeometryName;
 protected:
 	//Containers for created entities
 	typedef std::map<std::string,b2Body*> PhysBodiesMap;
@@ -206,17 +458,12 @@ protected:
 	typedef std::pair<b2Body*,IAgent*> OutofBoundsData;
 	typedef std::vector<OutofBoundsData> OutofBoundsVec;
 	typedef OutofBoundsVec::iterator	OutofBoundsVecIterator;
-	//Container for contact callbacks buffering
-	typedef std::map<ContactInfoKey,ContactInfo> ContactPointsMap;
-	typedef ContactPointsMap::iterator ContactPointsMapIterator;
-	typedef std::pair<ContactInfoKey,ContactInfo> ContactPointMapPair;
-	//Container for contact result callbacks buffering
-	typedef std::map<ContactInfoKey,ContactInfo> ContactResultsMap;
-	typedef ContactResultsMap::iterator ContactResultsMapIterator;
-	typedef std::pair<ContactInfoKey,ContactInfo> ContactResultsMapPair;
+	//container for edges baked from static bodies
+	typedef std::map<b2Body*,std::vector<b2Shape*> > BakedShapesMap;
+	typedef BakedShapesMap::iterator BakedShapesMapIterator;
 public:
 	//----- CONSTRUCTORS/DESTRUCTORS -----
-	PhysicsManager(const b2Vec2 &gravity,float32 timestep, int32 iterations, const b2Vec2 &upperbound,const b2Vec2 &lowerbound,b2DebugDraw *debugdrawimpl = NULL)
+	PhysicsManager(const b2Vec2 &gravity,float32 timestep, int32 iterations, const b2Vec2 &upperbound,const b2Vec2 &lowerbound,b2BroadPhaseType broadphase,int32 solverthreads,b2ContactSolverType contactsolver,bool physicsthread,b2DebugDraw *debugdrawimpl = NULL)
 		:mIterations(iterations),
 		 mTimeStep(timestep),
 		 mTimestepms(timestep*1000),
@@ -224,8 +471,41 @@ public:
 		 mTimeAccumulator(0),
 		 mpContactListener(NULL),
 		 mPhysicsStepped(false),
-		 mTimeStepped(0.0f)
+		 mTimeStepped(0.0f),
+		 mAwakeBodiesCount(0),
+		 mSleepingBodiesCount(0),
+		 mpCollisionDispatcher(NULL),
+		 mSnapshotValid(false),
+		 mpPhysicsThread(NULL),
+		 mpStepSnapshot(NULL),
+		 mStepping(false),
+		 mPendingSteps(0),
+		 mBatch(0),
+		 mThreadStepTime(0.0f),
+		 mThreadPublishTime(0.0f),
+		 mInterpolationTime(0.0f),
+		 mPreviousFront(0),
+		 mValidateCounter(0),
+		 mDebugDraw(debugdrawimpl != NULL),
+		 mpBakedBody(NULL)
 	{
+		memset(&mTOIStatistics,0,sizeof(b2TOIStatistics));
+		memset(&mIterationStatistics,0,sizeof(b2IterationStatistics));
+		memset(&mTriggerStatistics,0,sizeof(b2TriggerStatistics));
+		memset(&mSnapshotStatistics,0,sizeof(WorldSnapshotStatistics));
+		memset(&mContactBufferStatistics,0,sizeof(ContactBufferStatistics));
+		memset(&mContactFilterStatistics,0,sizeof(ContactFilterStatistics));
+		memset(&mContactFilterCounters,0,sizeof(ContactFilterStatistics));
+		memset(&mThreadStatistics,0,sizeof(PhysicsThreadStatistics));
+		memset(&mThreadCounters,0,sizeof(PhysicsThreadStatistics));
+		memset(&mStepProfile,0,sizeof(b2Profile));
+		memset(&mAverageStepProfile,0,sizeof(b2Profile));
+		memset(&mCollideStatistics,0,sizeof(b2CollideStatistics));
+		memset(&mAllocatorStatistics,0,sizeof(b2AllocatorStatistics));
+		memset(&mBakeStatistics,0,sizeof(BakeStatistics));
+		//Reserve contact buffers once
+		mContactPoints.Reserve(CONTACTBUFFERRESERVE);
+		mContactResults.Reserve(CONTACTBUFFERRESERVE);
 		//Construct a world using parameters supplied
 		//AABB for the world
 		b2AABB worldAABB;
@@ -233,11 +513,16 @@ public:
 		worldAABB.upperBound.Set(upperbound.x, upperbound.y);
 	
 		//Construct the world object, and allow bodies to sleep
-		mpTheWorld = new b2World(worldAABB,gravity,true);
+		mpTheWorld = new b2World(worldAABB,gravity,true,broadphase);
+		//Solve separate islands of bodies in parallel
+		mpTheWorld->SetSolverThreadCount(solverthreads);
+		//Contact solver algorithm
+		mpTheWorld->SetContactSolverType(contactsolver);
 		
 		//Config contact listener
 		mpContactListener = new GameContactListener(this);
 		mpTheWorld->SetContactListener(mpContactListener);
+		mpTheWorld->SetTriggerListener(mpContactListener);	//Trigger shapes (collectables) enter/exit, buffered as contacts
 		//Config boundary listener
 		mpBoundaryListener = new GameBoundaryListener(this);
 		mpTheWorld->SetBoundaryListener(mpBoundaryListener);
@@ -248,10 +533,19 @@ public:
 			mpTheWorld->SetDebugDraw(debugdrawimpl);
 		}
 
-		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager","World constructed successfully",LOGNORMAL);
+		//Step world in its own thread (if requested)
+		if(physicsthread)
+			_startPhysicsThread();
+
+		SingletonLogMgr::Instance()->AddNewLine("PhysicsManager",
+												broadphase == e_dynamicTreeBroadPhase ? "World constructed successfully (Dynamic tree broadphase)" : "World constructed successfully (SAP broadphase)",
+												LOGNORMAL);
 	}
 	~PhysicsManager()
 	{
+		//Physics thread ends before world is deleted
+		_stopPhysicsThread();
+
 		//Clear dynamic memory - Note that by deleting only the world
 		//all other elements contained are deleted... nice!
 		if(mpTheWorld)
@@ -281,6 +575,32 @@ public:
 	b2Joint* GetJoint(const std::string &name);
 	bool IsPhysicsStepped() { return mPhysicsStepped; }    //Returns control variable to know if in last update physics was stepped
 	float GetSteppedTime() { return mTimeStepped; }			//Returns the time which simulation advanced
+	b2PairStatistics GetPairStatistics() const { b2PairStatistics stats; mpTheWorld->GetPairStatistics(&stats); return stats; }  //Broad-phase pair table usage (lookups of last physics step)
+	b2ContactSolverStatistics GetContactSolverStatistics() const { b2ContactSolverStatistics stats; mpTheWorld->GetContactSolverStatistics(&stats); return stats; }  //Contacts solved in SIMD batches (last physics step)
+	const b2CollideStatistics& GetCollideStatistics() const { return mCollideStatistics; }  //Contacts updated, skipped (apart) and with manifold reused (last physics step)
+	const b2AllocatorStatistics& GetAllocatorStatistics() const { return mAllocatorStatistics; }  //Stack allocators high-water marks and block allocators usage (after last physics step)
+	const b2TOIStatistics& GetTOIStatistics() const { return mTOIStatistics; }  //Continuous collision events, recomputes and time (all steps of last update)
+	const b2IterationStatistics& GetIterationStatistics() const { return mIterationStatistics; }  //Solver iterations of islands, by class and histograms (all steps of last update)
+	const b2TriggerStatistics& GetTriggerStatistics() const { return mTriggerStatistics; }  //Trigger pairs tested, enters and exits (all steps of last update)
+	void SetIslandIterations(bool adaptive, int32 stackiterations, int32 softbodyiterations);  //Iterations of stacks and soft bodies (0 = general ones), early out of velocity iterations
+	const b2Profile& GetStepProfile() const { return mStepProfile; }				//Time of phases of last physics step, and world counts
+	const b2Profile& GetAverageStepProfile() const { return mAverageStepProfile; }	//Time of phases averaged over last steps
+	int GetAwakeBodiesCount() const { return mAwakeBodiesCount; }		//Dynamic bodies awake after last physics step
+	int GetSleepingBodiesCount() const { return mSleepingBodiesCount; }	//Dynamic bodies sleeping after last physics step
+	const ContactBufferStatistics& GetContactBufferStatistics() const { return mContactBufferStatistics; }  //Contact points and results buffered in last update
+	const ContactFilterStatistics& GetContactFilterStatistics() const { return mContactFilterStatistics; }  //Contact callbacks received and dropped by subscriptions in last update
+	void SetCollisionDispatcher(ICollisionDispatcher* dispatcher) { mpCollisionDispatcher = dispatcher; }  //Collisions go to dispatcher instead of events (NULL to unregister)
+	const WorldSnapshotStatistics& GetSnapshotStatistics() const { return mSnapshotStatistics; }  //Size of world snapshot and restore time
+	bool IsSnapshotValid() const { return mSnapshotValid; }		//Snapshot taken and world bodies, joints and controllers not changed since then
+	bool IsStepping() const { return mStepping; }		//Physics thread is stepping: world must not be used (see WaitForSteps)
+	const PhysicsThreadStatistics& GetThreadStatistics() const { return mThreadStatistics; }  //Physics thread steps and waits (last frame)
+	b2XForm GetBodyTransform(b2Body* body) const;		//Last completed transform of body (while physics thread steps: step snapshot read)
+	b2Vec2 GetBodyPosition(b2Body* body) const { return GetBodyTransform(body).position; }
+	float32 GetInterpolationFactor() const;				//Time of rendered frame between last two physics steps (0-1)
+	b2XForm GetInterpolatedTransform(b2Body* body) const;	//Transform of body to render (between last two physics steps)
+	b2Vec2 GetInterpolatedPosition(b2Body* body) const { return GetInterpolatedTransform(body).position; }
+	int GetBodyContacts(b2Body* body, std::vector<StepContact>& contacts) const;	//Touching contacts of a dynamic body after last completed step (appended, returns number found)
+	const BakeStatistics& GetBakeStatistics() const { return mBakeStatistics; }	//Static geometry baked at level load
 	//----- OTHER FUNCTIONS -----
 	//Methods to create / destroy physics elements
 	b2Body* CreateBody(const b2BodyDef* definition,const std::string& name);
@@ -297,17 +617,46 @@ public:
 	void DestroyJoint(const std::string& jointname);
 	void CreateMouseJoint(b2MouseJointDef* jointdef);
 	void DestroyMouseJoint();
+	b2Controller* CreateController(b2ControllerDef* definition);	//Controllers are not named: the creator keeps the pointer
+	void DestroyController(b2Controller* controller);
+	//Static geometry baking (level load): polygons of static bodies are merged in edge chains of one body.
+	//Baked bodies are kept without shapes (names, agents and joints stay), their edges point back to them
+	int BakeStaticBodies(const std::vector<std::string>& bodynames);	//Returns bodies baked (only static bodies of solid polygons)
 	//Queries
 	b2Body* QueryforBodies(const b2Vec2 &thepoint, bool includestatic = false);	//Query for bodies in a point (through AABB)
-	std::vector <b2Body*> QueryforBodies(const b2AABB &boundingbox, bool includestatic = false);  //Query for bodies inside AABB
+	int QueryforBodies(const b2AABB &boundingbox, std::vector<b2Body*>& foundbodies, bool includestatic = false);  //Query for bodies inside AABB (appended, returns number found)
 	bool QueryforoneBody(const b2AABB &boundingbox, const std::string &bodytofind); //Query for a specific body inside an AABB
+	//Queries with visitor (no limit of results)
+	void QueryAABB(const b2AABB &boundingbox, IPhysicsQueryVisitor* visitor, int queryindex = 0);	//Shapes which AABB overlaps the box
+	void QueryAABBs(const b2AABB* boxes, int count, IPhysicsQueryVisitor* visitor);		//Batch of boxes (query index is the box index)
+	void QueryPoint(const b2Vec2 &thepoint, IPhysicsQueryVisitor* visitor, int queryindex = 0);	//Shapes containing the point
+	void QueryPoints(const b2Vec2* points, int count, IPhysicsQueryVisitor* visitor);	//Batch of points (query index is the point index)
+	void RaycastSegment(const b2Segment &segment, IPhysicsRaycastVisitor* visitor, bool solidshapes = true, int queryindex = 0);	//Shapes hit by segment, in order (no limit, visitor can stop it)
+	void RaycastSegments(const b2Segment* segments, int count, IPhysicsRaycastVisitor* visitor, bool solidshapes = true);	//Batch of segments (query index is the segment index)
+
+	//World snapshot (fast restart of level)
+	void TakeSnapshot();		//Store state of world
+	bool RestoreSnapshot();		//Back to stored state (false if not valid: world needs to be created again)
 
 	//Advanced (not simple) bodies properties modification
 	void ChangeFrictionofBody(b2Body* thebody, float newfriction);   //Changes de friction of all shapes within the body
+	void ChangeFrictionofBodies(const std::vector<b2Body*>& bodies, const std::vector<float>& newfrictions);	//Changes friction of many bodies at once (contacts are kept)
+	//Materials: friction and restitution shared by shapes. Changing one changes contacts of its shapes in place
+	int CreateMaterial(float friction, float restitution);		//Returns material id
+	void ChangeMaterial(int material, float friction, float restitution);
+	void SetMaterialofBody(b2Body* thebody, int material);		//Material of all shapes within the body (b2_nullMaterial: own friction and restitution)
 	
 	//Updating methods
 	void Update (float dt);
 	void DebugRender();
+	//Physics thread: steps computed in update are done while the game does the rest of the frame.
+	//After each step the thread publishes transforms and contacts (step snapshot). While it steps, the
+	//game reads them (ReadStepSnapshot, GetBodyTransform, GetBodyContacts) and queues events which use
+	//the world (QueueCommand). Any other method of this class using the world waits for the thread first
+	void StartSteps();			//Hand steps to physics thread (game logic of frame done)
+	void WaitForSteps();		//Returns when physics thread is done (world can be used)
+	void QueueCommand(EventDataPointer const& command, IEventListener* handler);	//Event handled by handler in next update (world can be used then)
+	bool ReadStepSnapshot();	//Newest step done by physics thread is read, never waits (once per rendered frame). False if none newer
 	
 protected:
 	//----- INTERNAL VARIABLES -----
@@ -321,19 +670,69 @@ protected:
 	float32 mTimeAccumulator; //Step control variables
 	bool mPhysicsStepped;	  //Very important variable to check when actuating or applying forces to bodies,
 							  //as refresh rate of game is not the same as physics engine...!
+	b2TOIStatistics mTOIStatistics;	//Continuous collision counters summed over the steps of last update
+	b2IterationStatistics mIterationStatistics;	//Islands solver iterations summed over the steps of last update
+	b2TriggerStatistics mTriggerStatistics;		//Trigger pairs counters summed over the steps of last update (pairs of last step)
+	int mAwakeBodiesCount;			//Sleeping tracking (dynamic bodies)
+	int mSleepingBodiesCount;
+	b2Profile mStepProfile;			//Step profiling (last step and rolling average)
+	b2Profile mAverageStepProfile;
+	int mValidateCounter;			//Steps since last validation of world (debug mode)
+	b2CollideStatistics mCollideStatistics;		//Narrow-phase counters of last step
+	b2AllocatorStatistics mAllocatorStatistics;	//Allocators usage after last step
 	
 	b2World* mpTheWorld;  //The world
 
 	GameContactListener* mpContactListener; //Contact-collision handling
-	ContactPointsMap mContactPoints;
-	ContactResultsMap mContactResults;
+	ContactInfoBuffer mContactPoints;	//Contact callbacks buffering
+	ContactInfoBuffer mContactResults;	//Contact result callbacks buffering
+	ContactBufferStatistics mContactBufferStatistics;
+	ICollisionDispatcher* mpCollisionDispatcher; //Collisions delivering (if not set, events are sent)
+	ContactFilterStatistics mContactFilterStatistics;	//Contact callbacks filtering (last update)
+	ContactFilterStatistics mContactFilterCounters;		//Contact callbacks filtering (counting)
+
+	bool mSnapshotValid;						//World snapshot (restart of level)
+	std::vector<BodySnapshot> mBodiesSnapshot;
+	std::vector<float32> mJointsSnapshot;		//States of joints and controllers, in world lists order
+	std::vector<float32> mControllersSnapshot;
+	std::vector<ContactPointSnapshot> mContactsSnapshot;	//Ordered to search
+	WorldSnapshotStatistics mSnapshotStatistics;
+
+	PhysicsThread* mpPhysicsThread;				//Physics thread (NULL if world is stepped in update)
+	PhysicsStepSnapshot* mpStepSnapshot;		//State published after each step by physics thread (NULL without it)
+	bool mStepping;								//Physics thread stepping (world in use)
+	int mPendingSteps;							//Steps to hand to physics thread
+	int mBatch;									//Steps handed (counter)
+	float mThreadStepTime;						//Time in physics thread in last steps (written by thread)
+	float mThreadPublishTime;
+	std::vector<QueuedCommand> mCommands;		//Commands received while stepping
+	float32 mInterpolationTime;					//Time after last completed step, for rendering (ms)
+	std::vector<BodyTransform> mPreviousTransforms[2];	//Transforms of moving bodies before last step (ordered to search)
+	int mPreviousFront;							//Buffer of previous transforms read by rendering (other one is written by steps)
+	PhysicsThreadStatistics mThreadStatistics;	//Physics thread (last frame)
+	PhysicsThreadStatistics mThreadCounters;	//Physics thread (counting)
+	bool mDebugDraw;							//Debug draw registered
 
 	GameBoundaryListener* mpBoundaryListener; //Boundary listener implementation
 
 	PhysBodiesMap mBodiesMap;  //Containers of created elements
 	JointsMap mJointsMap;
 	OutofBoundsVec mOutofBoundsBodies;	//Container to know which bodies should be destroyed
+	b2Body* mpBakedBody;				//Static geometry baked at level load (NULL if nothing baked)
+	BakedShapesMap mBakedShapes;		//Edges baked from each static body
+	BakeStatistics mBakeStatistics;
 	//----- INTERNAL FUNCTIONS -----
+	void _stepWorld(int steps);		//Steps of simulation (in update or physics thread)
+	static void _threadSteps(void* context, int steps);	//Steps in physics thread (step time is measured)
+	void _startPhysicsThread();
+	void _stopPhysicsThread();
+	void _waitSteps();				//Wait for physics thread and count times
+	void _runCommands();			//Handle commands received while stepping
+	void _destroyBakedShapes(b2Body* sourcebody);	//Edges baked from a body are destroyed with it
+	void _changeFrictionofBody(b2Body* thebody, float newfriction);	//Friction of shapes and baked edges of body
+	void _storePreviousTransforms();	//Transforms of moving bodies before last step (rendering interpolates)
+	void _takeAgentHandles(ContactInfo& info);	//Store handles of contact agents
+	bool _isContactSubscribed(b2Shape* shape1, b2Shape* shape2, ContactState state);	//Some agent wants the contact
 	//Events generation - Collisions
 	void _sendNewContactEvent(const ContactInfo& data);
 	void _sendDeleteContactEvent(const ContactInfo& data);
@@ -63,6 +63,10 @@ void PhysicsSim::UpdateGameState(float dt)
 			//Update camera in course
 			SingletonIndieLib::Instance()->UpdateCameras(steppedtime);
 		}
+
+		//Every frame: graphics are placed between last two physics steps (smooth with any frame rate)
+		mAgentsManager->InterpolateAgents();
+		SingletonIndieLib::Instance()->InterpolateCameras(mPhysicsMgr->GetInterpolationFactor());
 	}
 	//***************************************************************
 
@@ -82,6 +86,9 @@ void PhysicsSim::UpdateGameState(float dt)
 		mRestartLevel = false;
 	}//IF 
 	//****************************************************************
+
+	//Game logic of this frame is done: physics thread (if used) steps while the frame is rendered
+	mPhysicsMgr->StartSteps();
 }
 
 //Drawing of whole scene
@@ -170,6 +177,10 @@ void PhysicsSim::RestartCurrentLevel()
 	//IF - A previous level existed
 	if(mCurrentLevelPointer)
 	{
+		//IF - Fast restart: world back to snapshot taken after load, and agents back to start
+		if(_restartFromSnapshot())
+			return;
+
 		//Local variables
 		std::string levelname (mCurrentLevelPointer->GetName());
 	
@@ -289,6 +300,10 @@ void PhysicsSim::_resetAndPrepareLevel(const std::string& levelname, const std::
 										  physicsconf.iterations,
 										  physicsconf.worldaabbmax,
 										  physicsconf.worldaabbmin,
+										  physicsconf.broadphase,
+										  physicsconf.solverthreads,
+										  physicsconf.contactsolver,
+										  physicsconf.physicsthread,
 										  SingletonIndieLib::Instance()->Box2DDebugRender)
 					);
 	#else //NOT DEBUG MODE: DONT REGISTER DEBUG DRAW
@@ -297,9 +312,15 @@ void PhysicsSim::_resetAndPrepareLevel(const std::string& levelname, const std::
 										  physicsconf.timestep,
 										  physicsconf.iterations,
 										  physicsconf.worldaabbmax,
-										  physicsconf.worldaabbmin)
+										  physicsconf.worldaabbmin,
+										  physicsconf.broadphase,
+										  physicsconf.solverthreads,
+										  physicsconf.contactsolver,
+										  physicsconf.physicsthread)
 					);
 	#endif
+	//Iterations of stacks and soft bodies
+	mPhysicsMgr->SetIslandIterations(physicsconf.adaptiveiterations,physicsconf.stackiterations,physicsconf.softbodyiterations);
 	
 	//Create agents manager
 	mAgentsManager.reset();
@@ -332,6 +353,9 @@ void PhysicsSim::_resetAndPrepareLevel(const std::string& levelname, const std::
 	
 	//No errors, get level pointer
 	mCurrentLevelPointer = thebuilder.GetCreatedLevel();
+
+	//Store world state for fast restarts
+	mPhysicsMgr->TakeSnapshot();
 	//*****************************LEVEL LOADED*********************************
 
 	//************************RESET INTERNAL LOGIC VARIABLES********************
@@ -343,6 +367,31 @@ void PhysicsSim::_resetAndPrepareLevel(const std::string& levelname, const std::
 	//*************************VARIABLES RESET**********************************
 }
 
+//Restart level without loading it: world restored from snapshot and agents back to start
+bool PhysicsSim::_restartFromSnapshot()
+{
+	//IF - World changed (bodies created or destroyed, drops collected...)
+	if(!mPhysicsMgr->IsSnapshotValid())
+		return false;
+
+	//As we restarted level, empty queues of events
+	SingletonGameEventMgr::Instance()->EmptyEventQueues();
+
+	//IF - Not restored (if some agent already restarted, the level is loaded again anyway)
+	if(!mPhysicsMgr->RestoreSnapshot() || !mAgentsManager->RestartAgents())
+		return false;
+
+	//************************RESET INTERNAL LOGIC VARIABLES********************
+	//Level is already loaded: no first tick delay
+	mFirstStart = true;
+	mGameOver = false;
+	mLoadNextLevel = false;
+	mRestartLevel = false;
+	//*************************VARIABLES RESET**********************************
+
+	return true;
+}
+
 bool PhysicsSim::_handleEvents(const EventData& theevent)
 {
 	bool eventprocessed(false);
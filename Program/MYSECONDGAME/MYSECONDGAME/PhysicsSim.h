@@ -104,6 +104,8 @@ private:
 	void _loadLevels();
 	//Load a level, reset managers and restart internal logic variables
 	void _resetAndPrepareLevel(const std::string& levelname, const std::string& levelfilepath);
+	//Restart current level from world snapshot (false if not possible)
+	bool _restartFromSnapshot();
 
 	//Event handling
 	bool _handleEvents(const EventData& theevent);
@@ -0,0 +1,241 @@
+/*
+	Filename: PhysicsStepSnapshot.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Transforms and touching contacts of the world after each physics step, published by the
+				 physics thread and read by the game thread while the thread goes on stepping
+	Comments: Three frames: one written, the newest published and the one read. Publishing and reading
+			  swap frames under a lock, so the game thread never waits for steps, only for a swap.
+			  Only dynamic bodies are stored (steps dont move static ones).
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "PhysicsStepSnapshot.h"
+#include <algorithm>
+#include <cassert>
+
+#ifdef _WIN32
+#include <windows.h>
+
+//Lock of frames swap
+struct PhysicsStepSnapshot::SnapshotLock
+{
+	SnapshotLock() { InitializeCriticalSection(&section); }
+	~SnapshotLock() { DeleteCriticalSection(&section); }
+	void Lock() { EnterCriticalSection(&section); }
+	void Unlock() { LeaveCriticalSection(&section); }
+
+	CRITICAL_SECTION section;
+};
+
+#else	//Tests out of the game (see PhysicsTests)
+#include <pthread.h>
+
+//Lock of frames swap
+struct PhysicsStepSnapshot::SnapshotLock
+{
+	SnapshotLock() { pthread_mutex_init(&mutex,NULL); }
+	~SnapshotLock() { pthread_mutex_destroy(&mutex); }
+	void Lock() { pthread_mutex_lock(&mutex); }
+	void Unlock() { pthread_mutex_unlock(&mutex); }
+
+	pthread_mutex_t mutex;
+};
+
+#endif
+
+//Creation with empty frames
+PhysicsStepSnapshot::PhysicsStepSnapshot():
+mpLock(new SnapshotLock()),
+mWrite(0),
+mNewest(1),
+mRead(2),
+mNewestUnread(false)
+{
+	Clear();
+}
+
+PhysicsStepSnapshot::~PhysicsStepSnapshot()
+{
+	delete mpLock;
+}
+
+//Transforms before a step
+void PhysicsStepSnapshot::BeginStep(b2World* world)
+{
+	assert(world);
+	mBefore.clear();
+	//LOOP - Dynamic bodies (sleeping ones can be woken by the island they touch, and moved in the step)
+	for(b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+	{
+		if(body->IsStatic() || body->IsFrozen())
+			continue;
+		StepBody before;
+		before.body = body;
+		before.xform = body->GetXForm();
+		before.previous = before.xform;
+		mBefore.push_back(before);
+	}//LOOP END
+	std::sort(mBefore.begin(),mBefore.end());
+}
+
+//State after a step is the newest frame (step 0: transforms before are the ones of read frame)
+void PhysicsStepSnapshot::Publish(b2World* world, int batch, int step, int steps)
+{
+	assert(world);
+	StepFrame& frame (mFrames[mWrite]);
+	frame.batch = batch;
+	frame.step = step;
+	frame.steps = steps;
+	frame.bodies.clear();
+	frame.contacts.clear();
+
+	//Steps handed: read frame is not changed until it is published (game thread writes and reads)
+	const std::vector<StepBody>& before (step == 0 ? mFrames[mRead].bodies : mBefore);
+
+	//LOOP - Dynamic bodies
+	for(b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+	{
+		if(body->IsStatic())
+			continue;
+
+		StepBody state;
+		state.body = body;
+		state.xform = body->GetXForm();
+		state.previous = state.xform;
+		std::vector<StepBody>::const_iterator itr = std::lower_bound(before.begin(),before.end(),state);
+		//IF - Body moved in step (or in last step before handing steps)
+		if(itr != before.end() && (*itr).body == body)
+			state.previous = step == 0 ? (*itr).previous : (*itr).xform;
+		frame.bodies.push_back(state);
+	}//LOOP END
+	AddWorldContacts(world,NULL,frame.contacts);
+	std::sort(frame.bodies.begin(),frame.bodies.end());
+	std::stable_sort(frame.contacts.begin(),frame.contacts.end());
+
+	//Written frame is the newest now
+	mpLock->Lock();
+	std::swap(mWrite,mNewest);
+	mNewestUnread = true;
+	mpLock->Unlock();
+}
+
+//Newest published frame is read from now on (false if there is not a newer one). Never waits for steps
+bool PhysicsStepSnapshot::Read()
+{
+	bool newer (false);
+	mpLock->Lock();
+	//IF - Published after last read
+	if(mNewestUnread)
+	{
+		std::swap(mRead,mNewest);
+		mNewestUnread = false;
+		newer = true;
+	}//IF
+	mpLock->Unlock();
+	return newer;
+}
+
+//Body in read frame (NULL if not there: static or created later)
+const StepBody* PhysicsStepSnapshot::FindBody(b2Body* body) const
+{
+	const std::vector<StepBody>& bodies (mFrames[mRead].bodies);
+	StepBody tofind;
+	tofind.body = body;
+	std::vector<StepBody>::const_iterator itr = std::lower_bound(bodies.begin(),bodies.end(),tofind);
+	//IF - Found
+	if(itr != bodies.end() && (*itr).body == body)
+		return &(*itr);
+
+	return NULL;
+}
+
+//Contacts of body in read frame (appended, returns number found)
+int PhysicsStepSnapshot::GetBodyContacts(b2Body* body, std::vector<StepContact>& contacts) const
+{
+	const std::vector<StepContact>& stored (mFrames[mRead].contacts);
+	StepContact tofind;
+	tofind.body = body;
+	std::vector<StepContact>::const_iterator itr = std::lower_bound(stored.begin(),stored.end(),tofind);
+	int found (0);
+	//LOOP - Contacts of body are together
+	for(; itr != stored.end() && (*itr).body == body; ++itr)
+	{
+		contacts.push_back(*itr);
+		++found;
+	}//LOOP END
+
+	return found;
+}
+
+//Touching contacts of body in world (NULL: of every dynamic body). Appended, returns number found
+int PhysicsStepSnapshot::AddWorldContacts(b2World* world, b2Body* body, std::vector<StepContact>& contacts)
+{
+	assert(world);
+	int found (0);
+	//LOOP - Contacts with points (sensors dont touch)
+	for(b2Contact* contact = world->GetContactList(); contact; contact = contact->GetNext())
+	{
+		if(contact->GetManifoldCount() == 0 || !contact->IsSolid())
+			continue;
+
+		const b2Manifold& manifold (contact->GetManifolds()[0]);
+		b2Body* body1 = contact->GetShape1()->GetBody();
+		b2Body* body2 = contact->GetShape2()->GetBody();
+		StepContact touching;
+		touching.point = b2Mul(body1->GetXForm(),manifold.points[0].localPoint1);
+		touching.pointcount = manifold.pointCount;
+		//IF - Wanted for first body
+		if(body ? body1 == body : !body1->IsStatic())
+		{
+			touching.body = body1;
+			touching.other = body2;
+			touching.normal = manifold.normal;
+			contacts.push_back(touching);
+			++found;
+		}//IF
+		//IF - Wanted for second body
+		if(body ? body2 == body : !body2->IsStatic())
+		{
+			touching.body = body2;
+			touching.other = body1;
+			touching.normal = -manifold.normal;
+			contacts.push_back(touching);
+			++found;
+		}//IF
+	}//LOOP END
+
+	return found;
+}
+
+//Frames are dropped (bodies of world destroyed or moved out of steps). Not while stepping
+void PhysicsStepSnapshot::Clear()
+{
+	//LOOP - Frames
+	for(int i = 0; i < 3; ++i)
+	{
+		mFrames[i].batch = 0;
+		mFrames[i].step = 0;
+		mFrames[i].steps = 0;
+		mFrames[i].bodies.clear();
+		mFrames[i].contacts.clear();
+	}//LOOP END
+	mBefore.clear();
+	mNewestUnread = false;
+}
+
+//Body created with memory of a destroyed one is dropped from frames. Not while stepping
+void PhysicsStepSnapshot::ForgetBody(b2Body* body)
+{
+	StepBody tofind;
+	tofind.body = body;
+	//LOOP - Frames
+	for(int i = 0; i < 3; ++i)
+	{
+		std::vector<StepBody>& bodies (mFrames[i].bodies);
+		std::vector<StepBody>::iterator itr = std::lower_bound(bodies.begin(),bodies.end(),tofind);
+		if(itr != bodies.end() && (*itr).body == body)
+			bodies.erase(itr);
+	}//LOOP END
+}
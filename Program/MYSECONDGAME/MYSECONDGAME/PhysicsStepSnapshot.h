@@ -0,0 +1,96 @@
+/*
+	Filename: PhysicsStepSnapshot.h
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Transforms and touching contacts of the world after each physics step, published by the
+				 physics thread and read by the game thread while the thread goes on stepping
+	Comments: Three frames: one written, the newest published and the one read. Publishing and reading
+			  swap frames under a lock, so the game thread never waits for steps, only for a swap.
+			  Only dynamic bodies are stored (steps dont move static ones).
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#ifndef _PHYSICSSTEPSNAPSHOT
+#define _PHYSICSSTEPSNAPSHOT
+
+//Library dependencies
+#include <vector>
+#include "Box2D\Box2D.h"
+//Class dependencies
+
+//Dynamic body after a step
+typedef struct StepBody
+{
+	b2Body* body;
+	b2XForm xform;			//After step
+	b2XForm previous;		//Before step (rendering interpolates)
+	//Operator less - than to search them (ordered by body)
+	bool operator <(const StepBody& tocompare) const
+	{
+		return body < tocompare.body; //Ugly pointer less-than compare...
+	}
+}StepBody;
+
+//Touching contact of a dynamic body after a step (stored for both bodies if both are dynamic)
+typedef struct StepContact
+{
+	b2Body* body;
+	b2Body* other;
+	b2Vec2 point;			//First contact point (world coords)
+	b2Vec2 normal;			//From body to other
+	int pointcount;
+	//Operator less - than to search them (ordered by body)
+	bool operator <(const StepContact& tocompare) const
+	{
+		return body < tocompare.body; //Ugly pointer less-than compare...
+	}
+}StepContact;
+
+//State of world after a step
+typedef struct StepFrame
+{
+	int batch;							//Steps handed together to physics thread (counter)
+	int step;							//Steps of batch done (0 = state when steps were handed)
+	int steps;							//Steps of batch
+	std::vector<StepBody> bodies;		//Ordered to search
+	std::vector<StepContact> contacts;	//Ordered to search
+}StepFrame;
+
+class PhysicsStepSnapshot
+{
+public:
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+	PhysicsStepSnapshot();
+	~PhysicsStepSnapshot();
+	//----- GET/SET FUNCTIONS -----
+	const StepFrame& GetFrame() const { return mFrames[mRead]; }	//Frame read by game thread (see Read)
+	//----- OTHER FUNCTIONS -----
+	//Writing (physics thread while stepping, game thread when handing steps)
+	void BeginStep(b2World* world);		//Transforms before a step
+	void Publish(b2World* world, int batch, int step, int steps);	//State after a step is the newest frame (step 0: transforms before are the ones of read frame)
+	//Reading (game thread)
+	bool Read();		//Newest published frame is read from now on (false if there is not a newer one). Never waits for steps
+	const StepBody* FindBody(b2Body* body) const;	//Body in read frame (NULL if not there: static or created later)
+	int GetBodyContacts(b2Body* body, std::vector<StepContact>& contacts) const;	//Contacts of body in read frame (appended, returns number found)
+	void Clear();		//Frames are dropped (bodies of world destroyed or moved out of steps). Not while stepping
+	void ForgetBody(b2Body* body);	//Body created with memory of a destroyed one is dropped from frames. Not while stepping
+	static int AddWorldContacts(b2World* world, b2Body* body, std::vector<StepContact>& contacts);	//Touching contacts of body in world (NULL: of every dynamic body). Appended, returns number found
+	//----- PUBLIC VARIABLES ------
+
+private:
+	//----- INTERNAL VARIABLES -----
+	struct SnapshotLock;			//System lock (defined for each platform)
+	SnapshotLock* mpLock;
+	StepFrame mFrames[3];			//Written, newest and read frames
+	int mWrite;
+	int mNewest;
+	int mRead;
+	bool mNewestUnread;				//Published after last read
+	std::vector<StepBody> mBefore;	//Transforms before step (only written by writer)
+	//----- INTERNAL FUNCTIONS -----
+	PhysicsStepSnapshot(const PhysicsStepSnapshot&);			//Not copied
+	PhysicsStepSnapshot& operator=(const PhysicsStepSnapshot&);
+};
+
+#endif
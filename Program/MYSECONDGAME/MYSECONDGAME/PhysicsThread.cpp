@@ -0,0 +1,171 @@
+/*
+	Filename: PhysicsThread.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Thread to step the physics world while the game does the rest of the frame (render...)
+	Comments: Only the physics manager uses it. While stepping, the world is owned by this thread.
+			  The steps are done by a callback, so the thread can be run out of the game (see PhysicsTests)
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "PhysicsThread.h"
+#include <cassert>
+
+#ifdef _WIN32
+
+//Creation of thread (waiting for steps)
+PhysicsThread::PhysicsThread(StepsCallback callback, void* context):
+mCallback(callback),
+mContext(context),
+mRunning(false),
+mSteps(0),
+mQuit(false),
+mThread(NULL)
+{
+	assert(mCallback);
+
+	mStartEvent = CreateEvent(NULL,FALSE,FALSE,NULL);
+	mDoneEvent = CreateEvent(NULL,FALSE,FALSE,NULL);
+	//IF - Events created
+	if(mStartEvent && mDoneEvent)
+		mThread = CreateThread(NULL,0,_threadMain,this,0,NULL);
+	mRunning = (mThread != NULL);
+}
+
+//Exit of thread (steps in course are finished)
+PhysicsThread::~PhysicsThread()
+{
+	//IF - Thread running
+	if(mRunning)
+	{
+		mQuit = true;
+		SetEvent(mStartEvent);
+		WaitForSingleObject(mThread,INFINITE);
+		CloseHandle(mThread);
+	}//IF
+
+	if(mStartEvent)
+		CloseHandle(mStartEvent);
+	if(mDoneEvent)
+		CloseHandle(mDoneEvent);
+}
+
+//Start stepping (returns at once)
+void PhysicsThread::BeginSteps(int steps)
+{
+	assert(mRunning && steps > 0);
+	mSteps = steps;
+	SetEvent(mStartEvent);
+}
+
+//Returns when started steps are done
+void PhysicsThread::WaitSteps()
+{
+	WaitForSingleObject(mDoneEvent,INFINITE);
+}
+
+//Thread function: steps the world when requested
+DWORD WINAPI PhysicsThread::_threadMain(LPVOID parameter)
+{
+	PhysicsThread* thethread = static_cast<PhysicsThread*>(parameter);
+
+	//LOOP - Wait for steps until exit
+	for(;;)
+	{
+		WaitForSingleObject(thethread->mStartEvent,INFINITE);
+		if(thethread->mQuit)
+			return 0;
+
+		thethread->mCallback(thethread->mContext,thethread->mSteps);
+
+		SetEvent(thethread->mDoneEvent);
+	}//LOOP END
+}
+
+#else	//Tests out of the game (see PhysicsTests)
+
+//Creation of thread (waiting for steps)
+PhysicsThread::PhysicsThread(StepsCallback callback, void* context):
+mCallback(callback),
+mContext(context),
+mRunning(false),
+mSteps(0),
+mQuit(false),
+mStart(false),
+mDone(false)
+{
+	assert(mCallback);
+
+	pthread_mutex_init(&mMutex,NULL);
+	pthread_cond_init(&mCondition,NULL);
+	mRunning = (pthread_create(&mThread,NULL,_threadMain,this) == 0);
+}
+
+//Exit of thread (steps in course are finished)
+PhysicsThread::~PhysicsThread()
+{
+	//IF - Thread running
+	if(mRunning)
+	{
+		pthread_mutex_lock(&mMutex);
+		mQuit = true;
+		pthread_cond_broadcast(&mCondition);
+		pthread_mutex_unlock(&mMutex);
+		pthread_join(mThread,NULL);
+	}//IF
+
+	pthread_cond_destroy(&mCondition);
+	pthread_mutex_destroy(&mMutex);
+}
+
+//Start stepping (returns at once)
+void PhysicsThread::BeginSteps(int steps)
+{
+	assert(mRunning && steps > 0);
+	pthread_mutex_lock(&mMutex);
+	mSteps = steps;
+	mStart = true;
+	mDone = false;
+	pthread_cond_broadcast(&mCondition);
+	pthread_mutex_unlock(&mMutex);
+}
+
+//Returns when started steps are done
+void PhysicsThread::WaitSteps()
+{
+	pthread_mutex_lock(&mMutex);
+	while(!mDone)
+		pthread_cond_wait(&mCondition,&mMutex);
+	mDone = false;
+	pthread_mutex_unlock(&mMutex);
+}
+
+//Thread function: steps the world when requested
+void* PhysicsThread::_threadMain(void* parameter)
+{
+	PhysicsThread* thethread = static_cast<PhysicsThread*>(parameter);
+
+	//LOOP - Wait for steps until exit
+	for(;;)
+	{
+		pthread_mutex_lock(&thethread->mMutex);
+		while(!thethread->mStart && !thethread->mQuit)
+			pthread_cond_wait(&thethread->mCondition,&thethread->mMutex);
+		bool quit (thethread->mQuit);
+		thethread->mStart = false;
+		int steps (thethread->mSteps);
+		pthread_mutex_unlock(&thethread->mMutex);
+		if(quit)
+			return NULL;
+
+		thethread->mCallback(thethread->mContext,steps);
+
+		pthread_mutex_lock(&thethread->mMutex);
+		thethread->mDone = true;
+		pthread_cond_broadcast(&thethread->mCondition);
+		pthread_mutex_unlock(&thethread->mMutex);
+	}//LOOP END
+}
+
+#endif
@@ -0,0 +1,66 @@
+/*
+	Filename: PhysicsThread.h
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Thread to step the physics world while the game does the rest of the frame (render...)
+	Comments: Only the physics manager uses it. While stepping, the world is owned by this thread.
+			  The steps are done by a callback, so the thread can be run out of the game (see PhysicsTests)
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#ifndef _PHYSICSTHREAD
+#define _PHYSICSTHREAD
+
+//Library dependencies
+#ifdef _WIN32
+#include <windows.h>   //Threads and events
+#else
+#include <pthread.h>   //Tests out of the game
+#endif
+//Class dependencies
+
+class PhysicsThread
+{
+public:
+	typedef void (*StepsCallback)(void* context, int steps);	//Does the steps (called in the thread)
+
+	//----- CONSTRUCTORS/DESTRUCTORS -----
+	PhysicsThread(StepsCallback callback, void* context);
+	~PhysicsThread();
+	//----- GET/SET FUNCTIONS -----
+	bool IsRunning() const { return mRunning; }		//Thread was created
+	//----- OTHER FUNCTIONS -----
+	void BeginSteps(int steps);		//Start stepping (returns at once)
+	void WaitSteps();				//Returns when started steps are done
+	//----- PUBLIC VARIABLES ------
+
+private:
+	//----- INTERNAL VARIABLES -----
+	StepsCallback mCallback;
+	void* mContext;
+	bool mRunning;
+	int mSteps;						//Steps to do
+	volatile bool mQuit;			//Thread exit request
+	#ifdef _WIN32
+	HANDLE mThread;
+	HANDLE mStartEvent;				//Auto reset events to start and end steps
+	HANDLE mDoneEvent;
+	#else
+	pthread_t mThread;
+	pthread_mutex_t mMutex;
+	pthread_cond_t mCondition;		//Signaled to start and end steps
+	bool mStart;
+	bool mDone;
+	#endif
+	//----- INTERNAL FUNCTIONS -----
+	#ifdef _WIN32
+	static DWORD WINAPI _threadMain(LPVOID parameter);
+	#else
+	static void* _threadMain(void* parameter);
+	#endif
+	PhysicsThread(const PhysicsThread&);			//Not copied
+	PhysicsThread& operator=(const PhysicsThread&);
+};
+
+#endif
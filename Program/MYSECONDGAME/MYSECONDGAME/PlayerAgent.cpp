@@ -331,8 +331,8 @@ bool PlayerAgent::HandleCollision(const CollisionEventData& data)
 	}//IF
 	//****************************************************************************************
 	//************************PROCESS SPECIAL CASE OF BLOB-COLLECTABLE COLLISION**************
-	//IF - New collision with main blob
-	if(data.GetEventType() == Event_NewCollision 
+	//IF - Main blob entered a collectable (collectables are triggers: no contacts with them)
+	if(data.GetEventType() == Event_TriggerEnter 
 	   &&
 	   !mSecondControl && !mSecondBlobController
 	   &&
@@ -664,6 +664,40 @@ void PlayerAgent::Destroy()
 	mActive = false;
 }
 
+//Back to state after level load (blob bodies restored by physics manager)
+bool PlayerAgent::Restart()
+{
+	//IF - Blob destroyed or thrown blobs (created after level load)
+	if(!mActive || mSecondBlobController || !mBlobsList.empty())
+		return false;
+
+	//IF - Blob cant restart
+	if(!mBlobController->Restart())
+		return false;
+
+	//Reset control and graphics
+	mAlive = true;
+	mControlDelay = -1.0f;
+	mSecondControl = false;
+	mBlobCollisionsList.clear();
+	mLinearVel = Vector2(0.0f,0.0f);
+	mParams.drawcolor = mParams.originaldrawcolor;
+	mAnimController->ForceDefaultAnim(false);
+
+	//Report others of change of health
+	BlobHealthInfo info(mBlobController->GetIntegrity(),mBlobController->IsIntegrityVeryLow());
+	SingletonGameEventMgr::Instance()->QueueEvent(
+											  EventDataPointer(new BlobHealthEvent(Event_BlobHealth,info))
+												);
+
+	//Update general camera position in player position
+	mParams.position = Vector2 (mBlobController->GetInitialParameters().initialx,
+						mBlobController->GetInitialParameters().initialy);
+	SingletonIndieLib::Instance()->GetCamera("General")->SetPosition(mParams.position );
+
+	return true;
+}
+
 //Called to set the pointer to blob controller
 void PlayerAgent::SetBlobController(BlobControllerPointer pointer) 
 { 
@@ -705,11 +739,11 @@ void PlayerAgent::_drawBlob(BlobControllerPointer thepointer,float radiusoffset,
 	BlobController::BodiesVector::const_reverse_iterator bodieslistend = thepointer->GetOuterBodiesListEnd();
 
 	//------Get center position-----
-	b2Vec2 centerpos = thepointer->GetCenterBody()->GetPosition(); 
+	b2Vec2 centerpos = mPhysicsMgr->GetInterpolatedPosition(thepointer->GetCenterBody()); //Rendering: between last two physics steps (thread can be stepping)
 	//Write start vertex to draw
 	drawpoints[0].x = static_cast<int>(mGlobalScale * centerpos.x);
 	drawpoints[0].y = static_cast<int>(mResY - (mGlobalScale * centerpos.y));
-	b2Vec2 bodypos = (*bodiesit)->GetPosition();
+	b2Vec2 bodypos = mPhysicsMgr->GetInterpolatedPosition(*bodiesit);
 	b2Vec2 raddir = bodypos - centerpos; //Get vector from center to point
 	float angle =  atan2(raddir.y,raddir.x); //Rotation angle	
 	b2Vec2 addradius(radiusoffset,0.0f);  //We have to add radius of body, to render last point!
@@ -730,7 +764,7 @@ void PlayerAgent::_drawBlob(BlobControllerPointer thepointer,float radiusoffset,
 		if(trianglevertex != 0)
 		{
 			//Write body vertex in triangle
-			b2Vec2 bodypos = (*bodiesit)->GetPosition();
+			b2Vec2 bodypos = mPhysicsMgr->GetInterpolatedPosition(*bodiesit);
 			b2Vec2 raddir = bodypos - centerpos; //Get vector from center to point
 			float angle =  atan2(raddir.y,raddir.x); //Rotation angle	
 			b2Vec2 addradius(radiusoffset,0.0f);  //We have to add radius of body, to render last point!
@@ -792,12 +826,35 @@ void PlayerAgent::_drawBlob(BlobControllerPointer thepointer,float radiusoffset,
 										  static_cast<byte>(drawcolor.alpha));	
 }
 
-void PlayerAgent::_updateBlobGFX(float dt)
+//Place blob sprite between last two physics steps (every frame)
+void PlayerAgent::InterpolateGFX()
+{
+	//IF - Agent is active
+	if(!mActive)
+		return;
+
+	_updateBlobSprite();
+}
+
+//Sprite placement with controlled blob position to render
+void PlayerAgent::_updateBlobSprite()
 {
+	//Controlled blob center (between last two physics steps)
+	b2Body* centerbody (mBlobController->GetCenterBody());
+	//IF - Second blob controlled
+	if(mSecondControl && mSecondBlobController)
+		centerbody = mSecondBlobController->GetCenterBody();
+	b2Vec2 position (mPhysicsMgr->GetInterpolatedPosition(centerbody));
+
 	//Update position of sprite (scaled to pixels)
-	mParams.sprite.gfxentity->SetPosition(static_cast<float>(mParams.position.x * mGlobalScale),
-									   static_cast<float>(mResY - (mParams.position.y * mGlobalScale)),
+	mParams.sprite.gfxentity->SetPosition(static_cast<float>(position.x * mGlobalScale),
+									   static_cast<float>(mResY - (position.y * mGlobalScale)),
 									   0);
+}
+
+void PlayerAgent::_updateBlobGFX(float dt)
+{
+	_updateBlobSprite();
 
 	//Update scaling of sprite and track damage
 	bool isnewdamage(false);
@@ -918,6 +975,11 @@ void PlayerAgent::_init()
 	//Init internal variables
 	mGlobalScale = SingletonIndieLib::Instance()->GetGeneralScale();
 	mResY = static_cast<float>(SingletonIndieLib::Instance()->Window->GetHeight());
+	//Contacts processed: persisting contacts are not used by blobs, and results (damage) only from other agents
+	_subscribeContacts(CONTACTADDEDMASK | CONTACTREMOVEDMASK | CONTACTRESULTMASK);
+	_subscribeContacts(PLAYER,CONTACTADDEDMASK | CONTACTREMOVEDMASK);
+	//Collectables are picked when entered (trigger shapes)
+	_subscribeContacts(COLLECTABLE,CONTACTTRIGGERENTERMASK);
 }
 
 
@@ -119,6 +119,8 @@ public:
 	virtual void HandleOutOfLimits(const OutOfLimitsEventData& data);								//Handle out of limits
 	virtual void Create( const GameAgentPar *params);				//Create from params
 	virtual void Destroy();											//Destroy body
+	virtual bool Restart();											//Back to state after level load
+	virtual void InterpolateGFX();									//Place blob sprite between last two physics steps
 
 protected:
 	//---- INTERNAL VARIABLES ----
@@ -145,6 +147,7 @@ protected:
 	//---- INTERNAL FUNCTIONS ----
 	void _drawBlob(BlobControllerPointer thepointer,float radiusoffset,const ColorRGBA& drawcolor); //Draw a blob
 	void _updateBlobGFX(float dt);						//GFX updating (indielib)
+	void _updateBlobSprite();							//Sprite placement with controlled blob position to render
 	void _init();
 	void _release();								//Release internal resorces
 };
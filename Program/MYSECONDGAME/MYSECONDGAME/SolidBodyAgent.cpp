@@ -33,8 +33,27 @@ void SolidBodyAgent::UpdateState(float dt)
 	//Update internal timer
 	mCounter += dt;
 
-	//Read position of body
-	b2XForm bodytransform (mParams.physicbody->GetXForm());
+	_updateSprites();
+
+	if(mOutOfLimits)
+		Destroy();	
+}
+
+//Place sprites between last two physics steps (every frame)
+void SolidBodyAgent::InterpolateGFX()
+{
+	//IF - Agent is active
+	if(!mActive)
+		return;
+
+	_updateSprites();
+}
+
+//Sprites placement with body transform to render
+void SolidBodyAgent::_updateSprites()
+{
+	//Read position of body (between last two physics steps)
+	b2XForm bodytransform (mPhysicsManager->GetInterpolatedTransform(mParams.physicbody));
 	
 	std::list<ContainedSprite>::iterator itr;
 	//LOOP - All sprites created
@@ -58,9 +77,6 @@ void SolidBodyAgent::UpdateState(float dt)
 			(*itr).gfxentity->SetPosition(static_cast<float>(positionpix.x),static_cast<float>(positionpix.y),0);
 		}//IF
 	}//LOOP END
-
-	if(mOutOfLimits)
-		Destroy();	
 }
 
 //Process possible collisions
@@ -165,8 +181,9 @@ bool SolidBodyAgent::HandleEvent(const EventData& theevent)
 		//IF - Atts changed
 		if(change)
 		{
-			//Change friction of body according to wetness param
-			mPhysicsManager->ChangeFrictionofBody(mParams.physicbody,mInitialFriction * (1 - mParams.wetness));
+			//Friction of body according to wetness param is changed by agents manager: all bodies
+			//wetted by the blob death at once (see GetFriction)
+			eventprocessed = true;
 
 			//Tint body according to new wetness
 			ColorHSLA newcolor = mWetTintColor;
@@ -199,6 +216,18 @@ void SolidBodyAgent::HandleOutOfLimits(const OutOfLimitsEventData&)
 	mOutOfLimits = true;
 }	
 
+//Back to state after level load (body restored by physics manager)
+bool SolidBodyAgent::Restart()
+{
+	//IF - Body is going to be destroyed
+	if(!mActive || mOutOfLimits)
+		return false;
+
+	//Contacts counters are kept: restored contacts are removed as usual
+	mCounter = 0.0f;
+	return true;
+}
+
 //Create from params
 void SolidBodyAgent::Create( const GameAgentPar *params)	
 {
@@ -236,6 +265,10 @@ void SolidBodyAgent::_init()
 	//Init internal variables
 	mGlobalScale = SingletonIndieLib::Instance()->GetGeneralScale();
 	mResY = static_cast<float>(SingletonIndieLib::Instance()->Window->GetHeight());
+	//Contacts processed: new ones with solid bodies (sounds), new and removed with player
+	_subscribeContacts(0);
+	_subscribeContacts(PHYSICBODY,CONTACTADDEDMASK);
+	_subscribeContacts(PLAYER,CONTACTADDEDMASK | CONTACTREMOVEDMASK);
 }
 //Release internal resources
 void SolidBodyAgent::_release()
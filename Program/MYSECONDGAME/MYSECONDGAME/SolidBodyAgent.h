@@ -74,6 +74,7 @@ public:
 	virtual AgentType GetType() { return mParams.type; }						//Get type of agent
 	virtual bool IsAlive()  { return mActive; }             //Get if agent was destroyed
 	const SolidBodyPar& GetAgentInfo() { return mParams; }
+	float GetFriction() const { return mInitialFriction * (1 - mParams.wetness); }	//Friction of body according to wetness
 	//----- OTHER FUNCTIONS --------------
 	virtual void UpdateState(float dt);								//Update object status
 	virtual bool HandleCollision(const CollisionEventData& data);	//Process possible collisions
@@ -81,6 +82,8 @@ public:
 	virtual void HandleOutOfLimits(const OutOfLimitsEventData& data);//Handle out of limits
 	virtual void Create( const GameAgentPar *params);				//Create from params
 	virtual void Destroy();											//Destroy body
+	virtual bool Restart();											//Back to state after level load
+	virtual void InterpolateGFX();									//Place sprites between last two physics steps
 
 protected:
 	//---- INTERNAL VARIABLES ----
@@ -101,6 +104,7 @@ protected:
 	//---- INTERNAL FUNCTIONS ----
 	void _init();							//Init internal resources
 	void _release();						//Release internal resources
+	void _updateSprites();					//Sprites placement with body transform to render
 };
 
 #endif
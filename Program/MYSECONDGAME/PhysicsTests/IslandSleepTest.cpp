@@ -0,0 +1,235 @@
+/*
+	Filename: IslandSleepTest.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Regression test for the persistent islands of Box2D (PERSISTENT ISLANDS in Box2D.h)
+	Comments: Piles of boxes, some of them jointed, settle on the ground. Checks that:
+			  - The settled piles stay asleep, without moving or evaluating contacts.
+			  - A bullet waking one pile wakes its whole island: jointed or touching bodies never
+			    differ in their sleep state after a step. The other piles stay asleep.
+			  - The hit pile settles again.
+			  - Islands woken or put to sleep as a whole (b2World::SetIslandAwake, world snapshot restore).
+			  Built with _DEBUG, b2World::ValidateIslands also checks the islands after each step.
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include <cstdio>
+#include <vector>
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 60.0f;
+	const int32 PileCount = 6;
+	const float32 PileSpacing = 20.0f;
+
+	class CountingListener : public b2ContactListener
+	{
+	public:
+		CountingListener():mPersistCount(0){}
+		virtual void Persist(const b2ContactPoint* point) { ++mPersistCount; }
+
+		long mPersistCount;
+	};
+
+	int gFailures = 0;
+
+	void _check(bool condition, const char* test, const char* detail)
+	{
+		if(!condition)
+		{
+			printf("FAIL %s: %s\n", test, detail);
+			++gFailures;
+		}
+	}
+
+	void _step(b2World& world)
+	{
+		world.Step(TimeStep, 10, 8, true);
+	}
+
+	int _awakeCount(b2World& world, float32 minx)
+	{
+		int count = 0;
+		//LOOP - Count the awake dynamic bodies right of minx
+		for(b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+		{
+			if(!b->IsStatic() && !b->IsSleeping() && b->GetPosition().x >= minx)
+			{
+				++count;
+			}
+		}//LOOP END
+		return count;
+	}
+
+	bool _settle(b2World& world, int maxsteps)
+	{
+		//LOOP - Step until every body sleeps
+		for(int i = 0; i < maxsteps; ++i)
+		{
+			_step(world);
+			if(_awakeCount(world, -B2_FLT_MAX) == 0)
+			{
+				return true;
+			}
+		}//LOOP END
+		return false;
+	}
+
+	// Jointed or touching dynamic bodies are in the same island, they sleep or wake together
+	bool _sharedSleepState(b2World& world)
+	{
+		//LOOP - Joints
+		for(b2Joint* j = world.GetJointList(); j; j = j->GetNext())
+		{
+			b2Body* b1 = j->GetBody1();
+			b2Body* b2 = j->GetBody2();
+			if(!b1->IsStatic() && !b2->IsStatic() && b1->IsSleeping() != b2->IsSleeping())
+			{
+				return false;
+			}
+		}//LOOP END
+
+		//LOOP - Touching solid contacts
+		for(b2Contact* c = world.GetContactList(); c; c = c->GetNext())
+		{
+			if(c->GetManifoldCount() == 0 || c->GetShape1()->IsSensor() || c->GetShape2()->IsSensor())
+			{
+				continue;
+			}
+			b2Body* b1 = c->GetShape1()->GetBody();
+			b2Body* b2 = c->GetShape2()->GetBody();
+			if(!b1->IsStatic() && !b2->IsStatic() && b1->IsSleeping() != b2->IsSleeping())
+			{
+				return false;
+			}
+		}//LOOP END
+
+		return true;
+	}
+
+	void _createPiles(b2World& world)
+	{
+		b2BodyDef grounddef;
+		grounddef.position.Set(PileSpacing * PileCount * 0.5f, -1.0f);
+		b2Body* ground = world.CreateBody(&grounddef);
+		b2PolygonDef groundshape;
+		groundshape.SetAsBox(PileSpacing * PileCount, 1.0f);
+		groundshape.friction = 0.6f;
+		ground->CreateShape(&groundshape);
+
+		//LOOP - Piles of 4x5 boxes, the two left columns jointed row by row
+		for(int p = 0; p < PileCount; ++p)
+		{
+			for(int row = 0; row < 5; ++row)
+			{
+				b2Body* left = NULL;
+				for(int col = 0; col < 4; ++col)
+				{
+					b2BodyDef def;
+					def.position.Set(PileSpacing * (p + 0.5f) + col * 1.01f, 0.5f + row * 1.01f);
+					b2Body* body = world.CreateBody(&def);
+					b2PolygonDef shape;
+					shape.SetAsBox(0.5f, 0.5f);
+					shape.density = 1.0f;
+					shape.friction = 0.6f;
+					body->CreateShape(&shape);
+					body->SetMassFromShapes();
+
+					if(col == 0)
+					{
+						left = body;
+					}
+					else if(col == 1)
+					{
+						b2RevoluteJointDef joint;
+						joint.Initialize(left, body, 0.5f * (left->GetPosition() + body->GetPosition()));
+						world.CreateJoint(&joint);
+					}
+				}
+			}
+		}//LOOP END
+	}
+}
+
+int main(int argc, char** argv)
+{
+	b2AABB worldaabb;
+	worldaabb.lowerBound.Set(-50.0f, -50.0f);
+	worldaabb.upperBound.Set(PileSpacing * PileCount + 50.0f, 100.0f);
+	b2World world(worldaabb, b2Vec2(0.0f, -10.0f), true);
+	CountingListener listener;
+	world.SetContactListener(&listener);
+
+	_createPiles(world);
+
+	//Settled piles stay asleep
+	_check(_settle(world, 3000), "SettledPileStaysAsleep", "the piles did not settle");
+	std::vector<b2Vec2> positions;
+	for(b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		positions.push_back(b->GetPosition());
+	}
+	long persistcount = listener.mPersistCount;
+	for(int i = 0; i < 600; ++i)
+	{
+		_step(world);
+	}
+	_check(_awakeCount(world, -B2_FLT_MAX) == 0, "SettledPileStaysAsleep", "bodies woke up");
+	_check(listener.mPersistCount == persistcount, "SettledPileStaysAsleep", "contacts were evaluated");
+	int index = 0;
+	bool moved = false;
+	for(b2Body* b = world.GetBodyList(); b; b = b->GetNext(), ++index)
+	{
+		moved = moved || b->GetPosition().x != positions[index].x || b->GetPosition().y != positions[index].y;
+	}
+	_check(!moved, "SettledPileStaysAsleep", "bodies moved");
+
+	//A bullet wakes the first pile as a whole, the far piles stay asleep
+	b2BodyDef bulletdef;
+	bulletdef.position.Set(2.0f, 1.5f);
+	bulletdef.isBullet = true;
+	b2Body* bullet = world.CreateBody(&bulletdef);
+	b2CircleDef bulletshape;
+	bulletshape.radius = 0.25f;
+	bulletshape.density = 5.0f;
+	bullet->CreateShape(&bulletshape);
+	bullet->SetMassFromShapes();
+	bullet->SetLinearVelocity(b2Vec2(50.0f, 0.0f));
+
+	bool shared = true;
+	for(int i = 0; i < 600; ++i)
+	{
+		_step(world);
+		shared = shared && _sharedSleepState(world);
+	}
+	_check(shared, "WakeWholeIsland", "jointed or touching bodies differ in sleep state");
+	_check(_awakeCount(world, PileSpacing * 2.0f) == 0, "WakeWholeIsland", "far piles woke up");
+
+	//The hit pile settles again
+	world.DestroyBody(bullet);
+	_check(_settle(world, 3000), "SettleAgain", "the piles did not settle again");
+
+	//The island of a body wakes and sleeps as a whole
+	b2Body* first = NULL;
+	for(b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+	{
+		if(!b->IsStatic() && b->GetPosition().x < PileSpacing)
+			first = b;
+	}
+	world.SetIslandAwake(first, true);
+	_check(_sharedSleepState(world) && _awakeCount(world, -B2_FLT_MAX) > 1, "SetIslandAwake", "the island did not wake as a whole");
+	_check(_awakeCount(world, PileSpacing * 2.0f) == 0, "SetIslandAwake", "far piles woke up");
+	first->SetLinearVelocity(b2Vec2(0.0f, 5.0f));
+	first->ApplyForce(b2Vec2(0.0f, 100.0f), first->GetWorldCenter());
+	world.SetIslandAwake(first, false);
+	_check(_awakeCount(world, -B2_FLT_MAX) == 0, "SetIslandAwake", "the island did not sleep as a whole");
+	_check(first->GetLinearVelocity().y == 0.0f, "SetIslandAwake", "a sleeping body kept its velocity");
+	_step(world);
+	_check(_awakeCount(world, -B2_FLT_MAX) == 0, "SetIslandAwake", "the island woke up after a step");
+
+	printf("%s: %d failures\n", gFailures ? "FAILED" : "PASSED", gFailures);
+	return gFailures ? 1 : 0;
+}
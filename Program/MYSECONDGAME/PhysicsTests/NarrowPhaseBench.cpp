@@ -0,0 +1,582 @@
+/*
+	Filename: NarrowPhaseBench.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Benchmark of batched (4 wide) circle and polygon-circle manifolds against the scalar functions of Box2D
+	Comments: A blob of circle masses settles on a floor of boxes. The circle and polygon-circle contacts
+			  of the settled pile are computed again and again:
+			  - Scalar: b2CollideCircles and b2CollidePolygonAndCircle for each contact, as b2Contact::Evaluate.
+			  - Batched: the circles are gathered once per step into arrays (center, radius and transform of
+			    each circle), the contacts are computed 4 at a time (SSE, or a plain version) and the
+			    manifolds are written back to each contact.
+			  Prints the time per contact of both, of the batched math alone (without gathering and
+			  writing back), of all contacts with one gather, and of a whole world step. The batched
+			  manifolds must be the scalar ones.
+			  Usage: NarrowPhaseBench [circles=600] [repeats=2000]
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include "Common/b2Timer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#if defined(_M_IX86) || defined(_M_X64) || defined(__SSE__)
+#define BENCH_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 60.0f;
+	const int32 SettleSteps = 180;
+	const float32 MassRadius = 0.25f;
+
+	//4 wide float math
+#ifdef BENCH_SSE
+	typedef __m128 Float4;
+	inline Float4 _set4(float32 a, float32 b, float32 c, float32 d) { return _mm_setr_ps(a, b, c, d); }
+	inline Float4 _splat4(float32 a) { return _mm_set1_ps(a); }
+	inline Float4 _add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+	inline Float4 _sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+	inline Float4 _mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+	inline Float4 _div4(Float4 a, Float4 b) { return _mm_div_ps(a, b); }
+	inline Float4 _sqrt4(Float4 a) { return _mm_sqrt_ps(a); }
+	inline Float4 _greater4(Float4 a, Float4 b) { return _mm_cmpgt_ps(a, b); }
+	inline Float4 _less4(Float4 a, Float4 b) { return _mm_cmplt_ps(a, b); }
+	inline Float4 _lessEqual4(Float4 a, Float4 b) { return _mm_cmple_ps(a, b); }
+	inline Float4 _greaterEqual4(Float4 a, Float4 b) { return _mm_cmpge_ps(a, b); }
+	inline Float4 _select4(Float4 mask, Float4 a, Float4 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+	inline void _store4(float32* p, Float4 a) { _mm_storeu_ps(p, a); }
+#else
+	typedef struct Float4 { float32 x[4]; }Float4;
+	inline Float4 _set4(float32 a, float32 b, float32 c, float32 d) { Float4 r; r.x[0] = a; r.x[1] = b; r.x[2] = c; r.x[3] = d; return r; }
+	inline Float4 _splat4(float32 a) { return _set4(a, a, a, a); }
+	inline Float4 _add4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] += b.x[i]; return a; }
+	inline Float4 _sub4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] -= b.x[i]; return a; }
+	inline Float4 _mul4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] *= b.x[i]; return a; }
+	inline Float4 _div4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] /= b.x[i]; return a; }
+	inline Float4 _sqrt4(Float4 a) { for(int i = 0; i < 4; ++i) a.x[i] = b2Sqrt(a.x[i]); return a; }
+	inline Float4 _greater4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] = a.x[i] > b.x[i] ? 1.0f : 0.0f; return a; }
+	inline Float4 _less4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] = a.x[i] < b.x[i] ? 1.0f : 0.0f; return a; }
+	inline Float4 _lessEqual4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] = a.x[i] <= b.x[i] ? 1.0f : 0.0f; return a; }
+	inline Float4 _greaterEqual4(Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] = a.x[i] >= b.x[i] ? 1.0f : 0.0f; return a; }
+	inline Float4 _select4(Float4 mask, Float4 a, Float4 b) { for(int i = 0; i < 4; ++i) a.x[i] = mask.x[i] != 0.0f ? a.x[i] : b.x[i]; return a; }
+	inline void _store4(float32* p, Float4 a) { for(int i = 0; i < 4; ++i) p[i] = a.x[i]; }
+#endif
+
+	//Circle or polygon-circle contact of the pile (shape 1 is the polygon)
+	typedef struct ContactPair
+	{
+		b2Shape* shape1;
+		b2Shape* shape2;
+		int circle1;		//Index in gathered circles (-1: polygon)
+		int circle2;
+	}ContactPair;
+
+	//Circles gathered once per step (structure of arrays)
+	typedef struct CircleArrays
+	{
+		std::vector<b2CircleShape*> shapes;
+		std::vector<float32> x, y, radius;			//World center
+		std::vector<float32> px, py, cosine, sine;		//Body transform
+	}CircleArrays;
+
+	//Results of the batched math (structure of arrays, 4 contacts a block)
+	typedef struct BatchResults
+	{
+		std::vector<float32> hit, nx, ny, separation, lx1, ly1, lx2, ly2, feature;
+	}BatchResults;
+
+	//Contacts in the blob and on the floor
+	b2World* _createWorld(int circles)
+	{
+		b2AABB worldaabb;
+		worldaabb.lowerBound.Set(-100.0f, -100.0f);
+		worldaabb.upperBound.Set(100.0f, 200.0f);
+		b2World* world = new b2World(worldaabb, b2Vec2(0.0f, -10.0f), false, e_dynamicTreeBroadPhase);
+
+		//Floor of boxes (polygon-circle contacts) between two walls
+		int perrow = 30;
+		float32 halfwidth = perrow * MassRadius;
+		b2BodyDef grounddef;
+		b2Body* ground = world->CreateBody(&grounddef);
+		b2PolygonDef box;
+		for(int i = 0; i < perrow / 2; ++i)
+		{
+			box.SetAsBox(2.0f * MassRadius, 0.5f, b2Vec2(-halfwidth + (4.0f * i + 2.0f) * MassRadius, -0.5f), 0.1f * (i % 3 - 1));
+			ground->CreateShape(&box);
+		}
+		box.SetAsBox(0.5f, 50.0f, b2Vec2(-halfwidth - 0.5f, 50.0f), 0.0f);
+		ground->CreateShape(&box);
+		box.SetAsBox(0.5f, 50.0f, b2Vec2(halfwidth + 0.5f, 50.0f), 0.0f);
+		ground->CreateShape(&box);
+
+		//Pile of masses
+		for(int i = 0; i < circles; ++i)
+		{
+			b2BodyDef def;
+			def.position.Set(-halfwidth + MassRadius * (2.0f * (i % perrow) + 1.0f + 0.3f * (i / perrow % 2)),
+							 MassRadius * (1.0f + 1.9f * (i / perrow)));
+			b2Body* body = world->CreateBody(&def);
+			b2CircleDef shape;
+			shape.radius = MassRadius * (0.9f + 0.1f * (i % 3));
+			shape.density = 1.0f;
+			shape.friction = 0.3f;
+			body->CreateShape(&shape);
+			body->SetMassFromShapes();
+		}
+		for(int i = 0; i < SettleSteps; ++i)
+		{
+			world->Step(TimeStep, 10, 8, true);
+		}
+		return world;
+	}
+
+	//Touching circle and polygon-circle contacts of the world, circles indexed in the arrays
+	void _collectPairs(b2World* world, CircleArrays& circles, std::vector<ContactPair>& circlepairs, std::vector<ContactPair>& polygonpairs)
+	{
+		for(b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+		{
+			for(b2Shape* shape = body->GetShapeList(); shape; shape = shape->GetNext())
+			{
+				if(shape->GetType() == e_circleShape)
+				{
+					shape->SetUserData(reinterpret_cast<void*>(circles.shapes.size()));
+					circles.shapes.push_back(static_cast<b2CircleShape*>(shape));
+				}
+			}
+		}
+		size_t count = circles.shapes.size();
+		circles.x.resize(count); circles.y.resize(count); circles.radius.resize(count);
+		circles.px.resize(count); circles.py.resize(count); circles.cosine.resize(count); circles.sine.resize(count);
+
+		for(b2Contact* contact = world->GetContactList(); contact; contact = contact->GetNext())
+		{
+			if(contact->GetManifoldCount() == 0)
+				continue;
+			ContactPair pair;
+			pair.shape1 = contact->GetShape1();
+			pair.shape2 = contact->GetShape2();
+			pair.circle1 = -1;
+			pair.circle2 = static_cast<int>(reinterpret_cast<size_t>(pair.shape2->GetUserData()));
+			if(pair.shape1->GetType() == e_circleShape && pair.shape2->GetType() == e_circleShape)
+			{
+				pair.circle1 = static_cast<int>(reinterpret_cast<size_t>(pair.shape1->GetUserData()));
+				circlepairs.push_back(pair);
+			}
+			else if(pair.shape1->GetType() == e_polygonShape && pair.shape2->GetType() == e_circleShape)
+			{
+				polygonpairs.push_back(pair);
+			}
+		}
+	}
+
+	//---------------------Scalar: Box2D functions, as b2Contact::Evaluate---------------------
+	void _scalarCircles(const std::vector<ContactPair>& pairs, std::vector<b2Manifold>& manifolds)
+	{
+		for(size_t i = 0; i < pairs.size(); ++i)
+		{
+			const ContactPair& pair = pairs[i];
+			b2CollideCircles(&manifolds[i], static_cast<b2CircleShape*>(pair.shape1), pair.shape1->GetBody()->GetXForm(),
+							 static_cast<b2CircleShape*>(pair.shape2), pair.shape2->GetBody()->GetXForm(), 0.0f);
+		}
+	}
+
+	void _scalarPolygons(const std::vector<ContactPair>& pairs, std::vector<b2Manifold>& manifolds)
+	{
+		for(size_t i = 0; i < pairs.size(); ++i)
+		{
+			const ContactPair& pair = pairs[i];
+			b2CollidePolygonAndCircle(&manifolds[i], static_cast<b2PolygonShape*>(pair.shape1), pair.shape1->GetBody()->GetXForm(),
+									  static_cast<b2CircleShape*>(pair.shape2), pair.shape2->GetBody()->GetXForm(), 0.0f);
+		}
+	}
+
+	//---------------------Batched---------------------
+	//Centers and transforms of all circles, once per step
+	void _gatherCircles(CircleArrays& circles)
+	{
+		for(size_t i = 0; i < circles.shapes.size(); ++i)
+		{
+			b2CircleShape* circle = circles.shapes[i];
+			const b2XForm& xf = circle->GetBody()->GetXForm();
+			b2Vec2 center = b2Mul(xf, circle->GetLocalPosition());
+			circles.x[i] = center.x;
+			circles.y[i] = center.y;
+			circles.radius[i] = circle->GetRadius();
+			circles.px[i] = xf.position.x;
+			circles.py[i] = xf.position.y;
+			circles.cosine[i] = xf.R.col1.x;
+			circles.sine[i] = xf.R.col1.y;
+		}
+	}
+
+	//Lanes of 4 contacts from the gathered arrays (last block repeats its last contact)
+	inline Float4 _lanes(const std::vector<float32>& values, const int* index)
+	{
+		return _set4(values[index[0]], values[index[1]], values[index[2]], values[index[3]]);
+	}
+
+	void _laneIndices(const std::vector<ContactPair>& pairs, size_t block, int* index1, int* index2)
+	{
+		for(size_t k = 0; k < 4; ++k)
+		{
+			size_t i = b2Min(block + k, pairs.size() - 1);
+			index1[k] = pairs[i].circle1;
+			index2[k] = pairs[i].circle2;
+		}
+	}
+
+	//Local point of a world point in 4 transforms (b2MulT)
+	inline void _mulT4(Float4 px, Float4 py, Float4 c, Float4 s, Float4 x, Float4 y, Float4* lx, Float4* ly)
+	{
+		Float4 dx = _sub4(x, px);
+		Float4 dy = _sub4(y, py);
+		*lx = _add4(_mul4(c, dx), _mul4(s, dy));
+		*ly = _sub4(_mul4(c, dy), _mul4(s, dx));
+	}
+
+	//Math of b2CollideCircles, 4 contacts at a time
+	void _batchCircles(const std::vector<ContactPair>& pairs, const CircleArrays& c, BatchResults& results)
+	{
+		const Float4 zero = _splat4(0.0f);
+		const Float4 one = _splat4(1.0f);
+		const Float4 half = _splat4(0.5f);
+		const Float4 epsilon = _splat4(B2_FLT_EPSILON);
+		for(size_t block = 0; block < pairs.size(); block += 4)
+		{
+			int i1[4], i2[4];
+			_laneIndices(pairs, block, i1, i2);
+			Float4 x1 = _lanes(c.x, i1), y1 = _lanes(c.y, i1), r1 = _lanes(c.radius, i1);
+			Float4 x2 = _lanes(c.x, i2), y2 = _lanes(c.y, i2), r2 = _lanes(c.radius, i2);
+
+			Float4 dx = _sub4(x2, x1);
+			Float4 dy = _sub4(y2, y1);
+			Float4 distsqr = _add4(_mul4(dx, dx), _mul4(dy, dy));
+			Float4 radiussum = _add4(r1, r2);
+			Float4 hit = _select4(_greater4(distsqr, _mul4(radiussum, radiussum)), zero, one);
+
+			//Centers on top of each other: normal up
+			Float4 same = _less4(distsqr, epsilon);
+			Float4 dist = _sqrt4(_select4(same, one, distsqr));
+			Float4 a = _div4(one, dist);
+			Float4 nx = _select4(same, zero, _mul4(a, dx));
+			Float4 ny = _select4(same, one, _mul4(a, dy));
+			Float4 separation = _select4(same, _sub4(zero, radiussum), _sub4(dist, radiussum));
+
+			//Point between the surfaces
+			Float4 x = _mul4(half, _add4(_add4(x1, _mul4(r1, nx)), _sub4(x2, _mul4(r2, nx))));
+			Float4 y = _mul4(half, _add4(_add4(y1, _mul4(r1, ny)), _sub4(y2, _mul4(r2, ny))));
+			Float4 lx1, ly1, lx2, ly2;
+			_mulT4(_lanes(c.px, i1), _lanes(c.py, i1), _lanes(c.cosine, i1), _lanes(c.sine, i1), x, y, &lx1, &ly1);
+			_mulT4(_lanes(c.px, i2), _lanes(c.py, i2), _lanes(c.cosine, i2), _lanes(c.sine, i2), x, y, &lx2, &ly2);
+
+			_store4(&results.hit[block], hit);
+			_store4(&results.nx[block], nx);
+			_store4(&results.ny[block], ny);
+			_store4(&results.separation[block], separation);
+			_store4(&results.lx1[block], lx1);
+			_store4(&results.ly1[block], ly1);
+			_store4(&results.lx2[block], lx2);
+			_store4(&results.ly2[block], ly2);
+		}
+	}
+
+	//Math of b2CollidePolygonAndCircle, 4 contacts at a time (polygon vertices read by lane)
+	void _batchPolygons(const std::vector<ContactPair>& pairs, const CircleArrays& c, BatchResults& results)
+	{
+		const Float4 zero = _splat4(0.0f);
+		const Float4 one = _splat4(1.0f);
+		const Float4 epsilon = _splat4(B2_FLT_EPSILON);
+		for(size_t block = 0; block < pairs.size(); block += 4)
+		{
+			b2PolygonShape* polygon[4];
+			const b2XForm* xf1[4];
+			int i1[4], i2[4];
+			_laneIndices(pairs, block, i1, i2);
+			int maxcount = 0;
+			for(size_t k = 0; k < 4; ++k)
+			{
+				polygon[k] = static_cast<b2PolygonShape*>(pairs[b2Min(block + k, pairs.size() - 1)].shape1);
+				xf1[k] = &polygon[k]->GetBody()->GetXForm();
+				maxcount = b2Max(maxcount, polygon[k]->GetVertexCount());
+			}
+
+			//Circle center in the frame of the polygon
+			Float4 cx = _lanes(c.x, i2), cy = _lanes(c.y, i2), radius = _lanes(c.radius, i2);
+			Float4 p1x = _set4(xf1[0]->position.x, xf1[1]->position.x, xf1[2]->position.x, xf1[3]->position.x);
+			Float4 p1y = _set4(xf1[0]->position.y, xf1[1]->position.y, xf1[2]->position.y, xf1[3]->position.y);
+			Float4 cos1 = _set4(xf1[0]->R.col1.x, xf1[1]->R.col1.x, xf1[2]->R.col1.x, xf1[3]->R.col1.x);
+			Float4 sin1 = _set4(xf1[0]->R.col1.y, xf1[1]->R.col1.y, xf1[2]->R.col1.y, xf1[3]->R.col1.y);
+			Float4 clx, cly;
+			_mulT4(p1x, p1y, cos1, sin1, cx, cy, &clx, &cly);
+
+			//Edge of max separation (lanes with fewer vertices repeat their last one)
+			Float4 separation = _splat4(-B2_FLT_MAX);
+			Float4 edge = zero;
+			for(int v = 0; v < maxcount; ++v)
+			{
+				float32 vx[4], vy[4], nx[4], ny[4];
+				for(int k = 0; k < 4; ++k)
+				{
+					int index = b2Min(v, polygon[k]->GetVertexCount() - 1);
+					vx[k] = polygon[k]->GetVertices()[index].x;
+					vy[k] = polygon[k]->GetVertices()[index].y;
+					nx[k] = polygon[k]->GetNormals()[index].x;
+					ny[k] = polygon[k]->GetNormals()[index].y;
+				}
+				Float4 s = _add4(_mul4(_set4(nx[0], nx[1], nx[2], nx[3]), _sub4(clx, _set4(vx[0], vx[1], vx[2], vx[3]))),
+								 _mul4(_set4(ny[0], ny[1], ny[2], ny[3]), _sub4(cly, _set4(vy[0], vy[1], vy[2], vy[3]))));
+				Float4 greater = _greater4(s, separation);
+				separation = _select4(greater, s, separation);
+				edge = _select4(greater, _splat4(static_cast<float32>(v)), edge);
+			}
+
+			//Edge vertices and normal of each lane
+			float32 edges[4];
+			_store4(edges, edge);
+			float32 v1x[4], v1y[4], v2x[4], v2y[4], enx[4], eny[4], vertex2[4];
+			for(int k = 0; k < 4; ++k)
+			{
+				int index1 = static_cast<int>(edges[k]);
+				int index2 = index1 + 1 < polygon[k]->GetVertexCount() ? index1 + 1 : 0;
+				vertex2[k] = static_cast<float32>(index2);
+				v1x[k] = polygon[k]->GetVertices()[index1].x;
+				v1y[k] = polygon[k]->GetVertices()[index1].y;
+				v2x[k] = polygon[k]->GetVertices()[index2].x;
+				v2y[k] = polygon[k]->GetVertices()[index2].y;
+				enx[k] = polygon[k]->GetNormals()[index1].x;
+				eny[k] = polygon[k]->GetNormals()[index1].y;
+			}
+			Float4 x1 = _set4(v1x[0], v1x[1], v1x[2], v1x[3]), y1 = _set4(v1y[0], v1y[1], v1y[2], v1y[3]);
+			Float4 x2 = _set4(v2x[0], v2x[1], v2x[2], v2x[3]), y2 = _set4(v2y[0], v2y[1], v2y[2], v2y[3]);
+
+			//Center outside: closest point of the edge segment (vertex 1, vertex 2 or inside)
+			Float4 ex = _sub4(x2, x1);
+			Float4 ey = _sub4(y2, y1);
+			Float4 length = _sqrt4(_add4(_mul4(ex, ex), _mul4(ey, ey)));
+			Float4 invlength = _div4(one, length);
+			ex = _mul4(ex, invlength);
+			ey = _mul4(ey, invlength);
+			Float4 u = _add4(_mul4(_sub4(clx, x1), ex), _mul4(_sub4(cly, y1), ey));
+			Float4 before = _lessEqual4(u, zero);
+			Float4 after = _greaterEqual4(u, length);
+			Float4 px = _select4(before, x1, _select4(after, x2, _add4(x1, _mul4(u, ex))));
+			Float4 py = _select4(before, y1, _select4(after, y2, _add4(y1, _mul4(u, ey))));
+			Float4 dx = _sub4(clx, px);
+			Float4 dy = _sub4(cly, py);
+			Float4 dist = _sqrt4(_add4(_mul4(dx, dx), _mul4(dy, dy)));
+			Float4 invdist = _div4(one, _select4(_greater4(dist, epsilon), dist, one));
+			Float4 inside = _less4(separation, epsilon);
+			Float4 localnx = _select4(inside, _set4(enx[0], enx[1], enx[2], enx[3]), _mul4(dx, invdist));
+			Float4 localny = _select4(inside, _set4(eny[0], eny[1], eny[2], eny[3]), _mul4(dy, invdist));
+			Float4 hit = _select4(inside, one, _select4(_greater4(dist, radius), zero, one));
+
+			//World normal, point on the circle surface and local points
+			Float4 nx = _sub4(_mul4(cos1, localnx), _mul4(sin1, localny));
+			Float4 ny = _add4(_mul4(sin1, localnx), _mul4(cos1, localny));
+			Float4 x = _sub4(cx, _mul4(radius, nx));
+			Float4 y = _sub4(cy, _mul4(radius, ny));
+			Float4 lx1, ly1, lx2, ly2;
+			_mulT4(p1x, p1y, cos1, sin1, x, y, &lx1, &ly1);
+			_mulT4(_lanes(c.px, i2), _lanes(c.py, i2), _lanes(c.cosine, i2), _lanes(c.sine, i2), x, y, &lx2, &ly2);
+
+			//Feature: edge (inside or projected in the edge) or -1 - vertex (vertex 1 or 2 of the edge)
+			Float4 minusone = _splat4(-1.0f);
+			Float4 feature = _select4(inside, edge, _select4(before, _sub4(minusone, edge),
+								_select4(after, _sub4(minusone, _set4(vertex2[0], vertex2[1], vertex2[2], vertex2[3])), edge)));
+
+			_store4(&results.hit[block], hit);
+			_store4(&results.nx[block], nx);
+			_store4(&results.ny[block], ny);
+			_store4(&results.separation[block], _sub4(_select4(inside, separation, dist), radius));
+			_store4(&results.lx1[block], lx1);
+			_store4(&results.ly1[block], ly1);
+			_store4(&results.lx2[block], lx2);
+			_store4(&results.ly2[block], ly2);
+			_store4(&results.feature[block], feature);
+		}
+	}
+
+	//Manifolds of the contacts from the batched results
+	void _scatter(const std::vector<ContactPair>& pairs, const BatchResults& results, bool polygons, std::vector<b2Manifold>& manifolds)
+	{
+		for(size_t i = 0; i < pairs.size(); ++i)
+		{
+			b2Manifold& manifold = manifolds[i];
+			if(results.hit[i] == 0.0f)
+			{
+				manifold.pointCount = 0;
+				continue;
+			}
+			manifold.pointCount = 1;
+			manifold.normal.Set(results.nx[i], results.ny[i]);
+			b2ManifoldPoint& point = manifold.points[0];
+			point.separation = results.separation[i];
+			point.localPoint1.Set(results.lx1[i], results.ly1[i]);
+			point.localPoint2.Set(results.lx2[i], results.ly2[i]);
+			point.id.key = 0;
+			//IF - Polygon feature: edge (>= 0) or vertex (-1 - vertex)
+			if(polygons)
+			{
+				int feature = static_cast<int>(results.feature[i]);
+				point.id.features.incidentEdge = feature >= 0 ? static_cast<uint8>(feature) : static_cast<uint8>(b2_nullFeature);
+				point.id.features.incidentVertex = feature < 0 ? static_cast<uint8>(-1 - feature) : static_cast<uint8>(b2_nullFeature);
+			}
+		}
+	}
+
+	void _resizeResults(BatchResults& results, size_t count)
+	{
+		size_t blocks = (count + 3) / 4 * 4;
+		results.hit.resize(blocks); results.nx.resize(blocks); results.ny.resize(blocks); results.separation.resize(blocks);
+		results.lx1.resize(blocks); results.ly1.resize(blocks); results.lx2.resize(blocks); results.ly2.resize(blocks);
+		results.feature.resize(blocks);
+	}
+
+	//Batched manifolds must be the scalar ones (returns failures)
+	int _compare(const char* name, const std::vector<b2Manifold>& scalar, const std::vector<b2Manifold>& batched)
+	{
+		const float32 tolerance = 1.0e-4f;
+		int failures = 0;
+		for(size_t i = 0; i < scalar.size(); ++i)
+		{
+			const b2Manifold& a = scalar[i];
+			const b2Manifold& b = batched[i];
+			bool same = a.pointCount == b.pointCount;
+			if(same && a.pointCount > 0)
+			{
+				const b2ManifoldPoint& pa = a.points[0];
+				const b2ManifoldPoint& pb = b.points[0];
+				same = pa.id.key == pb.id.key
+					   && b2Abs(pa.separation - pb.separation) < tolerance
+					   && (a.normal - b.normal).Length() < tolerance
+					   && (pa.localPoint1 - pb.localPoint1).Length() < tolerance
+					   && (pa.localPoint2 - pb.localPoint2).Length() < tolerance;
+			}
+			if(!same)
+			{
+				if(failures == 0)
+					printf("FAIL %s contact %d: batched manifold differs from scalar one\n", name, static_cast<int>(i));
+				++failures;
+			}
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int circlecount = argc > 1 ? atoi(argv[1]) : 600;
+	int repeats = argc > 2 ? atoi(argv[2]) : 2000;
+	int failures = 0;
+
+	b2World* world = _createWorld(circlecount);
+	CircleArrays circles;
+	std::vector<ContactPair> pairs[2];
+	_collectPairs(world, circles, pairs[0], pairs[1]);
+	const char* names[2] = {"circle", "polygon-circle"};
+
+	std::vector<b2Manifold> scalar[2];
+	std::vector<b2Manifold> batched[2];
+	BatchResults results[2];
+	for(int kind = 0; kind < 2; ++kind)
+	{
+		scalar[kind].resize(pairs[kind].size());
+		batched[kind].resize(pairs[kind].size());
+		_resizeResults(results[kind], pairs[kind].size());
+	}
+
+#ifdef BENCH_SSE
+	const char* mode = "SSE";
+#else
+	const char* mode = "plain";
+#endif
+	printf("%d circles, %d circle contacts, %d polygon-circle contacts, %d repeats, %s lanes (nanoseconds per contact)\n",
+		   circlecount, static_cast<int>(pairs[0].size()), static_cast<int>(pairs[1].size()), repeats, mode);
+	printf("%-16s %10s %10s %10s %10s\n", "contacts", "scalar", "math only", "batched", "speed-up");
+
+	//LOOP - Each kind of contact: scalar, batched math, and batched math with the manifolds written back
+	float32 kindtime[2];
+	_gatherCircles(circles);
+	for(int kind = 0; kind < 2; ++kind)
+	{
+		b2Timer timer;
+		for(int r = 0; r < repeats; ++r)
+		{
+			if(kind == 0)
+				_scalarCircles(pairs[kind], scalar[kind]);
+			else
+				_scalarPolygons(pairs[kind], scalar[kind]);
+		}
+		kindtime[kind] = timer.GetMilliseconds();
+
+		timer.Reset();
+		for(int r = 0; r < repeats; ++r)
+		{
+			if(kind == 0)
+				_batchCircles(pairs[kind], circles, results[kind]);
+			else
+				_batchPolygons(pairs[kind], circles, results[kind]);
+		}
+		float32 mathtime = timer.GetMilliseconds();
+
+		timer.Reset();
+		for(int r = 0; r < repeats; ++r)
+		{
+			if(kind == 0)
+				_batchCircles(pairs[kind], circles, results[kind]);
+			else
+				_batchPolygons(pairs[kind], circles, results[kind]);
+			_scatter(pairs[kind], results[kind], kind == 1, batched[kind]);
+		}
+		float32 batchedtime = timer.GetMilliseconds();
+
+		float32 scale = pairs[kind].empty() ? 0.0f : 1.0e6f / (static_cast<float32>(repeats) * pairs[kind].size());
+		printf("%-16s %10.1f %10.1f %10.1f %9.2fx\n", names[kind],
+			   kindtime[kind] * scale, mathtime * scale, batchedtime * scale, kindtime[kind] / b2Max(batchedtime, B2_FLT_EPSILON));
+		failures += _compare(names[kind], scalar[kind], batched[kind]);
+	}//LOOP END
+
+	//All contacts of a step: circles gathered once, both kinds computed and written back
+	b2Timer timer;
+	for(int r = 0; r < repeats; ++r)
+	{
+		_gatherCircles(circles);
+		for(int kind = 0; kind < 2; ++kind)
+		{
+			if(kind == 0)
+				_batchCircles(pairs[kind], circles, results[kind]);
+			else
+				_batchPolygons(pairs[kind], circles, results[kind]);
+			_scatter(pairs[kind], results[kind], kind == 1, batched[kind]);
+		}
+	}
+	float32 steptime = timer.GetMilliseconds();
+	timer.Reset();
+	for(int r = 0; r < repeats; ++r)
+	{
+		_gatherCircles(circles);
+	}
+	float32 gathertime = timer.GetMilliseconds();
+	float32 scale = 1.0e6f / (static_cast<float32>(repeats) * b2Max<size_t>(pairs[0].size() + pairs[1].size(), 1));
+	printf("%-16s %10.1f %10s %10.1f %9.2fx\n", "all, gathered", (kindtime[0] + kindtime[1]) * scale, "",
+		   steptime * scale, (kindtime[0] + kindtime[1]) / b2Max(steptime, B2_FLT_EPSILON));
+	printf("%-16s %10s %10s %10.1f\n", "(gather alone)", "", "", gathertime * scale);
+
+	//What the saving is worth: a whole step of the same world, for each of its contacts
+	int steps = b2Max(repeats / 20, 1);
+	timer.Reset();
+	for(int i = 0; i < steps; ++i)
+	{
+		world->Step(TimeStep, 10, 8, true);
+	}
+	printf("%-16s %10.1f\n", "world step", timer.GetMilliseconds() * 1.0e6f / (static_cast<float32>(steps) * world->GetContactCount()));
+
+	delete world;
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,273 @@
+/*
+	Filename: PhysicsThreadTest.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Test of the physics thread of the game and its step snapshot (PhysicsThread, PhysicsStepSnapshot)
+	Comments: A pile of circles and boxes is stepped in the physics thread, in batches of 1 to 4 steps, as
+			  the physics manager does. The steps publish the step snapshot, which the main thread reads
+			  while the thread steps (as rendering does), waiting for the steps only at the next frame.
+			  Each frame read must be the state of the same world stepped in the main thread after that
+			  step (transforms, transforms before the step and contacts), and steps must be read in order.
+			  Prints the steps read while the thread stepped, and the time the main thread spent reading
+			  and waiting.
+			  Usage: PhysicsThreadTest [bodies=300] [frames=300]
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include "Common/b2Timer.h"
+#include "PhysicsThread.h"
+#include "PhysicsStepSnapshot.h"
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 100.0f;
+	const float32 BoxHalfWidth = 15.0f;
+
+	// State of world after a step, stepped in main thread
+	typedef struct ReferenceStep
+	{
+		std::vector<b2Vec2> positions;	//By body index
+		int contacts;
+	}ReferenceStep;
+
+	// What the physics manager does in the thread
+	typedef struct Stepper
+	{
+		b2World* world;
+		PhysicsStepSnapshot* snapshot;
+		int batch;
+	}Stepper;
+
+	int _batchSteps(int frame)
+	{
+		return 1 + frame % 4;
+	}
+
+	b2World* _createWorld(int bodies)
+	{
+		b2AABB worldaabb;
+		worldaabb.lowerBound.Set(-100.0f, -100.0f);
+		worldaabb.upperBound.Set(100.0f, 300.0f);
+		b2World* world = new b2World(worldaabb, b2Vec2(0.0f, -10.0f), true);
+
+		b2BodyDef grounddef;
+		b2Body* ground = world->CreateBody(&grounddef);
+		b2PolygonDef groundshape;
+		groundshape.SetAsBox(BoxHalfWidth, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+		ground->CreateShape(&groundshape);
+		groundshape.SetAsBox(1.0f, 60.0f, b2Vec2(-BoxHalfWidth - 1.0f, 60.0f), 0.0f);
+		ground->CreateShape(&groundshape);
+		groundshape.SetAsBox(1.0f, 60.0f, b2Vec2(BoxHalfWidth + 1.0f, 60.0f), 0.0f);
+		ground->CreateShape(&groundshape);
+
+		//LOOP - Rows of circles and boxes, the index of the body is its user data
+		int perrow = static_cast<int>(BoxHalfWidth);
+		for(int i = 0; i < bodies; ++i)
+		{
+			b2BodyDef def;
+			def.position.Set(-BoxHalfWidth + 1.0f + 2.0f * (i % perrow) + 0.1f * (i / perrow % 3), 1.0f + 1.2f * (i / perrow));
+			def.userData = reinterpret_cast<void*>(static_cast<size_t>(i));
+			b2Body* body = world->CreateBody(&def);
+			if(i % 3)
+			{
+				b2CircleDef shape;
+				shape.radius = 0.4f + 0.1f * (i % 2);
+				shape.density = 1.0f;
+				shape.friction = 0.3f;
+				body->CreateShape(&shape);
+			}
+			else
+			{
+				b2PolygonDef shape;
+				shape.SetAsBox(0.45f, 0.45f);
+				shape.density = 1.0f;
+				shape.friction = 0.3f;
+				body->CreateShape(&shape);
+			}
+			body->SetMassFromShapes();
+		}//LOOP END
+
+		return world;
+	}
+
+	ReferenceStep _referenceStep(b2World* world, int bodies)
+	{
+		ReferenceStep step;
+		step.positions.resize(bodies);
+		for(b2Body* body = world->GetBodyList(); body; body = body->GetNext())
+		{
+			if(!body->IsStatic())
+			{
+				step.positions[reinterpret_cast<size_t>(body->GetUserData())] = body->GetPosition();
+			}
+		}
+		std::vector<StepContact> contacts;
+		step.contacts = PhysicsStepSnapshot::AddWorldContacts(world, NULL, contacts);
+		return step;
+	}
+
+	void _threadSteps(void* context, int steps)
+	{
+		Stepper* stepper = static_cast<Stepper*>(context);
+		for(int i = 0; i < steps; ++i)
+		{
+			stepper->snapshot->BeginStep(stepper->world);
+			stepper->world->Step(TimeStep, 10, 8, i == steps - 1);
+			stepper->snapshot->Publish(stepper->world, stepper->batch, i + 1, steps);
+		}
+	}
+
+	// Frame read must be the reference step, returns failures
+	int _checkFrame(const StepFrame& frame, const std::vector<ReferenceStep>& reference, int firststep, int bodies)
+	{
+		int failures = 0;
+		int step = firststep + frame.step;		//Steps done in world
+		const ReferenceStep& after = reference[step];
+		const ReferenceStep& before = reference[step > 0 ? step - 1 : 0];
+
+		if(static_cast<int>(frame.bodies.size()) != bodies)
+		{
+			printf("FAIL step %d: %d bodies read, %d in world\n", step, static_cast<int>(frame.bodies.size()), bodies);
+			return 1;
+		}
+		for(size_t i = 0; i < frame.bodies.size(); ++i)
+		{
+			const StepBody& state = frame.bodies[i];
+			size_t index = reinterpret_cast<size_t>(state.body->GetUserData());
+			if(state.xform.position.x != after.positions[index].x || state.xform.position.y != after.positions[index].y)
+			{
+				++failures;
+			}
+			if(state.previous.position.x != before.positions[index].x || state.previous.position.y != before.positions[index].y)
+			{
+				++failures;
+			}
+		}
+		if(static_cast<int>(frame.contacts.size()) != after.contacts)
+		{
+			++failures;
+		}
+		if(failures)
+		{
+			printf("FAIL step %d (batch %d, step %d of %d): %d values differ from the main thread world\n",
+				   step, frame.batch, frame.step, frame.steps, failures);
+		}
+		return failures;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int bodies = argc > 1 ? atoi(argv[1]) : 300;
+	int frames = argc > 2 ? atoi(argv[2]) : 300;
+	int failures = 0;
+
+	//Reference: same world stepped in main thread, in the same batches
+	std::vector<ReferenceStep> reference;
+	b2Timer referencetimer;
+	{
+		b2World* world = _createWorld(bodies);
+		reference.push_back(_referenceStep(world, bodies));
+		for(int f = 0; f < frames; ++f)
+		{
+			int steps = _batchSteps(f);
+			for(int i = 0; i < steps; ++i)
+			{
+				world->Step(TimeStep, 10, 8, i == steps - 1);
+				reference.push_back(_referenceStep(world, bodies));
+			}
+		}
+		delete world;
+	}
+	float32 steptime = referencetimer.GetMilliseconds() / (reference.size() - 1);
+
+	//Physics thread: frames hand steps to it and "render" for the time of half the steps, reading the snapshot
+	Stepper stepper;
+	stepper.world = _createWorld(bodies);
+	stepper.snapshot = new PhysicsStepSnapshot();
+	stepper.batch = 0;
+	PhysicsThread* thread = new PhysicsThread(_threadSteps, &stepper);
+	if(!thread->IsRunning())
+	{
+		printf("FAIL physics thread not created\n");
+		return 1;
+	}
+
+	int firststep = 0;			//Steps done before the batch
+	int reads = 0;				//Steps done after the hand-off, read while stepping
+	int lastread = -1;			//Last step read
+	float32 readtime = 0.0f;
+	float32 maxreadtime = 0.0f;
+	float32 waittime = 0.0f;
+	b2Timer totaltimer;
+	for(int f = 0; f < frames; ++f)
+	{
+		int steps = _batchSteps(f);
+
+		//Hand steps (PhysicsManager::StartSteps)
+		stepper.snapshot->Read();
+		++stepper.batch;
+		stepper.snapshot->Publish(stepper.world, stepper.batch, 0, steps);
+		stepper.snapshot->Read();
+		failures += _checkFrame(stepper.snapshot->GetFrame(), reference, firststep, bodies);
+		thread->BeginSteps(steps);
+
+		//Render: newest step read, never waiting for the thread
+		b2Timer rendertimer;
+		while(rendertimer.GetMilliseconds() < 0.5f * steps * steptime)
+		{
+			b2Timer timer;
+			bool newer = stepper.snapshot->Read();
+			float32 time = timer.GetMilliseconds();
+			readtime += time;
+			maxreadtime = b2Max(maxreadtime, time);
+			if(newer)
+			{
+				const StepFrame& frame = stepper.snapshot->GetFrame();
+				++reads;
+				if(frame.batch != stepper.batch || firststep + frame.step <= lastread)
+				{
+					printf("FAIL frame %d: batch %d step %d read after step %d\n", f, frame.batch, frame.step, lastread);
+					++failures;
+				}
+				lastread = firststep + frame.step;
+				failures += _checkFrame(frame, reference, firststep, bodies);
+			}
+		}
+
+		//Next update waits for the steps (PhysicsManager::Update)
+		b2Timer waittimer;
+		thread->WaitSteps();
+		waittime += waittimer.GetMilliseconds();
+		firststep += steps;
+	}
+	float32 totaltime = totaltimer.GetMilliseconds();
+
+	//Last step done is the newest frame
+	stepper.snapshot->Read();
+	failures += _checkFrame(stepper.snapshot->GetFrame(), reference, firststep - _batchSteps(frames - 1), bodies);
+
+	delete thread;
+	delete stepper.snapshot;
+	delete stepper.world;
+
+	printf("%d bodies, %d frames, %d steps (%.3f ms a step in main thread)\n", bodies, frames, firststep, steptime);
+	printf("%-24s %10d\n", "steps read stepping", reads);
+	printf("%-24s %10.3f\n", "read ms (all)", readtime);
+	printf("%-24s %10.4f\n", "read ms (max)", maxreadtime);
+	printf("%-24s %10.1f\n", "wait ms (all frames)", waittime);
+	printf("%-24s %10.1f\n", "total ms", totaltime);
+	if(reads == 0)
+	{
+		printf("FAIL no step read while the thread was stepping\n");
+		++failures;
+	}
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,227 @@
+/*
+	Filename: QueryBench.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Benchmark of the callback queries against the array queries (CALLBACK QUERIES in Box2D.h)
+	Comments: Circles spread over a level, queried with random boxes and ray casts. The array
+			  queries use a 15 shapes array, as the game did (MAXFOUNDSHAPES), the callback queries
+			  report every shape. Runs with both broad-phases, then with the dynamic tree over more
+			  circles than sweep and prune can hold (b2_maxProxies). Prints the time of a query and the
+			  shapes found. The ray casts for the first hit stop at the first shape reported.
+			  The callback ray casts must report every shape hit, in order (checked against all shapes).
+			  Usage: QueryBench [circles=480] [queries=20000] [tree circles=2000]
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include "Common/b2Timer.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	const int32 ArrayShapes = 15;		//The old MAXFOUNDSHAPES
+	const float32 LevelHalfSize = 50.0f;
+
+	// Same random numbers on every platform
+	unsigned int gSeed = 1;
+	float32 _random(float32 lo, float32 hi)
+	{
+		gSeed = gSeed * 1103515245u + 12345u;
+		return lo + (hi - lo) * static_cast<float32>((gSeed >> 8) & 0xFFFF) / 65535.0f;
+	}
+
+	class CountingQuery : public b2QueryCallback
+	{
+	public:
+		CountingQuery():mCount(0){}
+		virtual bool ReportShape(b2Shape* shape) { ++mCount; return true; }
+
+		long mCount;
+	};
+
+	// Counts the hits, and the hits out of order (first hit: stops at the first one)
+	class CountingRaycast : public b2RaycastCallback
+	{
+	public:
+		CountingRaycast(bool first):mFirst(first),mCount(0),mUnordered(0),mLast(0.0f){}
+		void Begin() { mLast = 0.0f; }
+		virtual bool ReportShape(b2Shape* shape, float32 lambda, const b2Vec2& normal)
+		{
+			++mCount;
+			if(lambda < mLast)
+				++mUnordered;
+			mLast = lambda;
+			return !mFirst;
+		}
+
+		bool mFirst;
+		long mCount;
+		long mUnordered;
+		float32 mLast;
+	};
+
+	typedef struct QueryResult
+	{
+		float32 time;	//Microseconds per query
+		long found;		//Shapes found, all queries
+	}QueryResult;
+
+	void _print(const char* name, const QueryResult& arrayresult, const QueryResult& callbackresult)
+	{
+		printf("%-16s %10.2f %10ld %10.2f %10ld\n", name, arrayresult.time, arrayresult.found, callbackresult.time, callbackresult.found);
+	}
+
+	b2Segment _randomSegment()
+	{
+		b2Segment segment;
+		segment.p1.Set(_random(-LevelHalfSize, LevelHalfSize), _random(-LevelHalfSize, LevelHalfSize));
+		segment.p2.Set(_random(-LevelHalfSize, LevelHalfSize), _random(-LevelHalfSize, LevelHalfSize));
+		return segment;
+	}
+
+	// Shapes hit by the segment, testing all of them (solid shapes, as the ray casts)
+	long _allHits(b2World& world, const b2Segment& segment)
+	{
+		long hits = 0;
+		for(b2Body* body = world.GetBodyList(); body; body = body->GetNext())
+		{
+			for(b2Shape* shape = body->GetShapeList(); shape; shape = shape->GetNext())
+			{
+				float32 lambda;
+				b2Vec2 normal;
+				if(shape->TestSegment(body->GetXForm(), &lambda, &normal, segment, 1.0f) != e_missCollide)
+				{
+					++hits;
+				}
+			}
+		}
+		return hits;
+	}
+
+	// Returns failures
+	int _run(b2BroadPhaseType type, const char* name, int circles, int queries)
+	{
+		b2AABB worldaabb;
+		worldaabb.lowerBound.Set(-LevelHalfSize - 10.0f, -LevelHalfSize - 10.0f);
+		worldaabb.upperBound.Set(LevelHalfSize + 10.0f, LevelHalfSize + 10.0f);
+		b2World world(worldaabb, b2Vec2(0.0f, 0.0f), true, type);
+
+		gSeed = 1;
+		//LOOP - Circles spread over the level
+		for(int i = 0; i < circles; ++i)
+		{
+			b2BodyDef def;
+			def.position.Set(_random(-LevelHalfSize, LevelHalfSize), _random(-LevelHalfSize, LevelHalfSize));
+			b2Body* body = world.CreateBody(&def);
+			b2CircleDef shape;
+			shape.radius = _random(0.3f, 1.0f);
+			body->CreateShape(&shape);
+		}//LOOP END
+
+		printf("%s broad-phase, %d circles, %d queries (microseconds per query, shapes found)\n", name, circles, queries);
+		printf("%-16s %10s %10s %10s %10s\n", "query", "array", "found", "callback", "found");
+
+		b2Shape* shapes[ArrayShapes];
+		float32 sizes[2] = { 3.0f, 7.5f };
+		//LOOP - Box queries, small and big boxes
+		for(int s = 0; s < 2; ++s)
+		{
+			QueryResult arrayresult = { 0.0f, 0 };
+			QueryResult callbackresult = { 0.0f, 0 };
+			CountingQuery callback;
+
+			gSeed = 7;
+			b2Timer timer;
+			for(int i = 0; i < queries; ++i)
+			{
+				b2AABB aabb;
+				aabb.lowerBound.Set(_random(-LevelHalfSize, LevelHalfSize), _random(-LevelHalfSize, LevelHalfSize));
+				aabb.upperBound = aabb.lowerBound + b2Vec2(2.0f * sizes[s], 2.0f * sizes[s]);
+				arrayresult.found += world.Query(aabb, shapes, ArrayShapes);
+			}
+			arrayresult.time = 1000.0f * timer.GetMilliseconds() / queries;
+
+			gSeed = 7;
+			timer.Reset();
+			for(int i = 0; i < queries; ++i)
+			{
+				b2AABB aabb;
+				aabb.lowerBound.Set(_random(-LevelHalfSize, LevelHalfSize), _random(-LevelHalfSize, LevelHalfSize));
+				aabb.upperBound = aabb.lowerBound + b2Vec2(2.0f * sizes[s], 2.0f * sizes[s]);
+				world.Query(&callback, aabb);
+			}
+			callbackresult.time = 1000.0f * timer.GetMilliseconds() / queries;
+			callbackresult.found = callback.mCount;
+
+			_print(s == 0 ? "box 6x6" : "box 15x15", arrayresult, callbackresult);
+		}//LOOP END
+
+		//Ray casts across the level: all hits (array of 15 shapes) and first hit (array of 1 shape)
+		int failures = 0;
+		//LOOP - All hits, first hit
+		for(int r = 0; r < 2; ++r)
+		{
+			int maxcount = r == 0 ? ArrayShapes : 1;
+			QueryResult arrayresult = { 0.0f, 0 };
+			QueryResult callbackresult = { 0.0f, 0 };
+			CountingRaycast callback(r == 1);
+
+			gSeed = 11;
+			b2Timer timer;
+			for(int i = 0; i < queries; ++i)
+			{
+				arrayresult.found += world.Raycast(_randomSegment(), shapes, maxcount, true, NULL);
+			}
+			arrayresult.time = 1000.0f * timer.GetMilliseconds() / queries;
+
+			gSeed = 11;
+			timer.Reset();
+			for(int i = 0; i < queries; ++i)
+			{
+				callback.Begin();
+				world.Raycast(&callback, _randomSegment(), true, NULL);
+			}
+			callbackresult.time = 1000.0f * timer.GetMilliseconds() / queries;
+			callbackresult.found = callback.mCount;
+
+			_print(r == 0 ? "ray cast" : "ray cast first", arrayresult, callbackresult);
+
+			//IF - All hits: every shape hit reported, in order
+			if(r == 0)
+			{
+				long hits = 0;
+				gSeed = 11;
+				for(int i = 0; i < queries; ++i)
+				{
+					hits += _allHits(world, _randomSegment());
+				}
+				if(hits != callback.mCount || callback.mUnordered != 0)
+				{
+					printf("FAIL ray cast: %ld hits reported, %ld shapes hit, %ld out of order\n", callback.mCount, hits, callback.mUnordered);
+					++failures;
+				}
+			}//IF
+		}//LOOP END
+
+		return failures;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int circles = argc > 1 ? atoi(argv[1]) : 480;
+	int queries = argc > 2 ? atoi(argv[2]) : 20000;
+	int treecircles = argc > 3 ? atoi(argv[3]) : 2000;
+	int failures = 0;
+
+	failures += _run(e_sweepAndPruneBroadPhase, "Sweep and prune", circles, queries);
+	printf("\n");
+	failures += _run(e_dynamicTreeBroadPhase, "Dynamic tree", circles, queries);
+	printf("\n");
+	failures += _run(e_dynamicTreeBroadPhase, "Dynamic tree", treecircles, queries);
+
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,109 @@
+/*
+	Filename: SolverBench.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Benchmark of the SIMD contact solver against the scalar one (SIMD CONTACT SOLVER MODE in Box2D.h)
+	Comments: A box filled with circles (single point contacts, the ones the SIMD solver batches)
+			  falls and piles up. Bodies don't sleep, so both solvers solve the whole pile every step.
+			  The same scene runs with each contact solver. Prints the step and island solve times,
+			  the constraints and the ones solved in batches.
+			  Usage: SolverBench [circles=480] [steps=600] (b2_maxProxies limits the circles)
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include "Common/b2Timer.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 60.0f;
+	const float32 BoxHalfWidth = 20.0f;
+
+	typedef struct BenchResult
+	{
+		float32 steptime;	//Milliseconds, all steps
+		float32 solvetime;	//Milliseconds in the island solve, all steps
+		long constraints;
+		long batched;
+	}BenchResult;
+
+	void _createBox(b2World& world)
+	{
+		b2BodyDef def;
+		b2Body* ground = world.CreateBody(&def);
+		b2PolygonDef shape;
+		shape.SetAsBox(BoxHalfWidth, 1.0f, b2Vec2(0.0f, -1.0f), 0.0f);
+		ground->CreateShape(&shape);
+		shape.SetAsBox(1.0f, 60.0f, b2Vec2(-BoxHalfWidth - 1.0f, 60.0f), 0.0f);
+		ground->CreateShape(&shape);
+		shape.SetAsBox(1.0f, 60.0f, b2Vec2(BoxHalfWidth + 1.0f, 60.0f), 0.0f);
+		ground->CreateShape(&shape);
+	}
+
+	BenchResult _run(b2ContactSolverType type, int circles, int steps)
+	{
+		b2AABB worldaabb;
+		worldaabb.lowerBound.Set(-100.0f, -100.0f);
+		worldaabb.upperBound.Set(100.0f, 300.0f);
+		b2World world(worldaabb, b2Vec2(0.0f, -10.0f), false);
+		world.SetContactSolverType(type);
+
+		_createBox(world);
+		//LOOP - Rows of circles over the box, sizes varied
+		int perrow = static_cast<int>(BoxHalfWidth);
+		for(int i = 0; i < circles; ++i)
+		{
+			b2BodyDef def;
+			def.position.Set(-BoxHalfWidth + 1.0f + 2.0f * (i % perrow) + 0.1f * (i / perrow % 3), 1.0f + 1.0f * (i / perrow));
+			b2Body* body = world.CreateBody(&def);
+			b2CircleDef shape;
+			shape.radius = 0.35f + 0.05f * (i % 3);
+			shape.density = 1.0f;
+			shape.friction = 0.3f;
+			body->CreateShape(&shape);
+			body->SetMassFromShapes();
+		}//LOOP END
+
+		BenchResult result = { 0.0f, 0.0f, 0, 0 };
+		//LOOP - Simulate
+		for(int i = 0; i < steps; ++i)
+		{
+			b2Timer timer;
+			world.Step(TimeStep, 10, 8, true);
+			result.steptime += timer.GetMilliseconds();
+
+			b2Profile profile;
+			world.GetProfile(&profile);
+			result.solvetime += profile.solve;
+			b2ContactSolverStatistics stats;
+			world.GetContactSolverStatistics(&stats);
+			result.constraints += stats.constraintCount;
+			result.batched += stats.batchedConstraintCount;
+		}//LOOP END
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int circles = argc > 1 ? atoi(argv[1]) : 480;
+	int steps = argc > 2 ? atoi(argv[2]) : 600;
+
+	printf("%d circles in a box (no sleep), %d steps (times are milliseconds, all steps)\n", circles, steps);
+	printf("%-8s %10s %10s %12s %10s\n", "solver", "step", "solve", "constraints", "batched");
+	const char* names[2] = { "scalar", "SIMD" };
+	b2ContactSolverType types[2] = { e_scalarContactSolver, e_simdContactSolver };
+	for(int i = 0; i < 2; ++i)
+	{
+		BenchResult result = _run(types[i], circles, steps);
+		printf("%-8s %10.1f %10.1f %12ld %9.1f%%\n", names[i], result.steptime, result.solvetime,
+			   result.constraints, result.constraints ? 100.0f * result.batched / result.constraints : 0.0f);
+	}
+
+	return 0;
+}
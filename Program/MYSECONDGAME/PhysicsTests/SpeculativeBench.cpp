@@ -0,0 +1,153 @@
+/*
+	Filename: SpeculativeBench.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Benchmark of speculative contacts against bullet TOI (SPECULATIVE CONTACTS in Box2D.h)
+	Comments: Small blobs (a ring of skin masses jointed to an inner mass, as BlobBuilder makes them)
+			  are thrown at a roof of thin tiles. The skin masses are plain bodies, bullets or
+			  speculative bodies. Prints the step time, the TOI events and the masses that went
+			  through the roof.
+			  Usage: SpeculativeBench [blobs=20] [speed=100] [threads=1]
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include "Common/b2Timer.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 60.0f;
+	const int32 StepCount = 120;
+	const int32 SkinMasses = 12;
+	const float32 BlobRadius = 0.5f;
+	const float32 MassRadius = 0.08f;
+	const float32 TileHalfHeight = 0.05f;
+
+	typedef enum SkinMode{ PLAIN, BULLET, SPECULATIVE, SKINMODESCOUNT }SkinMode;
+	const char* SkinModeNames[SKINMODESCOUNT] = { "plain", "bullet", "speculative" };
+
+	typedef struct BenchResult
+	{
+		float32 steptime;	//Milliseconds, all steps
+		float32 toitime;	//Milliseconds in SolveTOI, all steps
+		int toievents;
+		int through;		//Skin masses below the roof at the end
+	}BenchResult;
+
+	b2Body* _createMass(b2World& world, const b2Vec2& position, float32 radius, SkinMode mode, float32 speed)
+	{
+		b2BodyDef def;
+		def.position = position;
+		def.isBullet = (mode == BULLET);
+		def.isSpeculative = (mode == SPECULATIVE);
+		b2Body* body = world.CreateBody(&def);
+		b2CircleDef shape;
+		shape.radius = radius;
+		shape.density = 1.0f;
+		shape.friction = 0.3f;
+		body->CreateShape(&shape);
+		body->SetMassFromShapes();
+		body->SetLinearVelocity(b2Vec2(0.0f, -speed));
+		return body;
+	}
+
+	void _createBlob(b2World& world, const b2Vec2& center, SkinMode mode, float32 speed)
+	{
+		b2Body* inner = _createMass(world, center, 0.2f, PLAIN, speed);
+
+		b2DistanceJointDef spring;
+		spring.frequencyHz = 8.0f;
+		spring.dampingRatio = 0.5f;
+
+		b2Body* first = NULL;
+		b2Body* previous = NULL;
+		//LOOP - Skin masses, jointed to the inner mass and to the next mass
+		for(int i = 0; i < SkinMasses; ++i)
+		{
+			float32 angle = 2.0f * b2_pi * i / SkinMasses;
+			b2Vec2 position = center + BlobRadius * b2Vec2(cosf(angle), sinf(angle));
+			b2Body* mass = _createMass(world, position, MassRadius, mode, speed);
+
+			spring.Initialize(inner, mass, inner->GetWorldCenter(), mass->GetWorldCenter());
+			world.CreateJoint(&spring);
+			if(previous)
+			{
+				spring.Initialize(previous, mass, previous->GetWorldCenter(), mass->GetWorldCenter());
+				world.CreateJoint(&spring);
+			}
+			else
+			{
+				first = mass;
+			}
+			previous = mass;
+		}//LOOP END
+
+		spring.Initialize(previous, first, previous->GetWorldCenter(), first->GetWorldCenter());
+		world.CreateJoint(&spring);
+	}
+
+	BenchResult _run(SkinMode mode, int blobs, float32 speed, int threads)
+	{
+		b2AABB worldaabb;
+		worldaabb.lowerBound.Set(-100.0f, -200.0f);
+		worldaabb.upperBound.Set(100.0f, 100.0f);
+		b2World world(worldaabb, b2Vec2(0.0f, -10.0f), true);
+		world.SetSolverThreadCount(threads);
+
+		//LOOP - Roof of thin tiles under the blobs
+		for(int i = 0; i < blobs; ++i)
+		{
+			b2BodyDef def;
+			def.position.Set(-blobs * 1.5f + i * 3.0f, 0.0f);
+			b2Body* tile = world.CreateBody(&def);
+			b2PolygonDef shape;
+			shape.SetAsBox(1.5f, TileHalfHeight);
+			tile->CreateShape(&shape);
+			_createBlob(world, b2Vec2(def.position.x, 5.0f), mode, speed);
+		}//LOOP END
+
+		BenchResult result = { 0.0f, 0.0f, 0, 0 };
+		//LOOP - Simulate
+		for(int i = 0; i < StepCount; ++i)
+		{
+			b2Timer timer;
+			world.Step(TimeStep, 10, 8, true);
+			result.steptime += timer.GetMilliseconds();
+			b2TOIStatistics toi;
+			world.GetTOIStatistics(&toi);
+			result.toitime += toi.time;
+			result.toievents += toi.eventCount;
+		}//LOOP END
+
+		for(b2Body* b = world.GetBodyList(); b; b = b->GetNext())
+		{
+			if(!b->IsStatic() && b->GetPosition().y < 0.0f)
+			{
+				++result.through;
+			}
+		}
+
+		return result;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int blobs = argc > 1 ? atoi(argv[1]) : 20;
+	float32 speed = argc > 2 ? static_cast<float32>(atof(argv[2])) : 100.0f;
+	int threads = argc > 3 ? atoi(argv[3]) : 1;
+
+	printf("%d blobs of %d skin masses, thrown at %.0f m/s, %d steps, %d threads\n", blobs, SkinMasses, speed, StepCount, threads);
+	printf("%-12s %10s %10s %10s %10s\n", "skin", "step ms", "TOI ms", "TOI events", "through");
+	for(int mode = 0; mode < SKINMODESCOUNT; ++mode)
+	{
+		BenchResult result = _run(static_cast<SkinMode>(mode), blobs, speed, threads);
+		printf("%-12s %10.2f %10.2f %10d %10d\n", SkinModeNames[mode], result.steptime, result.toitime, result.toievents, result.through);
+	}
+
+	return 0;
+}
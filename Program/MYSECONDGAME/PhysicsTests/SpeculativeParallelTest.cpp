@@ -0,0 +1,162 @@
+/*
+	Filename: SpeculativeParallelTest.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Regression test for speculative contacts solved by the parallel island solver
+				 (SPECULATIVE CONTACTS and PARALLEL ISLAND SOLVING in Box2D.h)
+	Comments: Speculative circles are thrown against thin tiles, so many manifold points are ahead
+			  of the shapes. Points ahead are solved but not reported. The same scene runs solved
+			  on 1 and on 4 threads, and the contact results must be the same, in the same order.
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include <cstdio>
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 60.0f;
+	const int32 StepCount = 300;
+
+	// Counts and hashes the contact results of a step
+	class ResultListener : public b2ContactListener
+	{
+	public:
+		ResultListener():mCount(0),mHash(2166136261u){}
+		virtual void Result(const b2ContactResult* point)
+		{
+			++mCount;
+			_hash(point->normalImpulse);
+			_hash(point->tangentImpulse);
+			_hash(point->position.x);
+			_hash(point->position.y);
+			mHash = (mHash ^ static_cast<unsigned>(point->id.key)) * 16777619u;
+		}
+		void Reset() { mCount = 0; mHash = 2166136261u; }
+
+		int mCount;
+		unsigned mHash;
+
+	private:
+		void _hash(float32 value)
+		{
+			const unsigned char* bytes = reinterpret_cast<const unsigned char*>(&value);
+			for(unsigned int i = 0; i < sizeof(float32); ++i)
+			{
+				mHash = (mHash ^ bytes[i]) * 16777619u;
+			}
+		}
+	};
+
+	// Manifold points ahead of the shapes (not reported)
+	int _aheadPointCount(b2World& world)
+	{
+		int count = 0;
+		for(b2Contact* c = world.GetContactList(); c; c = c->GetNext())
+		{
+			b2Manifold* manifolds = c->GetManifolds();
+			for(int32 i = 0; i < c->GetManifoldCount(); ++i)
+			{
+				for(int32 j = 0; j < manifolds[i].pointCount; ++j)
+				{
+					if(manifolds[i].points[j].separation > 0.0f)
+					{
+						++count;
+					}
+				}
+			}
+		}
+		return count;
+	}
+
+	void _createScene(b2World& world)
+	{
+		//LOOP - Rows of thin tiles
+		for(int row = 0; row < 3; ++row)
+		{
+			for(int i = 0; i < 8; ++i)
+			{
+				b2BodyDef def;
+				def.position.Set(i * 4.0f, row * 6.0f);
+				b2Body* tile = world.CreateBody(&def);
+				b2PolygonDef shape;
+				shape.SetAsBox(2.0f, 0.05f);
+				tile->CreateShape(&shape);
+			}
+		}//LOOP END
+
+		//LOOP - Fast speculative circles over the tiles, some thrown down
+		for(int i = 0; i < 160; ++i)
+		{
+			b2BodyDef def;
+			def.position.Set(-1.5f + (i % 32) * 1.0f, 20.0f + (i / 32) * 0.6f);
+			def.isSpeculative = true;
+			b2Body* body = world.CreateBody(&def);
+			b2CircleDef shape;
+			shape.radius = 0.25f;
+			shape.density = 1.0f;
+			shape.friction = 0.3f;
+			body->CreateShape(&shape);
+			body->SetMassFromShapes();
+			if(i % 3 == 0)
+			{
+				body->SetLinearVelocity(b2Vec2(0.0f, -60.0f));
+			}
+		}//LOOP END
+	}
+}
+
+int main(int argc, char** argv)
+{
+	b2AABB worldaabb;
+	worldaabb.lowerBound.Set(-50.0f, -50.0f);
+	worldaabb.upperBound.Set(100.0f, 100.0f);
+
+	b2World serial(worldaabb, b2Vec2(0.0f, -10.0f), true);
+	b2World parallel(worldaabb, b2Vec2(0.0f, -10.0f), true);
+	parallel.SetSolverThreadCount(4);
+	ResultListener seriallistener;
+	ResultListener parallellistener;
+	serial.SetContactListener(&seriallistener);
+	parallel.SetContactListener(&parallellistener);
+	_createScene(serial);
+	_createScene(parallel);
+
+	int failures = 0;
+	int aheadsteps = 0;
+	int results = 0;
+	//LOOP - Step both worlds, compare the results of each step
+	for(int i = 0; i < StepCount; ++i)
+	{
+		seriallistener.Reset();
+		parallellistener.Reset();
+		serial.Step(TimeStep, 10, 8, true);
+		parallel.Step(TimeStep, 10, 8, true);
+
+		if(_aheadPointCount(parallel) > 0)
+		{
+			++aheadsteps;
+		}
+		results += seriallistener.mCount;
+
+		if(seriallistener.mCount != parallellistener.mCount || seriallistener.mHash != parallellistener.mHash)
+		{
+			printf("FAIL step %d: serial %d results (%08x), parallel %d results (%08x)\n", i,
+				   seriallistener.mCount, seriallistener.mHash, parallellistener.mCount, parallellistener.mHash);
+			++failures;
+		}
+	}//LOOP END
+
+	//The scene must have points ahead, or nothing was tested
+	if(aheadsteps == 0 || results == 0)
+	{
+		printf("FAIL: no points ahead of the shapes (%d steps) or no results (%d)\n", aheadsteps, results);
+		++failures;
+	}
+
+	printf("%d steps with points ahead, %d results\n", aheadsteps, results);
+	printf("%s: %d failures\n", failures ? "FAILED" : "PASSED", failures);
+	return failures ? 1 : 0;
+}
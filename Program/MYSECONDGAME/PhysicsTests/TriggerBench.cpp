@@ -0,0 +1,180 @@
+/*
+	Filename: TriggerBench.cpp
+	Copyright: Miguel Angel Quinones (mikeskywalker007@gmail.com)
+	Description: Benchmark of trigger shapes against sensor shapes (TRIGGER VOLUMES in Box2D.h)
+	Comments: A grid of static collectables (circles and boxes) and an active blob (a group of circle
+			  masses that never sleep, each one moving on its own path) going through them.
+			  The collectables are sensors (contacts, Add/Remove callbacks per point) or triggers
+			  (broad-phase pairs, Enter/Exit callbacks per shape). Prints the step, collide and
+			  trigger update times, and the callbacks.
+			  Usage: TriggerBench [grid side=40] [blob masses=40]
+			  See README.txt to build and run it.
+	Attribution:
+	License: You are free to use as you want... but it can destroy your computer, so dont blame me about it ;)
+	         Nevertheless it would be nice if you tell me you are using something I made, just for curiosity
+*/
+
+#include "Box2D.h"
+#include "Common/b2Timer.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+
+namespace
+{
+	const float32 TimeStep = 1.0f / 60.0f;
+	const int32 StepCount = 600;
+	const int32 MaxBlobMasses = 256;
+
+	// Sensor contact points begun and ended
+	class SensorListener : public b2ContactListener
+	{
+	public:
+		SensorListener():mAddCount(0),mRemoveCount(0){}
+		virtual void Add(const b2ContactPoint* point)
+		{
+			if(point->shape1->IsSensor() || point->shape2->IsSensor())
+			{
+				++mAddCount;
+			}
+		}
+		virtual void Remove(const b2ContactPoint* point)
+		{
+			if(point->shape1->IsSensor() || point->shape2->IsSensor())
+			{
+				++mRemoveCount;
+			}
+		}
+
+		int mAddCount;
+		int mRemoveCount;
+	};
+
+	class CountingTriggerListener : public b2TriggerListener
+	{
+	public:
+		CountingTriggerListener():mEnterCount(0),mExitCount(0){}
+		virtual void Enter(b2Shape* trigger, b2Shape* shape) { ++mEnterCount; }
+		virtual void Exit(b2Shape* trigger, b2Shape* shape) { ++mExitCount; }
+
+		int mEnterCount;
+		int mExitCount;
+	};
+
+	void _run(bool triggers, int side, int masses)
+	{
+		b2AABB worldaabb;
+		worldaabb.lowerBound.Set(-200.0f, -200.0f);
+		worldaabb.upperBound.Set(200.0f, 200.0f);
+		b2World world(worldaabb, b2Vec2(0.0f, 0.0f), true, e_dynamicTreeBroadPhase);
+		SensorListener sensorlistener;
+		CountingTriggerListener triggerlistener;
+		world.SetContactListener(&sensorlistener);
+		world.SetTriggerListener(&triggerlistener);
+
+		//LOOP - Grid of collectables, circles and boxes
+		for(int i = 0; i < side; ++i)
+		{
+			for(int j = 0; j < side; ++j)
+			{
+				b2BodyDef def;
+				def.position.Set(-side + 2.0f * i, -side + 2.0f * j);
+				b2Body* collectable = world.CreateBody(&def);
+				if((i + j) & 1)
+				{
+					b2CircleDef shape;
+					shape.radius = 0.4f;
+					shape.isSensor = !triggers;
+					shape.isTrigger = triggers;
+					collectable->CreateShape(&shape);
+				}
+				else
+				{
+					b2PolygonDef shape;
+					shape.SetAsBox(0.4f, 0.4f);
+					shape.isSensor = !triggers;
+					shape.isTrigger = triggers;
+					collectable->CreateShape(&shape);
+				}
+			}
+		}//LOOP END
+
+		//LOOP - Blob masses
+		b2Body* blob[MaxBlobMasses];
+		for(int k = 0; k < masses; ++k)
+		{
+			b2BodyDef def;
+			def.position.Set(-side + 1.0f * (k % 16) + 0.5f, -side + 1.0f * (k / 16) + 0.5f);
+			def.allowSleep = false;
+			blob[k] = world.CreateBody(&def);
+			b2CircleDef shape;
+			shape.radius = 0.25f;
+			shape.density = 1.0f;
+			blob[k]->CreateShape(&shape);
+			blob[k]->SetMassFromShapes();
+		}//LOOP END
+
+		float32 steptime = 0.0f;
+		float32 collidetime = 0.0f;
+		float32 triggertime = 0.0f;
+		//LOOP - Simulate, each mass on its own path
+		for(int s = 0; s < StepCount; ++s)
+		{
+			for(int k = 0; k < masses; ++k)
+			{
+				float32 a = 0.01f * s + 0.1f * k;
+				blob[k]->SetLinearVelocity(b2Vec2(6.0f * cosf(a * 0.7f), 6.0f * sinf(a * 1.3f)));
+			}
+
+			b2Timer timer;
+			world.Step(TimeStep, 10, 8, true);
+			steptime += timer.GetMilliseconds();
+
+			b2Profile profile;
+			world.GetProfile(&profile);
+			collidetime += profile.collide;
+			b2TriggerStatistics stats;
+			world.GetTriggerStatistics(&stats);
+			triggertime += stats.time;
+		}//LOOP END
+
+		//Destroyed masses exit the triggers they were in, every enter gets its exit
+		int contacts = world.GetContactCount();
+		int exitsbefore = triggerlistener.mExitCount;
+		b2TriggerStatistics stepstats;
+		world.GetTriggerStatistics(&stepstats);	//Counts of the last step, the destroyed pairs are added
+		for(int k = 0; k < masses; ++k)
+		{
+			world.DestroyBody(blob[k]);
+		}
+		b2TriggerStatistics stats;
+		world.GetTriggerStatistics(&stats);
+		int destroyexits = stats.exitCount - stepstats.exitCount;
+
+		printf("%-8s %10.1f %10.1f %10.1f %10d %10d %10d %10d\n", triggers ? "trigger" : "sensor",
+			   steptime, collidetime, triggertime, contacts,
+			   sensorlistener.mAddCount, triggerlistener.mEnterCount, triggerlistener.mExitCount);
+		if(triggerlistener.mExitCount != triggerlistener.mEnterCount || destroyexits != triggerlistener.mExitCount - exitsbefore)
+		{
+			printf("FAIL %d enters, %d exits, %d exits of destroyed masses in the statistics\n",
+				   triggerlistener.mEnterCount, triggerlistener.mExitCount, destroyexits);
+		}
+	}
+}
+
+int main(int argc, char** argv)
+{
+	int side = argc > 1 ? atoi(argv[1]) : 40;
+	int masses = argc > 2 ? atoi(argv[2]) : 40;
+	if(masses > MaxBlobMasses)
+	{
+		masses = MaxBlobMasses;
+	}
+
+	printf("%d collectables, blob of %d masses, %d steps (times are milliseconds, all steps)\n", side * side, masses, StepCount);
+	printf("%-8s %10s %10s %10s %10s %10s %10s %10s\n", "shapes", "step", "collide", "triggers", "contacts", "adds", "enters", "exits");
+	_run(false, side, masses);
+	_run(true, side, masses);
+
+	return 0;
+}